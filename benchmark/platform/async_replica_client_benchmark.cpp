@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures the throughput of AsyncReplicaClient over loopback. A receiver
+// thread reads the stream in 1MB chunks until all the messages have
+// arrived. The serial client writes the length header and the data of each
+// message separately, one message at a time, as the client did before the
+// gather writes.
+
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "platform/common/queue/lock_free_queue.h"
+#include "platform/networkstrate/async_replica_client.h"
+
+using namespace resdb;
+using boost::asio::ip::tcp;
+
+namespace {
+
+class SerialReplicaClient {
+ public:
+  SerialReplicaClient(boost::asio::io_service* io_service,
+                      const std::string& ip, int port)
+      : socket_(*io_service),
+        endpoint_(boost::asio::ip::address::from_string(ip), port) {
+    socket_.connect(endpoint_);
+  }
+
+  int SendMessage(const std::string& data) {
+    queue_.Push(std::make_unique<std::string>(data));
+    bool old_value = false;
+    if (in_process_.compare_exchange_strong(old_value, true)) {
+      OnSendNewMessage();
+    }
+    return 0;
+  }
+
+ private:
+  void OnSendNewMessage() {
+    while ((pending_data_ = queue_.Pop(0)) == nullptr) {
+      in_process_ = false;
+      bool old_value = false;
+      if (queue_.Empty() ||
+          !in_process_.compare_exchange_strong(old_value, true)) {
+        return;
+      }
+    }
+    data_size_ = pending_data_->size();
+    boost::asio::async_write(
+        socket_, boost::asio::buffer(&data_size_, sizeof(data_size_)),
+        [&](const boost::system::error_code& error, size_t) {
+          boost::asio::async_write(
+              socket_, boost::asio::buffer(*pending_data_),
+              [&](const boost::system::error_code& error, size_t) {
+                OnSendNewMessage();
+              });
+        });
+  }
+
+ private:
+  LockFreeQueue<std::string> queue_;
+  tcp::socket socket_;
+  tcp::endpoint endpoint_;
+  std::atomic<bool> in_process_ = false;
+  std::unique_ptr<std::string> pending_data_;
+  size_t data_size_ = 0;
+};
+
+template <typename Client>
+void Run(const std::string& name, size_t message_size, int message_num,
+         int port) {
+  boost::asio::io_service svr_service;
+  tcp::acceptor acceptor(
+      svr_service,
+      tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), port));
+  std::promise<void> done;
+  std::thread receiver([&]() {
+    tcp::socket socket(svr_service);
+    acceptor.accept(socket);
+    std::vector<char> buf(1 << 20);
+    size_t total = (sizeof(size_t) + message_size) * message_num;
+    size_t received = 0;
+    boost::system::error_code error;
+    while (received < total && !error) {
+      received += socket.read_some(boost::asio::buffer(buf), error);
+    }
+    done.set_value();
+  });
+
+  boost::asio::io_service io_service;
+  auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+  std::thread io_thread([&]() { io_service.run(); });
+  {
+    Client client(&io_service, "127.0.0.1", port);
+    std::string data(message_size, 'd');
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < message_num; ++i) {
+      client.SendMessage(data);
+    }
+    done.get_future().get();
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count() /
+                     1000000.0;
+    printf("%-8s %8zu %12.0f %10.1f\n", name.c_str(), message_size,
+           message_num / seconds,
+           message_num * message_size / seconds / (1 << 20));
+    work.reset();
+    io_service.stop();
+    io_thread.join();
+  }
+  receiver.join();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int message_num = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int port = 20000;
+  printf("%-8s %8s %12s %10s\n", "client", "bytes", "msgs/s", "MB/s");
+  for (size_t message_size : {64, 512, 4096, 65536}) {
+    int num = message_size > 4096 ? message_num / 16 : message_num;
+    Run<SerialReplicaClient>("serial", message_size, num, port++);
+    Run<AsyncReplicaClient>("gather", message_size, num, port++);
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures broadcasting a large batch to n replicas through
+// ReplicaCommunicator without the network. The copy rows hand the
+// serialized string to every client, which copies it, as the broadcast did
+// before MessageBuffer. The shared rows go through SendMessageFromPool and
+// share one buffer. Each client keeps its last few buffers alive as the
+// send queue would.
+
+#include <chrono>
+
+#include "platform/networkstrate/replica_communicator.h"
+#include "platform/proto/broadcast.pb.h"
+
+using namespace resdb;
+
+namespace {
+
+constexpr int kQueueDepth = 4;
+
+class HoldingClient : public AsyncReplicaClient {
+ public:
+  HoldingClient(boost::asio::io_service* io_service)
+      : AsyncReplicaClient(io_service, "127.0.0.1", 0) {}
+
+  int SendMessage(MessageBuffer data, SendLane lane) override {
+    queue_[idx_++ % kQueueDepth] = std::move(data);
+    return 0;
+  }
+
+ private:
+  MessageBuffer queue_[kQueueDepth];
+  int idx_ = 0;
+};
+
+class BenchReplicaCommunicator : public ReplicaCommunicator {
+ public:
+  BenchReplicaCommunicator(const std::vector<ReplicaInfo>& replicas)
+      : ReplicaCommunicator(replicas) {
+    for (const auto& replica : replicas) {
+      clients_[replica.port()] = std::make_unique<HoldingClient>(&io_service_);
+    }
+  }
+
+  int BroadcastShared(const google::protobuf::Message& message,
+                      const std::vector<ReplicaInfo>& replicas) {
+    return SendMessageFromPool(message, replicas);
+  }
+
+  int BroadcastCopy(const google::protobuf::Message& message,
+                    const std::vector<ReplicaInfo>& replicas) {
+    std::string data;
+    message.SerializeToString(&data);
+    std::lock_guard<std::mutex> lk(mutex_);
+    int ret = 0;
+    for (const auto& replica : replicas) {
+      ret += GetClientFromPool(replica.ip(), replica.port())
+                 ->AsyncReplicaClient::SendMessage(data) == 0;
+    }
+    return ret;
+  }
+
+ protected:
+  AsyncReplicaClient* GetClientFromPool(const std::string& ip,
+                                        int port) override {
+    return clients_[port].get();
+  }
+
+ private:
+  boost::asio::io_service io_service_;
+  std::map<int, std::unique_ptr<HoldingClient>> clients_;
+  std::mutex mutex_;
+};
+
+void Run(int replica_num, size_t batch_size, int round) {
+  std::vector<ReplicaInfo> replicas;
+  for (int i = 0; i < replica_num; ++i) {
+    ReplicaInfo replica;
+    replica.set_id(i + 1);
+    replica.set_ip("127.0.0.1");
+    replica.set_port(10000 + i);
+    replicas.push_back(replica);
+  }
+  BenchReplicaCommunicator communicator(replicas);
+
+  // A batch of 1KB requests.
+  BroadcastData broadcast_data;
+  for (size_t i = 0; i < batch_size / 1024; ++i) {
+    broadcast_data.add_data()->assign(1024, 'r');
+  }
+
+  for (bool shared : {false, true}) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < round; ++i) {
+      if (shared) {
+        communicator.BroadcastShared(broadcast_data, replicas);
+      } else {
+        communicator.BroadcastCopy(broadcast_data, replicas);
+      }
+    }
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count() /
+                     1000000.0;
+    // Bytes written to memory per broadcast: the serialization and the
+    // copies of the clients.
+    size_t copy_bytes =
+        broadcast_data.ByteSizeLong() * (1 + (shared ? 0 : replica_num));
+    printf("%-7s %9d %10zu %12.1f %12.1f %10.2f\n",
+           shared ? "shared" : "copy", replica_num, batch_size >> 10,
+           round / seconds, copy_bytes / 1048576.0,
+           copy_bytes * round / seconds / (1 << 30));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int round = argc > 1 ? std::atoi(argv[1]) : 200;
+  printf("%-7s %9s %10s %12s %12s %10s\n", "buffer", "replicas", "batch(KB)",
+         "broadcast/s", "copy MB/bc", "GB/s");
+  for (int replica_num : {4, 16, 32}) {
+    Run(replica_num, 1 << 20, round);
+  }
+  Run(32, 8 << 20, round / 8);
+  return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures DuplicateManager throughput with many worker threads. Every
+// operation runs CheckAndAddProposed, AddExecuted and CheckIfExecuted on a
+// fresh request hash, as the commit path does. The mutex-guarded ordered sets
+// used before are kept here for comparison.
+
+#include <glog/logging.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <set>
+#include <thread>
+
+#include "common/utils/utils.h"
+#include "platform/consensus/execution/duplicate_manager.h"
+
+using namespace resdb;
+
+namespace {
+
+class LockedSetDuplicateManager {
+ public:
+  bool CheckAndAddProposed(const std::string& hash) {
+    std::lock_guard<std::mutex> lk(prop_mutex_);
+    if (proposed_hash_set_.find(hash) != proposed_hash_set_.end()) {
+      return true;
+    }
+    proposed_hash_time_queue_.push(std::make_pair(hash, GetCurrentTime()));
+    proposed_hash_set_.insert(hash);
+    return false;
+  }
+
+  void AddExecuted(const std::string& hash, uint64_t seq) {
+    std::lock_guard<std::mutex> lk(exec_mutex_);
+    executed_hash_time_queue_.push(std::make_pair(hash, GetCurrentTime()));
+    executed_hash_set_.insert(hash);
+    executed_hash_seq_[hash] = seq;
+  }
+
+  uint64_t CheckIfExecuted(const std::string& hash) {
+    std::lock_guard<std::mutex> lk(exec_mutex_);
+    if (executed_hash_set_.find(hash) != executed_hash_set_.end()) {
+      return executed_hash_seq_[hash];
+    }
+    return 0;
+  }
+
+ private:
+  std::set<std::string> proposed_hash_set_;
+  std::set<std::string> executed_hash_set_;
+  std::queue<std::pair<std::string, uint64_t>> proposed_hash_time_queue_;
+  std::queue<std::pair<std::string, uint64_t>> executed_hash_time_queue_;
+  std::map<std::string, uint64_t> executed_hash_seq_;
+  std::mutex prop_mutex_;
+  std::mutex exec_mutex_;
+};
+
+std::vector<std::vector<std::string>> GenerateHashes(int thread_num,
+                                                     int op_num) {
+  std::mt19937_64 rng(0);
+  std::vector<std::vector<std::string>> hashes(thread_num);
+  for (auto& list : hashes) {
+    for (int i = 0; i < op_num; ++i) {
+      std::string hash(32, 0);
+      for (size_t j = 0; j < hash.size(); j += 8) {
+        uint64_t v = rng();
+        memcpy(&hash[j], &v, 8);
+      }
+      list.push_back(std::move(hash));
+    }
+  }
+  return hashes;
+}
+
+template <typename Manager>
+double Run(Manager* manager,
+           const std::vector<std::vector<std::string>>& hashes) {
+  std::vector<std::thread> threads;
+  auto start_time = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < hashes.size(); ++t) {
+    threads.push_back(std::thread([&, t]() {
+      uint64_t seq = t << 32;
+      for (const std::string& hash : hashes[t]) {
+        if (manager->CheckAndAddProposed(hash)) {
+          LOG(ERROR) << "unexpected duplicate";
+        }
+        manager->AddExecuted(hash, ++seq);
+        if (manager->CheckIfExecuted(hash) != seq) {
+          LOG(ERROR) << "unexpected seq";
+        }
+      }
+    }));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  auto end_time = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+                       end_time - start_time)
+                       .count() /
+                   1000000.0;
+  return hashes.size() * hashes[0].size() / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int op_num = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int max_thread_num = argc > 2 ? std::atoi(argv[2]) : 32;
+
+  ResConfigData config_data;
+  config_data.set_duplicate_index_capacity(1 << 22);
+  ResDBConfig config({}, ReplicaInfo(), config_data);
+
+  printf("threads  locked_set(ops/s)  hash_index(ops/s)\n");
+  for (int thread_num = 1; thread_num <= max_thread_num; thread_num *= 2) {
+    auto hashes = GenerateHashes(thread_num, op_num / thread_num);
+    LockedSetDuplicateManager locked_set;
+    double locked_set_tput = Run(&locked_set, hashes);
+    DuplicateManager manager(config);
+    double index_tput = Run(&manager, hashes);
+    printf("%7d  %17.0f  %17.0f\n", thread_num, locked_set_tput, index_tput);
+  }
+  return 0;
+}
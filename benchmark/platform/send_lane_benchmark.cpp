@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures the latency of small vote messages sent by AsyncReplicaClient
+// over loopback while 1MB batches keep the connection busy. The sender keeps
+// a backlog of batches queued and sends a vote every millisecond, in the
+// control lane or behind the batches in the bulk lane. The receiver reads
+// the frames and records the time each vote spent in flight.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#include "platform/networkstrate/async_replica_client.h"
+
+using namespace resdb;
+using boost::asio::ip::tcp;
+
+namespace {
+
+constexpr size_t kBatchSize = 1 << 20;
+constexpr size_t kBatchBacklog = 16;
+
+uint64_t GetTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Run(SendLane vote_lane, int vote_num, int port) {
+  boost::asio::io_service svr_service;
+  tcp::acceptor acceptor(
+      svr_service,
+      tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), port));
+  std::atomic<int> total_num = INT_MAX;
+  std::vector<uint64_t> latency;
+  uint64_t batch_num = 0;
+  std::thread receiver([&]() {
+    tcp::socket socket(svr_service);
+    acceptor.accept(socket);
+    std::vector<char> buf(kBatchSize);
+    for (int i = 0; i < total_num; ++i) {
+      size_t size = 0;
+      boost::asio::read(socket, boost::asio::buffer(&size, sizeof(size)));
+      boost::asio::read(socket, boost::asio::buffer(buf.data(), size));
+      if (buf[0] == 'v') {
+        uint64_t send_time = 0;
+        memcpy(&send_time, buf.data() + 1, sizeof(send_time));
+        latency.push_back(GetTimeUs() - send_time);
+      } else {
+        batch_num++;
+      }
+    }
+  });
+
+  boost::asio::io_service io_service;
+  auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+  std::thread io_thread([&]() { io_service.run(); });
+  auto start = std::chrono::steady_clock::now();
+  {
+    AsyncReplicaClient client(&io_service, "127.0.0.1", port, true);
+    MessageBuffer batch = NewMessageBuffer(std::string(kBatchSize, 'b'));
+    int send_num = 0;
+    uint64_t next_vote_time = GetTimeUs();
+    for (int i = 0; i < vote_num;) {
+      if (GetTimeUs() >= next_vote_time) {
+        std::string vote(64, 'v');
+        uint64_t now = GetTimeUs();
+        memcpy(vote.data() + 1, &now, sizeof(now));
+        client.SendMessage(NewMessageBuffer(std::move(vote)), vote_lane);
+        next_vote_time = now + 1000;
+        send_num++;
+        i++;
+      } else if (client.GetQueueDepth(SendLane::kBulk) < kBatchBacklog) {
+        client.SendMessage(batch, SendLane::kBulk);
+        send_num++;
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    }
+    total_num = send_num;
+    receiver.join();
+    work.reset();
+    io_service.stop();
+    io_thread.join();
+  }
+  double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count() /
+                   1000000.0;
+
+  std::sort(latency.begin(), latency.end());
+  printf("%-8s %8zu %10.0f %10lu %10lu %10lu\n",
+         vote_lane == SendLane::kControl ? "control" : "bulk", latency.size(),
+         batch_num * kBatchSize / seconds / (1 << 20),
+         latency[latency.size() / 2], latency[latency.size() * 99 / 100],
+         latency.back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int vote_num = argc > 1 ? std::atoi(argv[1]) : 2000;
+  printf("%-8s %8s %10s %10s %10s %10s\n", "lane", "votes", "batch MB/s",
+         "p50(us)", "p99(us)", "max(us)");
+  Run(SendLane::kBulk, vote_num, 20100);
+  Run(SendLane::kControl, vote_num, 20101);
+  return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures sending frames to a replica on the same host through loopback
+// TCP, AsyncReplicaClient to AsyncAcceptor, and through the shared memory
+// rings, ShmReplicaClient to ShmAcceptor. The latency is from sending a
+// frame to its delivery, one frame at a time.
+
+#include <chrono>
+#include <condition_variable>
+
+#include "platform/networkstrate/shm_transport.h"
+
+using namespace resdb;
+
+namespace {
+
+uint64_t GetTimeNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+class Receiver {
+ public:
+  AsyncAcceptor::SliceCallBack GetCallBack() {
+    return [&](std::unique_ptr<DataInfo> frame) {
+      std::lock_guard<std::mutex> lk(mutex_);
+      received_++;
+      cv_.notify_all();
+    };
+  }
+
+  void Wait(uint64_t num) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait(lk, [&]() { return received_ >= num; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  uint64_t received_ = 0;
+};
+
+void Run(bool shm, size_t message_size, int message_num, int port) {
+  Receiver receiver;
+  std::unique_ptr<AsyncAcceptor> tcp_acceptor;
+  std::unique_ptr<ShmAcceptor> shm_acceptor;
+  if (shm) {
+    shm_acceptor = std::make_unique<ShmAcceptor>("127.0.0.1", port,
+                                                 receiver.GetCallBack());
+    shm_acceptor->Start();
+  } else {
+    tcp_acceptor = std::make_unique<AsyncAcceptor>("127.0.0.1", port, 1,
+                                                   receiver.GetCallBack());
+    tcp_acceptor->StartAccept();
+  }
+
+  boost::asio::io_service io_service;
+  auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+  std::thread io_thread([&]() { io_service.run(); });
+  {
+    std::unique_ptr<AsyncReplicaClient> client;
+    if (shm) {
+      client = std::make_unique<ShmReplicaClient>(&io_service, "127.0.0.1",
+                                                  port, kDefaultShmRingBytes);
+    } else {
+      client =
+          std::make_unique<AsyncReplicaClient>(&io_service, "127.0.0.1", port);
+    }
+    MessageBuffer data = NewMessageBuffer(std::string(message_size, 'd'));
+
+    int latency_num = std::min(message_num, 1000);
+    uint64_t start = GetTimeNs();
+    for (int i = 0; i < latency_num; ++i) {
+      client->SendMessage(data);
+      receiver.Wait(i + 1);
+    }
+    double latency_us = (GetTimeNs() - start) / 1000.0 / latency_num;
+
+    start = GetTimeNs();
+    for (int i = 0; i < message_num; ++i) {
+      client->SendMessage(data);
+    }
+    receiver.Wait(latency_num + message_num);
+    double seconds = (GetTimeNs() - start) / 1e9;
+    printf("%-4s %8zu %12.0f %10.1f %12.1f\n", shm ? "shm" : "tcp",
+           message_size, message_num / seconds,
+           message_num * message_size / seconds / (1 << 20), latency_us);
+    work.reset();
+    io_service.stop();
+    io_thread.join();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int message_num = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int port = 21000;
+  printf("%-4s %8s %12s %10s %12s\n", "link", "bytes", "msgs/s", "MB/s",
+         "latency(us)");
+  for (size_t message_size : {64, 512, 4096, 65536}) {
+    int num = message_size > 4096 ? message_num / 16 : message_num;
+    Run(false, message_size, num, port++);
+    Run(true, message_size, num, port++);
+  }
+  return 0;
+}
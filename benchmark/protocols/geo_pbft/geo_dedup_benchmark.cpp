@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures the dedup of geo requests with many worker threads. Every
+// (seq, region) key is checked by several threads, as a request arrives
+// from f+1 senders of its region, and is expected to be new only once.
+// The mutex-guarded ordered set used before is kept here for comparison.
+
+#include <glog/logging.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "platform/consensus/ordering/geo_pbft/hash_set.h"
+
+using namespace resdb;
+
+namespace {
+
+class LockedSet {
+ public:
+  bool CheckAndAdd(const std::string& key) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    bool result = set_.count(key);
+    set_.insert(key);
+    return result;
+  }
+
+ private:
+  std::set<std::string> set_;
+  std::mutex mutex_;
+};
+
+std::string GetKey(uint64_t seq, uint32_t region) {
+  std::string key(sizeof(seq) + sizeof(region), 0);
+  memcpy(&key[0], &seq, sizeof(seq));
+  memcpy(&key[sizeof(seq)], &region, sizeof(region));
+  return key;
+}
+
+template <typename Set>
+double Run(Set* set, int thread_num, uint64_t seq_num, uint32_t region_num,
+           int copy_num) {
+  std::atomic<uint64_t> new_num = 0;
+  std::vector<std::thread> threads;
+  auto start_time = std::chrono::steady_clock::now();
+  for (int t = 0; t < thread_num; ++t) {
+    threads.push_back(std::thread([&, t]() {
+      // Thread t takes every thread_num-th message; the copies of a key
+      // are spread over different threads.
+      uint64_t op_num = seq_num * region_num * copy_num;
+      uint64_t local_new_num = 0;
+      for (uint64_t i = t; i < op_num; i += thread_num) {
+        uint64_t key_id = i / copy_num;
+        if (!set->CheckAndAdd(
+                GetKey(key_id / region_num + 1, key_id % region_num))) {
+          local_new_num++;
+        }
+      }
+      new_num += local_new_num;
+    }));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  auto end_time = std::chrono::steady_clock::now();
+  if (new_num != seq_num * region_num) {
+    LOG(ERROR) << "unexpected new keys:" << new_num;
+  }
+  double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+                       end_time - start_time)
+                       .count() /
+                   1000000.0;
+  return seq_num * region_num * copy_num / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint64_t seq_num = argc > 1 ? std::atoll(argv[1]) : 200000;
+  uint32_t region_num = argc > 2 ? std::atoi(argv[2]) : 3;
+  int max_thread_num = argc > 3 ? std::atoi(argv[3]) : 32;
+  // f+1 copies with 4 replicas per region.
+  const int copy_num = 2;
+
+  printf("threads  locked_set(ops/s)  hash_set(ops/s)\n");
+  for (int thread_num = 1; thread_num <= max_thread_num; thread_num *= 2) {
+    LockedSet locked_set;
+    double locked_set_tput =
+        Run(&locked_set, thread_num, seq_num, region_num, copy_num);
+    ConcurrentHashSet hash_set(2 * seq_num * region_num, 1);
+    double hash_set_tput =
+        Run(&hash_set, thread_num, seq_num, region_num, copy_num);
+    printf("%7d  %17.0f  %15.0f\n", thread_num, locked_set_tput,
+           hash_set_tput);
+  }
+  return 0;
+}
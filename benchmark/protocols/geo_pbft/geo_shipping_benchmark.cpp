@@ -0,0 +1,373 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures the cross-region shipping of GeoTransactionExecutor. The primary
+// of region 1 ships its committed batches to the other regions through a
+// modeled WAN link per region with a fixed one-way latency and bandwidth;
+// a sender blocks while its link is busy. The receivers verify the
+// certificates of every bundle. Each bundle size is run with per-batch
+// certificates and with one aggregate certificate per bundle.
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "common/crypto/threshold_signature.h"
+#include "executor/common/transaction_manager.h"
+#include "platform/config/resdb_config_utils.h"
+#include "platform/consensus/execution/geo_transaction_executor.h"
+
+using namespace resdb;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class Receiver {
+ public:
+  Receiver(int seq_num, const ThresholdPublicKey& public_key)
+      : verifier_(public_key), received_(seq_num + 1) {}
+
+  void OnBundle(const std::string& data, Clock::time_point now,
+                const std::vector<Clock::time_point>& start_time) {
+    GeoBundle bundle;
+    if (!bundle.ParseFromString(data)) {
+      LOG(ERROR) << "parse geo bundle fail";
+      return;
+    }
+    std::vector<std::string> hashes;
+    for (const Request& request : bundle.requests()) {
+      BatchUserRequest batch;
+      if (!batch.ParseFromString(request.data())) {
+        LOG(ERROR) << "parse batch fail";
+        return;
+      }
+      if (!bundle.has_aggregate_cert() &&
+          !verifier_.Verify(batch.hash(),
+                            batch.committed_certs().quorum_cert())) {
+        LOG(ERROR) << "verify cert fail";
+        return;
+      }
+      hashes.push_back(batch.hash());
+    }
+    if (bundle.has_aggregate_cert() &&
+        !verifier_.VerifyAggregate(hashes, bundle.aggregate_cert())) {
+      LOG(ERROR) << "verify aggregate cert fail";
+      return;
+    }
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (const Request& request : bundle.requests()) {
+      uint64_t seq = request.seq();
+      if (seq >= received_.size() || received_[seq]) {
+        continue;
+      }
+      received_[seq] = true;
+      latency_.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                             now - start_time[seq])
+                             .count());
+    }
+    cv_.notify_all();
+  }
+
+  void WaitForAll() {
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait(lk, [&] { return latency_.size() + 1 == received_.size(); });
+  }
+
+  std::vector<uint64_t> GetLatency() { return latency_; }
+
+ private:
+  ThresholdSignature verifier_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<bool> received_;
+  std::vector<uint64_t> latency_;
+};
+
+// One link from region 1 to a remote region. The bundles are serialized on
+// the link at the given bandwidth and delivered after the latency.
+class Link {
+ public:
+  Link(Receiver* receiver, const std::vector<Clock::time_point>* start_time,
+       int latency_ms, double bandwidth_mbps)
+      : receiver_(receiver),
+        start_time_(start_time),
+        latency_(std::chrono::milliseconds(latency_ms)),
+        bandwidth_mbps_(bandwidth_mbps),
+        free_time_(Clock::now()) {
+    delivery_thread_ = std::thread(&Link::Deliver, this);
+  }
+
+  ~Link() {
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    delivery_thread_.join();
+  }
+
+  void Send(std::string data) {
+    auto transfer_time = std::chrono::microseconds(
+        static_cast<int64_t>(data.size() * 8 / bandwidth_mbps_));
+    Clock::time_point done_time;
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      free_time_ = std::max(free_time_, Clock::now()) + transfer_time;
+      done_time = free_time_;
+      bytes_ += data.size();
+    }
+    std::this_thread::sleep_until(done_time);
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      in_flight_.push_back(std::make_pair(done_time + latency_, data));
+    }
+    cv_.notify_all();
+  }
+
+  uint64_t GetBytes() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return bytes_;
+  }
+
+ private:
+  void Deliver() {
+    while (true) {
+      std::pair<Clock::time_point, std::string> message;
+      {
+        std::unique_lock<std::mutex> lk(mutex_);
+        cv_.wait(lk, [&] { return stop_ || !in_flight_.empty(); });
+        if (stop_) {
+          return;
+        }
+        message = std::move(in_flight_.front());
+        in_flight_.pop_front();
+      }
+      std::this_thread::sleep_until(message.first);
+      receiver_->OnBundle(message.second, Clock::now(), *start_time_);
+    }
+  }
+
+ private:
+  Receiver* receiver_;
+  const std::vector<Clock::time_point>* start_time_;
+  Clock::duration latency_;
+  double bandwidth_mbps_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  Clock::time_point free_time_;
+  std::deque<std::pair<Clock::time_point, std::string>> in_flight_;
+  uint64_t bytes_ = 0;
+  bool stop_ = false;
+  std::thread delivery_thread_;
+};
+
+class WanReplicaCommunicator : public ReplicaCommunicator {
+ public:
+  WanReplicaCommunicator(std::map<int64_t, Link*> links)
+      : ReplicaCommunicator({}), links_(std::move(links)) {}
+
+  // The batches sent to the primary itself are not measured.
+  int SendBatchMessage(const std::vector<std::unique_ptr<Request>>& messages,
+                       const ReplicaInfo& replica_info) override {
+    return 0;
+  }
+
+  int SendMessage(const google::protobuf::Message& message,
+                  const ReplicaInfo& replica_info) override {
+    auto it = links_.find(replica_info.id());
+    if (it == links_.end()) {
+      return -1;
+    }
+    const Request& request = dynamic_cast<const Request&>(message);
+    it->second->Send(request.data());
+    return 0;
+  }
+
+ private:
+  std::map<int64_t, Link*> links_;
+};
+
+class NoopTransactionManager : public TransactionManager {};
+
+struct Result {
+  double throughput;
+  double mean_latency_ms;
+  double p99_latency_ms;
+  double bytes_per_seq;
+};
+
+Result Run(const ResConfigData& config_data,
+           const ThresholdPublicKey& public_key, int seq_num, int latency_ms,
+           double bandwidth_mbps,
+           const std::vector<BatchUserRequest>& batches) {
+  ReplicaInfo self_info = GenerateReplicaInfo(1, "127.0.0.1", 10001);
+  ResDBConfig config(config_data, self_info, KeyInfo(), CertificateInfo());
+
+  std::vector<Clock::time_point> start_time(seq_num + 1);
+  std::vector<std::unique_ptr<Receiver>> receivers;
+  std::vector<std::unique_ptr<Link>> links;
+  std::map<int64_t, Link*> replica_links;
+  for (const auto& region : config_data.region()) {
+    if (region.region_id() == config_data.self_region_id()) {
+      continue;
+    }
+    receivers.push_back(std::make_unique<Receiver>(seq_num, public_key));
+    links.push_back(std::make_unique<Link>(
+        receivers.back().get(), &start_time, latency_ms, bandwidth_mbps));
+    for (const auto& replica : region.replica_info()) {
+      replica_links[replica.id()] = links.back().get();
+    }
+  }
+
+  auto system_info = std::make_unique<SystemInfo>(config);
+  system_info->SetPrimary(self_info.id());
+  GeoTransactionExecutor executor(
+      config, std::move(system_info),
+      std::make_unique<WanReplicaCommunicator>(replica_links),
+      std::make_unique<NoopTransactionManager>());
+
+  auto begin = Clock::now();
+  for (int seq = 1; seq <= seq_num; ++seq) {
+    BatchUserRequest batch = batches[seq % batches.size()];
+    batch.set_seq(seq);
+    start_time[seq] = Clock::now();
+    executor.ExecuteBatch(batch);
+  }
+  std::vector<uint64_t> latency;
+  for (auto& receiver : receivers) {
+    receiver->WaitForAll();
+    std::vector<uint64_t> list = receiver->GetLatency();
+    latency.insert(latency.end(), list.begin(), list.end());
+  }
+  double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+                       Clock::now() - begin)
+                       .count() /
+                   1000000.0;
+  uint64_t bytes = 0;
+  for (auto& link : links) {
+    bytes += link->GetBytes();
+  }
+
+  std::sort(latency.begin(), latency.end());
+  double total_latency = 0;
+  for (uint64_t l : latency) {
+    total_latency += l;
+  }
+  Result result;
+  result.throughput = seq_num / seconds;
+  result.mean_latency_ms = total_latency / latency.size() / 1000;
+  result.p99_latency_ms = latency[latency.size() * 99 / 100] / 1000.0;
+  result.bytes_per_seq = static_cast<double>(bytes) / seq_num / links.size();
+  return result;
+}
+
+// Certified batches of region 1, reused for all the seqs.
+std::vector<BatchUserRequest> GenerateBatches(
+    const std::vector<ThresholdKeyShare>& key_shares, uint32_t threshold,
+    int batch_num, int request_size) {
+  std::vector<BatchUserRequest> batches;
+  for (int i = 0; i < batch_num; ++i) {
+    BatchUserRequest batch;
+    batch.add_user_requests()->mutable_request()->set_data(
+        std::string(request_size, 'a' + i % 26));
+    batch.set_hash(SignatureVerifier::CalculateHash(batch.SerializeAsString()));
+
+    std::vector<SignatureInfo> shares;
+    for (uint32_t j = 0; j < threshold; ++j) {
+      auto share = ThresholdSignature(key_shares[j]).SignShare(batch.hash());
+      if (!share.ok()) {
+        LOG(FATAL) << "sign share fail:" << share.status();
+      }
+      shares.push_back(*share);
+    }
+    std::vector<const SignatureInfo*> share_ptrs;
+    for (const auto& share : shares) {
+      share_ptrs.push_back(&share);
+    }
+    auto cert = ThresholdSignature(key_shares[0].public_key())
+                    .Combine(batch.hash(), share_ptrs);
+    if (!cert.ok()) {
+      LOG(FATAL) << "combine fail:" << cert.status();
+    }
+    *batch.mutable_committed_certs()->mutable_quorum_cert() = *cert;
+    batches.push_back(std::move(batch));
+  }
+  return batches;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int seq_num = argc > 1 ? std::atoi(argv[1]) : 2000;
+  int region_num = argc > 2 ? std::atoi(argv[2]) : 3;
+  int latency_ms = argc > 3 ? std::atoi(argv[3]) : 50;
+  double bandwidth_mbps = argc > 4 ? std::atof(argv[4]) : 100;
+  int request_size = argc > 5 ? std::atoi(argv[5]) : 512;
+
+  const uint32_t replica_num = 4, threshold = 3;
+  auto key_shares = ThresholdSignature::GenerateKeys(replica_num, threshold);
+  if (!key_shares.ok()) {
+    LOG(ERROR) << "generate keys fail:" << key_shares.status();
+    return -1;
+  }
+  std::vector<BatchUserRequest> batches =
+      GenerateBatches(*key_shares, threshold, 16, request_size);
+
+  ResConfigData config_data;
+  config_data.set_self_region_id(1);
+  for (int i = 1; i <= region_num; ++i) {
+    RegionInfo* region = config_data.add_region();
+    region->set_region_id(i);
+    for (uint32_t j = 1; j <= replica_num; ++j) {
+      int id = (i - 1) * replica_num + j;
+      *region->add_replica_info() =
+          GenerateReplicaInfo(id, "127.0.0.1", 10000 + id);
+    }
+  }
+
+  printf(
+      "bundle  cert       seq/s   mean_lat(ms)  p99_lat(ms)  bytes/seq\n");
+  for (int bundle_size : {1, 10, 50}) {
+    for (bool aggregate : {false, true}) {
+      config_data.set_geo_bundle_size(bundle_size);
+      if (aggregate) {
+        *config_data.mutable_region(0)->mutable_threshold_public_key() =
+            (*key_shares)[0].public_key();
+      } else {
+        config_data.mutable_region(0)->clear_threshold_public_key();
+      }
+      // The receivers always hold the public key of region 1.
+      Result result = Run(config_data, (*key_shares)[0].public_key(), seq_num,
+                          latency_ms, bandwidth_mbps, batches);
+      printf("%6d  %-9s  %6.0f  %12.1f  %11.1f  %9.0f\n", bundle_size,
+             aggregate ? "aggregate" : "per-batch", result.throughput,
+             result.mean_latency_ms, result.p99_latency_ms,
+             result.bytes_per_seq);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,383 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Runs a LinearPBFT cluster and a PBFT cluster of n replicas in one process
+// and reports the messages and bytes sent per transaction as n grows. Both
+// clusters deliver their messages through a queue and count them the same
+// way: a broadcast counts one message per replica, including the sender,
+// and every message is serialized as it would be on the wire, without the
+// envelope added by the transport. The PBFT replicas run the commitment of
+// the pbft ordering with a verifier accepting every batch; the checkpoint
+// messages are not counted. Compare the throughput of real clusters with the
+// kv_server_performance binaries of pbft and linear_pbft.
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+
+#include "common/crypto/signature_verifier.h"
+#include "executor/common/transaction_manager.h"
+#include "platform/config/resdb_config_utils.h"
+#include "platform/consensus/ordering/linear_pbft/algorithm/linear_pbft.h"
+#include "platform/consensus/ordering/pbft/checkpoint_manager.h"
+#include "platform/consensus/ordering/pbft/commitment.h"
+#include "platform/consensus/ordering/pbft/message_manager.h"
+#include "platform/networkstrate/replica_communicator.h"
+
+using namespace resdb;
+using namespace resdb::linear_pbft;
+
+namespace {
+
+constexpr int kWaitTimeoutSec = 60;
+
+void ShowUsage() {
+  printf("[txn num, default 100] [threshold key bits, default 2048, 0 to "
+         "disable]\n");
+}
+
+struct Message {
+  int type;
+  std::string data;
+  int to;
+};
+
+struct Result {
+  uint64_t message_num = 0;
+  uint64_t bytes = 0;
+  uint64_t committed = 0;
+  double seconds = 0;
+};
+
+Result RunLinearPBFT(int n, int txn_num, int key_bits) {
+  std::deque<Message> queue;
+  std::vector<std::unique_ptr<ThresholdSignature>> signatures;
+  std::vector<std::unique_ptr<LinearPBFT>> replicas;
+  Result result;
+
+  std::vector<ThresholdKeyShare> keys;
+  if (key_bits > 0) {
+    auto keys_or =
+        ThresholdSignature::GenerateKeys(n, 2 * ((n - 1) / 3) + 1, key_bits);
+    if (!keys_or.ok()) {
+      LOG(ERROR) << "generate threshold keys fail:" << keys_or.status();
+      return result;
+    }
+    keys = std::move(*keys_or);
+  }
+
+  for (int i = 1; i <= n; ++i) {
+    if (!keys.empty()) {
+      signatures.push_back(std::make_unique<ThresholdSignature>(keys[i - 1]));
+    }
+    auto replica = std::make_unique<LinearPBFT>(
+        i, (n - 1) / 3, n, nullptr,
+        keys.empty() ? nullptr : signatures.back().get());
+    replica->SetSingleCallFunc(
+        [&](int type, const google::protobuf::Message& msg, int to) {
+          queue.push_back({type, msg.SerializeAsString(), to});
+          return 0;
+        });
+    replica->SetBroadcastCallFunc(
+        [&](int type, const google::protobuf::Message& msg) {
+          std::string data = msg.SerializeAsString();
+          for (int j = 1; j <= n; ++j) {
+            queue.push_back({type, data, j});
+          }
+          return 0;
+        });
+    replica->SetCommitFunc([&](const google::protobuf::Message& msg) {
+      result.committed++;
+      return 0;
+    });
+    replicas.push_back(std::move(replica));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < txn_num; ++i) {
+    auto txn = std::make_unique<Transaction>();
+    txn->set_data(std::string(128, 'a' + i % 26));
+    txn->set_hash("hash_" + std::to_string(i));
+    replicas[0]->ReceiveTransaction(std::move(txn));
+
+    while (!queue.empty()) {
+      Message msg = std::move(queue.front());
+      queue.pop_front();
+      result.message_num++;
+      result.bytes += msg.data.size();
+      LinearPBFT* replica = replicas[msg.to - 1].get();
+      switch (msg.type) {
+        case MessageType::Propose: {
+          auto txn = std::make_unique<Transaction>();
+          txn->ParseFromString(msg.data);
+          replica->ReceivePropose(std::move(txn));
+          break;
+        }
+        case MessageType::PrepareVote:
+        case MessageType::CommitVote: {
+          auto vote = std::make_unique<Vote>();
+          vote->ParseFromString(msg.data);
+          replica->ReceiveVote(msg.type, std::move(vote));
+          break;
+        }
+        case MessageType::PrepareCert:
+        case MessageType::CommitCert: {
+          auto cert = std::make_unique<Certificate>();
+          cert->ParseFromString(msg.data);
+          replica->ReceiveCertificate(std::move(cert));
+          break;
+        }
+      }
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+// Accepts the batches of the proxy, the PBFT run only counts the messages.
+class AcceptAllVerifier : public SignatureVerifier {
+ public:
+  AcceptAllVerifier() : SignatureVerifier(KeyInfo(), CertificateInfo()) {}
+
+  bool VerifyMessage(const std::string& message,
+                     const SignatureInfo& sign) override {
+    return true;
+  }
+};
+
+// Counts the batches executed by a replica.
+class CountingExecutor : public TransactionManager {
+ public:
+  explicit CountingExecutor(std::atomic<uint64_t>* committed)
+      : TransactionManager(false, false), committed_(committed) {}
+
+  std::unique_ptr<BatchUserResponse> ExecuteBatch(
+      const BatchUserRequest& request) override {
+    (*committed_)++;
+    return std::make_unique<BatchUserResponse>();
+  }
+
+ private:
+  std::atomic<uint64_t>* committed_;
+};
+
+// Queues the messages of all the PBFT replicas instead of sending them.
+// The checkpoints and the responses are sent from the threads of the
+// replicas, so the queue is locked.
+class QueueCommunicator : public ReplicaCommunicator {
+ public:
+  QueueCommunicator(const std::vector<ReplicaInfo>& replicas)
+      : ReplicaCommunicator(replicas), n_(replicas.size()) {}
+
+  int SendMessage(const google::protobuf::Message& message) override {
+    std::string data = message.SerializeAsString();
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (int i = 1; i <= n_; ++i) {
+      queue_.push_back({0, data, i});
+    }
+    return 0;
+  }
+
+  int SendMessage(const google::protobuf::Message& message,
+                  const ReplicaInfo& replica_info) override {
+    SendMessage(message, replica_info.id());
+    return 0;
+  }
+
+  void BroadCast(const google::protobuf::Message& message) override {
+    SendMessage(message);
+  }
+
+  void SendMessage(const google::protobuf::Message& message,
+                   int64_t node_id) override {
+    if (node_id < 1 || node_id > n_) {
+      return;
+    }
+    std::lock_guard<std::mutex> lk(mutex_);
+    queue_.push_back(
+        {0, message.SerializeAsString(), static_cast<int>(node_id)});
+  }
+
+  bool Pop(Message* msg) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (queue_.empty()) {
+      return false;
+    }
+    *msg = std::move(queue_.front());
+    queue_.pop_front();
+    return true;
+  }
+
+ private:
+  int n_;
+  std::mutex mutex_;
+  std::deque<Message> queue_;
+};
+
+struct PBFTReplica {
+  PBFTReplica(const ResDBConfig& replica_config,
+              ReplicaCommunicator* communicator, SignatureVerifier* verifier,
+              std::atomic<uint64_t>* committed)
+      : config(replica_config),
+        system_info(config),
+        checkpoint_manager(config, communicator, verifier, &system_info),
+        message_manager(config, std::make_unique<CountingExecutor>(committed),
+                        &checkpoint_manager, &system_info),
+        commitment(config, &message_manager, communicator, verifier) {}
+
+  ResDBConfig config;
+  SystemInfo system_info;
+  CheckPointManager checkpoint_manager;
+  MessageManager message_manager;
+  Commitment commitment;
+};
+
+std::unique_ptr<Context> GetContext(int sender_id) {
+  auto context = std::make_unique<Context>();
+  context->signature.set_node_id(sender_id);
+  context->signature.set_signature("signature");
+  return context;
+}
+
+Result RunPBFT(int n, int txn_num) {
+  std::vector<ReplicaInfo> infos;
+  for (int i = 1; i <= n; ++i) {
+    infos.push_back(GenerateReplicaInfo(i, "127.0.0.1", 40000 + i));
+  }
+  AcceptAllVerifier verifier;
+  QueueCommunicator communicator(infos);
+  std::atomic<uint64_t> committed = 0;
+  std::vector<std::unique_ptr<PBFTReplica>> replicas;
+  for (int i = 1; i <= n; ++i) {
+    ResConfigData data;
+    data.set_not_need_signature(true);
+    replicas.push_back(std::make_unique<PBFTReplica>(
+        ResDBConfig(infos, infos[i - 1], data), &communicator, &verifier,
+        &committed));
+  }
+
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < txn_num; ++i) {
+    BatchUserRequest batch;
+    batch.add_user_requests()->mutable_request()->set_data(
+        std::string(128, 'a' + i % 26));
+    Request request;
+    request.set_type(Request::TYPE_NEW_TXNS);
+    request.set_hash("hash_" + std::to_string(i));
+    batch.SerializeToString(request.mutable_data());
+    // The primary refuses new seqs while too many are not executed.
+    while (replicas[0]->commitment.ProcessNewRequest(
+               GetContext(0), std::make_unique<Request>(request)) != 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    Message msg;
+    while (communicator.Pop(&msg)) {
+      auto request = std::make_unique<Request>();
+      request->ParseFromString(msg.data);
+      Commitment* commitment = &replicas[msg.to - 1]->commitment;
+      auto context = GetContext(request->sender_id());
+      switch (request->type()) {
+        case Request::TYPE_PRE_PREPARE:
+          commitment->ProcessProposeMsg(std::move(context), std::move(request));
+          break;
+        case Request::TYPE_PREPARE:
+          commitment->ProcessPrepareMsg(std::move(context), std::move(request));
+          break;
+        case Request::TYPE_COMMIT:
+          commitment->ProcessCommitMsg(std::move(context), std::move(request));
+          break;
+        default:
+          continue;
+      }
+      result.message_num++;
+      result.bytes += msg.data.size();
+    }
+  }
+  // The batches are executed by the threads of the replicas.
+  auto deadline = start + std::chrono::seconds(kWaitTimeoutSec);
+  while (committed < static_cast<uint64_t>(n) * txn_num &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  result.committed = committed;
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  // Each replica waits for its threads to stop, stop them together.
+  std::vector<std::thread> stop_threads;
+  for (auto& replica : replicas) {
+    stop_threads.push_back(
+        std::thread([replica = std::move(replica)]() mutable {
+          replica = nullptr;
+        }));
+  }
+  for (auto& th : stop_threads) {
+    th.join();
+  }
+  return result;
+}
+
+void CheckCommitted(const char* name, int n, int txn_num,
+                    const Result& result) {
+  if (result.committed != static_cast<uint64_t>(n) * txn_num) {
+    printf("%s n=%d committed %lu of %lu\n", name, n, result.committed,
+           static_cast<uint64_t>(n) * txn_num);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int txn_num = 100;
+  int key_bits = 2048;
+  if (argc > 1) {
+    txn_num = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    key_bits = atoi(argv[2]);
+  }
+  if (txn_num <= 0 || key_bits < 0) {
+    ShowUsage();
+    return 0;
+  }
+
+  printf("%6s %14s %14s %14s %14s %14s\n", "n", "linear msg/txn",
+         "pbft msg/txn", "linear B/txn", "pbft B/txn", "linear txn/s");
+  for (int n : {4, 7, 16, 31, 64, 100}) {
+    Result linear = RunLinearPBFT(n, txn_num, key_bits);
+    CheckCommitted("linear pbft", n, txn_num, linear);
+    Result pbft = RunPBFT(n, txn_num);
+    CheckCommitted("pbft", n, txn_num, pbft);
+    printf("%6d %14.1f %14.1f %14.1f %14.1f %14.0f\n", n,
+           static_cast<double>(linear.message_num) / txn_num,
+           static_cast<double>(pbft.message_num) / txn_num,
+           static_cast<double>(linear.bytes) / txn_num,
+           static_cast<double>(pbft.bytes) / txn_num,
+           txn_num / linear.seconds);
+  }
+  return 0;
+}
@@ -0,0 +1,477 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Runs a cluster of n PBFT replicas in one process and measures the
+// throughput and the latency of the ordering apart from the kernel network.
+// The replicas are linked by the in-process transport, by the simulated
+// network with the given link latency, bandwidth and loss, or by TCP. The
+// benchmark is the proxy of the client batches: it proposes each batch to
+// the primary and waits for f+1 matching responses, keeping a window of
+// batches in flight. The keys are generated at start, no config files are
+// needed.
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <set>
+#include <thread>
+
+#include "common/crypto/key_generator.h"
+#include "common/crypto/signature_verifier.h"
+#include "common/utils/utils.h"
+#include "executor/common/transaction_manager.h"
+#include "platform/consensus/ordering/pbft/consensus_manager_pbft.h"
+#include "platform/consensus/ordering/pbft/transaction_utils.h"
+#include "platform/networkstrate/service_network.h"
+#include "platform/networkstrate/simulated_transport.h"
+#include "platform/networkstrate/tcp_transport.h"
+#include "platform/proto/broadcast.pb.h"
+
+using namespace resdb;
+
+namespace {
+
+// The replicas listen to the clients on kPortBase + id and to the other
+// replicas 10000 above.
+constexpr int kPortBase = 31000;
+constexpr int kWaitTimeoutSec = 30;
+
+uint64_t GetTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Options {
+  int replica_num = 4;
+  // inproc, sim or tcp.
+  std::string network = "inproc";
+  int batch_num = 2000;
+  int batch_size = 100;
+  int window = 32;
+  SimulatedTransport::LinkOptions link;
+};
+
+struct NodeKey {
+  KeyInfo private_key;
+  CertificateInfo certificate;
+};
+
+// Issues the certificates of the nodes signed by one administrator key.
+class CertificateAuthority {
+ public:
+  CertificateAuthority() {
+    SecretKey admin_key = KeyGenerator::GeneratorKeys(SignatureInfo::ED25519);
+    admin_private_key_.set_key(admin_key.private_key());
+    admin_private_key_.set_hash_type(admin_key.hash_type());
+    admin_public_key_.set_key(admin_key.public_key());
+    admin_public_key_.set_hash_type(admin_key.hash_type());
+    CertificateInfo admin_certificate;
+    *admin_certificate.mutable_admin_public_key() = admin_public_key_;
+    admin_verifier_ = std::make_unique<SignatureVerifier>(admin_private_key_,
+                                                          admin_certificate);
+  }
+
+  int Issue(const ReplicaInfo& info, CertificateKeyInfo::Type type,
+            NodeKey* node_key) {
+    SecretKey key = KeyGenerator::GeneratorKeys(SignatureInfo::ED25519);
+    node_key->private_key.set_key(key.private_key());
+    node_key->private_key.set_hash_type(key.hash_type());
+
+    CertificateInfo& certificate = node_key->certificate;
+    *certificate.mutable_admin_public_key() = admin_public_key_;
+    certificate.set_node_id(info.id());
+    CertificateKeyInfo* key_info =
+        certificate.mutable_public_key()->mutable_public_key_info();
+    key_info->mutable_key()->set_key(key.public_key());
+    key_info->mutable_key()->set_hash_type(key.hash_type());
+    key_info->set_node_id(info.id());
+    key_info->set_type(type);
+    key_info->set_ip(info.ip());
+    key_info->set_port(info.port());
+    auto signature = admin_verifier_->SignCertificateKeyInfo(*key_info);
+    if (!signature.ok()) {
+      LOG(ERROR) << "sign certificate of node " << info.id()
+                 << " fail: " << signature.status();
+      return -1;
+    }
+    *certificate.mutable_public_key()->mutable_certificate() = *signature;
+    return 0;
+  }
+
+ private:
+  KeyInfo admin_private_key_, admin_public_key_;
+  std::unique_ptr<SignatureVerifier> admin_verifier_;
+};
+
+// Executes nothing, only the ordering is measured.
+class NullExecutor : public TransactionManager {
+ public:
+  std::unique_ptr<std::string> ExecuteData(
+      const std::string& request) override {
+    return std::make_unique<std::string>();
+  }
+};
+
+ReplicaInfo GetNodeInfo(int id) {
+  ReplicaInfo info;
+  info.set_id(id);
+  info.set_ip("127.0.0.1");
+  info.set_port(kPortBase + id);
+  return info;
+}
+
+// The transport of one node, nullptr for the default TCP transport.
+std::shared_ptr<Transport> GetTransport(
+    const Options& options, std::shared_ptr<InProcessTransport> network,
+    int id) {
+  if (options.network == "sim") {
+    return std::make_shared<SimulatedTransport>(network, options.link, id);
+  }
+  if (options.network == "inproc") {
+    return network;
+  }
+  return nullptr;
+}
+
+// Proposes the batches to the primary as the proxy of the clients and
+// collects the responses of the replicas.
+class Proxy {
+ public:
+  Proxy(const std::vector<ReplicaInfo>& replicas, const ReplicaInfo& self_info,
+        const NodeKey& key, std::shared_ptr<Transport> transport)
+      : replicas_(replicas),
+        self_info_(self_info),
+        key_(key),
+        min_response_num_((replicas.size() - 1) / 3 + 1),
+        verifier_(key.private_key, key.certificate),
+        transport_(std::move(transport)) {
+    listener_ = transport_->Listen(
+        self_info_.ip(), self_info_.port() + 10000,
+        [&](std::unique_ptr<DataInfo> frame) { OnFrame(std::move(frame)); });
+    assert(listener_ != nullptr);
+    communicator_ = std::make_unique<ReplicaCommunicator>(
+        replicas_, &verifier_, true, 1, 1, 0, nullptr, 0, transport_);
+  }
+
+  ~Proxy() {
+    communicator_ = nullptr;
+    listener_ = nullptr;
+  }
+
+  // Sends the key of the proxy to the replicas so that they verify the
+  // batches and send the responses back.
+  void Register() {
+    HeartBeatInfo hb_info;
+    hb_info.set_sender(self_info_.id());
+    *hb_info.add_public_keys() = key_.certificate.public_key();
+    Request request;
+    request.set_type(Request::TYPE_HEART_BEAT);
+    hb_info.SerializeToString(request.mutable_data());
+    communicator_->SendHeartBeat(request);
+  }
+
+  // Returns false if the batches are not committed in time.
+  bool Run(const Options& options) {
+    uint64_t start_time = GetTimeUs();
+    for (int i = 0; i < options.batch_num; ++i) {
+      {
+        std::unique_lock<std::mutex> lk(mutex_);
+        if (!cv_.wait_for(lk, std::chrono::seconds(kWaitTimeoutSec), [&]() {
+              return static_cast<int>(pending_.size()) < options.window;
+            })) {
+          return false;
+        }
+      }
+      std::unique_ptr<Request> request =
+          GenerateBatch(i, options.batch_size);
+      if (request == nullptr) {
+        return false;
+      }
+      {
+        std::lock_guard<std::mutex> lk(mutex_);
+        pending_[i] = {request->hash(), GetTimeUs()};
+      }
+      communicator_->SendMessage(*request, replicas_[0]);
+    }
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (!cv_.wait_for(lk, std::chrono::seconds(kWaitTimeoutSec),
+                      [&]() { return pending_.empty(); })) {
+      return false;
+    }
+    run_time_us_ = GetTimeUs() - start_time;
+    return true;
+  }
+
+  void Report(const Options& options) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    std::sort(latencies_.begin(), latencies_.end());
+    uint64_t total = 0;
+    for (uint64_t latency : latencies_) {
+      total += latency;
+    }
+    size_t num = std::max<size_t>(latencies_.size(), 1);
+    auto percentile = [&](double p) {
+      return latencies_.empty()
+                 ? 0
+                 : latencies_[std::min(latencies_.size() - 1,
+                                       size_t(latencies_.size() * p))] /
+                       1000.0;
+    };
+    printf("%-7s %8d %8d %8d %12.0f %10.2f %10.2f %10.2f\n",
+           options.network.c_str(), options.replica_num, options.batch_size,
+           failed_num_,
+           latencies_.size() * options.batch_size * 1e6 /
+               std::max<uint64_t>(run_time_us_, 1),
+           total / 1000.0 / num, percentile(0.5), percentile(0.99));
+  }
+
+ private:
+  std::unique_ptr<Request> GenerateBatch(int id, int batch_size) {
+    BatchUserRequest batch_request;
+    for (int i = 0; i < batch_size; ++i) {
+      BatchUserRequest::UserRequest* user_request =
+          batch_request.add_user_requests();
+      user_request->mutable_request()->set_data(
+          "request_" + std::to_string(id) + "_" + std::to_string(i));
+      user_request->set_id(i);
+    }
+    batch_request.set_createtime(GetCurrentTime());
+    batch_request.set_local_id(id);
+
+    auto request =
+        NewRequest(Request::TYPE_NEW_TXNS, Request(), self_info_.id());
+    batch_request.SerializeToString(request->mutable_data());
+    auto signature = verifier_.SignMessage(request->data());
+    if (!signature.ok()) {
+      LOG(ERROR) << "sign batch " << id << " fail: " << signature.status();
+      return nullptr;
+    }
+    *request->mutable_data_signature() = *signature;
+    request->set_hash(SignatureVerifier::CalculateHash(request->data()));
+    request->set_proxy_id(self_info_.id());
+    return request;
+  }
+
+  // The part of a response the replicas agree on, their create times and
+  // views may differ.
+  static std::string GetResult(const BatchUserResponse& batch_response) {
+    BatchUserResponse result;
+    *result.mutable_response() = batch_response.response();
+    result.set_seq(batch_response.seq());
+    result.set_local_id(batch_response.local_id());
+    return result.SerializeAsString();
+  }
+
+  void OnFrame(std::unique_ptr<DataInfo> frame) {
+    BroadcastData broadcast_data;
+    if (!broadcast_data.ParseFromArray(frame->buff, frame->data_len)) {
+      LOG(ERROR) << "parse broadcast data fail";
+      return;
+    }
+    for (const auto& data : broadcast_data.data()) {
+      ResDBMessage message;
+      Request response;
+      if (!message.ParseFromString(data) ||
+          !response.ParseFromString(message.data()) ||
+          response.type() != Request::TYPE_RESPONSE) {
+        continue;
+      }
+      // The executed batches are answered by their local id, the ones
+      // failing to get a sequence by their hash.
+      BatchUserResponse batch_response;
+      if (response.ret() != -2 &&
+          !batch_response.ParseFromString(response.data())) {
+        continue;
+      }
+      std::lock_guard<std::mutex> lk(mutex_);
+      auto it = response.ret() == -2
+                    ? std::find_if(pending_.begin(), pending_.end(),
+                                   [&](const auto& batch) {
+                                     return batch.second.hash ==
+                                            response.hash();
+                                   })
+                    : pending_.find(batch_response.local_id());
+      if (it == pending_.end()) {
+        continue;
+      }
+      if (response.ret() == -2) {
+        failed_num_++;
+      } else {
+        std::set<int32_t>& senders =
+            it->second.senders[GetResult(batch_response)];
+        senders.insert(response.sender_id());
+        if (senders.size() < min_response_num_) {
+          continue;
+        }
+        latencies_.push_back(GetTimeUs() - it->second.send_time);
+      }
+      pending_.erase(it);
+      cv_.notify_all();
+    }
+  }
+
+ private:
+  struct Batch {
+    std::string hash;
+    uint64_t send_time;
+    // The replicas sending each result.
+    std::map<std::string, std::set<int32_t>> senders;
+  };
+
+  std::vector<ReplicaInfo> replicas_;
+  ReplicaInfo self_info_;
+  NodeKey key_;
+  size_t min_response_num_;
+  SignatureVerifier verifier_;
+  std::shared_ptr<Transport> transport_;
+  std::unique_ptr<TransportListener> listener_;
+  std::unique_ptr<ReplicaCommunicator> communicator_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<uint64_t, Batch> pending_;
+  std::vector<uint64_t> latencies_;
+  int failed_num_ = 0;
+  uint64_t run_time_us_ = 0;
+};
+
+int Run(const Options& options) {
+  auto network = std::make_shared<InProcessTransport>();
+  CertificateAuthority authority;
+
+  std::vector<ReplicaInfo> replicas;
+  ResConfigData config_data;
+  RegionInfo* region = config_data.add_region();
+  for (int i = 1; i <= options.replica_num; ++i) {
+    replicas.push_back(GetNodeInfo(i));
+    *region->add_replica_info() = replicas.back();
+  }
+
+  std::vector<NodeKey> keys(replicas.size());
+  for (size_t i = 0; i < replicas.size(); ++i) {
+    if (authority.Issue(replicas[i], CertificateKeyInfo::REPLICA, &keys[i]) !=
+        0) {
+      return 1;
+    }
+  }
+
+  std::vector<std::unique_ptr<ServiceNetwork>> servers;
+  std::vector<std::thread> server_threads;
+  for (size_t i = 0; i < replicas.size(); ++i) {
+    const ReplicaInfo& replica = replicas[i];
+    ResDBConfig config(config_data, replica, keys[i].private_key,
+                       keys[i].certificate);
+    config.SetTransport(GetTransport(options, network, replica.id()));
+    // Keeps sending the heartbeats every second, the replicas stop in time.
+    config.SetTestMode(true);
+    servers.push_back(std::make_unique<ServiceNetwork>(
+        config, std::make_unique<ConsensusManagerPBFT>(
+                    config, std::make_unique<NullExecutor>())));
+    server_threads.push_back(std::thread(
+        [](ServiceNetwork* server) { server->Run(); }, servers.back().get()));
+  }
+  // The replicas are ready once they have exchanged their keys.
+  for (auto& server : servers) {
+    while (!server->ServiceIsReady()) {
+      usleep(10000);
+    }
+  }
+
+  ReplicaInfo proxy_info = GetNodeInfo(options.replica_num + 1);
+  std::shared_ptr<Transport> proxy_transport =
+      GetTransport(options, network, proxy_info.id());
+  if (proxy_transport == nullptr) {
+    proxy_transport = std::make_shared<TcpTransport>();
+  }
+  NodeKey proxy_key;
+  bool ok =
+      authority.Issue(proxy_info, CertificateKeyInfo::CLIENT, &proxy_key) == 0;
+  if (ok) {
+    Proxy proxy(replicas, proxy_info, proxy_key, proxy_transport);
+    proxy.Register();
+    usleep(100000);
+    ok = proxy.Run(options);
+    if (ok) {
+      proxy.Report(options);
+    } else {
+      printf("%-7s batches not committed in %ds\n", options.network.c_str(),
+             kWaitTimeoutSec);
+    }
+  }
+
+  for (auto& server : servers) {
+    server->Stop();
+  }
+  for (auto& th : server_threads) {
+    th.join();
+  }
+  return ok ? 0 : 1;
+}
+
+void ShowUsage() {
+  printf(
+      "<replica num> <network: inproc/sim/tcp> [batch num] [batch size] "
+      "[window] [latency us] [bandwidth MB/s] [loss rate]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    ShowUsage();
+    exit(0);
+  }
+
+  Options options;
+  options.replica_num = atoi(argv[1]);
+  options.network = argv[2];
+  if (argc > 3) {
+    options.batch_num = atoi(argv[3]);
+  }
+  if (argc > 4) {
+    options.batch_size = atoi(argv[4]);
+  }
+  if (argc > 5) {
+    options.window = atoi(argv[5]);
+  }
+  if (argc > 6) {
+    options.link.latency_us = strtoull(argv[6], nullptr, 10);
+  }
+  if (argc > 7) {
+    options.link.bandwidth_bytes_per_sec =
+        strtoull(argv[7], nullptr, 10) << 20;
+  }
+  if (argc > 8) {
+    options.link.loss_rate = atof(argv[8]);
+  }
+  if (options.replica_num < 4 ||
+      (options.network != "inproc" && options.network != "sim" &&
+       options.network != "tcp")) {
+    ShowUsage();
+    exit(0);
+  }
+
+  printf("%-7s %8s %8s %8s %12s %10s %10s %10s\n", "network", "replicas",
+         "batch", "failed", "txn/s", "avg(ms)", "p50(ms)", "p99(ms)");
+  return Run(options);
+}
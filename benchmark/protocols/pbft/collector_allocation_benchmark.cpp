@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Counts the heap allocations made by the LockFreeCollectorPool while running
+// the consensus messages of a sequence of transactions, with the per-slot
+// arena turned off and on. Allocations made to build the incoming messages are
+// not counted.
+//
+// Both runs use the current collector, so the run without the arena still
+// has the other copy removals of the collector. It is not the collector
+// before the arena was added.
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include "platform/consensus/ordering/pbft/lock_free_collector_pool.h"
+
+namespace {
+
+std::atomic<bool> counting = false;
+std::atomic<uint64_t> allocation_num = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  if (counting.load(std::memory_order_relaxed)) {
+    allocation_num.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+using namespace resdb;
+
+namespace {
+
+void ShowUsage() { printf("[replica num] [txn num]\n"); }
+
+int AddMessage(TransactionCollector* collector, const Request& request,
+               const SignatureInfo& signature, bool is_main_request,
+               int quorum) {
+  auto message = std::make_unique<Request>(request);
+  counting = true;
+  int ret = collector->AddRequest(
+      std::move(message), signature, is_main_request,
+      [&](const Request& request, int received_count,
+          TransactionCollector::CollectorDataType* data,
+          std::atomic<TransactionStatue>* status, bool force) {
+        TransactionStatue old_status = *status;
+        switch (request.type()) {
+          case Request::TYPE_PRE_PREPARE:
+            if (old_status == TransactionStatue::None) {
+              status->compare_exchange_strong(old_status,
+                                              TransactionStatue::READY_PREPARE);
+            }
+            break;
+          case Request::TYPE_PREPARE:
+            if (old_status == TransactionStatue::READY_PREPARE &&
+                received_count >= quorum) {
+              status->compare_exchange_strong(old_status,
+                                              TransactionStatue::READY_COMMIT);
+            }
+            break;
+          case Request::TYPE_COMMIT:
+            if (old_status == TransactionStatue::READY_COMMIT &&
+                received_count >= quorum) {
+              status->compare_exchange_strong(old_status,
+                                              TransactionStatue::READY_EXECUTE);
+            }
+            break;
+        }
+      });
+  counting = false;
+  return ret;
+}
+
+void Run(int replica_num, uint64_t txn_num, bool use_arena) {
+  int quorum = replica_num / 3 * 2 + 1;
+  LockFreeCollectorPool pool("bench", 64, nullptr,
+                             /*enable_viewchange=*/true, use_arena);
+
+  Request request;
+  request.set_hash(std::string(32, 'h'));
+  request.set_data(std::string(1024, 'd'));
+  request.set_primary_id(1);
+  request.set_proxy_id(1);
+  SignatureInfo signature;
+  signature.set_signature(std::string(64, 's'));
+
+  allocation_num = 0;
+  auto start_time = std::chrono::steady_clock::now();
+  for (uint64_t seq = 0; seq < txn_num; ++seq) {
+    TransactionCollector* collector = pool.GetCollector(seq);
+    request.set_seq(seq);
+    request.set_type(Request::TYPE_PRE_PREPARE);
+    request.set_sender_id(1);
+    AddMessage(collector, request, signature, true, quorum);
+
+    std::string data;
+    request.mutable_data()->swap(data);
+    for (int type : {Request::TYPE_PREPARE, Request::TYPE_COMMIT}) {
+      request.set_type(static_cast<Request::Type>(type));
+      for (int i = 1; i <= replica_num; ++i) {
+        request.set_sender_id(i);
+        signature.set_node_id(i);
+        AddMessage(collector, request, signature, false, quorum);
+      }
+    }
+    request.mutable_data()->swap(data);
+    counting = true;
+    pool.Update(seq);
+    counting = false;
+  }
+  auto end_time = std::chrono::steady_clock::now();
+  uint64_t allocations = allocation_num;
+  double run_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+                           end_time - start_time)
+                           .count() /
+                       1000.0;
+
+  printf("arena:%s replicas:%d txns:%lu allocations:%lu (%.2f per txn) "
+         "time:%.2fms\n",
+         use_arena ? "on" : "off", replica_num, txn_num, allocations,
+         static_cast<double>(allocations) / txn_num, run_time_ms);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::string(argv[1]) == "-h") {
+    ShowUsage();
+    return 0;
+  }
+  int replica_num = argc > 1 ? std::atoi(argv[1]) : 4;
+  uint64_t txn_num = argc > 2 ? std::atoll(argv[2]) : 100000;
+
+  Run(replica_num, txn_num, /*use_arena=*/false);
+  Run(replica_num, txn_num, /*use_arena=*/true);
+  return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Compares the bytes the primary uploads to propose one batch when it sends
+// the whole pre-prepare to every replica and when it sends one erasure coded
+// shard per replica, and measures the time to split a batch and to rebuild
+// it on a replica from f + 1 shards, the worst case of parity shards only.
+
+#include <chrono>
+
+#include "common/crypto/signature_verifier.h"
+#include "platform/consensus/ordering/pbft/proposal_dissemination.h"
+
+using namespace resdb;
+
+namespace {
+
+double GetSeconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         1000000.0;
+}
+
+void Run(int replica_num, size_t batch_size, int round) {
+  int f = (replica_num - 1) / 3;
+  ProposalDissemination primary(replica_num, f + 1);
+
+  Request pre_prepare;
+  pre_prepare.set_type(Request::TYPE_PRE_PREPARE);
+  pre_prepare.set_seq(1);
+  pre_prepare.set_sender_id(1);
+  pre_prepare.set_primary_id(1);
+  pre_prepare.mutable_data()->resize(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    (*pre_prepare.mutable_data())[i] = rand() % 256;
+  }
+  pre_prepare.set_hash(SignatureVerifier::CalculateHash(pre_prepare.data()));
+
+  std::vector<std::unique_ptr<Request>> chunks;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < round; ++i) {
+    chunks = primary.Split(pre_prepare);
+  }
+  double split_seconds = GetSeconds(start) / round;
+
+  size_t full_bytes = pre_prepare.ByteSizeLong() * (replica_num - 1);
+  size_t chunk_bytes = 0;
+  for (int i = 1; i < replica_num; ++i) {
+    chunk_bytes += chunks[i]->ByteSizeLong();
+  }
+
+  // The replica 1 rebuilds the batch from its own parity shard and f
+  // forwarded parity shards.
+  double rebuild_seconds = 0;
+  for (int r = 0; r < round; ++r) {
+    ProposalDissemination replica(replica_num, f + 1);
+    auto context = std::make_unique<Context>();
+    context->signature.set_signature("sign");
+    start = std::chrono::steady_clock::now();
+    replica.AddChunk(std::move(context), *chunks[replica_num - 1], true);
+    for (int i = 0; i < f; ++i) {
+      auto ret = replica.AddChunk(nullptr, *chunks[replica_num - 2 - i], false);
+      if (i == f - 1 && ret.second == nullptr) {
+        printf("rebuild fail\n");
+        return;
+      }
+    }
+    rebuild_seconds += GetSeconds(start);
+  }
+  rebuild_seconds /= round;
+
+  printf("%9d %10zu %14.1f %14.1f %8.2f %10.2f %12.2f\n", replica_num,
+         batch_size >> 10, full_bytes / 1048576.0, chunk_bytes / 1048576.0,
+         static_cast<double>(full_bytes) / chunk_bytes, split_seconds * 1000,
+         rebuild_seconds * 1000);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int round = argc > 1 ? std::atoi(argv[1]) : 20;
+  printf("%9s %10s %14s %14s %8s %10s %12s\n", "replicas", "batch(KB)",
+         "full MB/prop", "chunk MB/prop", "saving", "split(ms)",
+         "rebuild(ms)");
+  for (int replica_num : {4, 7, 16, 31}) {
+    Run(replica_num, 1 << 20, round);
+  }
+  return 0;
+}
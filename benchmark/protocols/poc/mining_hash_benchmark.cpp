@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Measures the PoW hashes per second of one thread: the double SHA-256 of a
+// 64-byte block header followed by a nonce. The string path builds the
+// message with the decimal nonce and hashes it twice, as the miner did
+// before. The other rows use NonceSHA256 with every kernel the CPU supports.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/crypto/hash.h"
+#include "common/crypto/sha256_multi.h"
+
+using namespace resdb::utils;
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         1000000.0;
+}
+
+// Count the digests starting with a zero byte so that the work is not
+// optimized out.
+double RunString(const std::string& header, uint64_t hash_num,
+                 uint64_t* found) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t nonce = 0; nonce < hash_num; ++nonce) {
+    std::string digest = CalculateSHA256Hash(
+        CalculateSHA256Hash(header + std::to_string(nonce)));
+    *found += digest[0] == 0;
+  }
+  return hash_num / Seconds(start);
+}
+
+double RunNonce(const std::string& header, uint64_t hash_num,
+                uint64_t* found) {
+  NonceSHA256 hasher(header);
+  constexpr size_t kBatch = 64;
+  uint64_t nonces[kBatch];
+  uint8_t digests[32 * kBatch];
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t base = 0; base < hash_num; base += kBatch) {
+    for (size_t i = 0; i < kBatch; ++i) {
+      nonces[i] = base + i;
+    }
+    hasher.DoubleHash(nonces, kBatch, digests);
+    for (size_t i = 0; i < kBatch; ++i) {
+      *found += digests[32 * i] == 0;
+    }
+  }
+  return hash_num / Seconds(start);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint64_t hash_num = argc > 1 ? std::atoll(argv[1]) : 2000000;
+  std::string header(64, 'h');
+  uint64_t found = 0;
+
+  printf("kernel    lanes  hashes/s\n");
+  printf("%-8s  %5d  %8.0f\n", "string", 1,
+         RunString(header, hash_num, &found));
+  SHA256Impl default_impl = GetSHA256Impl();
+  for (SHA256Impl impl : {SHA256Impl::kScalar, SHA256Impl::kAVX2,
+                          SHA256Impl::kSHANI, SHA256Impl::kAVX512}) {
+    if (!SetSHA256Impl(impl)) {
+      continue;
+    }
+    double tput = RunNonce(header, hash_num, &found);
+    printf("%-8s  %5zu  %8.0f\n", GetSHA256ImplName(impl).c_str(),
+           GetSHA256LaneNum(), tput);
+  }
+  printf("default kernel: %s, digests with a zero byte: %lu\n",
+         GetSHA256ImplName(default_impl).c_str(), found);
+  return 0;
+}
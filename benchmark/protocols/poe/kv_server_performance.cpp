@@ -20,6 +20,7 @@
 #include <glog/logging.h>
 
 #include "chain/storage/memory_db.h"
+#include "chain/storage/speculative_storage.h"
 #include "executor/kv/kv_executor.h"
 #include "platform/config/resdb_config_utils.h"
 #include "platform/consensus/ordering/poe/framework/consensus.h"
@@ -65,8 +66,12 @@ int main(int argc, char** argv) {
   config->RunningPerformance(true);
   ResConfigData config_data = config->GetConfigData();
 
+  // Execute speculatively, the writes reach the MemoryDB once their
+  // checkpoint is stable.
   auto performance_consens = std::make_unique<Consensus>(
-      *config, std::make_unique<KVExecutor>(std::make_unique<MemoryDB>()));
+      *config, std::make_unique<KVExecutor>(
+                   std::make_unique<SpeculativeStorage>(
+                       std::make_unique<MemoryDB>())));
   performance_consens->SetupPerformanceDataFunc([]() {
     KVRequest request;
     request.set_cmd(KVRequest::SET);
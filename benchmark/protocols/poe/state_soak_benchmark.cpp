@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Soak test of the PoE state tables. Runs a cluster of n replicas in one
+// process, each replica draining its message queue with a pool of worker
+// threads like the consensus service does, while one client keeps the
+// primary busy. Prints the committed throughput and the process RSS every
+// second; the RSS stays flat once the slot ring is populated since the
+// state of committed transactions is released.
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "platform/common/queue/lock_free_queue.h"
+#include "platform/consensus/ordering/poe/algorithm/poe.h"
+
+using namespace resdb;
+using namespace resdb::poe;
+
+namespace {
+
+void ShowUsage() {
+  printf("[seconds] [replica num] [window size] [worker num ...]\n");
+}
+
+struct Message {
+  int type;
+  std::string data;
+};
+
+double GetRSSMB() {
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE) / 1024.0 / 1024.0;
+}
+
+void Run(int seconds, int n, int window_size, int worker_num) {
+  std::vector<std::unique_ptr<LockFreeQueue<Message>>> queues;
+  std::vector<std::unique_ptr<PoE>> replicas;
+  std::atomic<uint64_t> committed = 0;
+  std::atomic<bool> stop = false;
+
+  for (int i = 1; i <= n; ++i) {
+    queues.push_back(std::make_unique<LockFreeQueue<Message>>());
+  }
+  for (int i = 1; i <= n; ++i) {
+    auto replica =
+        std::make_unique<PoE>(i, (n - 1) / 3, n, nullptr, window_size);
+    replica->SetBroadcastCallFunc(
+        [&](int type, const google::protobuf::Message& msg) {
+          std::string data = msg.SerializeAsString();
+          for (auto& queue : queues) {
+            queue->Push(std::make_unique<Message>(Message{type, data}));
+          }
+          return 0;
+        });
+    replica->SetCommitFunc([&, i](const google::protobuf::Message& msg) {
+      if (i == 1) {
+        committed++;
+      }
+      return 0;
+    });
+    replicas.push_back(std::move(replica));
+  }
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < worker_num; ++j) {
+      workers.push_back(std::thread([&, i]() {
+        while (!stop) {
+          std::unique_ptr<Message> msg = queues[i]->Pop();
+          if (msg == nullptr) {
+            continue;
+          }
+          if (msg->type == MessageType::Propose) {
+            auto txn = std::make_unique<Transaction>();
+            txn->ParseFromString(msg->data);
+            replicas[i]->ReceivePropose(std::move(txn));
+          } else {
+            auto proposal = std::make_unique<Proposal>();
+            proposal->ParseFromString(msg->data);
+            replicas[i]->ReceivePrepare(std::move(proposal));
+          }
+        }
+      }));
+    }
+  }
+
+  std::atomic<bool> client_stop = false;
+  std::thread client([&]() {
+    for (uint64_t i = 0; !client_stop; ++i) {
+      auto txn = std::make_unique<Transaction>();
+      txn->set_data(std::string(128, 'a' + i % 26));
+      txn->set_hash("hash_" + std::to_string(i));
+      replicas[0]->ReceiveTransaction(std::move(txn));
+    }
+  });
+
+  uint64_t last = 0;
+  for (int i = 1; i <= seconds; ++i) {
+    sleep(1);
+    uint64_t current = committed;
+    printf("%8d %8d %12lu %12.1f\n", worker_num, i, current - last,
+           GetRSSMB());
+    fflush(stdout);
+    last = current;
+  }
+
+  client_stop = true;
+  client.join();
+  stop = true;
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  while (true) {
+    bool empty = true;
+    for (auto& queue : queues) {
+      while (queue->Pop(0) != nullptr) {
+      }
+      empty = empty && queue->Empty();
+    }
+    if (empty) {
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int seconds = 10;
+  int n = 4;
+  int window_size = 4096;
+  std::vector<int> worker_nums;
+  if (argc > 1) {
+    seconds = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    n = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    window_size = atoi(argv[3]);
+  }
+  for (int i = 4; i < argc; ++i) {
+    worker_nums.push_back(atoi(argv[i]));
+  }
+  if (worker_nums.empty()) {
+    worker_nums = {1, 4, 16};
+  }
+  if (seconds <= 0 || n < 4 || window_size <= 0) {
+    ShowUsage();
+    return 0;
+  }
+
+  printf("%8s %8s %12s %12s\n", "workers", "second", "txn/s", "rss MB");
+  for (int worker_num : worker_nums) {
+    Run(seconds, n, window_size, worker_num);
+  }
+  return 0;
+}
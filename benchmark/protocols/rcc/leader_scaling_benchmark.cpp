@@ -0,0 +1,185 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Runs an RCC cluster of n replicas in one process with 1 to n concurrent
+// leaders and reports the bytes sent by the busiest replica per committed
+// transaction. With one leader, the leader sends every proposal to all the
+// replicas and its outgoing bandwidth caps the throughput; with m leaders
+// the proposals are spread over m replicas. The last column is the
+// throughput that load allows on the given link bandwidth. Messages are
+// serialized as they would be on the wire. Compare the throughput of real
+// clusters with the kv_server_performance binary and rcc_leader_num.
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+#include "platform/consensus/ordering/rcc/algorithm/rcc.h"
+
+using namespace resdb;
+using namespace resdb::rcc;
+
+namespace {
+
+void ShowUsage() {
+  printf("[replica num] [txn num] [txn size] [link bandwidth MB/s]\n");
+}
+
+struct Message {
+  int type;
+  std::string data;
+  int to;
+};
+
+struct Result {
+  uint64_t committed = 0;
+  uint64_t noop = 0;
+  std::vector<uint64_t> sent_bytes;
+  double seconds = 0;
+};
+
+Result Run(int n, int leader_num, int txn_num, int txn_size) {
+  std::deque<Message> queue;
+  std::vector<std::unique_ptr<RCC>> replicas;
+  Result result;
+  result.sent_bytes.resize(n + 1);
+
+  for (int i = 1; i <= n; ++i) {
+    auto replica =
+        std::make_unique<RCC>(i, (n - 1) / 3, n, leader_num, nullptr);
+    replica->SetSingleCallFunc(
+        [&, i](int type, const google::protobuf::Message& msg, int to) {
+          queue.push_back({type, msg.SerializeAsString(), to});
+          result.sent_bytes[i] += queue.back().data.size();
+          return 0;
+        });
+    replica->SetBroadcastCallFunc(
+        [&, i](int type, const google::protobuf::Message& msg) {
+          std::string data = msg.SerializeAsString();
+          if (type == MessageType::Propose &&
+              dynamic_cast<const Transaction&>(msg).noop()) {
+            result.noop++;
+          }
+          for (int j = 1; j <= n; ++j) {
+            queue.push_back({type, data, j});
+            if (j != i) {
+              result.sent_bytes[i] += data.size();
+            }
+          }
+          return 0;
+        });
+    replica->SetCommitFunc([&, i](const google::protobuf::Message& msg) {
+      if (i == 1) {
+        result.committed++;
+      }
+      return 0;
+    });
+    replicas.push_back(std::move(replica));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  const int batch_num = 100;
+  for (int i = 0; i < txn_num; i += batch_num) {
+    // Clients spread their requests over the replicas.
+    for (int j = i; j < std::min(txn_num, i + batch_num); ++j) {
+      auto txn = std::make_unique<Transaction>();
+      txn->set_data(std::string(txn_size, 'a' + j % 26));
+      txn->set_hash("hash_" + std::to_string(j));
+      replicas[j % n]->ReceiveTransaction(std::move(txn));
+    }
+
+    while (!queue.empty()) {
+      Message msg = std::move(queue.front());
+      queue.pop_front();
+      RCC* replica = replicas[msg.to - 1].get();
+      switch (msg.type) {
+        case MessageType::Forward:
+        case MessageType::Propose: {
+          auto txn = std::make_unique<Transaction>();
+          txn->ParseFromString(msg.data);
+          if (msg.type == MessageType::Forward) {
+            replica->ReceiveTransaction(std::move(txn));
+          } else {
+            replica->ReceivePropose(std::move(txn));
+          }
+          break;
+        }
+        case MessageType::PrepareMsg: {
+          auto prepare = std::make_unique<Prepare>();
+          prepare->ParseFromString(msg.data);
+          replica->ReceivePrepare(std::move(prepare));
+          break;
+        }
+      }
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int n = 16;
+  int txn_num = 10000;
+  int txn_size = 512;
+  double bandwidth = 125;
+  if (argc > 1) {
+    n = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    txn_num = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    txn_size = atoi(argv[3]);
+  }
+  if (argc > 4) {
+    bandwidth = atof(argv[4]);
+  }
+  if (n < 4 || txn_num <= 0 || txn_size <= 0 || bandwidth <= 0) {
+    ShowUsage();
+    return 0;
+  }
+
+  printf("%8s %10s %8s %16s %14s %14s\n", "leaders", "committed", "noop",
+         "max sent B/txn", "cpu txn/s", "link txn/s");
+  std::vector<int> leader_nums;
+  for (int leader_num = 1; leader_num < n; leader_num *= 2) {
+    leader_nums.push_back(leader_num);
+  }
+  leader_nums.push_back(n);
+  for (int leader_num : leader_nums) {
+    Result result = Run(n, leader_num, txn_num, txn_size);
+    if (result.committed != static_cast<uint64_t>(txn_num)) {
+      printf("leaders=%d committed %lu of %d\n", leader_num, result.committed,
+             txn_num);
+    }
+    uint64_t max_sent = *std::max_element(result.sent_bytes.begin(),
+                                          result.sent_bytes.end());
+    double bytes_per_txn = static_cast<double>(max_sent) / txn_num;
+    printf("%8d %10lu %8lu %16.1f %14.0f %14.0f\n", leader_num,
+           result.committed, result.noop, bytes_per_txn,
+           txn_num / result.seconds, bandwidth * 1e6 / bytes_per_txn);
+  }
+  return 0;
+}
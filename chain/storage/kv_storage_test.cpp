@@ -158,6 +158,38 @@ TEST_P(KVStorageTest, SetValueWithSeq) {
       std::make_pair(std::string("test_value_v2"), static_cast<uint64_t>(3)));
 }
 
+TEST_P(KVStorageTest, PruneHistory) {
+  for (int seq = 1; seq <= 5; ++seq) {
+    EXPECT_EQ(storage->SetValueWithSeq("key1", "value" + std::to_string(seq),
+                                       seq),
+              0);
+  }
+  EXPECT_EQ(storage->SetValueWithSeq("key2", "value2", 2), 0);
+  EXPECT_EQ(storage->GetAllItemsWithSeq().size(), 2);
+
+  // key1 drops the versions 1 to 3, the only version of key2 is kept.
+  EXPECT_EQ(storage->PruneHistory(4), 3);
+  EXPECT_EQ(storage->PruneHistory(4), 0);
+
+  EXPECT_EQ(storage->GetValueWithSeq("key1", 3),
+            std::make_pair(std::string(""), static_cast<uint64_t>(0)));
+  EXPECT_EQ(storage->GetValueWithSeq("key1", 4),
+            std::make_pair(std::string("value4"), static_cast<uint64_t>(4)));
+  EXPECT_EQ(storage->GetValueWithSeq("key2", 0),
+            std::make_pair(std::string("value2"), static_cast<uint64_t>(2)));
+
+  // The latest version stays even if it is below the seq.
+  EXPECT_EQ(storage->PruneHistory(10), 1);
+  EXPECT_EQ(storage->GetValueWithSeq("key1", 0),
+            std::make_pair(std::string("value5"), static_cast<uint64_t>(5)));
+
+  EXPECT_EQ(storage->SetValueWithSeq("key1", "value6", 6), 0);
+  EXPECT_EQ(storage->GetValueWithSeq("key1", 6),
+            std::make_pair(std::string("value6"), static_cast<uint64_t>(6)));
+  EXPECT_EQ(storage->PruneHistory(10), 1);
+  EXPECT_EQ(storage->GetAllItemsWithSeq().size(), 2);
+}
+
 TEST_P(KVStorageTest, GetAllValueWithSeq) {
   typedef std::vector<std::pair<std::string, uint64_t>> List;
   {
@@ -30,6 +30,19 @@
 namespace resdb {
 namespace storage {
 
+namespace {
+
+// The keys holding more than one seq version are indexed under this prefix,
+// so that the pruning only scans the index instead of the whole db. It sorts
+// before the printable keys.
+const std::string kSeqIndexPrefix("\0seq_index/", 11);
+
+bool IsSeqIndexKey(const leveldb::Slice& key) {
+  return key.starts_with(kSeqIndexPrefix);
+}
+
+}  // namespace
+
 std::unique_ptr<Storage> NewResLevelDB(const std::string& path,
                                        std::optional<LevelDBInfo> config) {
   if (config == std::nullopt) {
@@ -97,6 +110,7 @@ ResLevelDB::~ResLevelDB() {
 
 int ResLevelDB::SetValueWithSeq(const std::string& key,
                                 const std::string& value, uint64_t seq) {
+  std::lock_guard<std::mutex> lk(history_mutex_);
   std::string value_str = GetValue(key);
   ValueHistory history;
   if (!history.ParseFromString(value_str)) {
@@ -122,6 +136,12 @@ int ResLevelDB::SetValueWithSeq(const std::string& key,
   while (history.value_size() > max_history_) {
     history.mutable_value()->erase(history.mutable_value()->begin());
   }
+  if (history.value_size() == 2) {
+    int ret = UpdateSeqIndex(key, true);
+    if (ret) {
+      return ret;
+    }
+  }
 
   LOG(ERROR) << " set value, string:" << key << " seq:" << seq
              << " last seq:" << last_seq;
@@ -159,11 +179,28 @@ std::pair<std::string, uint64_t> ResLevelDB::GetValueWithSeq(
 }
 
 int ResLevelDB::SetValue(const std::string& key, const std::string& value) {
+  std::lock_guard<std::mutex> lk(batch_mutex_);
   if (block_cache_) {
+    std::lock_guard<std::mutex> cache_lk(cache_mutex_);
     block_cache_->Put(key, value);
   }
   batch_.Put(key, value);
+  return WriteBatchIfFull();
+}
+
+// The index entries bypass the block cache, they are only read by the
+// iterator of PruneHistory().
+int ResLevelDB::UpdateSeqIndex(const std::string& key, bool add) {
+  std::lock_guard<std::mutex> lk(batch_mutex_);
+  if (add) {
+    batch_.Put(kSeqIndexPrefix + key, "");
+  } else {
+    batch_.Delete(kSeqIndexPrefix + key);
+  }
+  return WriteBatchIfFull();
+}
 
+int ResLevelDB::WriteBatchIfFull() {
   if (batch_.ApproximateSize() >= write_batch_size_) {
     leveldb::Status status = db_->Write(leveldb::WriteOptions(), &batch_);
     if (status.ok()) {
@@ -183,6 +220,7 @@ std::string ResLevelDB::GetValue(const std::string& key) {
   bool found_in_cache = false;
 
   if (block_cache_) {
+    std::lock_guard<std::mutex> lk(cache_mutex_);
     value = block_cache_->Get(key);
     found_in_cache = !value.empty();
   }
@@ -205,6 +243,7 @@ std::string ResLevelDB::GetRange(const std::string& min_key,
   bool first_iteration = true;
   for (it->Seek(min_key); it->Valid() && it->key().ToString() <= max_key;
        it->Next()) {
+    if (IsSeqIndexKey(it->key())) continue;
     if (!first_iteration) values.append(",");
     first_iteration = false;
     values.append(it->value().ToString());
@@ -223,12 +262,17 @@ bool ResLevelDB::UpdateMetrics() {
   std::string approximate_size;
   db_->GetProperty("leveldb.stats", &stats);
   db_->GetProperty("leveldb.approximate-memory-usage", &approximate_size);
-  global_stats_->SetStorageEngineMetrics(block_cache_->GetCacheHitRatio(),
-                                         stats, approximate_size);
+  double hit_ratio = 0;
+  {
+    std::lock_guard<std::mutex> lk(cache_mutex_);
+    hit_ratio = block_cache_->GetCacheHitRatio();
+  }
+  global_stats_->SetStorageEngineMetrics(hit_ratio, stats, approximate_size);
   return true;
 }
 
 bool ResLevelDB::Flush() {
+  std::lock_guard<std::mutex> lk(batch_mutex_);
   leveldb::Status status = db_->Write(leveldb::WriteOptions(), &batch_);
   if (status.ok()) {
     batch_.Clear();
@@ -300,6 +344,9 @@ ResLevelDB::GetAllItemsWithSeq() {
 
   leveldb::Iterator* it = db_->NewIterator(leveldb::ReadOptions());
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    if (IsSeqIndexKey(it->key())) {
+      continue;
+    }
     ValueHistory history;
     if (!history.ParseFromString(it->value().ToString()) ||
         history.value_size() == 0) {
@@ -323,6 +370,9 @@ std::map<std::string, std::pair<std::string, int>> ResLevelDB::GetAllItems() {
 
   leveldb::Iterator* it = db_->NewIterator(leveldb::ReadOptions());
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    if (IsSeqIndexKey(it->key())) {
+      continue;
+    }
     ValueHistory history;
     if (!history.ParseFromString(it->value().ToString()) ||
         history.value_size() == 0) {
@@ -345,6 +395,9 @@ std::map<std::string, std::pair<std::string, int>> ResLevelDB::GetKeyRange(
   leveldb::Iterator* it = db_->NewIterator(leveldb::ReadOptions());
   for (it->Seek(min_key); it->Valid() && it->key().ToString() <= max_key;
        it->Next()) {
+    if (IsSeqIndexKey(it->key())) {
+      continue;
+    }
     ValueHistory history;
     if (!history.ParseFromString(it->value().ToString()) ||
         history.value_size() == 0) {
@@ -440,5 +493,71 @@ uint64_t ResLevelDB::GetLastCheckpoint() {
   return GetLastCheckpointInternal();
 }
 
+int ResLevelDB::PruneHistory(uint64_t seq) {
+  int num = 0;
+  std::string min_key, max_key;
+  // Make the batched index entries visible to the iterator.
+  if (!Flush()) {
+    return 0;
+  }
+  std::unique_ptr<leveldb::Iterator> it(
+      db_->NewIterator(leveldb::ReadOptions()));
+  for (it->Seek(kSeqIndexPrefix); it->Valid() && IsSeqIndexKey(it->key());
+       it->Next()) {
+    std::string key = it->key().ToString().substr(kSeqIndexPrefix.size());
+    int pruned = PruneKeyHistory(key, seq);
+    if (pruned == 0) {
+      continue;
+    }
+    num += pruned;
+    if (min_key.empty()) {
+      min_key = key;
+    }
+    max_key = key;
+  }
+  if (num == 0) {
+    return 0;
+  }
+  if (!Flush()) {
+    return num;
+  }
+  // Drop the overwritten histories from the sstables.
+  leveldb::Slice begin(min_key), end(max_key);
+  db_->CompactRange(&begin, &end);
+  LOG(ERROR) << "prune history below seq:" << seq << " versions:" << num
+             << " range:[" << min_key << "," << max_key << "]";
+  return num;
+}
+
+int ResLevelDB::PruneKeyHistory(const std::string& key, uint64_t seq) {
+  std::lock_guard<std::mutex> lk(history_mutex_);
+  std::string value_str = GetValue(key);
+  ValueHistory history;
+  if (!history.ParseFromString(value_str)) {
+    return 0;
+  }
+  if (history.value_size() < 2) {
+    UpdateSeqIndex(key, false);
+    return 0;
+  }
+  int num = 0;
+  while (num + 1 < history.value_size() && history.value(num).seq() > 0 &&
+         history.value(num).seq() < seq) {
+    num++;
+  }
+  if (num == 0) {
+    return 0;
+  }
+  history.mutable_value()->DeleteSubrange(0, num);
+  history.SerializeToString(&value_str);
+  if (SetValue(key, value_str)) {
+    return 0;
+  }
+  if (history.value_size() == 1) {
+    UpdateSeqIndex(key, false);
+  }
+  return num;
+}
+
 }  // namespace storage
 }  // namespace resdb
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 
@@ -80,13 +81,27 @@ class ResLevelDB : public Storage {
 
   virtual int SetLastCheckpoint(uint64_t ckpt);
 
+  // Prune the versions below seq and compact the range of the pruned keys.
+  // It only scans the index of the keys holding more than one seq version.
+  int PruneHistory(uint64_t seq) override;
+
+  bool IsThreadSafe() override { return true; }
+
  private:
   void CreateDB(const std::string& path);
   uint64_t GetLastCheckpointInternal();
   void UpdateLastCkpt(uint64_t seq);
+  int PruneKeyHistory(const std::string& key, uint64_t seq);
+  int UpdateSeqIndex(const std::string& key, bool add);
+  // Write the batch once it is full, batch_mutex_ must be held.
+  int WriteBatchIfFull();
 
  private:
   std::unique_ptr<leveldb::DB> db_ = nullptr;
+  // history_mutex_ serializes the read-modify-write of a value history with
+  // the pruning, batch_mutex_ guards batch_ and cache_mutex_ guards
+  // block_cache_, which is not thread safe.
+  std::mutex history_mutex_, batch_mutex_, cache_mutex_;
   ::leveldb::WriteBatch batch_;
   unsigned int write_buffer_size_ = 64 << 20;
   unsigned int write_batch_size_ = 1;
@@ -29,12 +29,14 @@ std::unique_ptr<Storage> NewMemoryDB() { return std::make_unique<MemoryDB>(); }
 MemoryDB::MemoryDB() {}
 
 int MemoryDB::SetValue(const std::string& key, const std::string& value) {
+  std::unique_lock<std::shared_mutex> lk(kv_mutex_);
   kv_map_[key] = value;
   return 0;
 }
 
 std::string MemoryDB::GetRange(const std::string& min_key,
                                const std::string& max_key) {
+  std::shared_lock<std::shared_mutex> lk(kv_mutex_);
   std::string values = "[";
   bool first_iteration = true;
   for (auto kv : kv_map_) {
@@ -49,6 +51,7 @@ std::string MemoryDB::GetRange(const std::string& min_key,
 }
 
 std::string MemoryDB::GetValue(const std::string& key) {
+  std::shared_lock<std::shared_mutex> lk(kv_mutex_);
   auto search = kv_map_.find(key);
   if (search != kv_map_.end())
     return search->second;
@@ -59,6 +62,7 @@ std::string MemoryDB::GetValue(const std::string& key) {
 
 std::pair<std::string, uint64_t> MemoryDB::GetValueWithSeq(
     const std::string& key, uint64_t seq) {
+  std::lock_guard<std::mutex> lk(seq_mutex_);
   auto search_it = kv_map_with_seq_.find(key);
   if (search_it != kv_map_with_seq_.end() && search_it->second.size()) {
     auto it = search_it->second.end();
@@ -78,6 +82,7 @@ std::pair<std::string, uint64_t> MemoryDB::GetValueWithSeq(
 
 int MemoryDB::SetValueWithSeq(const std::string& key, const std::string& value,
                               uint64_t seq) {
+  std::lock_guard<std::mutex> lk(seq_mutex_);
   auto it = kv_map_with_seq_.find(key);
   if (it != kv_map_with_seq_.end() && it->second.back().second > seq) {
     LOG(ERROR) << " value seq not match. key:" << key << " db seq:"
@@ -94,6 +99,7 @@ int MemoryDB::SetValueWithSeq(const std::string& key, const std::string& value,
 
 int MemoryDB::SetValueWithVersion(const std::string& key,
                                   const std::string& value, int version) {
+  std::unique_lock<std::shared_mutex> lk(kv_mutex_);
   auto it = kv_map_with_v_.find(key);
   if ((it == kv_map_with_v_.end() && version != 0) ||
       (it != kv_map_with_v_.end() && it->second.back().second != version)) {
@@ -108,6 +114,7 @@ int MemoryDB::SetValueWithVersion(const std::string& key,
 
 std::pair<std::string, int> MemoryDB::GetValueWithVersion(
     const std::string& key, int version) {
+  std::shared_lock<std::shared_mutex> lk(kv_mutex_);
   auto search_it = kv_map_with_v_.find(key);
   if (search_it != kv_map_with_v_.end() && search_it->second.size()) {
     auto it = search_it->second.end();
@@ -131,6 +138,7 @@ std::pair<std::string, int> MemoryDB::GetValueWithVersion(
 std::map<std::string, std::vector<std::pair<std::string, uint64_t>>>
 MemoryDB::GetAllItemsWithSeq() {
   std::map<std::string, std::vector<std::pair<std::string, uint64_t>>> resp;
+  std::lock_guard<std::mutex> lk(seq_mutex_);
   for (const auto& it : kv_map_with_seq_) {
     LOG(ERROR) << " value num:" << it.second.size();
     for (const auto& item : it.second) {
@@ -141,6 +149,7 @@ MemoryDB::GetAllItemsWithSeq() {
 }
 
 std::map<std::string, std::pair<std::string, int>> MemoryDB::GetAllItems() {
+  std::shared_lock<std::shared_mutex> lk(kv_mutex_);
   std::map<std::string, std::pair<std::string, int>> resp;
 
   for (const auto& it : kv_map_with_v_) {
@@ -151,6 +160,7 @@ std::map<std::string, std::pair<std::string, int>> MemoryDB::GetAllItems() {
 
 std::map<std::string, std::pair<std::string, int>> MemoryDB::GetKeyRange(
     const std::string& min_key, const std::string& max_key) {
+  std::shared_lock<std::shared_mutex> lk(kv_mutex_);
   LOG(ERROR) << "min key:" << min_key << " max key:" << max_key;
   std::map<std::string, std::pair<std::string, int>> resp;
   for (const auto& it : kv_map_with_v_) {
@@ -163,6 +173,7 @@ std::map<std::string, std::pair<std::string, int>> MemoryDB::GetKeyRange(
 
 std::vector<std::pair<std::string, int>> MemoryDB::GetHistory(
     const std::string& key, int min_version, int max_version) {
+  std::shared_lock<std::shared_mutex> lk(kv_mutex_);
   std::vector<std::pair<std::string, int>> resp;
   auto search_it = kv_map_with_v_.find(key);
   if (search_it == kv_map_with_v_.end()) {
@@ -184,6 +195,7 @@ std::vector<std::pair<std::string, int>> MemoryDB::GetHistory(
 
 std::vector<std::pair<std::string, int>> MemoryDB::GetTopHistory(
     const std::string& key, int top_number) {
+  std::shared_lock<std::shared_mutex> lk(kv_mutex_);
   std::vector<std::pair<std::string, int>> resp;
   auto search_it = kv_map_with_v_.find(key);
   if (search_it == kv_map_with_v_.end()) {
@@ -201,5 +213,18 @@ std::vector<std::pair<std::string, int>> MemoryDB::GetTopHistory(
   return resp;
 }
 
+int MemoryDB::PruneHistory(uint64_t seq) {
+  int num = 0;
+  std::lock_guard<std::mutex> lk(seq_mutex_);
+  for (auto& it : kv_map_with_seq_) {
+    auto& values = it.second;
+    while (values.size() > 1 && values.front().second < seq) {
+      values.pop_front();
+      num++;
+    }
+  }
+  return num;
+}
+
 }  // namespace storage
 }  // namespace resdb
@@ -22,6 +22,8 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 
 #include "chain/storage/storage.h"
@@ -83,10 +85,19 @@ class MemoryDB : public Storage {
   std::vector<std::pair<std::string, int>> GetTopHistory(const std::string& key,
                                                          int number) override;
 
+  int PruneHistory(uint64_t seq) override;
+
+  bool IsThreadSafe() override { return true; }
+
  private:
+  // Guards kv_map_ and kv_map_with_v_, the batches with disjoint keys may be
+  // executed concurrently.
+  std::shared_mutex kv_mutex_;
   std::unordered_map<std::string, std::string> kv_map_;
   std::unordered_map<std::string, std::list<std::pair<std::string, int>>>
       kv_map_with_v_;
+  // Guards kv_map_with_seq_, which is pruned outside the executor thread.
+  std::mutex seq_mutex_;
   std::unordered_map<std::string, std::list<std::pair<std::string, uint64_t>>>
       kv_map_with_seq_;
 };
@@ -58,6 +58,7 @@ class MockStorage : public Storage {
   MOCK_METHOD(ValuesSeqType, GetAllItemsWithSeq, (), (override));
 
   MOCK_METHOD(bool, Flush, (), (override));
+  MOCK_METHOD(int, PruneHistory, (uint64_t), (override));
 };
 
 }  // namespace resdb
@@ -0,0 +1,344 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "chain/storage/speculative_storage.h"
+
+#include <glog/logging.h>
+
+namespace resdb {
+namespace storage {
+
+SpeculativeStorage::SpeculativeStorage(std::unique_ptr<Storage> storage)
+    : storage_(std::move(storage)) {}
+
+void SpeculativeStorage::AddWrite(uint64_t seq, Write write) {
+  switch (write.type) {
+    case VALUE:
+      break;
+    case VALUE_WITH_SEQ:
+      values_with_seq_[write.key][seq] = write.value;
+      break;
+    case VALUE_WITH_VERSION:
+      values_with_version_[write.key][seq].emplace_back(write.value,
+                                                        write.version + 1);
+      break;
+  }
+  writes_[seq].push_back(std::move(write));
+}
+
+namespace {
+
+template <typename Index>
+void EraseSeq(Index* index, const std::string& key, uint64_t seq) {
+  auto it = index->find(key);
+  if (it == index->end()) {
+    return;
+  }
+  it->second.erase(seq);
+  if (it->second.empty()) {
+    index->erase(it);
+  }
+}
+
+}  // namespace
+
+void SpeculativeStorage::EraseIndex(uint64_t seq, const Write& write) {
+  switch (write.type) {
+    case VALUE:
+      break;
+    case VALUE_WITH_SEQ:
+      EraseSeq(&values_with_seq_, write.key, seq);
+      break;
+    case VALUE_WITH_VERSION:
+      EraseSeq(&values_with_version_, write.key, seq);
+      break;
+  }
+}
+
+int SpeculativeStorage::SetValue(const std::string& key,
+                                 const std::string& value) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (executing_seq_ > stable_seq_) {
+    AddWrite(executing_seq_, Write{key, storage_->GetValue(key), VALUE});
+  }
+  return storage_->SetValue(key, value);
+}
+
+int SpeculativeStorage::SetValueWithSeq(const std::string& key,
+                                        const std::string& value,
+                                        uint64_t seq) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (seq <= stable_seq_) {
+    return storage_->SetValueWithSeq(key, value, seq);
+  }
+  auto it = values_with_seq_.find(key);
+  if (it != values_with_seq_.end() && it->second.rbegin()->first > seq) {
+    LOG(ERROR) << " value seq not match. key:" << key
+               << " speculative seq:" << it->second.rbegin()->first
+               << " new seq:" << seq;
+    return -2;
+  }
+  AddWrite(seq, Write{key, value, VALUE_WITH_SEQ});
+  return 0;
+}
+
+std::string SpeculativeStorage::GetValue(const std::string& key) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return storage_->GetValue(key);
+}
+
+std::pair<std::string, uint64_t> SpeculativeStorage::GetValueWithSeq(
+    const std::string& key, uint64_t seq) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto it = values_with_seq_.find(key);
+  if (it != values_with_seq_.end()) {
+    if (seq == 0) {
+      return std::make_pair(it->second.rbegin()->second,
+                            it->second.rbegin()->first);
+    }
+    auto value_it = it->second.find(seq);
+    if (value_it != it->second.end()) {
+      return std::make_pair(value_it->second, seq);
+    }
+  }
+  return storage_->GetValueWithSeq(key, seq);
+}
+
+std::string SpeculativeStorage::GetRange(const std::string& min_key,
+                                         const std::string& max_key) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return storage_->GetRange(min_key, max_key);
+}
+
+int SpeculativeStorage::SetValueWithVersion(const std::string& key,
+                                            const std::string& value,
+                                            int version) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (executing_seq_ <= stable_seq_) {
+    return storage_->SetValueWithVersion(key, value, version);
+  }
+  int last_version = 0;
+  auto it = values_with_version_.find(key);
+  if (it != values_with_version_.end()) {
+    last_version = it->second.rbegin()->second.back().second;
+  } else {
+    last_version = storage_->GetValueWithVersion(key, 0).second;
+  }
+  if (last_version != version) {
+    LOG(ERROR) << " value version not match. key:" << key
+               << " speculative version:" << last_version
+               << " user version:" << version;
+    return -2;
+  }
+  AddWrite(executing_seq_, Write{key, value, VALUE_WITH_VERSION, version});
+  return 0;
+}
+
+std::pair<std::string, int> SpeculativeStorage::GetValueWithVersion(
+    const std::string& key, int version) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto it = values_with_version_.find(key);
+  if (it == values_with_version_.end()) {
+    return storage_->GetValueWithVersion(key, version);
+  }
+  if (version > 0) {
+    for (auto seq_it = it->second.rbegin(); seq_it != it->second.rend();
+         ++seq_it) {
+      for (auto value_it = seq_it->second.rbegin();
+           value_it != seq_it->second.rend(); ++value_it) {
+        if (value_it->second == version) {
+          return *value_it;
+        }
+      }
+    }
+    auto value = storage_->GetValueWithVersion(key, version);
+    if (value.second == version) {
+      return value;
+    }
+  }
+  // As the base storages, return the latest one if the version is not found.
+  return it->second.rbegin()->second.back();
+}
+
+std::map<std::string, std::vector<std::pair<std::string, uint64_t>>>
+SpeculativeStorage::GetAllItemsWithSeq() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto items = storage_->GetAllItemsWithSeq();
+  // The speculative seqs are above the stable ones.
+  for (const auto& it : values_with_seq_) {
+    for (const auto& [seq, value] : it.second) {
+      items[it.first].emplace_back(value, seq);
+    }
+  }
+  return items;
+}
+
+std::map<std::string, std::pair<std::string, int>>
+SpeculativeStorage::GetAllItems() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto items = storage_->GetAllItems();
+  for (const auto& it : values_with_version_) {
+    items[it.first] = it.second.rbegin()->second.back();
+  }
+  return items;
+}
+
+std::map<std::string, std::pair<std::string, int>>
+SpeculativeStorage::GetKeyRange(const std::string& min_key,
+                                const std::string& max_key) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto items = storage_->GetKeyRange(min_key, max_key);
+  for (const auto& it : values_with_version_) {
+    if (it.first >= min_key && it.first <= max_key) {
+      items[it.first] = it.second.rbegin()->second.back();
+    }
+  }
+  return items;
+}
+
+std::vector<std::pair<std::string, int>> SpeculativeStorage::GetHistory(
+    const std::string& key, int min_version, int max_version) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  std::vector<std::pair<std::string, int>> resp;
+  auto it = values_with_version_.find(key);
+  if (it != values_with_version_.end()) {
+    for (auto seq_it = it->second.rbegin(); seq_it != it->second.rend();
+         ++seq_it) {
+      for (auto value_it = seq_it->second.rbegin();
+           value_it != seq_it->second.rend(); ++value_it) {
+        if (value_it->second >= min_version &&
+            value_it->second <= max_version) {
+          resp.push_back(*value_it);
+        }
+      }
+    }
+  }
+  // The speculative versions are above the stable ones.
+  for (auto& value : storage_->GetHistory(key, min_version, max_version)) {
+    resp.push_back(std::move(value));
+  }
+  return resp;
+}
+
+std::vector<std::pair<std::string, int>> SpeculativeStorage::GetTopHistory(
+    const std::string& key, int top_number) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  std::vector<std::pair<std::string, int>> resp;
+  auto it = values_with_version_.find(key);
+  if (it != values_with_version_.end()) {
+    for (auto seq_it = it->second.rbegin(); seq_it != it->second.rend();
+         ++seq_it) {
+      for (auto value_it = seq_it->second.rbegin();
+           value_it != seq_it->second.rend(); ++value_it) {
+        if (resp.size() >= static_cast<size_t>(top_number)) {
+          return resp;
+        }
+        resp.push_back(*value_it);
+      }
+    }
+  }
+  if (resp.size() < static_cast<size_t>(top_number)) {
+    for (auto& value :
+         storage_->GetTopHistory(key, top_number - resp.size())) {
+      resp.push_back(std::move(value));
+    }
+  }
+  return resp;
+}
+
+bool SpeculativeStorage::Flush() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return storage_->Flush();
+}
+
+void SpeculativeStorage::SetExecutingSeq(uint64_t seq) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  executing_seq_ = seq;
+}
+
+int SpeculativeStorage::PruneHistory(uint64_t seq) {
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    seq = std::min(seq, stable_seq_);
+  }
+  // The base storage synchronizes the pruning with the writes, not holding
+  // mutex_ keeps the executor running during the scan.
+  return storage_->PruneHistory(seq);
+}
+
+void SpeculativeStorage::Stabilize(uint64_t seq) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  while (!writes_.empty() && writes_.begin()->first <= seq) {
+    uint64_t write_seq = writes_.begin()->first;
+    for (const Write& write : writes_.begin()->second) {
+      switch (write.type) {
+        case VALUE:
+          // Written through already.
+          break;
+        case VALUE_WITH_SEQ:
+          storage_->SetValueWithSeq(write.key, write.value, write_seq);
+          break;
+        case VALUE_WITH_VERSION:
+          storage_->SetValueWithVersion(write.key, write.value, write.version);
+          break;
+      }
+      EraseIndex(write_seq, write);
+    }
+    writes_.erase(writes_.begin());
+  }
+  stable_seq_ = std::max(stable_seq_, seq);
+}
+
+int SpeculativeStorage::Rollback(uint64_t seq) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  if (seq < stable_seq_) {
+    LOG(ERROR) << "rollback below the stable seq:" << seq
+               << " stable seq:" << stable_seq_;
+    seq = stable_seq_;
+  }
+  int num = 0;
+  while (!writes_.empty() && writes_.rbegin()->first > seq) {
+    auto it = std::prev(writes_.end());
+    // Undo in the reverse order to restore the value before the seq.
+    for (auto write = it->second.rbegin(); write != it->second.rend();
+         ++write) {
+      if (write->type == VALUE) {
+        storage_->SetValue(write->key, write->value);
+      }
+      EraseIndex(it->first, *write);
+    }
+    writes_.erase(it);
+    ++num;
+  }
+  executing_seq_ = std::min(executing_seq_, seq);
+  return num;
+}
+
+uint64_t SpeculativeStorage::GetStableSeq() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return stable_seq_;
+}
+
+size_t SpeculativeStorage::GetPendingSeqNum() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return writes_.size();
+}
+
+}  // namespace storage
+}  // namespace resdb
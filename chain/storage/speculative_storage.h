@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "chain/storage/storage.h"
+
+namespace resdb {
+namespace storage {
+
+// SpeculativeStorage keeps the writes of the executed but not yet stable
+// seqs on top of a base storage.
+//  Writes are tagged with their seq, SetValue() and SetValueWithVersion()
+//  with the one passed to SetExecutingSeq(). The writes of SetValueWithSeq()
+//  and SetValueWithVersion() are kept in an overlay and only reach the base
+//  storage once Stabilize() is called with a seq at or above them.
+//  SetValue() overwrites the key, it is written through and the previous
+//  value is kept to undo it. Rollback() discards the writes above a seq.
+//  All the reads see the speculative writes. The writes are tagged with a
+//  single executing seq, so the batches can not be executed in parallel.
+class SpeculativeStorage : public Storage {
+ public:
+  SpeculativeStorage(std::unique_ptr<Storage> storage);
+
+  int SetValue(const std::string& key, const std::string& value) override;
+  int SetValueWithSeq(const std::string& key, const std::string& value,
+                      uint64_t seq) override;
+  std::string GetValue(const std::string& key) override;
+  std::pair<std::string, uint64_t> GetValueWithSeq(const std::string& key,
+                                                   uint64_t seq) override;
+  std::string GetRange(const std::string& min_key,
+                       const std::string& max_key) override;
+
+  int SetValueWithVersion(const std::string& key, const std::string& value,
+                          int version) override;
+  std::pair<std::string, int> GetValueWithVersion(const std::string& key,
+                                                  int version) override;
+
+  std::map<std::string, std::vector<std::pair<std::string, uint64_t>>>
+  GetAllItemsWithSeq() override;
+  std::map<std::string, std::pair<std::string, int>> GetAllItems() override;
+  std::map<std::string, std::pair<std::string, int>> GetKeyRange(
+      const std::string& min_key, const std::string& max_key) override;
+
+  std::vector<std::pair<std::string, int>> GetHistory(const std::string& key,
+                                                      int min_version,
+                                                      int max_version) override;
+  std::vector<std::pair<std::string, int>> GetTopHistory(
+      const std::string& key, int top_number) override;
+
+  bool Flush() override;
+
+  void SetExecutingSeq(uint64_t seq) override;
+
+  // Prune the base storage, never above the stable seq.
+  int PruneHistory(uint64_t seq) override;
+
+  // Apply the writes up to seq to the base storage.
+  void Stabilize(uint64_t seq);
+  // Discard the writes above seq. Returns the number of seqs dropped.
+  int Rollback(uint64_t seq);
+
+  uint64_t GetStableSeq();
+  // The number of seqs in the overlay.
+  size_t GetPendingSeqNum();
+
+ private:
+  enum WriteType {
+    VALUE = 0,
+    VALUE_WITH_SEQ = 1,
+    VALUE_WITH_VERSION = 2,
+  };
+
+  struct Write {
+    std::string key;
+    // The previous value for VALUE, which is written through.
+    std::string value;
+    WriteType type;
+    // The version the write is based on, for VALUE_WITH_VERSION.
+    int version = 0;
+  };
+
+  void AddWrite(uint64_t seq, Write write);
+  void EraseIndex(uint64_t seq, const Write& write);
+
+ private:
+  std::unique_ptr<Storage> storage_;
+  std::mutex mutex_;
+  uint64_t stable_seq_ = 0;
+  uint64_t executing_seq_ = 0;
+  // The undo log, writes of each speculative seq in execution order.
+  std::map<uint64_t, std::vector<Write>> writes_;
+  // key -> <seq, value> of the speculative writes.
+  std::unordered_map<std::string, std::map<uint64_t, std::string>>
+      values_with_seq_;
+  // key -> <seq, [<value, version>]>, a seq can update a key more than once.
+  std::unordered_map<
+      std::string,
+      std::map<uint64_t, std::vector<std::pair<std::string, int>>>>
+      values_with_version_;
+};
+
+}  // namespace storage
+}  // namespace resdb
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "chain/storage/speculative_storage.h"
+
+#include <gtest/gtest.h>
+
+#include "chain/storage/memory_db.h"
+
+namespace resdb {
+namespace storage {
+namespace {
+
+class SpeculativeStorageTest : public ::testing::Test {
+ protected:
+  SpeculativeStorageTest() {
+    auto base = std::make_unique<MemoryDB>();
+    base_ = base.get();
+    storage_ = std::make_unique<SpeculativeStorage>(std::move(base));
+  }
+
+ protected:
+  MemoryDB* base_;
+  std::unique_ptr<SpeculativeStorage> storage_;
+};
+
+TEST_F(SpeculativeStorageTest, ReadOwnWrites) {
+  EXPECT_EQ(storage_->SetValueWithSeq("key", "v1", 1), 0);
+  EXPECT_EQ(storage_->SetValueWithSeq("key", "v2", 2), 0);
+  storage_->SetExecutingSeq(2);
+  EXPECT_EQ(storage_->SetValue("plain", "p2"), 0);
+
+  EXPECT_EQ(storage_->GetValueWithSeq("key", 0),
+            std::make_pair(std::string("v2"), uint64_t(2)));
+  EXPECT_EQ(storage_->GetValueWithSeq("key", 1),
+            std::make_pair(std::string("v1"), uint64_t(1)));
+  EXPECT_EQ(storage_->GetValue("plain"), "p2");
+
+  // The seq writes do not reach the base storage before they are stable.
+  EXPECT_EQ(base_->GetValueWithSeq("key", 0).first, "");
+  EXPECT_EQ(base_->GetValue("plain"), "p2");
+  EXPECT_EQ(storage_->GetPendingSeqNum(), 2);
+}
+
+TEST_F(SpeculativeStorageTest, Stabilize) {
+  storage_->SetValueWithSeq("key", "v1", 1);
+  storage_->SetValueWithSeq("key", "v2", 2);
+  storage_->SetValueWithSeq("key", "v3", 3);
+
+  storage_->Stabilize(2);
+  EXPECT_EQ(storage_->GetStableSeq(), 2);
+  EXPECT_EQ(base_->GetValueWithSeq("key", 0),
+            std::make_pair(std::string("v2"), uint64_t(2)));
+  EXPECT_EQ(base_->GetValueWithSeq("key", 1).first, "v1");
+  EXPECT_EQ(storage_->GetValueWithSeq("key", 0).first, "v3");
+  EXPECT_EQ(storage_->GetPendingSeqNum(), 1);
+
+  // Writes at or below the stable seq go to the base storage.
+  storage_->SetValueWithSeq("other", "o2", 2);
+  EXPECT_EQ(base_->GetValueWithSeq("other", 0).first, "o2");
+}
+
+TEST_F(SpeculativeStorageTest, Rollback) {
+  storage_->SetExecutingSeq(1);
+  storage_->SetValueWithSeq("key", "v1", 1);
+  storage_->SetValue("plain", "p1");
+  storage_->Stabilize(1);
+  storage_->SetExecutingSeq(2);
+  storage_->SetValueWithSeq("key", "v2", 2);
+  storage_->SetValue("plain", "p2");
+  storage_->SetExecutingSeq(3);
+  storage_->SetValueWithSeq("new", "n3", 3);
+  storage_->SetValue("plain", "p3");
+  storage_->SetValue("new_plain", "np3");
+
+  EXPECT_EQ(storage_->Rollback(1), 2);
+  EXPECT_EQ(storage_->GetValueWithSeq("key", 0).first, "v1");
+  EXPECT_EQ(storage_->GetValueWithSeq("new", 0).first, "");
+  EXPECT_EQ(storage_->GetValue("plain"), "p1");
+  EXPECT_EQ(storage_->GetValue("new_plain"), "");
+  EXPECT_EQ(base_->GetValue("plain"), "p1");
+  EXPECT_EQ(storage_->GetPendingSeqNum(), 0);
+
+  // The seqs are executed again after the rollback.
+  EXPECT_EQ(storage_->SetValueWithSeq("key", "v2'", 2), 0);
+  EXPECT_EQ(storage_->GetValueWithSeq("key", 0).first, "v2'");
+
+  // The stable writes can not be undone.
+  EXPECT_EQ(storage_->Rollback(0), 1);
+  EXPECT_EQ(storage_->GetValueWithSeq("key", 0).first, "v1");
+}
+
+TEST_F(SpeculativeStorageTest, VersionedWrites) {
+  storage_->SetExecutingSeq(1);
+  EXPECT_EQ(storage_->SetValueWithVersion("ver", "a", 0), 0);
+  EXPECT_EQ(storage_->SetValueWithVersion("ver", "b", 1), 0);
+  // The version must follow the speculative one.
+  EXPECT_EQ(storage_->SetValueWithVersion("ver", "c", 1), -2);
+
+  EXPECT_EQ(storage_->GetValueWithVersion("ver", 0),
+            std::make_pair(std::string("b"), 2));
+  EXPECT_EQ(storage_->GetValueWithVersion("ver", 1),
+            std::make_pair(std::string("a"), 1));
+  EXPECT_EQ(base_->GetValueWithVersion("ver", 0).first, "");
+
+  storage_->Stabilize(1);
+  EXPECT_EQ(base_->GetValueWithVersion("ver", 0),
+            std::make_pair(std::string("b"), 2));
+
+  storage_->SetExecutingSeq(2);
+  EXPECT_EQ(storage_->SetValueWithVersion("ver", "c", 2), 0);
+  EXPECT_EQ(storage_->GetValueWithVersion("ver", 0).first, "c");
+  // The stable versions are read from the base storage.
+  EXPECT_EQ(storage_->GetValueWithVersion("ver", 1).first, "a");
+
+  EXPECT_EQ(storage_->Rollback(1), 1);
+  EXPECT_EQ(storage_->GetValueWithVersion("ver", 0),
+            std::make_pair(std::string("b"), 2));
+}
+
+TEST_F(SpeculativeStorageTest, WritesTaggedWithExecutingSeq) {
+  storage_->Stabilize(1);
+  // The last SetValueWithSeq() is stable, the executing seq is not.
+  storage_->SetValueWithSeq("key", "v1", 1);
+  storage_->SetExecutingSeq(2);
+  EXPECT_EQ(storage_->SetValueWithVersion("ver", "a", 0), 0);
+  EXPECT_EQ(base_->GetValueWithVersion("ver", 0).first, "");
+
+  EXPECT_EQ(storage_->Rollback(1), 1);
+  EXPECT_EQ(storage_->GetValueWithVersion("ver", 0).first, "");
+}
+
+TEST_F(SpeculativeStorageTest, RangeReadsSeeOverlay) {
+  storage_->SetExecutingSeq(1);
+  storage_->SetValueWithSeq("a", "a1", 1);
+  storage_->SetValueWithVersion("k1", "x", 0);
+  storage_->SetValueWithVersion("k2", "y", 0);
+  storage_->Stabilize(1);
+
+  storage_->SetExecutingSeq(2);
+  storage_->SetValueWithSeq("a", "a2", 2);
+  storage_->SetValueWithVersion("k1", "x2", 1);
+  storage_->SetValueWithVersion("k3", "z", 0);
+  storage_->SetValue("p", "p2");
+
+  std::map<std::string, std::pair<std::string, int>> items = {
+      {"k1", {"x2", 2}}, {"k2", {"y", 1}}, {"k3", {"z", 1}}};
+  EXPECT_EQ(storage_->GetAllItems(), items);
+  items.erase("k3");
+  EXPECT_EQ(storage_->GetKeyRange("k1", "k2"), items);
+
+  std::vector<std::pair<std::string, int>> history = {{"x2", 2}, {"x", 1}};
+  EXPECT_EQ(storage_->GetHistory("k1", 1, 2), history);
+  EXPECT_EQ(storage_->GetTopHistory("k1", 2), history);
+  history.pop_back();
+  EXPECT_EQ(storage_->GetTopHistory("k1", 1), history);
+
+  std::vector<std::pair<std::string, uint64_t>> values = {{"a1", 1},
+                                                          {"a2", 2}};
+  EXPECT_EQ(storage_->GetAllItemsWithSeq()["a"], values);
+  EXPECT_EQ(storage_->GetRange("p", "p"), "[p2]");
+}
+
+}  // namespace
+}  // namespace storage
+}  // namespace resdb
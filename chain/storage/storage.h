@@ -64,8 +64,22 @@ class Storage {
 
   virtual bool Flush() { return true; };
 
+  // Whether different keys can be read and written from several threads at
+  // once, e.g. by the batches executed in parallel.
+  virtual bool IsThreadSafe() { return false; }
+
   virtual uint64_t GetLastCheckpoint() { return 0; }
 
+  // Called by the executor before it executes the batch of seq. The writes
+  // without a seq of their own, SetValue() and SetValueWithVersion(), belong
+  // to it.
+  virtual void SetExecutingSeq(uint64_t seq) {}
+
+  // Remove the versions written by SetValueWithSeq() below seq, the latest
+  // version of each key is always kept.
+  // Return the number of versions removed.
+  virtual int PruneHistory(uint64_t seq) { return 0; }
+
   void SetMaxHistoryNum(int num) { max_history_ = num; }
 
  protected:
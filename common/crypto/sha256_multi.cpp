@@ -0,0 +1,621 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/crypto/sha256_multi.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace resdb {
+namespace utils {
+
+namespace {
+
+struct State {
+  uint32_t h[8];
+};
+
+using CompressFunc = void (*)(State* const* states,
+                              const uint8_t* const* blocks, size_t num);
+
+constexpr uint32_t kInitState[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                    0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                    0x1f83d9ab, 0x5be0cd19};
+
+alignas(64) constexpr uint32_t kK[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline uint32_t LoadBE32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+inline void StoreBE32(uint8_t* p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+inline void StoreBE64(uint8_t* p, uint64_t v) {
+  StoreBE32(p, v >> 32);
+  StoreBE32(p + 4, v);
+}
+
+inline uint32_t Rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+void CompressOne(State* state, const uint8_t* block) {
+  uint32_t w[64];
+  for (int t = 0; t < 16; ++t) {
+    w[t] = LoadBE32(block + 4 * t);
+  }
+  for (int t = 16; t < 64; ++t) {
+    uint32_t s0 = Rotr(w[t - 15], 7) ^ Rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+    uint32_t s1 = Rotr(w[t - 2], 17) ^ Rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+    w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+  }
+  uint32_t a = state->h[0], b = state->h[1], c = state->h[2],
+           d = state->h[3], e = state->h[4], f = state->h[5],
+           g = state->h[6], h = state->h[7];
+  for (int t = 0; t < 64; ++t) {
+    uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) +
+                  ((e & f) ^ (~e & g)) + kK[t] + w[t];
+    uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) +
+                  ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state->h[0] += a;
+  state->h[1] += b;
+  state->h[2] += c;
+  state->h[3] += d;
+  state->h[4] += e;
+  state->h[5] += f;
+  state->h[6] += g;
+  state->h[7] += h;
+}
+
+void CompressScalar(State* const* states, const uint8_t* const* blocks,
+                    size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    CompressOne(states[i], blocks[i]);
+  }
+}
+
+#if defined(__x86_64__)
+
+// Call kernel on groups of Lanes buffers. The lanes after the last buffer
+// repeat the first one and their results are dropped.
+template <size_t Lanes, typename Kernel>
+void CompressLanes(State* const* states, const uint8_t* const* blocks,
+                   size_t num, Kernel kernel) {
+  for (size_t base = 0; base < num; base += Lanes) {
+    State* lane_states[Lanes];
+    const uint8_t* lane_blocks[Lanes];
+    State unused = *states[base];
+    for (size_t j = 0; j < Lanes; ++j) {
+      bool used = base + j < num;
+      lane_states[j] = used ? states[base + j] : &unused;
+      lane_blocks[j] = used ? blocks[base + j] : blocks[base];
+    }
+    kernel(lane_states, lane_blocks);
+  }
+}
+
+// The 16 message words of each lane, word t of lane j at words[t][j].
+template <size_t Lanes>
+void LoadWords(const uint8_t* const* blocks, uint32_t words[16][Lanes]) {
+  for (size_t j = 0; j < Lanes; ++j) {
+    for (int t = 0; t < 16; ++t) {
+      words[t][j] = LoadBE32(blocks[j] + 4 * t);
+    }
+  }
+}
+
+__attribute__((target("avx2"))) inline __m256i Rotr8(__m256i x, int n) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+__attribute__((target("avx2"))) void Compress8(State** states,
+                                               const uint8_t** blocks) {
+  alignas(32) uint32_t words[16][8];
+  LoadWords<8>(blocks, words);
+  alignas(32) uint32_t lanes[8][8];
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      lanes[i][j] = states[j]->h[i];
+    }
+  }
+
+  __m256i v[8], w[16];
+  for (int i = 0; i < 8; ++i) {
+    v[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes[i]));
+  }
+  for (int t = 0; t < 16; ++t) {
+    w[t] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[t]));
+  }
+  __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5],
+          g = v[6], h = v[7];
+  for (int t = 0; t < 64; ++t) {
+    if (t >= 16) {
+      __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+      __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(Rotr8(w15, 7),
+                                                     Rotr8(w15, 18)),
+                                    _mm256_srli_epi32(w15, 3));
+      __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(Rotr8(w2, 17),
+                                                     Rotr8(w2, 19)),
+                                    _mm256_srli_epi32(w2, 10));
+      w[t & 15] = _mm256_add_epi32(
+          _mm256_add_epi32(w[t & 15], s0),
+          _mm256_add_epi32(w[(t - 7) & 15], s1));
+    }
+    __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(Rotr8(e, 6), Rotr8(e, 11)),
+                                  Rotr8(e, 25));
+    __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f),
+                                  _mm256_andnot_si256(e, g));
+    __m256i t1 = _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(h, s1), ch),
+        _mm256_add_epi32(_mm256_set1_epi32(kK[t]), w[t & 15]));
+    __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(Rotr8(a, 2), Rotr8(a, 13)),
+                                  Rotr8(a, 22));
+    __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b),
+                                  _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    __m256i t2 = _mm256_add_epi32(s0, maj);
+    h = g;
+    g = f;
+    f = e;
+    e = _mm256_add_epi32(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm256_add_epi32(t1, t2);
+  }
+  __m256i out[8] = {a, b, c, d, e, f, g, h};
+  for (int i = 0; i < 8; ++i) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[i]),
+                       _mm256_add_epi32(v[i], out[i]));
+  }
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      states[j]->h[i] = lanes[i][j];
+    }
+  }
+}
+
+void CompressAVX2(State* const* states, const uint8_t* const* blocks,
+                  size_t num) {
+  CompressLanes<8>(states, blocks, num, Compress8);
+}
+
+__attribute__((target("avx512f"))) void Compress16(State** states,
+                                                   const uint8_t** blocks) {
+  alignas(64) uint32_t words[16][16];
+  LoadWords<16>(blocks, words);
+  alignas(64) uint32_t lanes[8][16];
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      lanes[i][j] = states[j]->h[i];
+    }
+  }
+
+  __m512i v[8], w[16];
+  for (int i = 0; i < 8; ++i) {
+    v[i] = _mm512_load_si512(lanes[i]);
+  }
+  for (int t = 0; t < 16; ++t) {
+    w[t] = _mm512_load_si512(words[t]);
+  }
+  __m512i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5],
+          g = v[6], h = v[7];
+  for (int t = 0; t < 64; ++t) {
+    if (t >= 16) {
+      __m512i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+      // 0x96 is the three-way xor.
+      __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w15, 7),
+                                             _mm512_ror_epi32(w15, 18),
+                                             _mm512_srli_epi32(w15, 3), 0x96);
+      __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w2, 17),
+                                             _mm512_ror_epi32(w2, 19),
+                                             _mm512_srli_epi32(w2, 10), 0x96);
+      w[t & 15] = _mm512_add_epi32(_mm512_add_epi32(w[t & 15], s0),
+                                   _mm512_add_epi32(w[(t - 7) & 15], s1));
+    }
+    __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(e, 6),
+                                           _mm512_ror_epi32(e, 11),
+                                           _mm512_ror_epi32(e, 25), 0x96);
+    // 0xCA selects f where e is set and g elsewhere, 0xE8 is the majority.
+    __m512i ch = _mm512_ternarylogic_epi32(e, f, g, 0xCA);
+    __m512i t1 = _mm512_add_epi32(
+        _mm512_add_epi32(_mm512_add_epi32(h, s1), ch),
+        _mm512_add_epi32(_mm512_set1_epi32(kK[t]), w[t & 15]));
+    __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(a, 2),
+                                           _mm512_ror_epi32(a, 13),
+                                           _mm512_ror_epi32(a, 22), 0x96);
+    __m512i maj = _mm512_ternarylogic_epi32(a, b, c, 0xE8);
+    __m512i t2 = _mm512_add_epi32(s0, maj);
+    h = g;
+    g = f;
+    f = e;
+    e = _mm512_add_epi32(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm512_add_epi32(t1, t2);
+  }
+  __m512i out[8] = {a, b, c, d, e, f, g, h};
+  for (int i = 0; i < 8; ++i) {
+    _mm512_store_si512(lanes[i], _mm512_add_epi32(v[i], out[i]));
+  }
+  for (int i = 0; i < 8; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      states[j]->h[i] = lanes[i][j];
+    }
+  }
+}
+
+void CompressAVX512(State* const* states, const uint8_t* const* blocks,
+                    size_t num) {
+  CompressLanes<16>(states, blocks, num, Compress16);
+}
+
+// One block with the SHA extensions. The state is kept as ABEF and CDGH as
+// required by sha256rnds2.
+__attribute__((target("sha,sse4.1"))) void CompressOneSHANI(
+    State* state, const uint8_t* block) {
+  const __m128i mask =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state->h));
+  __m128i state1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state->h + 4));
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);             // CDAB
+  state1 = _mm_shuffle_epi32(state1, 0x1B);       // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);       // CDGH
+  __m128i abef = state0, cdgh = state1;
+
+  // msgs[j % 4] holds the words of the group j - 4 when the group j starts.
+  __m128i msgs[4];
+  for (int j = 0; j < 16; ++j) {
+    __m128i msg;
+    if (j < 4) {
+      msg = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * j)),
+          mask);
+    } else {
+      msg = _mm_sha256msg1_epu32(msgs[j % 4], msgs[(j + 1) % 4]);
+      msg = _mm_add_epi32(
+          msg, _mm_alignr_epi8(msgs[(j + 3) % 4], msgs[(j + 2) % 4], 4));
+      msg = _mm_sha256msg2_epu32(msg, msgs[(j + 3) % 4]);
+    }
+    msgs[j % 4] = msg;
+    __m128i k = _mm_add_epi32(
+        msg, _mm_load_si128(reinterpret_cast<const __m128i*>(kK + 4 * j)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, k);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(k, 0x0E));
+  }
+  state0 = _mm_add_epi32(state0, abef);
+  state1 = _mm_add_epi32(state1, cdgh);
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);        // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1);     // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);  // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8);     // HGFE
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state->h), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state->h + 4), state1);
+}
+
+void CompressSHANI(State* const* states, const uint8_t* const* blocks,
+                   size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    CompressOneSHANI(states[i], blocks[i]);
+  }
+}
+
+struct CPUFeatures {
+  bool avx2 = false;
+  bool avx512 = false;
+  bool sha = false;
+};
+
+CPUFeatures DetectCPU() {
+  CPUFeatures features;
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+  bool ssse3 = ecx & (1u << 9), sse41 = ecx & (1u << 19);
+  bool osxsave = ecx & (1u << 27);
+  uint64_t xcr0 = 0;
+  if (osxsave) {
+    uint32_t lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    xcr0 = (static_cast<uint64_t>(hi) << 32) | lo;
+  }
+  // The OS has to save the ymm and zmm registers.
+  bool os_avx = (xcr0 & 0x6) == 0x6;
+  bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+  features.avx2 = os_avx && (ebx & (1u << 5));
+  features.avx512 = os_avx512 && (ebx & (1u << 16));
+  features.sha = ssse3 && sse41 && (ebx & (1u << 29));
+  return features;
+}
+
+#endif
+
+bool IsSupported(SHA256Impl impl) {
+#if defined(__x86_64__)
+  static const CPUFeatures features = DetectCPU();
+  switch (impl) {
+    case SHA256Impl::kScalar:
+      return true;
+    case SHA256Impl::kAVX2:
+      return features.avx2;
+    case SHA256Impl::kSHANI:
+      return features.sha;
+    case SHA256Impl::kAVX512:
+      return features.avx512;
+  }
+  return false;
+#else
+  return impl == SHA256Impl::kScalar;
+#endif
+}
+
+SHA256Impl DetectImpl() {
+  // SHA-NI hashes one buffer at a time, but it is as fast as the 8 lanes of
+  // AVX2 without transposing the blocks, and does not need full lanes.
+  for (SHA256Impl impl : {SHA256Impl::kAVX512, SHA256Impl::kSHANI,
+                          SHA256Impl::kAVX2}) {
+    if (IsSupported(impl)) {
+      return impl;
+    }
+  }
+  return SHA256Impl::kScalar;
+}
+
+std::atomic<SHA256Impl>& CurrentImpl() {
+  static std::atomic<SHA256Impl> impl(DetectImpl());
+  return impl;
+}
+
+CompressFunc GetCompressFunc() {
+#if defined(__x86_64__)
+  switch (CurrentImpl().load(std::memory_order_relaxed)) {
+    case SHA256Impl::kAVX2:
+      return CompressAVX2;
+    case SHA256Impl::kSHANI:
+      return CompressSHANI;
+    case SHA256Impl::kAVX512:
+      return CompressAVX512;
+    default:
+      break;
+  }
+#endif
+  return CompressScalar;
+}
+
+// The last one or two blocks of a message: the bytes after the last full
+// block, 0x80, zeros and the size in bits.
+size_t PadTail(const uint8_t* tail, size_t tail_size, uint64_t total_size,
+               uint8_t* out) {
+  size_t block_num = tail_size + 9 > 64 ? 2 : 1;
+  memset(out, 0, 64 * block_num);
+  memcpy(out, tail, tail_size);
+  out[tail_size] = 0x80;
+  StoreBE64(out + 64 * block_num - 8, total_size * 8);
+  return block_num;
+}
+
+void StoreDigest(const State& state, uint8_t* out) {
+  for (int i = 0; i < 8; ++i) {
+    StoreBE32(out + 4 * i, state.h[i]);
+  }
+}
+
+// out + 32 * i = SHA256(out + 32 * i) for the num digests in out.
+void HashDigests(uint8_t* digests, size_t num, CompressFunc compress) {
+  constexpr size_t kChunk = 64;
+  State states[kChunk];
+  State* state_ptrs[kChunk];
+  uint8_t blocks[kChunk][64];
+  const uint8_t* block_ptrs[kChunk];
+  for (size_t base = 0; base < num; base += kChunk) {
+    size_t chunk = std::min(kChunk, num - base);
+    for (size_t i = 0; i < chunk; ++i) {
+      memcpy(states[i].h, kInitState, sizeof(kInitState));
+      PadTail(digests + 32 * (base + i), 32, 32, blocks[i]);
+      state_ptrs[i] = &states[i];
+      block_ptrs[i] = blocks[i];
+    }
+    compress(state_ptrs, block_ptrs, chunk);
+    for (size_t i = 0; i < chunk; ++i) {
+      StoreDigest(states[i], digests + 32 * (base + i));
+    }
+  }
+}
+
+}  // namespace
+
+SHA256Impl GetSHA256Impl() { return CurrentImpl(); }
+
+bool IsSHA256ImplSupported(SHA256Impl impl) { return IsSupported(impl); }
+
+bool SetSHA256Impl(SHA256Impl impl) {
+  if (!IsSupported(impl)) {
+    return false;
+  }
+  CurrentImpl() = impl;
+  return true;
+}
+
+std::string GetSHA256ImplName(SHA256Impl impl) {
+  switch (impl) {
+    case SHA256Impl::kScalar:
+      return "scalar";
+    case SHA256Impl::kAVX2:
+      return "avx2";
+    case SHA256Impl::kSHANI:
+      return "sha-ni";
+    case SHA256Impl::kAVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+size_t GetSHA256LaneNum() {
+  switch (GetSHA256Impl()) {
+    case SHA256Impl::kAVX2:
+      return 8;
+    case SHA256Impl::kAVX512:
+      return 16;
+    default:
+      return 1;
+  }
+}
+
+void MultiSHA256(const std::string_view* data, size_t num, uint8_t* out) {
+  CompressFunc compress = GetCompressFunc();
+  std::vector<State> states(num);
+  std::vector<std::array<uint8_t, 128>> tails(num);
+  std::vector<size_t> block_nums(num);
+  size_t max_block_num = 0;
+  for (size_t i = 0; i < num; ++i) {
+    memcpy(states[i].h, kInitState, sizeof(kInitState));
+    size_t full_size = data[i].size() / 64 * 64;
+    block_nums[i] =
+        data[i].size() / 64 +
+        PadTail(reinterpret_cast<const uint8_t*>(data[i].data()) + full_size,
+                data[i].size() - full_size, data[i].size(), tails[i].data());
+    max_block_num = std::max(max_block_num, block_nums[i]);
+  }
+
+  // Hash the r-th block of all the buffers which have one together.
+  std::vector<State*> state_ptrs;
+  std::vector<const uint8_t*> block_ptrs;
+  for (size_t r = 0; r < max_block_num; ++r) {
+    state_ptrs.clear();
+    block_ptrs.clear();
+    for (size_t i = 0; i < num; ++i) {
+      if (r >= block_nums[i]) {
+        continue;
+      }
+      size_t full_num = data[i].size() / 64;
+      state_ptrs.push_back(&states[i]);
+      block_ptrs.push_back(
+          r < full_num ? reinterpret_cast<const uint8_t*>(data[i].data()) +
+                             64 * r
+                       : tails[i].data() + 64 * (r - full_num));
+    }
+    compress(state_ptrs.data(), block_ptrs.data(), state_ptrs.size());
+  }
+  for (size_t i = 0; i < num; ++i) {
+    StoreDigest(states[i], out + 32 * i);
+  }
+}
+
+void MultiDoubleSHA256(const std::string_view* data, size_t num,
+                       uint8_t* out) {
+  MultiSHA256(data, num, out);
+  HashDigests(out, num, GetCompressFunc());
+}
+
+NonceSHA256::NonceSHA256(const std::string& prefix)
+    : prefix_size_(prefix.size()) {
+  State state;
+  memcpy(state.h, kInitState, sizeof(kInitState));
+  size_t full_size = prefix.size() / 64 * 64;
+  for (size_t i = 0; i < full_size; i += 64) {
+    CompressOne(&state, reinterpret_cast<const uint8_t*>(prefix.data()) + i);
+  }
+  memcpy(midstate_, state.h, sizeof(midstate_));
+  tail_ = prefix.substr(full_size);
+}
+
+std::string NonceSHA256::GetMessage(const std::string& prefix,
+                                    uint64_t nonce) {
+  uint8_t buf[8];
+  StoreBE64(buf, nonce);
+  return prefix + std::string(reinterpret_cast<const char*>(buf), 8);
+}
+
+void NonceSHA256::DoubleHash(const uint64_t* nonces, size_t num,
+                             uint8_t* out) const {
+  CompressFunc compress = GetCompressFunc();
+  constexpr size_t kChunk = 64;
+  State states[kChunk];
+  State* state_ptrs[kChunk];
+  uint8_t tails[kChunk][128];
+  const uint8_t* block_ptrs[kChunk];
+  uint8_t message[64 + 8];
+  memcpy(message, tail_.data(), tail_.size());
+
+  for (size_t base = 0; base < num; base += kChunk) {
+    size_t chunk = std::min(kChunk, num - base);
+    size_t block_num = 0;
+    for (size_t i = 0; i < chunk; ++i) {
+      memcpy(states[i].h, midstate_, sizeof(midstate_));
+      StoreBE64(message + tail_.size(), nonces[base + i]);
+      block_num =
+          PadTail(message, tail_.size() + 8, prefix_size_ + 8, tails[i]);
+      state_ptrs[i] = &states[i];
+    }
+    for (size_t r = 0; r < block_num; ++r) {
+      for (size_t i = 0; i < chunk; ++i) {
+        block_ptrs[i] = tails[i] + 64 * r;
+      }
+      compress(state_ptrs, block_ptrs, chunk);
+    }
+    for (size_t i = 0; i < chunk; ++i) {
+      StoreDigest(states[i], out + 32 * (base + i));
+    }
+    HashDigests(out + 32 * base, chunk, compress);
+  }
+}
+
+}  // namespace utils
+}  // namespace resdb
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <string_view>
+
+namespace resdb {
+namespace utils {
+
+// Multi-buffer SHA-256. Several independent buffers are hashed by one
+// kernel call, one per SIMD lane (16 with AVX-512, 8 with AVX2), or one
+// after another with the SHA extensions or the portable code. The kernel is
+// picked from the CPU on the first call.
+enum class SHA256Impl {
+  kScalar = 0,
+  kAVX2 = 1,
+  kSHANI = 2,
+  kAVX512 = 3,
+};
+
+SHA256Impl GetSHA256Impl();
+bool IsSHA256ImplSupported(SHA256Impl impl);
+// Force the kernel, used by tests and benchmarks.
+// Return false if the CPU does not support it.
+bool SetSHA256Impl(SHA256Impl impl);
+std::string GetSHA256ImplName(SHA256Impl impl);
+// The number of buffers hashed together by the kernel in use.
+size_t GetSHA256LaneNum();
+
+// Write SHA256(data[i]) to out + 32 * i for i < num. The buffers may have
+// different sizes.
+void MultiSHA256(const std::string_view* data, size_t num, uint8_t* out);
+// Write SHA256(SHA256(data[i])) to out + 32 * i for i < num.
+void MultiDoubleSHA256(const std::string_view* data, size_t num,
+                       uint8_t* out);
+
+// Double SHA-256 of a fixed prefix followed by a nonce encoded as 8
+// big-endian bytes, as used by the PoW. The full 64-byte blocks of the
+// prefix are hashed once at construction.
+class NonceSHA256 {
+ public:
+  explicit NonceSHA256(const std::string& prefix);
+
+  // The message hashed for the nonce.
+  static std::string GetMessage(const std::string& prefix, uint64_t nonce);
+
+  // Write SHA256(SHA256(prefix + nonce[i])) to out + 32 * i for i < num.
+  void DoubleHash(const uint64_t* nonces, size_t num, uint8_t* out) const;
+
+ private:
+  uint32_t midstate_[8];
+  std::string tail_;
+  uint64_t prefix_size_;
+};
+
+}  // namespace utils
+}  // namespace resdb
@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/crypto/sha256_multi.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "common/crypto/hash.h"
+
+namespace resdb {
+namespace utils {
+namespace {
+
+std::string ToHex(const uint8_t* digest) {
+  static const char kHex[] = "0123456789abcdef";
+  std::string hex;
+  for (int i = 0; i < 32; ++i) {
+    hex += kHex[digest[i] >> 4];
+    hex += kHex[digest[i] & 0xf];
+  }
+  return hex;
+}
+
+std::string ToString(const uint8_t* digest) {
+  return std::string(reinterpret_cast<const char*>(digest), 32);
+}
+
+class MultiSHA256Test : public ::testing::TestWithParam<SHA256Impl> {
+ protected:
+  void SetUp() override {
+    default_impl_ = GetSHA256Impl();
+    if (!SetSHA256Impl(GetParam())) {
+      GTEST_SKIP() << GetSHA256ImplName(GetParam()) << " is not supported";
+    }
+  }
+  void TearDown() override { SetSHA256Impl(default_impl_); }
+
+  SHA256Impl default_impl_;
+};
+
+TEST_P(MultiSHA256Test, KnownDigests) {
+  std::vector<std::string_view> data = {
+      "", "abc", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"};
+  uint8_t out[3 * 32];
+  MultiSHA256(data.data(), data.size(), out);
+  EXPECT_EQ(ToHex(out),
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  EXPECT_EQ(ToHex(out + 32),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  EXPECT_EQ(ToHex(out + 64),
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+TEST_P(MultiSHA256Test, DifferentSizes) {
+  std::mt19937 rng(0);
+  std::vector<std::string> buffers;
+  for (size_t size = 0; size < 300; size += 7) {
+    std::string buffer(size, 0);
+    for (char& c : buffer) {
+      c = rng();
+    }
+    buffers.push_back(buffer);
+  }
+  std::vector<std::string_view> data(buffers.begin(), buffers.end());
+  std::vector<uint8_t> out(32 * data.size());
+  MultiSHA256(data.data(), data.size(), out.data());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    EXPECT_EQ(ToString(&out[32 * i]), CalculateSHA256Hash(buffers[i]));
+  }
+
+  MultiDoubleSHA256(data.data(), data.size(), out.data());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    EXPECT_EQ(ToString(&out[32 * i]),
+              CalculateSHA256Hash(CalculateSHA256Hash(buffers[i])));
+  }
+}
+
+TEST_P(MultiSHA256Test, Nonces) {
+  // Prefixes with no full block, one full block and a two-block tail.
+  for (size_t prefix_size : {10, 64, 120}) {
+    std::string prefix(prefix_size, 'p');
+    NonceSHA256 hasher(prefix);
+    std::vector<uint64_t> nonces;
+    for (uint64_t nonce = 0; nonce < 100; ++nonce) {
+      nonces.push_back(nonce * 0x0102030405ULL);
+    }
+    std::vector<uint8_t> out(32 * nonces.size());
+    hasher.DoubleHash(nonces.data(), nonces.size(), out.data());
+    for (size_t i = 0; i < nonces.size(); ++i) {
+      EXPECT_EQ(ToString(&out[32 * i]),
+                CalculateSHA256Hash(CalculateSHA256Hash(
+                    NonceSHA256::GetMessage(prefix, nonces[i]))));
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Impls, MultiSHA256Test,
+                         ::testing::Values(SHA256Impl::kScalar,
+                                           SHA256Impl::kAVX2,
+                                           SHA256Impl::kSHANI,
+                                           SHA256Impl::kAVX512));
+
+}  // namespace
+}  // namespace utils
+}  // namespace resdb
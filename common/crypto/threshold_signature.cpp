@@ -0,0 +1,442 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/crypto/threshold_signature.h"
+
+#include <cryptopp/nbtheory.h>
+#include <cryptopp/osrng.h>
+#include <glog/logging.h>
+
+#include <set>
+
+#include "common/crypto/hash.h"
+
+namespace resdb {
+
+namespace {
+
+using CryptoPP::Integer;
+
+// The public exponent, it must be a prime larger than player_num.
+constexpr long kPublicExponent = 65537;
+// The bits of the share proof challenge, the output size of SHA256.
+constexpr size_t kChallengeBits = 256;
+
+std::string EncodeInteger(const Integer& value) {
+  std::string data(value.MinEncodedSize(), '\0');
+  value.Encode(reinterpret_cast<CryptoPP::byte*>(&data[0]), data.size());
+  return data;
+}
+
+Integer DecodeInteger(const std::string& data) {
+  return Integer(reinterpret_cast<const CryptoPP::byte*>(data.data()),
+                 data.size());
+}
+
+Integer Factorial(uint32_t n) {
+  Integer value = Integer::One();
+  for (uint32_t i = 2; i <= n; ++i) {
+    value *= Integer(static_cast<long>(i));
+  }
+  return value;
+}
+
+// Generate a safe prime p = 2 * sub_prime + 1.
+void GenerateSafePrime(CryptoPP::RandomNumberGenerator& rng, uint32_t bits,
+                       Integer* prime, Integer* sub_prime) {
+  CryptoPP::PrimeAndGenerator generator;
+  generator.Generate(1, rng, bits, bits - 1);
+  *prime = generator.Prime();
+  *sub_prime = generator.SubPrime();
+}
+
+}  // namespace
+
+ThresholdSignature::ThresholdSignature(const ThresholdPublicKey& public_key)
+    : public_key_(public_key),
+      n_(DecodeInteger(public_key.modulus())),
+      e_(DecodeInteger(public_key.public_exponent())),
+      delta_(Factorial(public_key.player_num())),
+      modulus_bytes_(public_key.modulus().size()) {
+  if (!public_key.verification_base().empty() &&
+      public_key.verification_keys_size() ==
+          static_cast<int>(public_key.player_num())) {
+    verification_base_ = DecodeInteger(public_key.verification_base());
+    for (const std::string& key : public_key.verification_keys()) {
+      verification_keys_.push_back(DecodeInteger(key));
+    }
+  }
+}
+
+ThresholdSignature::ThresholdSignature(const ThresholdKeyShare& key_share)
+    : ThresholdSignature(key_share.public_key()) {
+  share_ = DecodeInteger(key_share.share());
+  node_id_ = key_share.node_id();
+}
+
+absl::StatusOr<std::vector<ThresholdKeyShare>> ThresholdSignature::GenerateKeys(
+    uint32_t player_num, uint32_t threshold, uint32_t modulus_bits) {
+  if (threshold == 0 || threshold > player_num ||
+      player_num >= kPublicExponent) {
+    return absl::InvalidArgumentError("invalid threshold parameters");
+  }
+  if (modulus_bits < 256) {
+    return absl::InvalidArgumentError("modulus is too small");
+  }
+
+  CryptoPP::AutoSeededRandomPool rng;
+  Integer p, p1, q, q1;
+  GenerateSafePrime(rng, modulus_bits / 2, &p, &p1);
+  do {
+    GenerateSafePrime(rng, modulus_bits - modulus_bits / 2, &q, &q1);
+  } while (p == q);
+
+  Integer n = p * q;
+  Integer m = p1 * q1;
+  Integer e(kPublicExponent);
+  Integer d = e.InverseMod(m);
+
+  // f(X) = d + a_1 X + ... + a_{k-1} X^{k-1} mod m, share i is f(i).
+  std::vector<Integer> coefficients = {d};
+  for (uint32_t i = 1; i < threshold; ++i) {
+    coefficients.push_back(Integer(rng, Integer::Zero(), m - 1));
+  }
+
+  ThresholdPublicKey public_key;
+  public_key.set_modulus(EncodeInteger(n));
+  public_key.set_public_exponent(EncodeInteger(e));
+  public_key.set_player_num(player_num);
+  public_key.set_threshold(threshold);
+
+  // The verification base v is a random square, which generates the
+  // squares of Z_n* with high probability.
+  Integer r(rng, Integer::Two(), n - 2);
+  Integer v = (r * r) % n;
+  public_key.set_verification_base(EncodeInteger(v));
+
+  std::vector<Integer> values;
+  for (uint32_t i = 1; i <= player_num; ++i) {
+    Integer x(static_cast<long>(i));
+    Integer value = Integer::Zero();
+    for (auto it = coefficients.rbegin(); it != coefficients.rend(); ++it) {
+      value = (value * x + *it) % m;
+    }
+    public_key.add_verification_keys(EncodeInteger(a_exp_b_mod_c(v, value, n)));
+    values.push_back(value);
+  }
+
+  std::vector<ThresholdKeyShare> shares;
+  for (uint32_t i = 1; i <= player_num; ++i) {
+    ThresholdKeyShare share;
+    *share.mutable_public_key() = public_key;
+    share.set_node_id(i);
+    share.set_share(EncodeInteger(values[i - 1]));
+    shares.push_back(std::move(share));
+  }
+  return shares;
+}
+
+// Full domain hash: expand SHA256 to the modulus size plus 128 bits
+// and reduce modulo n.
+Integer ThresholdSignature::HashToGroup(const std::string& message) const {
+  std::string digest;
+  for (uint32_t counter = 0; digest.size() < modulus_bytes_ + 16; ++counter) {
+    digest += utils::CalculateSHA256Hash(std::to_string(counter) + ":" +
+                                         message);
+  }
+  return DecodeInteger(digest) % n_;
+}
+
+bool ThresholdSignature::VerifyInteger(const Integer& x,
+                                       const Integer& signature) const {
+  if (signature.IsNegative() || signature >= n_) {
+    return false;
+  }
+  return a_exp_b_mod_c(signature, e_, n_) == x;
+}
+
+// c = H(v, x~, v_i, x_i^2, v^r, x~^r), each value is prefixed with its size.
+Integer ThresholdSignature::ShareChallenge(const Integer& x_tilde,
+                                           const Integer& v_i,
+                                           const Integer& x_i_square,
+                                           const Integer& v_r,
+                                           const Integer& x_r) const {
+  std::string data;
+  for (const Integer* value :
+       {&verification_base_, &x_tilde, &v_i, &x_i_square, &v_r, &x_r}) {
+    std::string encoded = EncodeInteger(*value);
+    data += std::to_string(encoded.size()) + ":" + encoded;
+  }
+  return DecodeInteger(utils::CalculateSHA256Hash(data));
+}
+
+absl::StatusOr<SignatureInfo> ThresholdSignature::SignShare(
+    const std::string& message) const {
+  if (!CanSign()) {
+    return absl::FailedPreconditionError("no key share");
+  }
+  Integer x = HashToGroup(message);
+  Integer value = a_exp_b_mod_c(x, Integer::Two() * delta_ * share_, n_);
+
+  SignatureInfo info;
+  info.set_hash_type(SignatureInfo::THRESHOLD_RSA);
+  info.set_node_id(node_id_);
+  info.set_signature(EncodeInteger(value));
+
+  if (static_cast<size_t>(node_id_) <= verification_keys_.size()) {
+    // Prove log_v(v_i) = log_{x~}(x_i^2) with x~ = x^(4 * delta):
+    // z = share * c + r for a random r of L(n) + 2 * kChallengeBits bits.
+    CryptoPP::AutoSeededRandomPool rng;
+    Integer r(rng, Integer::Zero(),
+              Integer::Power2(modulus_bytes_ * 8 + 2 * kChallengeBits));
+    Integer x_tilde = a_exp_b_mod_c(x, Integer(4) * delta_, n_);
+    Integer c = ShareChallenge(
+        x_tilde, verification_keys_[node_id_ - 1], (value * value) % n_,
+        a_exp_b_mod_c(verification_base_, r, n_),
+        a_exp_b_mod_c(x_tilde, r, n_));
+    info.mutable_share_proof()->set_challenge(EncodeInteger(c));
+    info.mutable_share_proof()->set_response(EncodeInteger(share_ * c + r));
+  }
+  return info;
+}
+
+bool ThresholdSignature::VerifyShare(const std::string& message,
+                                     const SignatureInfo& share) const {
+  if (!IsWellFormedShare(&share) || verification_keys_.empty() ||
+      share.share_proof().challenge().empty() ||
+      share.share_proof().response().empty()) {
+    return false;
+  }
+  Integer x_i = DecodeInteger(share.signature());
+  if (x_i.IsZero() || x_i >= n_) {
+    return false;
+  }
+  Integer c = DecodeInteger(share.share_proof().challenge());
+  Integer z = DecodeInteger(share.share_proof().response());
+  const Integer& v_i = verification_keys_[share.node_id() - 1];
+  Integer x_tilde = a_exp_b_mod_c(HashToGroup(message), Integer(4) * delta_,
+                                  n_);
+  Integer x_i_square = (x_i * x_i) % n_;
+  // v^z * v_i^(-c) and x~^z * x_i^(-2c) recover v^r and x~^r.
+  Integer v_r = (a_exp_b_mod_c(verification_base_, z, n_) *
+                 a_exp_b_mod_c(v_i.InverseMod(n_), c, n_)) %
+                n_;
+  Integer x_r = (a_exp_b_mod_c(x_tilde, z, n_) *
+                 a_exp_b_mod_c(x_i_square.InverseMod(n_), c, n_)) %
+                n_;
+  return ShareChallenge(x_tilde, v_i, x_i_square, v_r, x_r) == c;
+}
+
+bool ThresholdSignature::IsWellFormedShare(const SignatureInfo* share) const {
+  return share != nullptr &&
+         share->hash_type() == SignatureInfo::THRESHOLD_RSA &&
+         share->node_id() >= 1 && share->node_id() <= GetPlayerNum() &&
+         !share->signature().empty();
+}
+
+absl::StatusOr<QuorumCertificate> ThresholdSignature::Combine(
+    const std::string& message,
+    const std::vector<const SignatureInfo*>& shares) const {
+  uint32_t threshold = GetThreshold();
+  std::vector<std::pair<long, Integer>> used;
+  std::set<long> signers;
+  for (const SignatureInfo* share : shares) {
+    if (used.size() >= threshold) {
+      break;
+    }
+    if (!IsWellFormedShare(share)) {
+      continue;
+    }
+    if (!signers.insert(share->node_id()).second) {
+      continue;
+    }
+    used.push_back(std::make_pair(static_cast<long>(share->node_id()),
+                                  DecodeInteger(share->signature()) % n_));
+  }
+  if (used.size() < threshold) {
+    return absl::FailedPreconditionError("not enough signature shares");
+  }
+
+  Integer x = HashToGroup(message);
+  Integer y = CombineShares(x, used);
+  if (!VerifyInteger(x, y)) {
+    // Some of the shares are corrupted, which is expected from a faulty
+    // signer. Pick the valid ones so that the certificate only depends on
+    // the honest shares.
+    used.clear();
+    signers.clear();
+    for (const SignatureInfo* share : shares) {
+      if (used.size() >= threshold) {
+        break;
+      }
+      if (!IsWellFormedShare(share) ||
+          signers.count(share->node_id()) > 0 ||
+          !VerifyShare(message, *share)) {
+        continue;
+      }
+      signers.insert(share->node_id());
+      used.push_back(std::make_pair(static_cast<long>(share->node_id()),
+                                    DecodeInteger(share->signature())));
+    }
+    if (used.size() < threshold) {
+      return absl::InvalidArgumentError("invalid signature share");
+    }
+    y = CombineShares(x, used);
+    if (!VerifyInteger(x, y)) {
+      return absl::InvalidArgumentError("invalid signature share");
+    }
+  }
+
+  QuorumCertificate cert;
+  cert.set_signature(EncodeInteger(y));
+  for (const auto& it : used) {
+    AddSigner(&cert, it.first);
+  }
+  return cert;
+}
+
+Integer ThresholdSignature::CombineShares(
+    const Integer& x, const std::vector<std::pair<long, Integer>>& used) const {
+  // w = prod x_j^(2 * lambda_j), where lambda_j = delta * prod_{j' != j}
+  // j' / (j' - j) is the Lagrange coefficient at 0 scaled to an integer.
+  Integer w = Integer::One();
+  for (const auto& [j, x_j] : used) {
+    Integer numerator = delta_;
+    Integer denominator = Integer::One();
+    for (const auto& it : used) {
+      if (it.first == j) {
+        continue;
+      }
+      numerator *= Integer(it.first);
+      denominator *= Integer(it.first - j);
+    }
+    bool negative = numerator.IsNegative() != denominator.IsNegative();
+    Integer lambda = numerator.AbsoluteValue() / denominator.AbsoluteValue();
+    Integer value = a_exp_b_mod_c(x_j, Integer::Two() * lambda, n_);
+    if (negative) {
+      value = value.InverseMod(n_);
+    }
+    w = (w * value) % n_;
+  }
+
+  // w^e = x^(4 * delta^2). Find a * 4 * delta^2 + b * e = 1, then
+  // y = w^a * x^b satisfies y^e = x.
+  Integer e_prime = Integer(4) * delta_ * delta_;
+  Integer a = e_prime.InverseMod(e_);
+  Integer b = (a * e_prime - Integer::One()) / e_;  // y = w^a * x^(-b)
+  return (a_exp_b_mod_c(w, a, n_) * a_exp_b_mod_c(x.InverseMod(n_), b, n_)) %
+         n_;
+}
+
+bool ThresholdSignature::Verify(const std::string& message,
+                                const QuorumCertificate& cert) const {
+  if (cert.signature().empty() || n_.IsZero()) {
+    return false;
+  }
+  if (GetSignerNum(cert) < GetThreshold()) {
+    return false;
+  }
+  return VerifyInteger(HashToGroup(message), DecodeInteger(cert.signature()));
+}
+
+absl::StatusOr<QuorumCertificate> ThresholdSignature::Aggregate(
+    const std::vector<const QuorumCertificate*>& certs) const {
+  if (certs.empty() || n_.IsZero()) {
+    return absl::InvalidArgumentError("no certificate to aggregate");
+  }
+  QuorumCertificate aggregate_cert;
+  Integer y = Integer::One();
+  for (const QuorumCertificate* cert : certs) {
+    if (cert == nullptr || cert->signature().empty() ||
+        GetSignerNum(*cert) < GetThreshold()) {
+      return absl::InvalidArgumentError("invalid certificate");
+    }
+    y = (y * DecodeInteger(cert->signature())) % n_;
+    std::string* bitmap = aggregate_cert.mutable_signer_bitmap();
+    if (bitmap->size() < cert->signer_bitmap().size()) {
+      bitmap->resize(cert->signer_bitmap().size(), '\0');
+    }
+    for (size_t i = 0; i < cert->signer_bitmap().size(); ++i) {
+      (*bitmap)[i] |= cert->signer_bitmap()[i];
+    }
+  }
+  aggregate_cert.set_signature(EncodeInteger(y));
+  return aggregate_cert;
+}
+
+bool ThresholdSignature::VerifyAggregate(
+    const std::vector<std::string>& messages,
+    const QuorumCertificate& cert) const {
+  if (messages.empty() || cert.signature().empty() || n_.IsZero()) {
+    return false;
+  }
+  Integer x = Integer::One();
+  for (const std::string& message : messages) {
+    x = (x * HashToGroup(message)) % n_;
+  }
+  return VerifyInteger(x, DecodeInteger(cert.signature()));
+}
+
+uint32_t ThresholdSignature::GetThreshold() const {
+  return public_key_.threshold();
+}
+
+uint32_t ThresholdSignature::GetPlayerNum() const {
+  return public_key_.player_num();
+}
+
+int64_t ThresholdSignature::GetNodeId() const { return node_id_; }
+
+bool ThresholdSignature::CanSign() const {
+  return node_id_ > 0 && !share_.IsZero();
+}
+
+const ThresholdPublicKey& ThresholdSignature::GetPublicKey() const {
+  return public_key_;
+}
+
+bool ThresholdSignature::HasSigner(const QuorumCertificate& cert,
+                                   int64_t node_id) {
+  if (node_id < 0 ||
+      static_cast<size_t>(node_id / 8) >= cert.signer_bitmap().size()) {
+    return false;
+  }
+  return cert.signer_bitmap()[node_id / 8] & (1 << (node_id % 8));
+}
+
+uint32_t ThresholdSignature::GetSignerNum(const QuorumCertificate& cert) {
+  uint32_t num = 0;
+  for (unsigned char c : cert.signer_bitmap()) {
+    num += __builtin_popcount(c);
+  }
+  return num;
+}
+
+void ThresholdSignature::AddSigner(QuorumCertificate* cert, int64_t node_id) {
+  if (node_id < 0) {
+    return;
+  }
+  std::string* bitmap = cert->mutable_signer_bitmap();
+  if (bitmap->size() <= static_cast<size_t>(node_id / 8)) {
+    bitmap->resize(node_id / 8 + 1, '\0');
+  }
+  (*bitmap)[node_id / 8] |= (1 << (node_id % 8));
+}
+
+}  // namespace resdb
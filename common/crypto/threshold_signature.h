@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <cryptopp/integer.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "common/proto/signature_info.pb.h"
+
+namespace resdb {
+
+// ThresholdSignature implements Shoup's practical threshold RSA
+// ("Practical Threshold Signatures", EUROCRYPT 2000): any `threshold` of the
+// `player_num` replicas can sign shares which are combined into one standard
+// RSA signature. The combined certificate has a constant size and is
+// verified with a single exponentiation using the public key, regardless of
+// the number of signers.
+//
+// Keys are produced by a trusted dealer (see GenerateKeys) and share
+// i belongs to the replica whose node_id is i (1 <= i <= player_num).
+class ThresholdSignature {
+ public:
+  // Verifier only: can verify certificates and combine shares, but not sign.
+  explicit ThresholdSignature(const ThresholdPublicKey& public_key);
+  // Signer: can also sign shares with the key share of key_share.node_id().
+  explicit ThresholdSignature(const ThresholdKeyShare& key_share);
+
+  // RSA moduli below 2048 bits are not considered secure.
+  static constexpr uint32_t kDefaultModulusBits = 2048;
+
+  // Dealer: generate a public key with player_num shares, any threshold of
+  // them are able to create a certificate.
+  static absl::StatusOr<std::vector<ThresholdKeyShare>> GenerateKeys(
+      uint32_t player_num, uint32_t threshold,
+      uint32_t modulus_bits = kDefaultModulusBits);
+
+  // Sign the share of the message. The result has hash type THRESHOLD_RSA
+  // and carries the proof of correctness checked by VerifyShare().
+  absl::StatusOr<SignatureInfo> SignShare(const std::string& message) const;
+
+  // Verify a single share against the verification key of its signer.
+  // Returns false if the public key has no verification keys.
+  bool VerifyShare(const std::string& message,
+                   const SignatureInfo& share) const;
+
+  // Combine the shares of the message into a certificate. The first
+  // `threshold` shares from distinct signers are tried first; if the result
+  // does not verify, the shares are checked one by one and the certificate
+  // is combined from the valid ones. Fails if there are not enough valid
+  // shares.
+  //
+  // The cost is one modular exponentiation per share, with an exponent of
+  // about log2(player_num!) bits, and one with the public exponent to check
+  // the result, so it grows faster than the number of shares. A corrupted
+  // share adds the check of every share, four exponentiations with
+  // exponents longer than the modulus each.
+  absl::StatusOr<QuorumCertificate> Combine(
+      const std::string& message,
+      const std::vector<const SignatureInfo*>& shares) const;
+
+  bool Verify(const std::string& message, const QuorumCertificate& cert) const;
+
+  // Aggregate the certificates of different messages into one certificate
+  // by multiplying the signatures (condensed RSA). It is checked against
+  // all the messages at once by VerifyAggregate() with one exponentiation.
+  // The signer bitmap is the union of the ones of the certificates.
+  absl::StatusOr<QuorumCertificate> Aggregate(
+      const std::vector<const QuorumCertificate*>& certs) const;
+  bool VerifyAggregate(const std::vector<std::string>& messages,
+                       const QuorumCertificate& cert) const;
+
+  uint32_t GetThreshold() const;
+  uint32_t GetPlayerNum() const;
+  int64_t GetNodeId() const;
+  bool CanSign() const;
+  const ThresholdPublicKey& GetPublicKey() const;
+
+  // Helpers for the signer bitmap of a certificate.
+  static bool HasSigner(const QuorumCertificate& cert, int64_t node_id);
+  static uint32_t GetSignerNum(const QuorumCertificate& cert);
+  static void AddSigner(QuorumCertificate* cert, int64_t node_id);
+
+ private:
+  CryptoPP::Integer HashToGroup(const std::string& message) const;
+  bool VerifyInteger(const CryptoPP::Integer& x,
+                     const CryptoPP::Integer& signature) const;
+  bool IsWellFormedShare(const SignatureInfo* share) const;
+  // Returns the signature combined from exactly `threshold` shares.
+  CryptoPP::Integer CombineShares(
+      const CryptoPP::Integer& x,
+      const std::vector<std::pair<long, CryptoPP::Integer>>& shares) const;
+  CryptoPP::Integer ShareChallenge(
+      const CryptoPP::Integer& x_tilde, const CryptoPP::Integer& v_i,
+      const CryptoPP::Integer& x_i_square, const CryptoPP::Integer& v_r,
+      const CryptoPP::Integer& x_r) const;
+
+ private:
+  ThresholdPublicKey public_key_;
+  CryptoPP::Integer n_, e_;
+  // delta_ = player_num!, used to keep the Lagrange coefficients integral.
+  CryptoPP::Integer delta_;
+  CryptoPP::Integer share_;
+  // v and v_i, empty for keys generated without verification keys.
+  CryptoPP::Integer verification_base_;
+  std::vector<CryptoPP::Integer> verification_keys_;
+  int64_t node_id_ = 0;
+  size_t modulus_bytes_ = 0;
+};
+
+}  // namespace resdb
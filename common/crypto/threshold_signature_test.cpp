@@ -0,0 +1,189 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/crypto/threshold_signature.h"
+
+#include <gtest/gtest.h>
+
+namespace resdb {
+namespace {
+
+class ThresholdSignatureTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    auto keys = ThresholdSignature::GenerateKeys(4, 3, 512);
+    ASSERT_TRUE(keys.ok());
+    keys_ = new std::vector<ThresholdKeyShare>(std::move(*keys));
+  }
+
+  static void TearDownTestSuite() { delete keys_; }
+
+  std::vector<SignatureInfo> SignShares(const std::string& message,
+                                        const std::vector<int>& ids) {
+    std::vector<SignatureInfo> shares;
+    for (int id : ids) {
+      auto share = ThresholdSignature((*keys_)[id - 1]).SignShare(message);
+      EXPECT_TRUE(share.ok());
+      shares.push_back(*share);
+    }
+    return shares;
+  }
+
+  std::vector<const SignatureInfo*> Pointers(
+      const std::vector<SignatureInfo>& shares) {
+    std::vector<const SignatureInfo*> ptrs;
+    for (const auto& share : shares) {
+      ptrs.push_back(&share);
+    }
+    return ptrs;
+  }
+
+  static std::vector<ThresholdKeyShare>* keys_;
+};
+
+std::vector<ThresholdKeyShare>* ThresholdSignatureTest::keys_ = nullptr;
+
+TEST_F(ThresholdSignatureTest, CombineAnyQuorum) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  std::string message = "test message";
+
+  std::string signature;
+  for (const auto& ids : std::vector<std::vector<int>>{
+           {1, 2, 3}, {2, 3, 4}, {4, 1, 3}, {1, 2, 3, 4}}) {
+    auto shares = SignShares(message, ids);
+    auto cert = verifier.Combine(message, Pointers(shares));
+    ASSERT_TRUE(cert.ok());
+    EXPECT_TRUE(verifier.Verify(message, *cert));
+    EXPECT_EQ(ThresholdSignature::GetSignerNum(*cert), 3);
+    // The combined signature is the unique RSA signature of the message.
+    if (signature.empty()) {
+      signature = cert->signature();
+    }
+    EXPECT_EQ(cert->signature(), signature);
+  }
+}
+
+TEST_F(ThresholdSignatureTest, SignerBitmap) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  auto shares = SignShares("test", {2, 3, 4});
+  auto cert = verifier.Combine("test", Pointers(shares));
+  ASSERT_TRUE(cert.ok());
+  EXPECT_FALSE(ThresholdSignature::HasSigner(*cert, 1));
+  EXPECT_TRUE(ThresholdSignature::HasSigner(*cert, 2));
+  EXPECT_TRUE(ThresholdSignature::HasSigner(*cert, 3));
+  EXPECT_TRUE(ThresholdSignature::HasSigner(*cert, 4));
+  EXPECT_FALSE(ThresholdSignature::HasSigner(*cert, 100));
+}
+
+TEST_F(ThresholdSignatureTest, NotEnoughShares) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  auto shares = SignShares("test", {1, 2});
+  // Duplicated shares do not count.
+  shares.push_back(shares[0]);
+  EXPECT_FALSE(verifier.Combine("test", Pointers(shares)).ok());
+}
+
+TEST_F(ThresholdSignatureTest, InvalidShare) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  auto shares = SignShares("test", {1, 2});
+  auto other = SignShares("other", {3});
+  shares.push_back(other[0]);
+  EXPECT_FALSE(verifier.Combine("test", Pointers(shares)).ok());
+}
+
+TEST_F(ThresholdSignatureTest, VerifyShare) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  auto shares = SignShares("test", {1, 2, 3, 4});
+  for (const auto& share : shares) {
+    EXPECT_TRUE(verifier.VerifyShare("test", share));
+    EXPECT_FALSE(verifier.VerifyShare("other", share));
+  }
+
+  SignatureInfo wrong_signer = shares[0];
+  wrong_signer.set_node_id(2);
+  EXPECT_FALSE(verifier.VerifyShare("test", wrong_signer));
+
+  // A share of another message with a proof copied from a valid share.
+  SignatureInfo forged = SignShares("other", {1})[0];
+  *forged.mutable_share_proof() = shares[0].share_proof();
+  EXPECT_FALSE(verifier.VerifyShare("test", forged));
+
+  SignatureInfo no_proof = shares[0];
+  no_proof.clear_share_proof();
+  EXPECT_FALSE(verifier.VerifyShare("test", no_proof));
+}
+
+TEST_F(ThresholdSignatureTest, CombineSkipsInvalidShare) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  auto shares = SignShares("test", {1, 2, 3, 4});
+  // The first share comes from a faulty signer.
+  shares[0] = SignShares("other", {1})[0];
+  auto cert = verifier.Combine("test", Pointers(shares));
+  ASSERT_TRUE(cert.ok());
+  EXPECT_TRUE(verifier.Verify("test", *cert));
+  EXPECT_FALSE(ThresholdSignature::HasSigner(*cert, 1));
+  EXPECT_EQ(ThresholdSignature::GetSignerNum(*cert), 3);
+}
+
+TEST_F(ThresholdSignatureTest, VerifyFail) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  auto shares = SignShares("test", {1, 2, 3});
+  auto cert = verifier.Combine("test", Pointers(shares));
+  ASSERT_TRUE(cert.ok());
+  EXPECT_FALSE(verifier.Verify("test2", *cert));
+
+  QuorumCertificate less_signers = *cert;
+  less_signers.clear_signer_bitmap();
+  ThresholdSignature::AddSigner(&less_signers, 1);
+  EXPECT_FALSE(verifier.Verify("test", less_signers));
+}
+
+TEST_F(ThresholdSignatureTest, Aggregate) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  std::vector<std::string> messages = {"test1", "test2", "test3"};
+  std::vector<QuorumCertificate> certs;
+  for (const std::string& message : messages) {
+    auto shares = SignShares(message, {1, 2, 3});
+    auto cert = verifier.Combine(message, Pointers(shares));
+    ASSERT_TRUE(cert.ok());
+    certs.push_back(*cert);
+  }
+  auto aggregate_cert =
+      verifier.Aggregate({&certs[0], &certs[1], &certs[2]});
+  ASSERT_TRUE(aggregate_cert.ok());
+  EXPECT_TRUE(verifier.VerifyAggregate(messages, *aggregate_cert));
+  EXPECT_EQ(ThresholdSignature::GetSignerNum(*aggregate_cert), 3);
+
+  EXPECT_FALSE(verifier.VerifyAggregate({"test1", "test2"}, *aggregate_cert));
+  EXPECT_FALSE(verifier.VerifyAggregate({"test1", "test2", "test4"},
+                                        *aggregate_cert));
+
+  QuorumCertificate less_signers = certs[0];
+  less_signers.clear_signer_bitmap();
+  EXPECT_FALSE(verifier.Aggregate({&less_signers, &certs[1]}).ok());
+}
+
+TEST_F(ThresholdSignatureTest, VerifierCanNotSign) {
+  ThresholdSignature verifier((*keys_)[0].public_key());
+  EXPECT_FALSE(verifier.CanSign());
+  EXPECT_FALSE(verifier.SignShare("test").ok());
+}
+
+}  // namespace
+}  // namespace resdb
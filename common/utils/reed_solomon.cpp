@@ -0,0 +1,213 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/utils/reed_solomon.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace resdb {
+
+namespace {
+
+// GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1.
+struct GaloisField {
+  GaloisField() {
+    int x = 1;
+    for (int i = 0; i < 255; ++i) {
+      exp[i] = x;
+      exp[i + 255] = x;
+      log[x] = i;
+      x <<= 1;
+      if (x & 0x100) {
+        x ^= 0x11d;
+      }
+    }
+    for (int a = 0; a < 256; ++a) {
+      for (int b = 0; b < 256; ++b) {
+        mul[a][b] = a && b ? exp[log[a] + log[b]] : 0;
+      }
+    }
+  }
+
+  uint8_t Inv(uint8_t a) const { return exp[255 - log[a]]; }
+
+  uint8_t exp[510];
+  uint8_t log[256];
+  uint8_t mul[256][256];
+};
+
+const GaloisField& GF() {
+  static const GaloisField gf;
+  return gf;
+}
+
+// out ^= c * in
+void MulAdd(uint8_t c, const char* in, char* out, size_t size) {
+  if (c == 0) {
+    return;
+  }
+  const uint8_t* row = GF().mul[c];
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(in);
+  uint8_t* dst = reinterpret_cast<uint8_t*>(out);
+  for (size_t i = 0; i < size; ++i) {
+    dst[i] ^= row[src[i]];
+  }
+}
+
+// Invert the n x n matrix in place by Gauss-Jordan elimination.
+bool Invert(std::vector<uint8_t>& matrix, int n) {
+  const GaloisField& gf = GF();
+  std::vector<uint8_t> inv(n * n, 0);
+  for (int i = 0; i < n; ++i) {
+    inv[i * n + i] = 1;
+  }
+  for (int col = 0; col < n; ++col) {
+    int pivot = col;
+    while (pivot < n && matrix[pivot * n + col] == 0) {
+      pivot++;
+    }
+    if (pivot == n) {
+      return false;
+    }
+    if (pivot != col) {
+      for (int j = 0; j < n; ++j) {
+        std::swap(matrix[pivot * n + j], matrix[col * n + j]);
+        std::swap(inv[pivot * n + j], inv[col * n + j]);
+      }
+    }
+    uint8_t scale = gf.Inv(matrix[col * n + col]);
+    for (int j = 0; j < n; ++j) {
+      matrix[col * n + j] = gf.mul[scale][matrix[col * n + j]];
+      inv[col * n + j] = gf.mul[scale][inv[col * n + j]];
+    }
+    for (int row = 0; row < n; ++row) {
+      uint8_t c = matrix[row * n + col];
+      if (row == col || c == 0) {
+        continue;
+      }
+      for (int j = 0; j < n; ++j) {
+        matrix[row * n + j] ^= gf.mul[c][matrix[col * n + j]];
+        inv[row * n + j] ^= gf.mul[c][inv[col * n + j]];
+      }
+    }
+  }
+  matrix.swap(inv);
+  return true;
+}
+
+}  // namespace
+
+ReedSolomon::ReedSolomon(int data_shard_num, int parity_shard_num)
+    : data_shard_num_(data_shard_num), parity_shard_num_(parity_shard_num) {
+  assert(data_shard_num_ > 0 && parity_shard_num_ >= 0);
+  assert(data_shard_num_ + parity_shard_num_ <= 256);
+  const GaloisField& gf = GF();
+  parity_matrix_.resize(parity_shard_num_ * data_shard_num_);
+  for (int i = 0; i < parity_shard_num_; ++i) {
+    for (int j = 0; j < data_shard_num_; ++j) {
+      parity_matrix_[i * data_shard_num_ + j] =
+          gf.Inv((data_shard_num_ + i) ^ j);
+    }
+  }
+}
+
+int ReedSolomon::GetDataShardNum() const { return data_shard_num_; }
+
+int ReedSolomon::GetShardNum() const {
+  return data_shard_num_ + parity_shard_num_;
+}
+
+std::vector<std::string> ReedSolomon::Encode(const std::string& data) const {
+  size_t shard_size = std::max<size_t>(
+      1, (data.size() + data_shard_num_ - 1) / data_shard_num_);
+  std::vector<std::string> shards(GetShardNum());
+  for (int i = 0; i < data_shard_num_; ++i) {
+    size_t begin = std::min(data.size(), i * shard_size);
+    shards[i] = data.substr(begin, shard_size);
+    shards[i].resize(shard_size, 0);
+  }
+  for (int i = 0; i < parity_shard_num_; ++i) {
+    std::string& parity = shards[data_shard_num_ + i];
+    parity.assign(shard_size, 0);
+    for (int j = 0; j < data_shard_num_; ++j) {
+      MulAdd(parity_matrix_[i * data_shard_num_ + j], shards[j].data(),
+             parity.data(), shard_size);
+    }
+  }
+  return shards;
+}
+
+bool ReedSolomon::Decode(const std::vector<std::string>& shards,
+                         size_t data_size, std::string* data) const {
+  if (static_cast<int>(shards.size()) != GetShardNum()) {
+    return false;
+  }
+  // Use the first data_shard_num_ shards present.
+  std::vector<int> rows;
+  size_t shard_size = 0;
+  for (int i = 0; i < GetShardNum(); ++i) {
+    if (static_cast<int>(rows.size()) == data_shard_num_) {
+      break;
+    }
+    if (shards[i].empty()) {
+      continue;
+    }
+    if (shard_size > 0 && shards[i].size() != shard_size) {
+      return false;
+    }
+    shard_size = shards[i].size();
+    rows.push_back(i);
+  }
+  if (static_cast<int>(rows.size()) < data_shard_num_ ||
+      data_size > shard_size * data_shard_num_) {
+    return false;
+  }
+
+  std::vector<uint8_t> matrix(data_shard_num_ * data_shard_num_, 0);
+  for (int r = 0; r < data_shard_num_; ++r) {
+    if (rows[r] < data_shard_num_) {
+      matrix[r * data_shard_num_ + rows[r]] = 1;
+    } else {
+      int parity = rows[r] - data_shard_num_;
+      std::copy_n(parity_matrix_.begin() + parity * data_shard_num_,
+                  data_shard_num_, matrix.begin() + r * data_shard_num_);
+    }
+  }
+  if (!Invert(matrix, data_shard_num_)) {
+    return false;
+  }
+
+  data->assign(shard_size * data_shard_num_, 0);
+  for (int i = 0; i < data_shard_num_; ++i) {
+    char* out = data->data() + i * shard_size;
+    if (!shards[i].empty()) {
+      std::copy(shards[i].begin(), shards[i].end(), out);
+      continue;
+    }
+    for (int r = 0; r < data_shard_num_; ++r) {
+      MulAdd(matrix[i * data_shard_num_ + r], shards[rows[r]].data(), out,
+             shard_size);
+    }
+  }
+  data->resize(data_size);
+  return true;
+}
+
+}  // namespace resdb
@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace resdb {
+
+// ReedSolomon is a systematic Reed-Solomon erasure code over GF(2^8). The
+// data is split into data_shard_num shards of equal size followed by
+// parity_shard_num parity shards, and any data_shard_num of the shards
+// recover the data. The parity rows form a Cauchy matrix, so every square
+// submatrix of the encoding matrix is invertible.
+class ReedSolomon {
+ public:
+  // data_shard_num + parity_shard_num must not be larger than 256.
+  ReedSolomon(int data_shard_num, int parity_shard_num);
+
+  int GetDataShardNum() const;
+  int GetShardNum() const;
+
+  // The data is padded with zeros to a multiple of data_shard_num bytes.
+  std::vector<std::string> Encode(const std::string& data) const;
+
+  // Recover the data of data_size bytes. shards[i] is the shard i or empty
+  // if it is missing. Returns false if fewer than data_shard_num shards
+  // are present or their sizes do not match.
+  bool Decode(const std::vector<std::string>& shards, size_t data_size,
+              std::string* data) const;
+
+ private:
+  int data_shard_num_;
+  int parity_shard_num_;
+  // parity_shard_num_ x data_shard_num_ coefficients of the parity shards.
+  std::vector<uint8_t> parity_matrix_;
+};
+
+}  // namespace resdb
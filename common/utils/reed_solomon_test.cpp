@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/utils/reed_solomon.h"
+
+#include <gtest/gtest.h>
+
+namespace resdb {
+namespace {
+
+std::string RandomData(size_t size) {
+  std::string data(size, 0);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = rand() % 256;
+  }
+  return data;
+}
+
+TEST(ReedSolomonTest, EncodeSystematic) {
+  ReedSolomon rs(3, 2);
+  std::vector<std::string> shards = rs.Encode("abcdefgh");
+  ASSERT_EQ(shards.size(), 5);
+  EXPECT_EQ(shards[0], "abc");
+  EXPECT_EQ(shards[1], "def");
+  EXPECT_EQ(shards[2], std::string("gh\0", 3));
+  EXPECT_EQ(shards[3].size(), 3);
+  EXPECT_EQ(shards[4].size(), 3);
+}
+
+TEST(ReedSolomonTest, DecodeFromAnyShards) {
+  // n = 7, f = 2: any f + 1 shards recover the data.
+  ReedSolomon rs(3, 4);
+  std::string data = RandomData(1000);
+  std::vector<std::string> shards = rs.Encode(data);
+  for (int mask = 0; mask < (1 << 7); ++mask) {
+    std::vector<std::string> received(7);
+    int num = 0;
+    for (int i = 0; i < 7; ++i) {
+      if (mask & (1 << i)) {
+        received[i] = shards[i];
+        num++;
+      }
+    }
+    std::string decoded;
+    EXPECT_EQ(rs.Decode(received, data.size(), &decoded), num >= 3);
+    if (num >= 3) {
+      EXPECT_EQ(decoded, data);
+    }
+  }
+}
+
+TEST(ReedSolomonTest, DecodeFromParityShards) {
+  ReedSolomon rs(11, 21);
+  std::string data = RandomData(1 << 16);
+  std::vector<std::string> shards = rs.Encode(data);
+  for (int i = 0; i < 11; ++i) {
+    shards[i].clear();
+  }
+  std::string decoded;
+  EXPECT_TRUE(rs.Decode(shards, data.size(), &decoded));
+  EXPECT_EQ(decoded, data);
+}
+
+TEST(ReedSolomonTest, DecodeInvalidShards) {
+  ReedSolomon rs(2, 2);
+  std::vector<std::string> shards = rs.Encode("abcd");
+  std::string decoded;
+  EXPECT_FALSE(rs.Decode({shards[0], shards[1]}, 4, &decoded));
+  EXPECT_FALSE(rs.Decode({shards[0], "xyz", "", ""}, 4, &decoded));
+  EXPECT_FALSE(rs.Decode(shards, 5, &decoded));
+}
+
+}  // namespace
+}  // namespace resdb
@@ -35,6 +35,11 @@ std::unique_ptr<std::string> TransactionManager::ExecuteData(
   return std::make_unique<std::string>();
 }
 
+bool TransactionManager::GetBatchKeys(const BatchUserRequest& request,
+                                      std::set<std::string>* keys) {
+  return false;
+}
+
 std::unique_ptr<google::protobuf::Message> TransactionManager::ParseData(
     const std::string& data) {
   return nullptr;
@@ -67,6 +72,9 @@ TransactionManager::ExecuteBatchDataWithSeq(
     uint64_t seq,
     const std::vector<std::unique_ptr<google::protobuf::Message>>& requests) {
   seq_ = seq;
+  if (GetStorage() != nullptr) {
+    GetStorage()->SetExecutingSeq(seq);
+  }
   return ExecuteBatchData(requests);
 }
 
@@ -90,6 +98,9 @@ std::unique_ptr<BatchUserResponse> TransactionManager::ExecuteBatchWithSeq(
     uint64_t seq, const BatchUserRequest& request) {
   LOG(ERROR) << " execute batch seq:" << seq_;
   seq_ = seq;
+  if (GetStorage() != nullptr) {
+    GetStorage()->SetExecutingSeq(seq);
+  }
   return ExecuteBatch(request);
 }
 
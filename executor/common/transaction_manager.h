@@ -20,6 +20,7 @@
 #pragma once
 
 #include <memory>
+#include <set>
 
 #include "chain/storage/storage.h"
 #include "platform/proto/resdb.pb.h"
@@ -54,6 +55,13 @@ class TransactionManager {
 
   virtual std::unique_ptr<std::string> ExecuteData(const std::string& request);
 
+  // Add the keys read or written by the batch into keys. Batches with
+  // disjoint keys may be executed concurrently, in which case ExecuteBatch
+  // must be thread safe for them. Return false if the keys are unknown, then
+  // the batch is executed alone.
+  virtual bool GetBatchKeys(const BatchUserRequest& request,
+                            std::set<std::string>* keys);
+
   bool IsOutOfOrder();
 
   bool NeedResponse();
@@ -42,6 +42,33 @@ std::unique_ptr<google::protobuf::Message> KVExecutor::ParseData(
   return kv_request;
 }
 
+bool KVExecutor::GetBatchKeys(const BatchUserRequest& request,
+                              std::set<std::string>* keys) {
+  // The batches are only executed in parallel on a thread safe storage.
+  if (storage_ == nullptr || !storage_->IsThreadSafe()) {
+    return false;
+  }
+  for (const auto& sub_request : request.user_requests()) {
+    KVRequest kv_request;
+    if (!kv_request.ParseFromString(sub_request.request().data())) {
+      return false;
+    }
+    switch (kv_request.cmd()) {
+      case KVRequest::SET:
+      case KVRequest::GET:
+      case KVRequest::SET_WITH_VERSION:
+      case KVRequest::GET_WITH_VERSION:
+      case KVRequest::GET_HISTORY:
+      case KVRequest::GET_TOP:
+        keys->insert(kv_request.key());
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
 std::unique_ptr<std::string> KVExecutor::ExecuteRequest(
     const google::protobuf::Message& request) {
   KVResponse kv_response;
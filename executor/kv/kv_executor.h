@@ -41,6 +41,12 @@ class KVExecutor : public TransactionManager {
   std::unique_ptr<std::string> ExecuteRequest(
       const google::protobuf::Message& kv_request) override;
 
+  // Only the commands on a single key are known, the range scans and the
+  // contracts may touch any key. No keys are known if the storage is not
+  // thread safe.
+  bool GetBatchKeys(const BatchUserRequest& request,
+                    std::set<std::string>* keys) override;
+
  protected:
   virtual void Set(const std::string& key, const std::string& value);
   std::string Get(const std::string& key);
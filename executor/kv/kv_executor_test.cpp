@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 
 #include "chain/storage/memory_db.h"
+#include "chain/storage/mock_storage.h"
 #include "chain/storage/storage.h"
 #include "common/test/test_macros.h"
 #include "platform/config/resdb_config_utils.h"
@@ -338,6 +339,27 @@ TEST_F(KVExecutorTest, SetValueWithVersion) {
   }
 }
 
+TEST(KVExecutorBatchKeysTest, GetBatchKeys) {
+  BatchUserRequest batch;
+  KVRequest request;
+  request.set_cmd(KVRequest::SET);
+  request.set_key("test_key");
+  request.SerializeToString(
+      batch.add_user_requests()->mutable_request()->mutable_data());
+
+  std::set<std::string> keys;
+  KVExecutor executor(std::make_unique<MemoryDB>());
+  EXPECT_TRUE(executor.GetBatchKeys(batch, &keys));
+  EXPECT_EQ(keys, std::set<std::string>({"test_key"}));
+
+  // The batches on a storage which is not thread safe are not executed in
+  // parallel.
+  keys.clear();
+  KVExecutor mock_executor(std::make_unique<MockStorage>());
+  EXPECT_FALSE(mock_executor.GetBatchKeys(batch, &keys));
+  EXPECT_TRUE(keys.empty());
+}
+
 }  // namespace
 
 }  // namespace resdb
@@ -27,13 +27,16 @@ namespace resdb {
 struct DataInfo {
   DataInfo() : buff(nullptr), data_len(0) {}
   ~DataInfo() {
-    if (buff) {
+    if (buff && holder == nullptr) {
       free(buff);
-      buff = nullptr;
     }
+    buff = nullptr;
   }
   void* buff = nullptr;
   size_t data_len = 0;
+  // If set, buff points into the memory kept alive by holder, like a pooled
+  // receive slab, and is not freed with the DataInfo.
+  std::shared_ptr<void> holder;
 };
 
 }  // namespace resdb
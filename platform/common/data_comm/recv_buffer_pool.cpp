@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/common/data_comm/recv_buffer_pool.h"
+
+#include <stdlib.h>
+
+namespace resdb {
+
+RecvBufferPool::RecvBufferPool(size_t slab_size, size_t max_free_num)
+    : slab_size_(slab_size), max_free_num_(max_free_num) {}
+
+RecvBufferPool::~RecvBufferPool() {
+  for (auto& it : free_slabs_) {
+    for (char* data : it.second) {
+      free(data);
+    }
+  }
+}
+
+std::shared_ptr<char> RecvBufferPool::Get(size_t size, size_t* capacity) {
+  size_t slab_size = slab_size_;
+  while (slab_size < size) {
+    slab_size <<= 1;
+  }
+
+  char* data = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto& slabs = free_slabs_[slab_size];
+    if (!slabs.empty()) {
+      data = slabs.back();
+      slabs.pop_back();
+    } else {
+      alloc_num_++;
+    }
+  }
+  if (data == nullptr) {
+    data = static_cast<char*>(malloc(slab_size));
+  }
+  *capacity = slab_size;
+
+  auto pool = shared_from_this();
+  return std::shared_ptr<char>(
+      data, [pool, slab_size](char* data) { pool->Release(data, slab_size); });
+}
+
+void RecvBufferPool::Release(char* data, size_t size) {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto& slabs = free_slabs_[size];
+    if (slabs.size() < max_free_num_) {
+      slabs.push_back(data);
+      return;
+    }
+  }
+  free(data);
+}
+
+size_t RecvBufferPool::GetAllocNum() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return alloc_num_;
+}
+
+}  // namespace resdb
@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace resdb {
+
+// RecvBufferPool provides the slabs the network frames are received into.
+// A slab is shared by the frames read into it and goes back to the pool
+// once the last reference is released. The pool has to be owned by a
+// std::shared_ptr, the slabs keep it alive.
+class RecvBufferPool : public std::enable_shared_from_this<RecvBufferPool> {
+ public:
+  // Slabs are slab_size bytes or the next power of two fitting a larger
+  // request. At most max_free_num free slabs of each size are kept.
+  RecvBufferPool(size_t slab_size = 1 << 20, size_t max_free_num = 16);
+  ~RecvBufferPool();
+
+  // Returns a slab with at least size bytes, its size is set to capacity.
+  std::shared_ptr<char> Get(size_t size, size_t* capacity);
+
+  // The number of slabs allocated from the system.
+  size_t GetAllocNum();
+
+ private:
+  void Release(char* data, size_t size);
+
+ private:
+  size_t slab_size_;
+  size_t max_free_num_;
+  std::mutex mutex_;
+  std::map<size_t, std::vector<char*>> free_slabs_;
+  size_t alloc_num_ = 0;
+};
+
+}  // namespace resdb
@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/common/data_comm/recv_buffer_pool.h"
+
+#include <gtest/gtest.h>
+
+namespace resdb {
+namespace {
+
+TEST(RecvBufferPoolTest, ReuseSlab) {
+  auto pool = std::make_shared<RecvBufferPool>(1024, 1);
+  size_t capacity = 0;
+  char* data = nullptr;
+  {
+    std::shared_ptr<char> slab = pool->Get(10, &capacity);
+    EXPECT_EQ(capacity, 1024);
+    data = slab.get();
+  }
+  std::shared_ptr<char> slab = pool->Get(1024, &capacity);
+  EXPECT_EQ(slab.get(), data);
+  EXPECT_EQ(pool->GetAllocNum(), 1);
+}
+
+TEST(RecvBufferPoolTest, LargeSlab) {
+  auto pool = std::make_shared<RecvBufferPool>(1024, 1);
+  size_t capacity = 0;
+  std::shared_ptr<char> slab1 = pool->Get(1025, &capacity);
+  EXPECT_EQ(capacity, 2048);
+  std::shared_ptr<char> slab2 = pool->Get(100, &capacity);
+  EXPECT_EQ(capacity, 1024);
+  EXPECT_EQ(pool->GetAllocNum(), 2);
+}
+
+TEST(RecvBufferPoolTest, SlabOutlivesPool) {
+  auto pool = std::make_shared<RecvBufferPool>(1024, 1);
+  size_t capacity = 0;
+  std::shared_ptr<char> slab = pool->Get(10, &capacity);
+  pool.reset();
+  memset(slab.get(), 1, capacity);
+}
+
+}  // namespace
+}  // namespace resdb
@@ -0,0 +1,59 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/common/data_comm/wire_format.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+namespace resdb {
+
+using google::protobuf::internal::WireFormatLite;
+
+bool ForEachBytesField(
+    const char* data, size_t len,
+    const std::function<bool(int field_number, std::string_view value)>&
+        callback) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(data), len);
+  while (uint32_t tag = input.ReadTag()) {
+    if (WireFormatLite::GetTagWireType(tag) !=
+        WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!WireFormatLite::SkipField(&input, tag)) {
+        return false;
+      }
+      continue;
+    }
+    uint32_t size = 0;
+    if (!input.ReadVarint32(&size)) {
+      return false;
+    }
+    size_t pos = input.CurrentPosition();
+    if (size > len - pos || !input.Skip(size)) {
+      return false;
+    }
+    if (!callback(WireFormatLite::GetTagFieldNumber(tag),
+                  std::string_view(data + pos, size))) {
+      return false;
+    }
+  }
+  return input.ConsumedEntireMessage();
+}
+
+}  // namespace resdb
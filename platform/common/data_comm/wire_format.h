@@ -0,0 +1,37 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string_view>
+
+namespace resdb {
+
+// Walks the length-delimited fields (bytes, strings and sub-messages) of a
+// serialized message and passes their field numbers and values to
+// callback. The values point into data, nothing is copied. The other fields
+// are skipped. Returns false if the message is malformed or the callback
+// returns false.
+bool ForEachBytesField(
+    const char* data, size_t len,
+    const std::function<bool(int field_number, std::string_view value)>&
+        callback);
+
+}  // namespace resdb
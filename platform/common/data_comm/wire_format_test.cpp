@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/common/data_comm/wire_format.h"
+
+#include <gtest/gtest.h>
+
+#include "platform/proto/broadcast.pb.h"
+
+namespace resdb {
+namespace {
+
+TEST(WireFormatTest, ReadInPlace) {
+  BroadcastData broadcast_data;
+  broadcast_data.add_data("test1");
+  broadcast_data.add_data("");
+  broadcast_data.add_data(std::string(1000, 'a'));
+  broadcast_data.set_is_resp(true);
+  std::string data;
+  broadcast_data.SerializeToString(&data);
+
+  std::vector<std::string_view> values;
+  EXPECT_TRUE(ForEachBytesField(data.data(), data.size(),
+                                [&](int field_number, std::string_view value) {
+                                  EXPECT_EQ(field_number, 1);
+                                  values.push_back(value);
+                                  return true;
+                                }));
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(values[0], "test1");
+  EXPECT_EQ(values[1], "");
+  EXPECT_EQ(values[2], std::string(1000, 'a'));
+  EXPECT_GE(values[2].data(), data.data());
+  EXPECT_LE(values[2].data() + values[2].size(), data.data() + data.size());
+}
+
+TEST(WireFormatTest, Malformed) {
+  BroadcastData broadcast_data;
+  broadcast_data.add_data(std::string(100, 'a'));
+  std::string data;
+  broadcast_data.SerializeToString(&data);
+
+  EXPECT_FALSE(ForEachBytesField(
+      data.data(), data.size() - 1,
+      [&](int field_number, std::string_view value) { return true; }));
+  EXPECT_FALSE(ForEachBytesField(
+      data.data(), data.size(),
+      [&](int field_number, std::string_view value) { return false; }));
+}
+
+}  // namespace
+}  // namespace resdb
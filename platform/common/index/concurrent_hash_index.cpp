@@ -0,0 +1,307 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/common/index/concurrent_hash_index.h"
+
+#include <glog/logging.h>
+#include <string.h>
+
+#include "common/utils/utils.h"
+
+namespace resdb {
+
+namespace {
+
+uint32_t RoundUpPowerOfTwo(uint32_t v) {
+  uint32_t ret = 1;
+  while (ret < v) {
+    ret <<= 1;
+  }
+  return ret;
+}
+
+uint64_t Mix(uint64_t v) {
+  v ^= v >> 33;
+  v *= 0xff51afd7ed558ccdULL;
+  v ^= v >> 33;
+  v *= 0xc4ceb9fe1a85ec53ULL;
+  v ^= v >> 33;
+  return v;
+}
+
+// Fold the digest into 64 bits. For a SHA-256 digest this is as good as
+// truncating it; it also spreads keys that only differ in their tails.
+uint64_t GetTag(const std::string& key) {
+  uint64_t tag = key.size();
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= key.size(); i += sizeof(uint64_t)) {
+    uint64_t v;
+    memcpy(&v, key.data() + i, sizeof(v));
+    tag = Mix(tag ^ v);
+  }
+  if (i < key.size()) {
+    uint64_t v = 0;
+    memcpy(&v, key.data() + i, key.size() - i);
+    tag = Mix(tag ^ v);
+  }
+  // 0 is reserved for empty slots.
+  return tag == 0 ? 1 : tag;
+}
+
+}  // namespace
+
+ConcurrentHashIndex::ConcurrentHashIndex(uint64_t capacity,
+                                         uint64_t generation_useconds,
+                                         uint32_t generation_num,
+                                         uint32_t shard_num)
+    : shard_num_(RoundUpPowerOfTwo(std::max<uint32_t>(shard_num, 1))),
+      shard_mask_(shard_num_ - 1),
+      shard_bits_(__builtin_ctz(shard_num_)),
+      generation_useconds_(std::max<uint64_t>(generation_useconds, 1)),
+      generation_num_(std::max<uint32_t>(generation_num, 1)),
+      // Round down so that all the shards stay within capacity.
+      max_bucket_num_(
+          std::max<uint64_t>(capacity / shard_num_ / kBucketSize, 1)),
+      shards_(std::make_unique<Shard[]>(shard_num_)),
+      time_func_(GetCurrentTime) {
+  uint64_t bucket_num =
+      std::max<uint64_t>(max_bucket_num_ >> kInitialShift, 1);
+  for (uint32_t i = 0; i < shard_num_; ++i) {
+    shards_[i].bucket_num = bucket_num;
+    shards_[i].slots.resize(bucket_num * kBucketSize);
+  }
+  LOG(INFO) << "create hash index, capacity:" << Capacity() << " max:"
+            << max_bucket_num_ * kBucketSize * shard_num_
+            << " shards:" << shard_num_
+            << " generation(us):" << generation_useconds_
+            << " generation num:" << generation_num_;
+}
+
+void ConcurrentHashIndex::SetTimeFunc(std::function<uint64_t()> time_func) {
+  time_func_ = time_func;
+}
+
+uint64_t ConcurrentHashIndex::Capacity() {
+  uint64_t capacity = 0;
+  for (uint32_t i = 0; i < shard_num_; ++i) {
+    std::lock_guard<std::mutex> lk(shards_[i].mutex);
+    capacity += shards_[i].slots.size();
+  }
+  return capacity;
+}
+
+uint64_t ConcurrentHashIndex::GrowNum() const { return grow_num_; }
+
+uint64_t ConcurrentHashIndex::EvictNum() const { return evict_num_; }
+
+uint64_t ConcurrentHashIndex::GetGeneration() const {
+  // Start from generation_num_ so that a fresh slot (generation 0) is never
+  // considered live.
+  return time_func_() / generation_useconds_ + generation_num_;
+}
+
+bool ConcurrentHashIndex::IsLive(const Slot& slot, uint64_t generation) const {
+  return slot.tag != 0 && slot.generation + generation_num_ > generation;
+}
+
+ConcurrentHashIndex::Shard& ConcurrentHashIndex::GetShard(uint64_t tag) {
+  return shards_[tag & shard_mask_];
+}
+
+// The bucket is taken from the bits of the tag above the shard bits, so the
+// keys of a full bucket are spread once the shard grows.
+ConcurrentHashIndex::Slot* ConcurrentHashIndex::GetBucket(
+    std::vector<Slot>& slots, uint64_t bucket_num, uint64_t tag) {
+  uint64_t bucket = (tag >> shard_bits_) % bucket_num;
+  return &slots[bucket * kBucketSize];
+}
+
+ConcurrentHashIndex::Slot* ConcurrentHashIndex::FindSlot(
+    Slot* bucket, uint64_t tag, const std::string& key, uint64_t generation) {
+  size_t key_size = std::min(key.size(), kMaxKeySize);
+  for (uint32_t i = 0; i < kBucketSize; ++i) {
+    Slot* slot = bucket + i;
+    if (slot->tag != tag || !IsLive(*slot, generation)) {
+      continue;
+    }
+    // Verify the digest in case two keys share the same tag.
+    if (slot->key_size == key_size &&
+        memcmp(slot->key, key.data(), key_size) == 0) {
+      return slot;
+    }
+  }
+  return nullptr;
+}
+
+ConcurrentHashIndex::Slot* ConcurrentHashIndex::FindFreeSlot(
+    Slot* bucket, uint64_t generation) {
+  for (uint32_t i = 0; i < kBucketSize; ++i) {
+    Slot* slot = bucket + i;
+    if (!IsLive(*slot, generation)) {
+      return slot;
+    }
+  }
+  return nullptr;
+}
+
+ConcurrentHashIndex::Slot* ConcurrentHashIndex::FindOldestSlot(
+    Slot* bucket) {
+  Slot* oldest = bucket;
+  for (uint32_t i = 1; i < kBucketSize; ++i) {
+    if (bucket[i].generation < oldest->generation) {
+      oldest = bucket + i;
+    }
+  }
+  return oldest;
+}
+
+ConcurrentHashIndex::Slot* ConcurrentHashIndex::AcquireSlot(
+    Shard& shard, uint64_t tag, uint64_t generation) {
+  Slot* bucket = GetBucket(shard.slots, shard.bucket_num, tag);
+  Slot* slot = FindFreeSlot(bucket, generation);
+  if (slot != nullptr) {
+    return slot;
+  }
+  // Grow at most once. The bucket can still be full if more than
+  // kBucketSize live keys fall into it.
+  if (Grow(shard, generation)) {
+    bucket = GetBucket(shard.slots, shard.bucket_num, tag);
+    slot = FindFreeSlot(bucket, generation);
+    if (slot != nullptr) {
+      return slot;
+    }
+  }
+  if (evict_num_.fetch_add(1, std::memory_order_relaxed) == 0) {
+    LOG(WARNING) << "hash index is full, evict the oldest entries";
+  }
+  return FindOldestSlot(bucket);
+}
+
+// Double the buckets up to max_bucket_num_ and move the live entries, the
+// expired ones are dropped. If a bucket of the new table overflows, the
+// oldest entry in it is evicted.
+bool ConcurrentHashIndex::Grow(Shard& shard, uint64_t generation) {
+  if (shard.bucket_num >= max_bucket_num_) {
+    return false;
+  }
+  uint64_t bucket_num = std::min(shard.bucket_num * 2, max_bucket_num_);
+  std::vector<Slot> slots(bucket_num * kBucketSize);
+  for (const Slot& slot : shard.slots) {
+    if (!IsLive(slot, generation)) {
+      continue;
+    }
+    Slot* bucket = GetBucket(slots, bucket_num, slot.tag);
+    Slot* free_slot = FindFreeSlot(bucket, generation);
+    if (free_slot == nullptr) {
+      evict_num_.fetch_add(1, std::memory_order_relaxed);
+      free_slot = FindOldestSlot(bucket);
+      if (free_slot->generation > slot.generation) {
+        continue;
+      }
+    }
+    *free_slot = slot;
+  }
+  shard.slots.swap(slots);
+  shard.bucket_num = bucket_num;
+  grow_num_.fetch_add(1, std::memory_order_relaxed);
+  LOG(INFO) << "grow hash index shard to " << bucket_num << " buckets";
+  return true;
+}
+
+void ConcurrentHashIndex::SetSlot(Slot* slot, uint64_t tag,
+                                  const std::string& key, uint64_t value,
+                                  uint64_t generation) {
+  slot->tag = tag;
+  slot->value = value;
+  slot->generation = generation;
+  slot->key_size = std::min(key.size(), kMaxKeySize);
+  memcpy(slot->key, key.data(), slot->key_size);
+}
+
+bool ConcurrentHashIndex::Find(const std::string& key, uint64_t* value) {
+  uint64_t tag = GetTag(key);
+  uint64_t generation = GetGeneration();
+  Shard& shard = GetShard(tag);
+  std::lock_guard<std::mutex> lk(shard.mutex);
+  Slot* slot = FindSlot(GetBucket(shard.slots, shard.bucket_num, tag), tag,
+                        key, generation);
+  if (slot == nullptr) {
+    return false;
+  }
+  if (value) {
+    *value = slot->value;
+  }
+  return true;
+}
+
+bool ConcurrentHashIndex::Insert(const std::string& key, uint64_t value) {
+  uint64_t tag = GetTag(key);
+  uint64_t generation = GetGeneration();
+  Shard& shard = GetShard(tag);
+  std::lock_guard<std::mutex> lk(shard.mutex);
+  Slot* bucket = GetBucket(shard.slots, shard.bucket_num, tag);
+  if (FindSlot(bucket, tag, key, generation) != nullptr) {
+    return false;
+  }
+  SetSlot(AcquireSlot(shard, tag, generation), tag, key, value, generation);
+  return true;
+}
+
+void ConcurrentHashIndex::Update(const std::string& key, uint64_t value) {
+  uint64_t tag = GetTag(key);
+  uint64_t generation = GetGeneration();
+  Shard& shard = GetShard(tag);
+  std::lock_guard<std::mutex> lk(shard.mutex);
+  Slot* slot = FindSlot(GetBucket(shard.slots, shard.bucket_num, tag), tag,
+                        key, generation);
+  if (slot == nullptr) {
+    slot = AcquireSlot(shard, tag, generation);
+  }
+  SetSlot(slot, tag, key, value, generation);
+}
+
+bool ConcurrentHashIndex::Erase(const std::string& key) {
+  uint64_t tag = GetTag(key);
+  uint64_t generation = GetGeneration();
+  Shard& shard = GetShard(tag);
+  std::lock_guard<std::mutex> lk(shard.mutex);
+  Slot* slot = FindSlot(GetBucket(shard.slots, shard.bucket_num, tag), tag,
+                        key, generation);
+  if (slot == nullptr) {
+    return false;
+  }
+  slot->tag = 0;
+  return true;
+}
+
+uint64_t ConcurrentHashIndex::Size() {
+  uint64_t generation = GetGeneration();
+  uint64_t size = 0;
+  for (uint32_t i = 0; i < shard_num_; ++i) {
+    std::lock_guard<std::mutex> lk(shards_[i].mutex);
+    for (const Slot& slot : shards_[i].slots) {
+      if (IsLive(slot, generation)) {
+        size++;
+      }
+    }
+  }
+  return size;
+}
+
+}  // namespace resdb
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace resdb {
+
+// A concurrent index from request digests to a uint64_t value.
+//
+// Keys are located by a 64-bit fold of the digest. The table is split into
+// shards, each guarded by its own lock, and every shard is an open-addressing
+// table made of small buckets. A key is verified against the stored digest
+// when the fold matches, so a collision never reports a false duplicate for
+// keys up to kMaxKeySize bytes (e.g. SHA-256 digests).
+//
+// Entries expire by generation instead of being tracked one by one: time is
+// cut into generations of generation_useconds and an entry added in
+// generation g is dropped once the current generation reaches
+// g + generation_num. Expired slots are reused in place, so there is no
+// background cleaner.
+//
+// Each shard starts with a quarter of its share of capacity and doubles its
+// buckets when a bucket is full of live entries, up to its share of
+// capacity. Past that, or if the bucket is still full after growing, the
+// entry with the oldest generation in the bucket is evicted to make room, so
+// the memory never exceeds capacity slots. An evicted key is no longer
+// reported, so capacity should hold the keys of generation_num generations.
+class ConcurrentHashIndex {
+ public:
+  static constexpr size_t kMaxKeySize = 32;
+
+  ConcurrentHashIndex(uint64_t capacity, uint64_t generation_useconds,
+                      uint32_t generation_num, uint32_t shard_num = 64);
+
+  // Return true if key is in the index. The value is set if it is not null.
+  bool Find(const std::string& key, uint64_t* value = nullptr);
+
+  // Add key with value if it does not exist.
+  // Return false if the key has already been added.
+  bool Insert(const std::string& key, uint64_t value = 0);
+
+  // Add key with value, or overwrite the value if it exists.
+  void Update(const std::string& key, uint64_t value);
+
+  // Remove the key. Return false if it does not exist.
+  bool Erase(const std::string& key);
+
+  // The number of live entries. It scans the whole table.
+  uint64_t Size();
+  // The number of slots allocated by all the shards. It never exceeds the
+  // capacity given at construction.
+  uint64_t Capacity();
+  // The number of times a shard grew because a bucket was full.
+  uint64_t GrowNum() const;
+  // The number of live entries evicted because their bucket was full and the
+  // shard could not grow.
+  uint64_t EvictNum() const;
+
+  // Set the function returning the current time in microseconds.
+  // Used for testing, or to run the generations on a logical clock.
+  void SetTimeFunc(std::function<uint64_t()> time_func);
+
+ private:
+  struct Slot {
+    uint64_t tag = 0;
+    uint64_t value = 0;
+    uint64_t generation = 0;
+    uint8_t key_size = 0;
+    char key[kMaxKeySize];
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    uint64_t bucket_num = 0;
+    std::vector<Slot> slots;
+  };
+
+  uint64_t GetGeneration() const;
+  bool IsLive(const Slot& slot, uint64_t generation) const;
+  Shard& GetShard(uint64_t tag);
+  Slot* GetBucket(std::vector<Slot>& slots, uint64_t bucket_num,
+                  uint64_t tag);
+  Slot* FindSlot(Slot* bucket, uint64_t tag, const std::string& key,
+                 uint64_t generation);
+  // Return nullptr if all the slots in the bucket are live.
+  Slot* FindFreeSlot(Slot* bucket, uint64_t generation);
+  // Return the live slot with the oldest generation.
+  Slot* FindOldestSlot(Slot* bucket);
+  // Return a free slot for tag, growing the shard if its bucket is full, or
+  // evicting the oldest entry of the bucket if the shard is at its bound.
+  // Must be called holding the shard mutex.
+  Slot* AcquireSlot(Shard& shard, uint64_t tag, uint64_t generation);
+  // Return false if the shard is already at max_bucket_num_.
+  bool Grow(Shard& shard, uint64_t generation);
+  void SetSlot(Slot* slot, uint64_t tag, const std::string& key,
+               uint64_t value, uint64_t generation);
+
+ private:
+  static constexpr uint32_t kBucketSize = 8;
+  // A shard starts with max_bucket_num_ >> kInitialShift buckets.
+  static constexpr uint32_t kInitialShift = 2;
+
+  uint32_t shard_num_;
+  uint32_t shard_mask_;
+  uint32_t shard_bits_;
+  uint64_t generation_useconds_;
+  uint32_t generation_num_;
+  uint64_t max_bucket_num_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<uint64_t> grow_num_ = 0;
+  std::atomic<uint64_t> evict_num_ = 0;
+  std::function<uint64_t()> time_func_;
+};
+
+}  // namespace resdb
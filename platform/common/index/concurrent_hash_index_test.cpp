@@ -0,0 +1,163 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/common/index/concurrent_hash_index.h"
+
+#include <glog/logging.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace resdb {
+namespace {
+
+class ConcurrentHashIndexTest : public ::testing::Test {
+ protected:
+  ConcurrentHashIndexTest() : index_(1024, 100, 2, 4) {
+    index_.SetTimeFunc([&]() { return time_; });
+  }
+
+  uint64_t time_ = 0;
+  ConcurrentHashIndex index_;
+};
+
+TEST_F(ConcurrentHashIndexTest, InsertAndFind) {
+  uint64_t value = 0;
+  EXPECT_FALSE(index_.Find("hash1"));
+  EXPECT_TRUE(index_.Insert("hash1", 10));
+  EXPECT_FALSE(index_.Insert("hash1", 11));
+  EXPECT_TRUE(index_.Find("hash1", &value));
+  EXPECT_EQ(value, 10);
+  EXPECT_FALSE(index_.Find("hash2"));
+  EXPECT_EQ(index_.Size(), 1);
+}
+
+TEST_F(ConcurrentHashIndexTest, Update) {
+  uint64_t value = 0;
+  index_.Update("hash1", 10);
+  index_.Update("hash1", 20);
+  EXPECT_TRUE(index_.Find("hash1", &value));
+  EXPECT_EQ(value, 20);
+  EXPECT_EQ(index_.Size(), 1);
+}
+
+TEST_F(ConcurrentHashIndexTest, Erase) {
+  EXPECT_TRUE(index_.Insert("hash1"));
+  EXPECT_TRUE(index_.Erase("hash1"));
+  EXPECT_FALSE(index_.Erase("hash1"));
+  EXPECT_FALSE(index_.Find("hash1"));
+  EXPECT_TRUE(index_.Insert("hash1"));
+}
+
+TEST_F(ConcurrentHashIndexTest, ExpireByGeneration) {
+  EXPECT_TRUE(index_.Insert("hash1"));
+  time_ = 150;
+  EXPECT_TRUE(index_.Insert("hash2"));
+  EXPECT_TRUE(index_.Find("hash1"));
+
+  // hash1 was added in generation 0 and expires in generation 2.
+  time_ = 200;
+  EXPECT_FALSE(index_.Find("hash1"));
+  EXPECT_TRUE(index_.Find("hash2"));
+
+  time_ = 300;
+  EXPECT_FALSE(index_.Find("hash2"));
+  EXPECT_EQ(index_.Size(), 0);
+}
+
+TEST_F(ConcurrentHashIndexTest, SameTagDifferentKey) {
+  // Keys longer than kMaxKeySize share the stored prefix, but the tag covers
+  // the whole key.
+  std::string prefix(ConcurrentHashIndex::kMaxKeySize, 'a');
+  EXPECT_TRUE(index_.Insert(prefix + "1"));
+  EXPECT_TRUE(index_.Insert(prefix + "2"));
+  EXPECT_TRUE(index_.Insert(prefix));
+  EXPECT_EQ(index_.Size(), 3);
+}
+
+TEST_F(ConcurrentHashIndexTest, GrowUpToCapacity) {
+  // The shards start with a quarter of the capacity.
+  EXPECT_EQ(index_.Capacity(), 256);
+  for (uint64_t i = 0; i < 512; ++i) {
+    EXPECT_TRUE(index_.Insert("hash" + std::to_string(i), i));
+  }
+  EXPECT_GT(index_.GrowNum(), 0);
+  EXPECT_LE(index_.Capacity(), 1024);
+  for (uint64_t i = 0; i < 4096; ++i) {
+    index_.Insert("more" + std::to_string(i), i);
+  }
+  // The shards stop at the capacity and evict entries instead.
+  EXPECT_EQ(index_.Capacity(), 1024);
+  EXPECT_GT(index_.EvictNum(), 0);
+  EXPECT_LE(index_.Size(), 1024);
+}
+
+TEST_F(ConcurrentHashIndexTest, EvictOldestWhenBucketFull) {
+  // A single bucket, so every key falls into it and the shard cannot grow.
+  ConcurrentHashIndex index(8, 100, 100, 1);
+  uint64_t time = 0;
+  index.SetTimeFunc([&]() { return time; });
+  for (uint64_t i = 0; i < 9; ++i) {
+    time = i * 100;
+    EXPECT_TRUE(index.Insert("hash" + std::to_string(i), i));
+  }
+  EXPECT_EQ(index.Capacity(), 8);
+  EXPECT_EQ(index.GrowNum(), 0);
+  EXPECT_EQ(index.EvictNum(), 1);
+  EXPECT_FALSE(index.Find("hash0"));
+  for (uint64_t i = 1; i < 9; ++i) {
+    EXPECT_TRUE(index.Find("hash" + std::to_string(i)));
+  }
+}
+
+TEST_F(ConcurrentHashIndexTest, ReuseExpiredSlots) {
+  uint64_t capacity = index_.Capacity();
+  for (int round = 0; round < 8; ++round) {
+    time_ += 200;
+    for (uint64_t i = 0; i < capacity / 8; ++i) {
+      index_.Insert("hash" + std::to_string(round) + "_" + std::to_string(i));
+    }
+  }
+  // The expired keys make room for the new ones.
+  EXPECT_EQ(index_.Capacity(), capacity);
+}
+
+TEST(ConcurrentHashIndexThreadTest, ConcurrentInsert) {
+  ConcurrentHashIndex index(1 << 16, 1000000, 4);
+  std::atomic<int> inserted = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.push_back(std::thread([&]() {
+      for (int i = 0; i < 10000; ++i) {
+        if (index.Insert("hash" + std::to_string(i), i)) {
+          inserted++;
+        }
+      }
+    }));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  EXPECT_EQ(inserted, 10000);
+  EXPECT_EQ(index.Size(), 10000);
+}
+
+}  // namespace
+}  // namespace resdb
@@ -253,4 +253,21 @@ void ResDBConfig::SetViewchangeCommitTimeout(uint64_t timeout_ms) {
   config_data_.set_view_change_timeout_ms(timeout_ms);
 }
 
+const ThresholdKeyShare* ResDBConfig::GetThresholdKeyShare() const {
+  return threshold_key_share_.has_value() ? &threshold_key_share_.value()
+                                          : nullptr;
+}
+
+void ResDBConfig::SetThresholdKeyShare(const ThresholdKeyShare& key_share) {
+  threshold_key_share_ = key_share;
+}
+
+std::shared_ptr<Transport> ResDBConfig::GetTransport() const {
+  return transport_;
+}
+
+void ResDBConfig::SetTransport(std::shared_ptr<Transport> transport) {
+  transport_ = std::move(transport);
+}
+
 }  // namespace resdb
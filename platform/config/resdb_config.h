@@ -19,11 +19,16 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
+
 #include "common/proto/signature_info.pb.h"
 #include "platform/proto/replica_info.pb.h"
 
 namespace resdb {
 
+class Transport;
+
 // TODO read from a proto json file.
 class ResDBConfig {
  public:
@@ -121,12 +126,26 @@ class ResDBConfig {
   uint32_t GetViewchangeCommitTimeout() const;
   void SetViewchangeCommitTimeout(uint64_t timeout_ms);
 
+  // The threshold key share of this replica, used to create constant-size
+  // quorum certificates. Clients only own the public key to verify them.
+  // Returns nullptr if it is not set.
+  const ThresholdKeyShare* GetThresholdKeyShare() const;
+  void SetThresholdKeyShare(const ThresholdKeyShare& key_share);
+
+  // The transport linking the replicas, like the in-process one running a
+  // cluster in one process. Returns nullptr if it is not set, the replicas
+  // are linked by TCP then.
+  std::shared_ptr<Transport> GetTransport() const;
+  void SetTransport(std::shared_ptr<Transport> transport);
+
  private:
   ResConfigData config_data_;
   std::vector<ReplicaInfo> replicas_;
   ReplicaInfo self_info_;
   const KeyInfo private_key_;
   const CertificateInfo public_key_cert_info_;
+  std::optional<ThresholdKeyShare> threshold_key_share_;
+  std::shared_ptr<Transport> transport_;
   int client_timeout_ms_ = 3000000;
   std::string checkpoint_logging_path_;
   int checkpoint_water_mark_ = 5;
@@ -60,6 +60,21 @@ KeyInfo ReadKey(const std::string& file_name) {
   return key;
 }
 
+// Returns false if the key file does not exist. T is ThresholdKeyShare or
+// ThresholdPublicKey.
+template <typename T>
+bool ReadThresholdKey(const std::string& file_name, T* key) {
+  std::ifstream file(file_name, std::ios::binary);
+  if (!file.is_open()) {
+    LOG(ERROR) << "open threshold key:" << file_name
+               << " fail:" << strerror(errno);
+    return false;
+  }
+  std::string res((std::istreambuf_iterator<char>(file)),
+                  std::istreambuf_iterator<char>());
+  return key->ParseFromString(res);
+}
+
 CertificateInfo ReadCert(const std::string& file_name) {
   int fd = open(file_name.c_str(), O_RDONLY, 0666);
   if (fd < 0) {
@@ -172,11 +187,33 @@ std::unique_ptr<ResDBConfig> GenerateResDBConfig(
 
   *(*self_info).mutable_certificate_info() = cert_info;
 
+  std::unique_ptr<ResDBConfig> config;
   if (gen_func.has_value()) {
-    return (*gen_func)(config_data, self_info.value(), private_key, cert_info);
+    config =
+        (*gen_func)(config_data, self_info.value(), private_key, cert_info);
+  } else {
+    config = std::make_unique<ResDBConfig>(config_data, self_info.value(),
+                                           private_key, cert_info);
+  }
+
+  if (!config_data.threshold_key_path().empty()) {
+    ThresholdKeyShare key_share;
+    if (cert_info.public_key().public_key_info().type() ==
+        CertificateKeyInfo::CLIENT) {
+      // Clients only verify the certificates of the responses.
+      if (ReadThresholdKey(
+              config_data.threshold_key_path() + "/threshold.key.pub",
+              key_share.mutable_public_key())) {
+        config->SetThresholdKeyShare(key_share);
+      }
+    } else if (ReadThresholdKey(config_data.threshold_key_path() + "/node" +
+                                    std::to_string((*self_info).id()) +
+                                    ".threshold.key",
+                                &key_share)) {
+      config->SetThresholdKeyShare(key_share);
+    }
   }
-  return std::make_unique<ResDBConfig>(config_data, self_info.value(),
-                                       private_key, cert_info);
+  return config;
 }
 
 ResDBConfig GenerateResDBConfig(const std::string& config_file) {
@@ -21,123 +21,65 @@
 
 #include <glog/logging.h>
 
-#include "common/utils/utils.h"
 namespace resdb {
+
 DuplicateManager::DuplicateManager(const ResDBConfig& config)
     : config_(config) {
   if (config.GetConfigData().duplicate_check_frequency_useconds() > 0) {
     frequency_useconds_ =
         config.GetConfigData().duplicate_check_frequency_useconds();
   }
-  stop_ = false;
-  update_thread_ = std::thread(&DuplicateManager::UpdateRecentHash, this);
-}
-
-DuplicateManager::~DuplicateManager() {
-  stop_ = true;
-  if (update_thread_.joinable()) {
-    update_thread_.join();
+  if (config.GetConfigData().duplicate_index_capacity() > 0) {
+    capacity_ = config.GetConfigData().duplicate_index_capacity();
   }
+  // Each generation lasts frequency_useconds_. Keep one more generation than
+  // the window so that a hash lives for at least window_useconds_.
+  uint32_t generation_num = (window_useconds_ + frequency_useconds_ - 1) /
+                                frequency_useconds_ +
+                            1;
+  proposed_hash_ = std::make_unique<ConcurrentHashIndex>(
+      capacity_, frequency_useconds_, generation_num);
+  executed_hash_ = std::make_unique<ConcurrentHashIndex>(
+      capacity_, frequency_useconds_, generation_num);
 }
 
-bool DuplicateManager::IsStop() { return stop_; }
+DuplicateManager::~DuplicateManager() = default;
 
 bool DuplicateManager::CheckIfProposed(const std::string& hash) {
-  std::lock_guard<std::mutex> lk(prop_mutex_);
-  return proposed_hash_set_.find(hash) != proposed_hash_set_.end();
+  return proposed_hash_->Find(hash);
 }
 
 uint64_t DuplicateManager::CheckIfExecuted(const std::string& hash) {
-  std::lock_guard<std::mutex> lk(exec_mutex_);
-  if (executed_hash_set_.find(hash) != executed_hash_set_.end()) {
-    return executed_hash_seq_[hash];
-  } else {
-    return 0;
+  uint64_t seq = 0;
+  if (executed_hash_->Find(hash, &seq)) {
+    return seq;
   }
+  return 0;
 }
 
 void DuplicateManager::AddProposed(const std::string& hash) {
-  std::lock_guard<std::mutex> lk(prop_mutex_);
-  proposed_hash_time_queue_.push(std::make_pair(hash, GetCurrentTime()));
-  proposed_hash_set_.insert(hash);
+  proposed_hash_->Update(hash, 0);
 }
 
 void DuplicateManager::AddExecuted(const std::string& hash, uint64_t seq) {
-  std::lock_guard<std::mutex> lk(exec_mutex_);
-  executed_hash_time_queue_.push(std::make_pair(hash, GetCurrentTime()));
-  executed_hash_set_.insert(hash);
-  executed_hash_seq_[hash] = seq;
+  executed_hash_->Update(hash, seq);
 }
 
 bool DuplicateManager::CheckAndAddProposed(const std::string& hash) {
-  std::lock_guard<std::mutex> lk(prop_mutex_);
-  if (proposed_hash_set_.find(hash) != proposed_hash_set_.end()) {
-    return true;
-  }
-  proposed_hash_time_queue_.push(std::make_pair(hash, GetCurrentTime()));
-  proposed_hash_set_.insert(hash);
-  return false;
+  return !proposed_hash_->Insert(hash);
 }
 
 bool DuplicateManager::CheckAndAddExecuted(const std::string& hash,
                                            uint64_t seq) {
-  std::lock_guard<std::mutex> lk(exec_mutex_);
-  if (executed_hash_set_.find(hash) != executed_hash_set_.end()) {
-    return true;
-  }
-  executed_hash_time_queue_.push(std::make_pair(hash, GetCurrentTime()));
-  executed_hash_set_.insert(hash);
-  executed_hash_seq_[hash] = seq;
-  return false;
+  return !executed_hash_->Insert(hash, seq);
 }
 
 void DuplicateManager::EraseProposed(const std::string& hash) {
-  std::lock_guard<std::mutex> lk(prop_mutex_);
-  proposed_hash_set_.erase(hash);
+  proposed_hash_->Erase(hash);
 }
 
 void DuplicateManager::EraseExecuted(const std::string& hash) {
-  std::lock_guard<std::mutex> lk(exec_mutex_);
-  executed_hash_set_.erase(hash);
-  executed_hash_seq_.erase(hash);
+  executed_hash_->Erase(hash);
 }
 
-void DuplicateManager::UpdateRecentHash() {
-  uint64_t time = GetCurrentTime();
-  while (!IsStop()) {
-    time = time + frequency_useconds_;
-    auto sleep_time = time - GetCurrentTime();
-    usleep(sleep_time);
-    while (true) {
-      std::lock_guard<std::mutex> lk(prop_mutex_);
-      if (!proposed_hash_time_queue_.empty()) {
-        auto it = proposed_hash_time_queue_.front();
-        if (it.second + window_useconds_ < time) {
-          proposed_hash_time_queue_.pop();
-          proposed_hash_set_.erase(it.first);
-        } else {
-          break;
-        }
-      } else {
-        break;
-      }
-    }
-
-    while (true) {
-      std::lock_guard<std::mutex> lk(exec_mutex_);
-      if (!executed_hash_time_queue_.empty()) {
-        auto it = executed_hash_time_queue_.front();
-        if (it.second + window_useconds_ < time) {
-          executed_hash_time_queue_.pop();
-          executed_hash_set_.erase(it.first);
-          executed_hash_seq_.erase(it.first);
-        } else {
-          break;
-        }
-      } else {
-        break;
-      }
-    }
-  }
-}
 }  // namespace resdb
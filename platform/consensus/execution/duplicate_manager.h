@@ -20,19 +20,20 @@
 #pragma once
 
 #include <stdint.h>
-#include <unistd.h>
 
-#include <map>
 #include <memory>
-#include <mutex>
-#include <queue>
-#include <set>
-#include <thread>
+#include <string>
 
+#include "platform/common/index/concurrent_hash_index.h"
 #include "platform/config/resdb_config.h"
 
 namespace resdb {
 
+// Tracks the hash of the requests proposed and executed recently to reject
+// duplicated requests. A hash is remembered for at least window_useconds_.
+// Both indexes grow up to duplicate_index_capacity in the config. Once full,
+// the oldest hashes are evicted first, so the capacity should hold the
+// requests of a window.
 class DuplicateManager {
  public:
   DuplicateManager(const ResDBConfig& config);
@@ -46,24 +47,14 @@ class DuplicateManager {
   void EraseExecuted(const std::string& hash);
   bool CheckAndAddProposed(const std::string& hash);
   bool CheckAndAddExecuted(const std::string& hash, uint64_t seq);
-  void UpdateRecentHash();
-
- private:
-  bool IsStop();
 
  private:
   ResDBConfig config_;
-  std::set<std::string> proposed_hash_set_;
-  std::set<std::string> executed_hash_set_;
-  std::queue<std::pair<std::string, uint64_t>> proposed_hash_time_queue_;
-  std::queue<std::pair<std::string, uint64_t>> executed_hash_time_queue_;
-  std::map<std::string, uint64_t> executed_hash_seq_;
-  std::thread update_thread_;
-  std::mutex prop_mutex_;
-  std::mutex exec_mutex_;
+  std::unique_ptr<ConcurrentHashIndex> proposed_hash_;
+  std::unique_ptr<ConcurrentHashIndex> executed_hash_;
   uint64_t frequency_useconds_ = 5000000;  // 5s
   uint64_t window_useconds_ = 20000000;    // 20s
-  bool stop_ = false;
+  uint64_t capacity_ = 1 << 18;
 };
 
 }  // namespace resdb
@@ -23,6 +23,12 @@
 
 namespace resdb {
 
+struct GeoGlobalExecutor::Batch {
+  std::unique_ptr<Request> request;
+  BatchUserRequest batch_request;
+  std::unique_ptr<BatchUserResponse> batch_response;
+};
+
 GeoGlobalExecutor::GeoGlobalExecutor(
     std::unique_ptr<TransactionManager> global_transaction_manager,
     const ResDBConfig& config)
@@ -31,8 +37,12 @@ GeoGlobalExecutor::GeoGlobalExecutor(
       is_stop_(false) {
   global_stats_ = Stats::GetGlobalStats();
   region_size_ = config_.GetConfigData().region().size();
-  order_thread_ = std::thread(&GeoGlobalExecutor::OrderRound, this);
   my_region_ = config.GetConfigData().self_region_id();
+  // The ordering thread executes one batch of each wave itself.
+  for (int i = 1; i < config_.GetConfigData().geo_execute_worker_num(); ++i) {
+    workers_.push_back(std::thread(&GeoGlobalExecutor::RunWorker, this));
+  }
+  order_thread_ = std::thread(&GeoGlobalExecutor::OrderRound, this);
 }
 
 GeoGlobalExecutor::~GeoGlobalExecutor() { Stop(); }
@@ -42,34 +52,151 @@ void GeoGlobalExecutor::Stop() {
   if (order_thread_.joinable()) {
     order_thread_.join();
   }
+  {
+    std::lock_guard<std::mutex> lk(task_mutex_);
+    task_cv_.notify_all();
+  }
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
 }
 
-void GeoGlobalExecutor::Execute(std::unique_ptr<Request> request) {
-  BatchUserRequest batch_request;
-  if (!batch_request.ParseFromString(request->data())) {
+bool GeoGlobalExecutor::ParseBatch(const Request& request,
+                                   BatchUserRequest* batch_request) {
+  if (!batch_request->ParseFromString(request.data())) {
     LOG(ERROR) << "[GeoGlobalExecutor] parse data fail!";
-    return;
+    return false;
   }
-  if (request->data().empty()) {
+  if (request.data().empty()) {
     LOG(ERROR) << "[GeoGlobalExecutor] request->data() is empty ";
-    return;
+    return false;
   }
 
   if (global_stats_) {
-    global_stats_->IncTotalGeoRequest(batch_request.user_requests_size());
-  }
-  if (global_transaction_manager_) {
-    auto batch_response =
-        global_transaction_manager_->ExecuteBatch(batch_request);
-    if (batch_response != nullptr &&
-        request->region_info().region_id() == my_region_) {
-      batch_response->set_createtime(batch_request.createtime());
-      batch_response->set_local_id(batch_request.local_id());
-      batch_response->set_proxy_id(batch_request.proxy_id());
-      batch_response->set_seq(batch_request.seq());
-      resp_queue_.Push(std::move(batch_response));
+    global_stats_->IncTotalGeoRequest(batch_request->user_requests_size());
+  }
+  return true;
+}
+
+std::unique_ptr<BatchUserResponse> GeoGlobalExecutor::ExecuteBatch(
+    const BatchUserRequest& batch_request) {
+  if (global_transaction_manager_ == nullptr) {
+    return nullptr;
+  }
+  return global_transaction_manager_->ExecuteBatch(batch_request);
+}
+
+void GeoGlobalExecutor::AddResponse(
+    const Request& request, const BatchUserRequest& batch_request,
+    std::unique_ptr<BatchUserResponse> batch_response) {
+  if (batch_response != nullptr &&
+      request.region_info().region_id() == my_region_) {
+    batch_response->set_createtime(batch_request.createtime());
+    batch_response->set_local_id(batch_request.local_id());
+    batch_response->set_proxy_id(batch_request.proxy_id());
+    batch_response->set_seq(batch_request.seq());
+    resp_queue_.Push(std::move(batch_response));
+  }
+}
+
+void GeoGlobalExecutor::Execute(std::unique_ptr<Request> request) {
+  BatchUserRequest batch_request;
+  if (!ParseBatch(*request, &batch_request)) {
+    return;
+  }
+  AddResponse(*request, batch_request, ExecuteBatch(batch_request));
+}
+
+void GeoGlobalExecutor::RunWorker() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lk(task_mutex_);
+      task_cv_.wait(lk, [&] { return IsStop() || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void GeoGlobalExecutor::ExecuteWave(const std::vector<Batch*>& wave) {
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+  size_t pending = wave.size() - 1;
+  {
+    std::lock_guard<std::mutex> lk(task_mutex_);
+    for (size_t i = 1; i < wave.size(); ++i) {
+      Batch* batch = wave[i];
+      tasks_.push_back([&, batch]() {
+        batch->batch_response = ExecuteBatch(batch->batch_request);
+        std::lock_guard<std::mutex> lk(done_mutex);
+        if (--pending == 0) {
+          done_cv.notify_one();
+        }
+      });
+    }
+  }
+  task_cv_.notify_all();
+  wave[0]->batch_response = ExecuteBatch(wave[0]->batch_request);
+
+  std::unique_lock<std::mutex> lk(done_mutex);
+  done_cv.wait(lk, [&] { return pending == 0; });
+}
+
+void GeoGlobalExecutor::ExecuteParallel(
+    std::vector<std::unique_ptr<Request>> requests) {
+  std::vector<Batch> batches;
+  batches.reserve(requests.size());
+  for (auto& request : requests) {
+    Batch batch;
+    if (!ParseBatch(*request, &batch.batch_request)) {
+      continue;
+    }
+    batch.request = std::move(request);
+    batches.push_back(std::move(batch));
+  }
+
+  std::vector<Batch*> wave;
+  std::set<std::string> wave_keys;
+  bool wave_keys_known = true;
+  auto flush_wave = [&]() {
+    if (wave.empty()) {
+      return;
+    }
+    ExecuteWave(wave);
+    // The waves follow the global order, deliver the responses in it.
+    for (Batch* batch : wave) {
+      AddResponse(*batch->request, batch->batch_request,
+                  std::move(batch->batch_response));
+    }
+    wave.clear();
+    wave_keys.clear();
+    wave_keys_known = true;
+  };
+
+  for (Batch& batch : batches) {
+    std::set<std::string> keys;
+    bool keys_known = global_transaction_manager_ &&
+                      global_transaction_manager_->GetBatchKeys(
+                          batch.batch_request, &keys);
+    bool conflict = !keys_known || !wave_keys_known;
+    for (auto it = keys.begin(); !conflict && it != keys.end(); ++it) {
+      conflict = wave_keys.count(*it) > 0;
     }
+    if (conflict) {
+      flush_wave();
+    }
+    wave.push_back(&batch);
+    wave_keys.insert(keys.begin(), keys.end());
+    wave_keys_known = wave_keys_known && keys_known;
   }
+  flush_wave();
 }
 
 bool GeoGlobalExecutor::IsStop() { return is_stop_; }
@@ -79,15 +206,18 @@ int GeoGlobalExecutor::OrderGeoRequest(std::unique_ptr<Request> request) {
   return 0;
 }
 
-void GeoGlobalExecutor::AddData() {
-  auto request = order_queue_.Pop();
+bool GeoGlobalExecutor::AddData(int timeout_ms) {
+  auto request = order_queue_.Pop(timeout_ms);
   if (request == nullptr) {
-    return;
+    return false;
+  }
+  if (global_stats_) {
+    global_stats_->IncGeoRequest();
   }
-  global_stats_->IncGeoRequest();
   uint64_t seq_num = request->seq();
   int region_id = request->region_info().region_id();
   execute_map_[std::make_pair(seq_num, region_id)] = std::move(request);
+  return true;
 }
 
 std::unique_ptr<Request> GeoGlobalExecutor::GetNextMap() {
@@ -114,12 +244,30 @@ std::unique_ptr<Request> GeoGlobalExecutor::GetNextMap() {
 void GeoGlobalExecutor::OrderRound() {
   while (!IsStop()) {
     AddData();
+    if (workers_.empty()) {
+      while (!IsStop()) {
+        std::unique_ptr<Request> seq_map = GetNextMap();
+        if (seq_map == nullptr) {
+          break;
+        }
+        Execute(std::move(seq_map));
+      }
+      continue;
+    }
+
+    // Take all the requests received so far and execute the ones ready.
+    while (!IsStop() && AddData(0)) {
+    }
+    std::vector<std::unique_ptr<Request>> requests;
     while (!IsStop()) {
       std::unique_ptr<Request> seq_map = GetNextMap();
       if (seq_map == nullptr) {
         break;
       }
-      Execute(std::move(seq_map));
+      requests.push_back(std::move(seq_map));
+    }
+    if (!requests.empty()) {
+      ExecuteParallel(std::move(requests));
     }
   }
 }
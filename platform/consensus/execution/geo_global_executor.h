@@ -18,6 +18,8 @@
  */
 
 #pragma once
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <queue>
 #include <unordered_map>
@@ -29,6 +31,15 @@
 
 namespace resdb {
 
+// GeoGlobalExecutor executes the batches of all the regions in the global
+// order: round by round (the seq), and by region id inside a round.
+//
+// If geo_execute_worker_num is set, the batches of a round that are ready
+// are split into waves in region order. A batch joins the current wave if
+// its keys, from TransactionManager::GetBatchKeys, do not intersect the
+// keys of the wave; the batches of a wave are executed concurrently. The
+// responses are still delivered in (round, region) order, so the result is
+// the same as the serial execution.
 class GeoGlobalExecutor {
  public:
   GeoGlobalExecutor(
@@ -49,7 +60,20 @@ class GeoGlobalExecutor {
   bool IsStop();
   void OrderRound();
   std::unique_ptr<Request> GetNextMap();
-  void AddData();
+  bool AddData(int timeout_ms = 100);
+
+  bool ParseBatch(const Request& request, BatchUserRequest* batch_request);
+  std::unique_ptr<BatchUserResponse> ExecuteBatch(
+      const BatchUserRequest& batch_request);
+  void AddResponse(const Request& request,
+                   const BatchUserRequest& batch_request,
+                   std::unique_ptr<BatchUserResponse> batch_response);
+
+  // Parallel execution.
+  void ExecuteParallel(std::vector<std::unique_ptr<Request>> requests);
+  struct Batch;
+  void ExecuteWave(const std::vector<Batch*>& wave);
+  void RunWorker();
 
  protected:
   std::unique_ptr<TransactionManager> global_transaction_manager_;
@@ -66,5 +90,10 @@ class GeoGlobalExecutor {
   LockFreeQueue<Request> order_queue_;
   LockFreeQueue<BatchUserResponse> resp_queue_;
   int my_region_;
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex task_mutex_;
+  std::condition_variable task_cv_;
 };
 }  // namespace resdb
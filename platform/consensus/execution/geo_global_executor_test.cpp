@@ -24,6 +24,7 @@
 #include <gtest/gtest.h>
 
 #include <future>
+#include <thread>
 
 #include "common/test/test_macros.h"
 #include "executor/common/mock_transaction_manager.h"
@@ -90,6 +91,87 @@ TEST_F(GlobalExecutorTest, ExecuteFailed) {
   global_executor.Execute(std::make_unique<Request>(request));
 }
 
+// Records the batches running at the same time. The key of a batch is its
+// request data.
+class KeyedTransactionManager : public TransactionManager {
+ public:
+  bool GetBatchKeys(const BatchUserRequest& request,
+                    std::set<std::string>* keys) override {
+    for (const auto& sub_request : request.user_requests()) {
+      keys->insert(sub_request.request().data());
+    }
+    return true;
+  }
+
+  std::unique_ptr<BatchUserResponse> ExecuteBatch(
+      const BatchUserRequest& request) override {
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      running_.insert(request.user_requests(0).request().data());
+      max_running_ = std::max(max_running_, running_.size());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::lock_guard<std::mutex> lk(mutex_);
+    running_.erase(request.user_requests(0).request().data());
+    order_.push_back(request.seq());
+    return std::make_unique<BatchUserResponse>();
+  }
+
+  size_t GetMaxRunning() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return max_running_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::set<std::string> running_;
+  size_t max_running_ = 0;
+  std::vector<uint64_t> order_;
+};
+
+TEST(GeoGlobalExecutorParallelTest, ExecuteNonConflictBatches) {
+  ResConfigData config_data;
+  config_data.set_self_region_id(1);
+  config_data.set_geo_execute_worker_num(4);
+  for (int i = 1; i <= 3; ++i) {
+    config_data.add_region()->set_region_id(i);
+  }
+  ResDBConfig config({GenerateReplicaInfo(1, "127.0.0.1", 1234)},
+                     GenerateReplicaInfo(1, "127.0.0.1", 1234), config_data);
+
+  auto manager = std::make_unique<KeyedTransactionManager>();
+  KeyedTransactionManager* manager_ptr = manager.get();
+  GeoGlobalExecutor global_executor(std::move(manager), config);
+
+  // Region 3 of each round writes the key of region 1 and has to wait for
+  // it, region 2 runs with region 1. Region 1 comes last so that the whole
+  // round is ready at once.
+  std::vector<std::string> keys = {"a", "b", "a"};
+  for (int seq = 1; seq <= 2; ++seq) {
+    for (int region : {2, 3, 1}) {
+      Request request;
+      request.set_seq(seq);
+      request.mutable_region_info()->set_region_id(region);
+      BatchUserRequest batch_request;
+      batch_request.set_seq(seq);
+      batch_request.add_user_requests()->mutable_request()->set_data(
+          keys[region - 1] + std::to_string(seq));
+      batch_request.SerializeToString(request.mutable_data());
+      global_executor.OrderGeoRequest(std::make_unique<Request>(request));
+    }
+  }
+
+  // The responses of region 1 come in the seq order.
+  for (int seq = 1; seq <= 2; ++seq) {
+    std::unique_ptr<BatchUserResponse> response;
+    while (response == nullptr) {
+      response = global_executor.GetResponseMsg();
+    }
+    EXPECT_EQ(response->seq(), seq);
+  }
+  EXPECT_GE(manager_ptr->GetMaxRunning(), 2);
+}
+
 }  // namespace
 
 }  // namespace resdb
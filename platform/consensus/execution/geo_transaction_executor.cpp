@@ -21,6 +21,9 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <iterator>
+
 #include "platform/consensus/ordering/common/transaction_utils.h"
 
 namespace resdb {
@@ -35,14 +38,43 @@ GeoTransactionExecutor::GeoTransactionExecutor(
       replica_communicator_(std::move(replica_communicator)),
       local_transaction_manager_(std::move(local_transaction_manager)),
       is_stop_(false) {
+  const ResConfigData& config_data = config_.GetConfigData();
+  if (config_data.geo_bundle_size() > 0) {
+    bundle_size_ = config_data.geo_bundle_size();
+  }
+  if (config_data.geo_send_queue_size() > 0) {
+    send_queue_size_ = config_data.geo_send_queue_size();
+  }
+  for (const auto& region : config_data.region()) {
+    if (region.region_id() == config_data.self_region_id()) {
+      if (region.has_threshold_public_key()) {
+        region_signature_ =
+            std::make_unique<ThresholdSignature>(region.threshold_public_key());
+      }
+      continue;
+    }
+    auto sender = std::make_unique<RegionSender>();
+    sender->region = region;
+    region_senders_.push_back(std::move(sender));
+  }
+  for (auto& sender : region_senders_) {
+    sender->thread = std::thread(&GeoTransactionExecutor::ShipBundles, this,
+                                 sender.get());
+  }
   geo_thread_ = std::thread(&GeoTransactionExecutor::SendGeoMessages, this);
 }
 
 GeoTransactionExecutor::~GeoTransactionExecutor() {
   is_stop_ = true;
+  send_cv_.notify_all();
   if (geo_thread_.joinable()) {
     geo_thread_.join();
   }
+  for (auto& sender : region_senders_) {
+    if (sender->thread.joinable()) {
+      sender->thread.join();
+    }
+  }
 }
 
 bool GeoTransactionExecutor::IsStop() { return is_stop_; }
@@ -65,17 +97,16 @@ void GeoTransactionExecutor::SendGeoMessages() {
       }
     }
     if (messages.size() > 0) {
-      SendBatchGeoMessage(messages);
+      SendBatchGeoMessage(std::move(messages));
       messages.clear();
     }
+    ShipPendingRequests();
   }
   return;
 }
 
 void GeoTransactionExecutor::SendBatchGeoMessage(
-    const std::vector<std::unique_ptr<Request>>& batch_geo_request) {
-  ResConfigData config_data = config_.GetConfigData();
-
+    std::vector<std::unique_ptr<Request>> batch_geo_request) {
   int self_send = replica_communicator_->SendBatchMessage(
       batch_geo_request, config_.GetSelfInfo());
   if (self_send < 0) {
@@ -83,26 +114,128 @@ void GeoTransactionExecutor::SendBatchGeoMessage(
   }
   // Only for primary node: send out GEO_REQUEST to other regions.
   if (config_.GetSelfInfo().id() == system_info_->GetPrimaryId()) {
-    for (const auto& region : config_data.region()) {
-      if (region.region_id() == config_data.self_region_id()) {
+    for (auto& request : batch_geo_request) {
+      pending_.push_back(std::move(request));
+    }
+  }
+}
+
+void GeoTransactionExecutor::ShipPendingRequests() {
+  while (!pending_.empty() && !IsStop()) {
+    // Wait for the queues only if a full bundle is ready, otherwise keep
+    // collecting the seqs until they have room.
+    if (!WaitForSendQueues(pending_.size() >= bundle_size_)) {
+      return;
+    }
+    size_t num = std::min(pending_.size(), bundle_size_);
+    std::vector<std::unique_ptr<Request>> requests(
+        std::make_move_iterator(pending_.begin()),
+        std::make_move_iterator(pending_.begin() + num));
+    pending_.erase(pending_.begin(), pending_.begin() + num);
+
+    std::shared_ptr<Request> bundle = NewGeoBundle(std::move(requests));
+    {
+      std::lock_guard<std::mutex> lk(send_mutex_);
+      for (auto& sender : region_senders_) {
+        sender->bundles.push_back(bundle);
+      }
+    }
+    send_cv_.notify_all();
+  }
+}
+
+bool GeoTransactionExecutor::WaitForSendQueues(bool block) {
+  auto has_room = [&] {
+    for (const auto& sender : region_senders_) {
+      if (sender->bundles.size() >= send_queue_size_) {
+        return false;
+      }
+    }
+    return true;
+  };
+  std::unique_lock<std::mutex> lk(send_mutex_);
+  if (!block) {
+    return has_room();
+  }
+  while (!IsStop()) {
+    if (send_cv_.wait_for(lk, std::chrono::milliseconds(100), has_room)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<Request> GeoTransactionExecutor::NewGeoBundle(
+    std::vector<std::unique_ptr<Request>> requests) {
+  GeoBundle geo_bundle;
+  std::vector<BatchUserRequest> batches(requests.size());
+  std::vector<const QuorumCertificate*> certs;
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (batches[i].ParseFromString(requests[i]->data()) &&
+        batches[i].committed_certs().has_quorum_cert()) {
+      certs.push_back(&batches[i].committed_certs().quorum_cert());
+    }
+  }
+  if (region_signature_ && certs.size() == requests.size()) {
+    auto aggregate_cert = region_signature_->Aggregate(certs);
+    if (aggregate_cert.ok()) {
+      *geo_bundle.mutable_aggregate_cert() = std::move(*aggregate_cert);
+      // The aggregate certificate replaces the ones of the batches.
+      for (size_t i = 0; i < requests.size(); ++i) {
+        batches[i].mutable_committed_certs()->clear_quorum_cert();
+        batches[i].SerializeToString(requests[i]->mutable_data());
+      }
+    } else {
+      LOG(ERROR) << "aggregate certificates fail:" << aggregate_cert.status();
+    }
+  }
+  for (auto& request : requests) {
+    geo_bundle.add_requests()->Swap(request.get());
+  }
+
+  std::unique_ptr<Request> bundle = resdb::NewRequest(
+      Request::TYPE_GEO_BUNDLE, Request(), config_.GetSelfInfo().id(),
+      config_.GetConfigData().self_region_id());
+  geo_bundle.SerializeToString(bundle->mutable_data());
+  return bundle;
+}
+
+void GeoTransactionExecutor::ShipBundles(RegionSender* sender) {
+  // maximum number of faulty replicas in this region
+  int max_faulty = (sender->region.replica_info_size() - 1) / 3;
+  while (!IsStop()) {
+    std::shared_ptr<Request> bundle;
+    {
+      std::unique_lock<std::mutex> lk(send_mutex_);
+      if (!send_cv_.wait_for(lk, std::chrono::milliseconds(100), [&] {
+            return !sender->bundles.empty() || IsStop();
+          })) {
         continue;
       }
-      // maximum number of faulty replicas in this region
-      int max_faulty = (region.replica_info_size() - 1) / 3;
-      int num_request_sent = 0;
-      for (const auto& replica : region.replica_info()) {
-        // send to f + 1 replicas in the region
-        if (num_request_sent > max_faulty) {
-          break;
-        }
-        int ret =
-            replica_communicator_->SendBatchMessage(batch_geo_request, replica);
-        if (ret >= 0) {
-          num_request_sent++;
-        }
+      if (sender->bundles.empty()) {
+        continue;
+      }
+      // The bundle stays in the queue while it is sent, counting towards
+      // the backpressure.
+      bundle = sender->bundles.front();
+    }
+
+    int num_request_sent = 0;
+    for (const auto& replica : sender->region.replica_info()) {
+      // send to f + 1 replicas in the region
+      if (num_request_sent > max_faulty) {
+        break;
+      }
+      int ret = replica_communicator_->SendMessage(*bundle, replica);
+      if (ret >= 0) {
+        num_request_sent++;
       }
     }
-    // LOG(ERROR) << "local executor send out geo message";
+    {
+      std::lock_guard<std::mutex> lk(send_mutex_);
+      sender->bundles.pop_front();
+    }
+    send_cv_.notify_all();
   }
 }
 
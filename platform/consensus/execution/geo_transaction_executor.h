@@ -18,6 +18,11 @@
  */
 
 #pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "common/crypto/threshold_signature.h"
 #include "executor/common/transaction_manager.h"
 #include "platform/config/resdb_config.h"
 #include "platform/consensus/execution/system_info.h"
@@ -25,6 +30,13 @@
 
 namespace resdb {
 
+// GeoTransactionExecutor ships the batches committed in the local region to
+// the other regions.
+//  The primary bundles up to geo_bundle_size committed seqs per message,
+//  with one aggregate certificate if the region owns a threshold key. Each
+//  region has its own send queue and thread, so a slow region does not hold
+//  the others. A bundle is formed only when every queue has room, the seqs
+//  committed in the meantime join the next bundle.
 class GeoTransactionExecutor : public TransactionManager {
  public:
   GeoTransactionExecutor(
@@ -38,9 +50,19 @@ class GeoTransactionExecutor : public TransactionManager {
   bool IsStop();
 
  private:
+  struct RegionSender {
+    RegionInfo region;
+    std::deque<std::shared_ptr<Request>> bundles;
+    std::thread thread;
+  };
+
   void SendGeoMessages();
-  void SendBatchGeoMessage(
-      const std::vector<std::unique_ptr<Request>>& requests);
+  void SendBatchGeoMessage(std::vector<std::unique_ptr<Request>> requests);
+  void ShipPendingRequests();
+  bool WaitForSendQueues(bool block);
+  std::unique_ptr<Request> NewGeoBundle(
+      std::vector<std::unique_ptr<Request>> requests);
+  void ShipBundles(RegionSender* sender);
 
  protected:
   ResDBConfig config_;
@@ -52,6 +74,16 @@ class GeoTransactionExecutor : public TransactionManager {
   LockFreeQueue<Request> queue_;
   std::atomic<bool> is_stop_;
 
+  size_t bundle_size_ = 50;
+  size_t send_queue_size_ = 16;
+  // Aggregates the quorum certificates of the local region.
+  std::unique_ptr<ThresholdSignature> region_signature_;
+  // The requests waiting for room in the send queues, used by geo_thread_.
+  std::vector<std::unique_ptr<Request>> pending_;
+  std::vector<std::unique_ptr<RegionSender>> region_senders_;
+  std::mutex send_mutex_;
+  std::condition_variable send_cv_;
+
   std::vector<std::unique_ptr<BatchUserRequest>> messages_;
 };
 
@@ -23,6 +23,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <future>
 
 #include "common/test/test_macros.h"
@@ -127,12 +128,22 @@ TEST(LocalExecutorTest, PrimaryNodeBroadcast) {
 
   ReplicaInfo rep_info = GenerateReplicaInfo(1, "127.0.0.1", 10001);
 
-  int call_times = 0;
+  std::atomic<int> call_times = 0;
   std::promise<bool> done;
   std::future<bool> done_future = done.get_future();
-  EXPECT_CALL(*replica_communicator, SendBatchMessage)
-      .WillRepeatedly(Invoke([&]() {
-        if (++call_times >= 3) {
+  EXPECT_CALL(*replica_communicator, SendBatchMessage).WillOnce(Return(0));
+  // The bundle is shipped to f+1 replicas of region 2.
+  EXPECT_CALL(*replica_communicator,
+              SendMessage(_, Matcher<const ReplicaInfo&>(_)))
+      .WillRepeatedly(Invoke([&](const google::protobuf::Message& message,
+                                 const ReplicaInfo& replica) {
+        const Request& request = dynamic_cast<const Request&>(message);
+        EXPECT_EQ(request.type(), Request::TYPE_GEO_BUNDLE);
+        EXPECT_GE(replica.id(), 6);
+        GeoBundle bundle;
+        EXPECT_TRUE(bundle.ParseFromString(request.data()));
+        EXPECT_EQ(bundle.requests_size(), 1);
+        if (++call_times == 2) {
           done.set_value(true);
         }
         return 0;
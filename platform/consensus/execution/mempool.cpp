@@ -0,0 +1,162 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/execution/mempool.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace resdb {
+
+Mempool::Mempool(size_t max_batch_num, size_t builder_num)
+    : max_batch_num_(max_batch_num),
+      max_builder_batch_num_(
+          std::max<size_t>(max_batch_num / std::max<size_t>(builder_num, 1),
+                           1)) {}
+
+void Mempool::SetFetchFunc(FetchFunc func) { fetch_func_ = func; }
+
+bool Mempool::Add(std::unique_ptr<Request> batch, bool force) {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    std::string hash = batch->hash();
+    if (batches_.find(hash) != batches_.end()) {
+      return false;
+    }
+    size_t& builder_batch_num = builder_batch_num_[batch->proxy_id()];
+    if (!force && builder_batch_num >= max_builder_batch_num_) {
+      LOG(ERROR) << "mempool share is full, reject batch from builder:"
+                 << batch->proxy_id() << " num:" << builder_batch_num;
+      return false;
+    }
+    ++builder_batch_num;
+    Batch& stored = batches_[hash];
+    stored.request = std::move(batch);
+    stored.arrival_stable_seq = stable_seq_;
+    arrival_.push(std::move(hash));
+  }
+  cv_.notify_all();
+  return true;
+}
+
+bool Mempool::Contains(const std::string& hash) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return batches_.find(hash) != batches_.end();
+}
+
+std::unique_ptr<Request> Mempool::Get(const std::string& hash) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = batches_.find(hash);
+  if (it == batches_.end()) {
+    return nullptr;
+  }
+  return std::make_unique<Request>(*it->second.request);
+}
+
+bool Mempool::FillData(Request* request, uint64_t timeout_us) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto it = batches_.find(request->hash());
+  if (it == batches_.end()) {
+    if (fetch_func_) {
+      lk.unlock();
+      fetch_func_(*request);
+      lk.lock();
+    }
+    cv_.wait_for(lk, std::chrono::microseconds(timeout_us), [&] {
+      it = batches_.find(request->hash());
+      return it != batches_.end();
+    });
+    if (it == batches_.end()) {
+      LOG(ERROR) << "batch is not in the mempool, seq:" << request->seq();
+      return false;
+    }
+  }
+  request->set_data(it->second.request->data());
+  *request->mutable_data_signature() = it->second.request->data_signature();
+  if (it->second.executed_seq == 0 && request->seq() > 0) {
+    it->second.executed_seq = request->seq();
+    executed_.emplace(request->seq(), request->hash());
+  }
+  return true;
+}
+
+void Mempool::Prune(uint64_t stable_seq) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (stable_seq <= stable_seq_) {
+    return;
+  }
+  // The replicas behind stable_seq recover from the checkpoint instead.
+  auto end = executed_.upper_bound(stable_seq);
+  for (auto it = executed_.begin(); it != end; ++it) {
+    auto batch_it = batches_.find(it->second);
+    if (batch_it != batches_.end()) {
+      Erase(batch_it);
+    }
+  }
+  executed_.erase(executed_.begin(), end);
+
+  uint64_t last_stable_seq = stable_seq_;
+  stable_seq_ = stable_seq;
+  while (batches_.size() >= max_batch_num_ && !arrival_.empty()) {
+    auto it = batches_.find(arrival_.front());
+    if (it == batches_.end()) {
+      arrival_.pop();
+      continue;
+    }
+    if (it->second.executed_seq > 0 ||
+        it->second.arrival_stable_seq >= last_stable_seq) {
+      break;
+    }
+    LOG(ERROR) << "drop stale batch, arrived at stable seq:"
+               << it->second.arrival_stable_seq;
+    Erase(it);
+    arrival_.pop();
+  }
+  // Drop the hash of the released batches.
+  if (arrival_.size() > 2 * max_batch_num_) {
+    std::queue<std::string> arrival;
+    for (; !arrival_.empty(); arrival_.pop()) {
+      if (batches_.find(arrival_.front()) != batches_.end()) {
+        arrival.push(std::move(arrival_.front()));
+      }
+    }
+    arrival_.swap(arrival);
+  }
+}
+
+void Mempool::Erase(std::unordered_map<std::string, Batch>::iterator it) {
+  auto num_it = builder_batch_num_.find(it->second.request->proxy_id());
+  if (num_it != builder_batch_num_.end() && --num_it->second == 0) {
+    builder_batch_num_.erase(num_it);
+  }
+  batches_.erase(it);
+}
+
+uint64_t Mempool::GetStableSeq() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return stable_seq_;
+}
+
+size_t Mempool::Size() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return batches_.size();
+}
+
+}  // namespace resdb
@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+
+#include "platform/proto/resdb.pb.h"
+
+namespace resdb {
+
+// Mempool stores the batches disseminated by the replicas before they are
+// ordered. Consensus only orders the hash of a batch and the executor takes
+// the payload from here. A batch missing locally is fetched through the
+// fetch function, e.g. from the replicas which acked the batch.
+// A stored batch may already be certified and ordered, so it is kept until it
+// has been executed and a later checkpoint is stable. The max_batch_num
+// batches are shared out evenly among the builder_num replicas building
+// them, keyed by the proxy id of the batch, so a faulty builder can not take
+// the room of the others. Once a builder holds its share, its new batches
+// are rejected; the ones that were never executed within two checkpoints are
+// dropped when the mempool is full.
+class Mempool {
+ public:
+  typedef std::function<void(const Request& request)> FetchFunc;
+
+  Mempool(size_t max_batch_num, size_t builder_num = 1);
+  ~Mempool() = default;
+
+  void SetFetchFunc(FetchFunc func);
+
+  // Store a batch keyed by its hash. Return false if it exists or its
+  // builder holds its share of the mempool. A forced batch, e.g. one fetched
+  // to be executed, is stored even if the share is used up.
+  bool Add(std::unique_ptr<Request> batch, bool force = false);
+  bool Contains(const std::string& hash);
+  // Return a copy of the batch, or nullptr if it does not exist.
+  std::unique_ptr<Request> Get(const std::string& hash);
+
+  // Copy the payload of the batch with the hash of request into the request.
+  // If the batch is missing, ask the fetch function for it and wait for at
+  // most timeout_us. Return false if it has not arrived yet.
+  // The batch is released once the checkpoint of its seq is stable.
+  bool FillData(Request* request, uint64_t timeout_us);
+
+  // Drop the batches executed at or below stable_seq, and the ones not
+  // executed since the previous stable checkpoint if the mempool is full.
+  void Prune(uint64_t stable_seq);
+  uint64_t GetStableSeq();
+
+  size_t Size();
+
+ private:
+  struct Batch {
+    std::unique_ptr<Request> request;
+    // The stable checkpoint when the batch arrived.
+    uint64_t arrival_stable_seq = 0;
+    // The seq the batch was executed at, 0 if it is not executed.
+    uint64_t executed_seq = 0;
+  };
+
+  // Must be called holding mutex_.
+  void Erase(std::unordered_map<std::string, Batch>::iterator it);
+
+  size_t max_batch_num_;
+  size_t max_builder_batch_num_;
+  FetchFunc fetch_func_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<std::string, Batch> batches_;
+  // The number of batches stored for each builder.
+  std::unordered_map<int32_t, size_t> builder_batch_num_;
+  // The hash of the batches in the order of their arrival.
+  std::queue<std::string> arrival_;
+  // The hash of the executed batches by their seq.
+  std::multimap<uint64_t, std::string> executed_;
+  uint64_t stable_seq_ = 0;
+};
+
+}  // namespace resdb
@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/execution/mempool.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+
+#include "common/test/test_macros.h"
+
+namespace resdb {
+namespace {
+
+using ::resdb::testing::EqualsProto;
+
+std::unique_ptr<Request> NewBatch(const std::string& hash) {
+  auto batch = std::make_unique<Request>();
+  batch->set_type(Request::TYPE_MEMPOOL_BATCH);
+  batch->set_hash(hash);
+  batch->set_data("data_" + hash);
+  batch->mutable_data_signature()->set_node_id(1);
+  return batch;
+}
+
+TEST(MempoolTest, AddBatch) {
+  Mempool mempool(4);
+  EXPECT_TRUE(mempool.Add(NewBatch("h1")));
+  EXPECT_FALSE(mempool.Add(NewBatch("h1")));
+  EXPECT_TRUE(mempool.Contains("h1"));
+  EXPECT_FALSE(mempool.Contains("h2"));
+  EXPECT_THAT(*mempool.Get("h1"), EqualsProto(*NewBatch("h1")));
+  EXPECT_EQ(mempool.Get("h2"), nullptr);
+}
+
+TEST(MempoolTest, RejectBatchWhenFull) {
+  Mempool mempool(2);
+  EXPECT_TRUE(mempool.Add(NewBatch("h1")));
+  EXPECT_TRUE(mempool.Add(NewBatch("h2")));
+  // The stored batches may be ordered, they are not dropped for new ones.
+  EXPECT_FALSE(mempool.Add(NewBatch("h3")));
+  EXPECT_EQ(mempool.Size(), 2);
+  EXPECT_TRUE(mempool.Contains("h1"));
+  EXPECT_TRUE(mempool.Contains("h2"));
+  EXPECT_FALSE(mempool.Contains("h3"));
+
+  // Unless the batch is fetched to be executed.
+  EXPECT_TRUE(mempool.Add(NewBatch("h3"), /*force=*/true));
+  EXPECT_EQ(mempool.Size(), 3);
+}
+
+TEST(MempoolTest, RejectBatchOverBuilderShare) {
+  Mempool mempool(4, /*builder_num=*/2);
+  auto new_batch = [](const std::string& hash, int32_t builder) {
+    std::unique_ptr<Request> batch = NewBatch(hash);
+    batch->set_proxy_id(builder);
+    return batch;
+  };
+  EXPECT_TRUE(mempool.Add(new_batch("h1", 1)));
+  EXPECT_TRUE(mempool.Add(new_batch("h2", 1)));
+  EXPECT_FALSE(mempool.Add(new_batch("h3", 1)));
+  // The other builder still has its share.
+  EXPECT_TRUE(mempool.Add(new_batch("h3", 2)));
+
+  // The share is released once the batch is executed and stable.
+  Request request;
+  request.set_hash("h1");
+  request.set_seq(5);
+  EXPECT_TRUE(mempool.FillData(&request, 0));
+  mempool.Prune(5);
+  EXPECT_TRUE(mempool.Add(new_batch("h4", 1)));
+}
+
+TEST(MempoolTest, PruneExecutedBatch) {
+  Mempool mempool(2);
+  EXPECT_TRUE(mempool.Add(NewBatch("h1")));
+  EXPECT_TRUE(mempool.Add(NewBatch("h2")));
+
+  Request request;
+  request.set_hash("h2");
+  request.set_seq(5);
+  EXPECT_TRUE(mempool.FillData(&request, 0));
+
+  // Kept until the checkpoint of its seq is stable.
+  mempool.Prune(4);
+  EXPECT_TRUE(mempool.Contains("h2"));
+  mempool.Prune(5);
+  EXPECT_FALSE(mempool.Contains("h2"));
+  EXPECT_TRUE(mempool.Contains("h1"));
+  EXPECT_EQ(mempool.GetStableSeq(), 5);
+  EXPECT_TRUE(mempool.Add(NewBatch("h3")));
+}
+
+TEST(MempoolTest, PruneStaleBatch) {
+  Mempool mempool(2);
+  EXPECT_TRUE(mempool.Add(NewBatch("h1")));
+  mempool.Prune(5);
+  EXPECT_TRUE(mempool.Add(NewBatch("h2")));
+
+  // h1 is not executed since the checkpoint 5, but the mempool is not full.
+  Mempool not_full(4);
+  EXPECT_TRUE(not_full.Add(NewBatch("h1")));
+  not_full.Prune(5);
+  not_full.Prune(10);
+  EXPECT_TRUE(not_full.Contains("h1"));
+
+  // h2 arrived after the checkpoint 5, it is kept.
+  mempool.Prune(10);
+  EXPECT_FALSE(mempool.Contains("h1"));
+  EXPECT_TRUE(mempool.Contains("h2"));
+}
+
+TEST(MempoolTest, FillData) {
+  Mempool mempool(4);
+  mempool.Add(NewBatch("h1"));
+
+  Request request;
+  request.set_hash("h1");
+  request.set_seq(1);
+  EXPECT_TRUE(mempool.FillData(&request, 0));
+  EXPECT_EQ(request.data(), "data_h1");
+  EXPECT_EQ(request.data_signature().node_id(), 1);
+}
+
+TEST(MempoolTest, FetchMissingBatch) {
+  Mempool mempool(4);
+  std::promise<std::string> fetched;
+  mempool.SetFetchFunc(
+      [&](const Request& request) { fetched.set_value(request.hash()); });
+
+  std::thread fetcher([&]() {
+    std::string hash = fetched.get_future().get();
+    mempool.Add(NewBatch(hash));
+  });
+
+  Request request;
+  request.set_hash("h1");
+  EXPECT_TRUE(mempool.FillData(&request, 10000000));
+  EXPECT_EQ(request.data(), "data_h1");
+  fetcher.join();
+}
+
+TEST(MempoolTest, FetchTimeout) {
+  Mempool mempool(4);
+  int fetch_num = 0;
+  mempool.SetFetchFunc([&](const Request& request) { fetch_num++; });
+
+  Request request;
+  request.set_hash("h1");
+  EXPECT_FALSE(mempool.FillData(&request, 1000));
+  EXPECT_FALSE(mempool.FillData(&request, 1000));
+  EXPECT_EQ(fetch_num, 2);
+  EXPECT_TRUE(request.data().empty());
+}
+
+}  // namespace
+}  // namespace resdb
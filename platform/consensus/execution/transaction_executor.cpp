@@ -25,6 +25,13 @@
 
 namespace resdb {
 
+namespace {
+
+// The max time waiting for a missing batch before fetching it again.
+constexpr uint64_t kMempoolWaitUs = 100000;
+
+}  // namespace
+
 TransactionExecutor::TransactionExecutor(
     const ResDBConfig& config, PostExecuteFunc post_exec_func,
     SystemInfo* system_info,
@@ -167,6 +174,7 @@ std::unique_ptr<Request> TransactionExecutor::GetNextData() {
     return nullptr;
   }
   auto res = std::move(candidates_.begin()->second);
+  FillData(res.get());
   if (pre_exec_func_) {
     pre_exec_func_(res.get());
   }
@@ -235,6 +243,7 @@ void TransactionExecutor::ExecuteMessageOutOfOrder() {
     if (message == nullptr) {
       continue;
     }
+    FillData(message.get());
     OnlyExecute(std::move(message));
   }
 }
@@ -372,6 +381,19 @@ void TransactionExecutor::SetDuplicateManager(DuplicateManager* manager) {
   duplicate_manager_ = manager;
 }
 
+void TransactionExecutor::SetMempool(Mempool* mempool) { mempool_ = mempool; }
+
+// Only the hash of the batches disseminated through the mempool is ordered.
+// The batches are executed in order, so wait here until the payload arrives.
+void TransactionExecutor::FillData(Request* request) {
+  if (mempool_ == nullptr || !request->data().empty() ||
+      !request->has_availability_cert()) {
+    return;
+  }
+  while (!IsStop() && !mempool_->FillData(request, kMempoolWaitUs)) {
+  }
+}
+
 bool TransactionExecutor::SetFlag(uint64_t uid, int f) {
   std::unique_lock<std::mutex> lk(f_mutex_[uid % mod]);
   auto it = flag_[uid % mod].find(uid);
@@ -476,6 +498,7 @@ void TransactionExecutor::PrepareMessage() {
 
     // LOG(ERROR)<<" prepare uid:"<<uid;
 
+    FillData(request.get());
     // Execute the request, then send the response back to the user.
     std::unique_ptr<BatchUserRequest> batch_request =
         std::make_unique<BatchUserRequest>();
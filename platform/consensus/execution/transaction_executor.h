@@ -25,6 +25,7 @@
 #include "platform/common/queue/lock_free_queue.h"
 #include "platform/config/resdb_config.h"
 #include "platform/consensus/execution/duplicate_manager.h"
+#include "platform/consensus/execution/mempool.h"
 #include "platform/consensus/execution/system_info.h"
 #include "platform/proto/resdb.pb.h"
 #include "platform/statistic/stats.h"
@@ -63,6 +64,9 @@ class TransactionExecutor {
 
   void SetDuplicateManager(DuplicateManager* manager);
 
+  // Take the payloads of the batches whose hash is ordered from the mempool.
+  void SetMempool(Mempool* mempool);
+
   void AddExecuteMessage(std::unique_ptr<Request> message);
 
   Storage* GetStorage();
@@ -83,6 +87,7 @@ class TransactionExecutor {
 
   void AddNewData(std::unique_ptr<Request> message);
   std::unique_ptr<Request> GetNextData();
+  void FillData(Request* request);
 
   bool IsStop();
 
@@ -113,6 +118,7 @@ class TransactionExecutor {
   std::atomic<bool> stop_;
   Stats* global_stats_ = nullptr;
   DuplicateManager* duplicate_manager_;
+  Mempool* mempool_ = nullptr;
   int execute_thread_num_ = 10;
   static const int blucket_num_ = 1024;
   int blucket_[blucket_num_];
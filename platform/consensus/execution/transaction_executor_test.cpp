@@ -68,6 +68,46 @@ TEST(TransactionExecutorTest, ExecuteOne) {
   done_future.get();
 }
 
+TEST(TransactionExecutorTest, ExecuteFromMempool) {
+  std::promise<bool> done;
+  std::future<bool> done_future = done.get_future();
+
+  ResDBConfig config = GetResDBConfig();
+  auto batch = std::make_unique<Request>();
+  batch->set_hash("hash_1");
+  BatchUserRequest batch_request;
+  batch_request.add_user_requests()->mutable_request()->set_data("execute_1");
+  batch_request.SerializeToString(batch->mutable_data());
+
+  // Only the hash of the batch is ordered.
+  Request request;
+  request.set_seq(1);
+  request.set_hash("hash_1");
+  request.mutable_availability_cert()->add_committed_certs()->set_node_id(1);
+
+  SystemInfo system_info(config);
+  auto mock_executor = std::make_unique<MockTransactionExecutorDataImpl>();
+
+  EXPECT_CALL(*mock_executor, ExecuteData)
+      .WillOnce(Invoke([&](const std::string& input) {
+        EXPECT_EQ(input, "execute_1");
+        done.set_value(true);
+        return nullptr;
+      }));
+  Mempool mempool(16);
+  TransactionExecutor executor(
+      config,
+      [&](std::unique_ptr<Request>, std::unique_ptr<BatchUserResponse> resp) {},
+      &system_info, std::move(mock_executor));
+  executor.SetMempool(&mempool);
+
+  EXPECT_EQ(executor.Commit(std::make_unique<Request>(request)), 0);
+  // The batch arrives after its hash is committed.
+  mempool.Add(std::move(batch));
+
+  done_future.get();
+}
+
 TEST(TransactionExecutorTest, MaxPendingExecuteSeq) {
   Stats::GetGlobalStats()->Stop();
   ResDBConfig config = GetResDBConfig();
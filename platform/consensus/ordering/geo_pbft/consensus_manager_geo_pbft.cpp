@@ -37,6 +37,9 @@ int ConsensusManagerGeoPBFT::ConsensusCommit(std::unique_ptr<Context> context,
   switch (request->type()) {
     case Request::TYPE_GEO_REQUEST:
       return commitment_->GeoProcessCcm(std::move(context), std::move(request));
+    case Request::TYPE_GEO_BUNDLE:
+      return commitment_->GeoProcessBundle(std::move(context),
+                                           std::move(request));
   }
   return ConsensusManagerPBFT::ConsensusCommit(std::move(context),
                                                std::move(request));
@@ -20,22 +20,50 @@
 #include "platform/consensus/ordering/geo_pbft/geo_pbft_commitment.h"
 
 #include <glog/logging.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "platform/consensus/ordering/common/transaction_utils.h"
 
 namespace resdb {
 
+namespace {
+
+// The dedup window keeps the requests of kEpochNum epochs of kEpochSeqs
+// seqs each.
+constexpr uint64_t kEpochSeqs = 4096;
+constexpr uint32_t kEpochNum = 8;
+
+std::string GetReqKey(uint64_t seq, uint32_t sender_region) {
+  std::string key(sizeof(seq) + sizeof(sender_region), 0);
+  memcpy(&key[0], &seq, sizeof(seq));
+  memcpy(&key[sizeof(seq)], &sender_region, sizeof(sender_region));
+  return key;
+}
+
+}  // namespace
+
 GeoPBFTCommitment::GeoPBFTCommitment(
     std::unique_ptr<GeoGlobalExecutor> global_executor,
     const ResDBConfig& config, std::unique_ptr<SystemInfo> system_info,
     ReplicaCommunicator* replica_communicator, SignatureVerifier* verifier)
     : global_executor_(std::move(global_executor)),
       stop_(false),
+      received_(2 * kEpochSeqs * kEpochNum *
+                    std::max(config.GetConfigData().region_size(), 1),
+                kEpochNum),
       config_(std::move(config)),
       system_info_(std::move(system_info)),
       replica_communicator_(std::move(replica_communicator)),
       verifier_(verifier) {
   global_stats_ = Stats::GetGlobalStats();
+  for (const auto& region : config_.GetConfigData().region()) {
+    if (region.has_threshold_public_key()) {
+      region_verifiers_[region.region_id()] =
+          std::make_unique<ThresholdSignature>(region.threshold_public_key());
+    }
+  }
   executed_thread_ =
       std::thread(&GeoPBFTCommitment::PostProcessExecutedMsg, this);
 }
@@ -48,7 +76,17 @@ GeoPBFTCommitment::~GeoPBFTCommitment() {
 }
 
 bool GeoPBFTCommitment::VerifyCerts(const BatchUserRequest& request,
-                                    const std::string& raw_data) {
+                                    const std::string& raw_data,
+                                    int sender_region_id) {
+  if (request.committed_certs().has_quorum_cert()) {
+    auto it = region_verifiers_.find(sender_region_id);
+    if (it == region_verifiers_.end()) {
+      LOG(ERROR) << "no threshold key of region:" << sender_region_id;
+      return false;
+    }
+    return it->second->Verify(request.hash(),
+                              request.committed_certs().quorum_cert());
+  }
   if (verifier_) {
     std::string hash = request.hash();
     for (const auto& sig : request.committed_certs().committed_certs()) {
@@ -63,20 +101,26 @@ bool GeoPBFTCommitment::VerifyCerts(const BatchUserRequest& request,
 }
 
 bool GeoPBFTCommitment::AddNewReq(uint64_t seq, uint32_t sender_region) {
-  std::lock_guard<std::mutex> lk(mutex_);
   if (seq < min_seq_) {
     return false;
   }
-  // LOG(ERROR)<<"add req seq:"<<seq<<" regioin:"<<sender_region;
-  auto ret = checklist_[seq % (1 << 20)].insert(sender_region);
-  return ret.second;
+  return !received_.CheckAndAdd(GetReqKey(seq, sender_region));
+}
+
+bool GeoPBFTCommitment::HasReq(uint64_t seq, uint32_t sender_region) {
+  if (seq < min_seq_) {
+    return true;
+  }
+  return received_.Contains(GetReqKey(seq, sender_region));
 }
 
 void GeoPBFTCommitment::UpdateSeq(uint64_t seq) {
-  std::lock_guard<std::mutex> lk(mutex_);
-  if (seq > min_seq_) {
-    min_seq_ = seq;
+  uint64_t current = min_seq_.load();
+  while (current < seq && !min_seq_.compare_exchange_weak(current, seq)) {
   }
+  // The requests below min_seq_ are rejected before the set is checked, so
+  // they can expire.
+  received_.AdvanceEpoch(seq / kEpochSeqs);
 }
 
 int GeoPBFTCommitment::GeoProcessCcm(std::unique_ptr<Context> context,
@@ -98,7 +142,7 @@ int GeoPBFTCommitment::GeoProcessCcm(std::unique_ptr<Context> context,
   }
 
   if (!batch_request.has_committed_certs() ||
-      !VerifyCerts(batch_request, request->data())) {
+      !VerifyCerts(batch_request, request->data(), sender_region_id)) {
     // CheckCertificates
     LOG(ERROR) << "no certs";
     return -2;
@@ -120,6 +164,92 @@ int GeoPBFTCommitment::GeoProcessCcm(std::unique_ptr<Context> context,
   return global_executor_->OrderGeoRequest(std::move(request));
 }
 
+bool GeoPBFTCommitment::VerifyBundle(const GeoBundle& bundle,
+                                     int sender_region_id) {
+  std::vector<BatchUserRequest> batches(bundle.requests_size());
+  for (int i = 0; i < bundle.requests_size(); ++i) {
+    const Request& request = bundle.requests(i);
+    if (request.region_info().region_id() != sender_region_id) {
+      LOG(ERROR) << "request from region:" << request.region_info().region_id()
+                 << " in the bundle of region:" << sender_region_id;
+      return false;
+    }
+    if (!batches[i].ParseFromString(request.data())) {
+      LOG(ERROR) << "parse batch fail";
+      return false;
+    }
+  }
+
+  if (!bundle.has_aggregate_cert()) {
+    for (const BatchUserRequest& batch : batches) {
+      if (!batch.has_committed_certs() ||
+          !VerifyCerts(batch, "", sender_region_id)) {
+        LOG(ERROR) << "no certs";
+        return false;
+      }
+    }
+    return true;
+  }
+
+  auto it = region_verifiers_.find(sender_region_id);
+  if (it == region_verifiers_.end()) {
+    LOG(ERROR) << "no threshold key of region:" << sender_region_id;
+    return false;
+  }
+  std::vector<std::string> hashes;
+  for (const BatchUserRequest& batch : batches) {
+    hashes.push_back(batch.hash());
+  }
+  return it->second->VerifyAggregate(hashes, bundle.aggregate_cert());
+}
+
+int GeoPBFTCommitment::GeoProcessBundle(std::unique_ptr<Context> context,
+                                        std::unique_ptr<Request> request) {
+  int sender_region_id = request->region_info().region_id();
+  GeoBundle bundle;
+  if (!bundle.ParseFromString(request->data())) {
+    LOG(ERROR) << "parse geo bundle fail";
+    return -2;
+  }
+
+  // The bundle arrives from several senders, skip the copies before
+  // verifying the certificate.
+  bool has_new = false;
+  for (const Request& geo_request : bundle.requests()) {
+    if (!HasReq(geo_request.seq(), sender_region_id)) {
+      has_new = true;
+      break;
+    }
+  }
+  if (!has_new) {
+    return 1;
+  }
+
+  if (!VerifyBundle(bundle, sender_region_id)) {
+    LOG(ERROR) << "verify geo bundle fail, region:" << sender_region_id;
+    return -2;
+  }
+
+  int self_region_id = config_.GetConfigData().self_region_id();
+  // if the bundle comes from another region, do local broadcast
+  if (sender_region_id != self_region_id) {
+    std::unique_ptr<Request> broadcast_bundle =
+        resdb::NewRequest(Request::TYPE_GEO_BUNDLE, *request,
+                          config_.GetSelfInfo().id(), sender_region_id);
+    replica_communicator_->BroadCast(*broadcast_bundle);
+  }
+
+  for (Request& geo_request : *bundle.mutable_requests()) {
+    if (!AddNewReq(geo_request.seq(), sender_region_id)) {
+      continue;
+    }
+    auto order_request = std::make_unique<Request>();
+    order_request->Swap(&geo_request);
+    global_executor_->OrderGeoRequest(std::move(order_request));
+  }
+  return 0;
+}
+
 int GeoPBFTCommitment::PostProcessExecutedMsg() {
   while (!stop_) {
     auto batch_resp = global_executor_->GetResponseMsg();
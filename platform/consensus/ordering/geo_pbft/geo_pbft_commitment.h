@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "common/crypto/threshold_signature.h"
 #include "platform/config/resdb_config.h"
 #include "platform/consensus/execution/geo_global_executor.h"
 #include "platform/consensus/execution/system_info.h"
@@ -41,12 +42,19 @@ class GeoPBFTCommitment {
 
   int GeoProcessCcm(std::unique_ptr<Context> context,
                     std::unique_ptr<Request> request);
+  // Process the committed batches of another region shipped in one
+  // TYPE_GEO_BUNDLE message.
+  int GeoProcessBundle(std::unique_ptr<Context> context,
+                       std::unique_ptr<Request> request);
 
  private:
   bool VerifyCerts(const BatchUserRequest& request,
-                   const std::string& raw_data);
+                   const std::string& raw_data, int sender_region_id);
+
+  bool VerifyBundle(const GeoBundle& bundle, int sender_region_id);
 
   bool AddNewReq(uint64_t seq, uint32_t sender_region);
+  bool HasReq(uint64_t seq, uint32_t sender_region);
   void UpdateSeq(uint64_t seq);
 
   int PostProcessExecutedMsg();
@@ -54,15 +62,18 @@ class GeoPBFTCommitment {
  private:
   std::unique_ptr<GeoGlobalExecutor> global_executor_;
   std::atomic<bool> stop_;
-  std::set<uint32_t> checklist_[1 << 20];
+  // (seq, region) of the geo requests received. The epoch follows the
+  // executed seq.
+  ConcurrentHashSet received_;
   ResDBConfig config_;
   std::unique_ptr<SystemInfo> system_info_ = nullptr;
   ReplicaCommunicator* replica_communicator_;
   SignatureVerifier* verifier_;
+  // Verifiers of the quorum certificates from each region.
+  std::map<int, std::unique_ptr<ThresholdSignature>> region_verifiers_;
   Stats* global_stats_;
-  std::mutex mutex_;
   std::thread executed_thread_;
-  uint64_t min_seq_ = 0;
+  std::atomic<uint64_t> min_seq_ = 0;
 };
 
 }  // namespace resdb
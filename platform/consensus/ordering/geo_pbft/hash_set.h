@@ -19,52 +19,52 @@
 
 #pragma once
 
-#include <iostream>
-#include <mutex>
-#include <set>
+#include <atomic>
+#include <string>
+
+#include "platform/common/index/concurrent_hash_index.h"
 
 namespace resdb {
 
-template <class _type>
-class SpinLockSet {
+// A concurrent set of digests used to drop duplicated messages.
+//
+// It is a sharded open-addressing table (see ConcurrentHashIndex) whose
+// entries expire by epoch. The epoch is a logical clock moved forward by
+// the owner, e.g. from the executed seq. A key added in epoch e is dropped
+// once the epoch reaches e + epoch_num, and its slot is reused in place.
+// The capacity should hold the keys of epoch_num epochs; otherwise the
+// table grows and GrowNum() goes up. Live keys are never dropped.
+class ConcurrentHashSet {
  public:
-  SpinLockSet(){};
-  ~SpinLockSet() { set_.clear(); }
-
-  int exists(_type key) {
-    bool result = false;
-    lock_.lock();
-    result = set_.count(key);
-    lock_.unlock();
-    return result;
-  }
-  void add(_type key) {
-    lock_.lock();
-    set_.insert(key);
-    lock_.unlock();
-  };
-  int check_and_add(_type key) {
-    bool result = false;
-    lock_.lock();
-    result = set_.count(key);
-    set_.insert(key);
-    lock_.unlock();
-    return result;
+  ConcurrentHashSet(uint64_t capacity, uint32_t epoch_num,
+                    uint32_t shard_num = 64)
+      : index_(capacity, 1, epoch_num, shard_num) {
+    index_.SetTimeFunc([this]() { return epoch_.load(); });
   }
-  int remove(_type key) {
-    lock_.lock();
 
-    int result = set_.erase(key);
+  bool Contains(const std::string& key) { return index_.Find(key); }
 
-    lock_.unlock();
-    return result;
+  // Add the key. Return true if it has already been added.
+  bool CheckAndAdd(const std::string& key) { return !index_.Insert(key); }
+
+  bool Remove(const std::string& key) { return index_.Erase(key); }
+
+  // Move the epoch forward to epoch. It never goes back.
+  void AdvanceEpoch(uint64_t epoch) {
+    uint64_t current = epoch_.load();
+    while (current < epoch && !epoch_.compare_exchange_weak(current, epoch)) {
+    }
   }
 
-  int size() { return set_.size(); }
+  uint64_t GetEpoch() const { return epoch_; }
+
+  // The number of live keys. It scans the whole table.
+  uint64_t Size() { return index_.Size(); }
+  uint64_t GrowNum() const { return index_.GrowNum(); }
 
  private:
-  std::set<_type> set_;
-  std::mutex lock_;
+  std::atomic<uint64_t> epoch_ = 0;
+  ConcurrentHashIndex index_;
 };
 
-}  // namespace resdb
\ No newline at end of file
+}  // namespace resdb
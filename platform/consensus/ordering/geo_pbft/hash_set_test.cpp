@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/geo_pbft/hash_set.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace resdb {
+namespace {
+
+TEST(ConcurrentHashSetTest, CheckAndAdd) {
+  ConcurrentHashSet set(1024, 2, 4);
+  EXPECT_FALSE(set.Contains("hash1"));
+  EXPECT_FALSE(set.CheckAndAdd("hash1"));
+  EXPECT_TRUE(set.CheckAndAdd("hash1"));
+  EXPECT_TRUE(set.Contains("hash1"));
+  EXPECT_FALSE(set.Contains("hash2"));
+  EXPECT_EQ(set.Size(), 1);
+
+  EXPECT_TRUE(set.Remove("hash1"));
+  EXPECT_FALSE(set.Remove("hash1"));
+  EXPECT_FALSE(set.CheckAndAdd("hash1"));
+}
+
+TEST(ConcurrentHashSetTest, EpochExpire) {
+  ConcurrentHashSet set(1024, 2, 4);
+  EXPECT_FALSE(set.CheckAndAdd("hash1"));
+  set.AdvanceEpoch(1);
+  EXPECT_FALSE(set.CheckAndAdd("hash2"));
+  EXPECT_TRUE(set.Contains("hash1"));
+
+  set.AdvanceEpoch(2);
+  EXPECT_FALSE(set.Contains("hash1"));
+  EXPECT_TRUE(set.Contains("hash2"));
+
+  // The epoch never goes back.
+  set.AdvanceEpoch(1);
+  EXPECT_EQ(set.GetEpoch(), 2);
+  set.AdvanceEpoch(3);
+  EXPECT_FALSE(set.Contains("hash2"));
+  EXPECT_EQ(set.Size(), 0);
+}
+
+TEST(ConcurrentHashSetTest, ConcurrentAdd) {
+  ConcurrentHashSet set(1 << 16, 2);
+  std::atomic<int> added = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.push_back(std::thread([&]() {
+      for (int i = 0; i < 1000; ++i) {
+        if (!set.CheckAndAdd("hash" + std::to_string(i))) {
+          added++;
+        }
+      }
+    }));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  EXPECT_EQ(added, 1000);
+  EXPECT_EQ(set.Size(), 1000);
+}
+
+}  // namespace
+}  // namespace resdb
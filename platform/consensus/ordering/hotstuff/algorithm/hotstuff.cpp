@@ -0,0 +1,486 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/hotstuff/algorithm/hotstuff.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "common/crypto/hash.h"
+#include "common/utils/utils.h"
+
+namespace resdb {
+namespace hotstuff {
+
+HotStuff::HotStuff(int id, int f, int total_num, SignatureVerifier* verifier,
+                   const ThresholdSignature* threshold_signature,
+                   int timeout_ms, int max_batch_num)
+    : ProtocolBase(id, f, total_num),
+      max_batch_num_(max_batch_num),
+      threshold_signature_(threshold_signature),
+      timeout_ms_(timeout_ms),
+      last_progress_time_(GetCurrentTime()) {
+  verifier_ = verifier;
+
+  auto genesis = std::make_unique<Block>();
+  genesis->set_hash(GetBlockHash(*genesis));
+  genesis_hash_ = genesis->hash();
+  genesis->mutable_justify()->set_block_hash(genesis_hash_);
+  high_qc_ = genesis->justify();
+  lock_hash_ = exec_hash_ = genesis_hash_;
+  blocks_[genesis_hash_] = std::move(genesis);
+  if (GetLeader(1) == id_) {
+    ready_view_ = 1;
+  }
+
+  if (timeout_ms_ > 0) {
+    pacemaker_thread_ = std::thread(&HotStuff::Pacemaker, this);
+  }
+  LOG(ERROR) << "hotstuff id:" << id_ << " timeout:" << timeout_ms_
+             << " threshold signature:" << (threshold_signature_ != nullptr);
+}
+
+HotStuff::~HotStuff() {
+  Stop();
+  if (pacemaker_thread_.joinable()) {
+    pacemaker_thread_.join();
+  }
+}
+
+int HotStuff::GetLeader(int64_t view) const { return view % total_num_ + 1; }
+
+int64_t HotStuff::GetCurrentView() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return current_view_;
+}
+
+int64_t HotStuff::GetCommittedHeight() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return GetBlock(exec_hash_)->height();
+}
+
+std::string HotStuff::GetBlockHash(const Block& block) const {
+  std::string data = block.parent_hash() + ":" + std::to_string(block.view()) +
+                     ":" + std::to_string(block.height()) + ":" +
+                     std::to_string(block.proposer()) + ":" +
+                     block.justify().block_hash();
+  for (const Transaction& txn : block.txns()) {
+    data += ":" + txn.hash() + utils::CalculateSHA256Hash(txn.data());
+  }
+  return utils::CalculateSHA256Hash(data);
+}
+
+// The height is signed as well: a QC carries it and the replicas compare it
+// with their locked block.
+std::string HotStuff::GetVoteMessage(int64_t view, int64_t height,
+                                     const std::string& hash) const {
+  return "hotstuff:" + std::to_string(view) + ":" + std::to_string(height) +
+         ":" + hash;
+}
+
+const Block* HotStuff::GetBlock(const std::string& hash) const {
+  auto it = blocks_.find(hash);
+  return it == blocks_.end() ? nullptr : it->second.get();
+}
+
+bool HotStuff::Extends(const Block& block, const Block& ancestor) const {
+  const Block* current = &block;
+  while (current != nullptr && current->height() > ancestor.height()) {
+    current = GetBlock(current->parent_hash());
+  }
+  return current != nullptr && current->hash() == ancestor.hash();
+}
+
+bool HotStuff::VerifyQC(const QC& qc) const {
+  if (qc.block_hash() == genesis_hash_) {
+    return qc.height() == 0;
+  }
+  std::string message = GetVoteMessage(qc.view(), qc.height(), qc.block_hash());
+  if (threshold_signature_) {
+    return qc.has_quorum_cert() &&
+           threshold_signature_->Verify(message, qc.quorum_cert());
+  }
+  std::set<int64_t> signers;
+  for (const auto& signature : qc.signatures()) {
+    if (verifier_ && !verifier_->VerifyMessage(message, signature)) {
+      return false;
+    }
+    signers.insert(signature.node_id());
+  }
+  return signers.size() >= static_cast<size_t>(2 * f_ + 1);
+}
+
+bool HotStuff::ReceiveTransaction(std::unique_ptr<Transaction> txn) {
+  std::vector<Outgoing> outgoing;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    int64_t next_view = current_view_ + 1;
+    if (GetLeader(next_view) != id_ || proposed_view_ >= next_view) {
+      outgoing.push_back(
+          {MessageType::Forward, GetLeader(next_view), std::move(txn)});
+    } else {
+      txn->set_create_time(GetCurrentTime());
+      pending_.push_back(std::move(txn));
+      if (ready_view_ > proposed_view_) {
+        TryPropose(ready_view_, &outgoing);
+      }
+    }
+  }
+  Send(&outgoing);
+  return true;
+}
+
+bool HotStuff::HasPendingWork() const {
+  if (!pending_.empty()) {
+    return true;
+  }
+  // Blocks carrying transactions which are not committed yet, including the
+  // ones abandoned by a view change which still need the chain to move on.
+  int64_t exec_height = GetBlock(exec_hash_)->height();
+  for (const auto& it : blocks_) {
+    if (it.second->height() > exec_height && it.second->txns_size() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void HotStuff::TryPropose(int64_t view, std::vector<Outgoing>* outgoing) {
+  if (GetLeader(view) != id_ || view <= proposed_view_ ||
+      view < current_view_) {
+    return;
+  }
+  if (!HasPendingWork()) {
+    // Nothing to propose, wait for new transactions.
+    ready_view_ = view;
+    return;
+  }
+
+  auto block = std::make_unique<Block>();
+  block->set_parent_hash(high_qc_.block_hash());
+  block->set_view(view);
+  block->set_height(high_qc_.height() + 1);
+  block->set_proposer(id_);
+  *block->mutable_justify() = high_qc_;
+  for (int i = 0; i < max_batch_num_ && !pending_.empty(); ++i) {
+    *block->add_txns() = std::move(*pending_.front());
+    pending_.pop_front();
+  }
+  block->set_hash(GetBlockHash(*block));
+  proposed_view_ = view;
+  ready_view_ = -1;
+  outgoing->push_back({MessageType::Propose, 0, std::move(block)});
+}
+
+void HotStuff::UpdateHighQC(const QC& qc) {
+  if (qc.height() > high_qc_.height()) {
+    high_qc_ = qc;
+  }
+}
+
+// b'' <- b*.justify.node, b' <- b''.justify.node, b <- b'.justify.node.
+// Lock on b' and commit b if b'', b' and b form a direct chain.
+void HotStuff::Update(const Block& block, std::vector<Transaction>* committed) {
+  UpdateHighQC(block.justify());
+  const Block* b2 = GetBlock(block.justify().block_hash());
+  if (b2 == nullptr) {
+    return;
+  }
+  const Block* b1 = GetBlock(b2->justify().block_hash());
+  if (b1 == nullptr) {
+    return;
+  }
+  if (b1->height() > GetBlock(lock_hash_)->height()) {
+    lock_hash_ = b1->hash();
+  }
+  const Block* b0 = GetBlock(b1->justify().block_hash());
+  if (b0 == nullptr) {
+    return;
+  }
+  if (b2->parent_hash() == b1->hash() && b1->parent_hash() == b0->hash()) {
+    Commit(*b0, committed);
+  }
+}
+
+void HotStuff::Commit(const Block& block, std::vector<Transaction>* committed) {
+  const Block* exec = GetBlock(exec_hash_);
+  if (block.height() <= exec->height()) {
+    return;
+  }
+  std::vector<const Block*> chain;
+  const Block* current = &block;
+  while (current != nullptr && current->height() > exec->height()) {
+    chain.push_back(current);
+    current = GetBlock(current->parent_hash());
+  }
+  if (current == nullptr || current->hash() != exec_hash_) {
+    LOG(ERROR) << "committed block does not extend the last committed block,"
+               << " height:" << block.height();
+    return;
+  }
+  for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+    for (const Transaction& txn : (*it)->txns()) {
+      committed->push_back(txn);
+      committed->back().set_seq(++committed_seq_);
+    }
+  }
+  exec_hash_ = block.hash();
+  last_progress_time_ = GetCurrentTime();
+  timeout_num_ = 0;
+}
+
+void HotStuff::GarbageCollect() {
+  int64_t exec_height = GetBlock(exec_hash_)->height();
+  for (auto it = blocks_.begin(); it != blocks_.end();) {
+    if (it->second->height() < exec_height) {
+      it = blocks_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  while (!votes_.empty() && votes_.begin()->first.first + 1 < current_view_) {
+    votes_.erase(votes_.begin());
+  }
+  while (!new_views_.empty() && new_views_.begin()->first < current_view_) {
+    new_views_.erase(new_views_.begin());
+  }
+}
+
+bool HotStuff::ReceiveProposal(std::unique_ptr<Block> block) {
+  if (block->proposer() != GetLeader(block->view()) ||
+      block->hash() != GetBlockHash(*block) ||
+      block->parent_hash() != block->justify().block_hash() ||
+      block->height() != block->justify().height() + 1 ||
+      !VerifyQC(block->justify())) {
+    LOG(ERROR) << "invalid proposal, view:" << block->view()
+               << " proposer:" << block->proposer();
+    return false;
+  }
+
+  std::vector<Outgoing> outgoing;
+  std::vector<Transaction> committed;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (block->view() < current_view_ || GetBlock(block->hash()) != nullptr) {
+      return false;
+    }
+    const Block* new_block = block.get();
+    blocks_[block->hash()] = std::move(block);
+
+    Update(*new_block, &committed);
+
+    const Block* lock_block = GetBlock(lock_hash_);
+    if (new_block->view() > voted_view_ &&
+        (Extends(*new_block, *lock_block) ||
+         new_block->justify().height() > lock_block->height())) {
+      voted_view_ = new_block->view();
+      current_view_ = std::max(current_view_, new_block->view());
+      last_progress_time_ = GetCurrentTime();
+
+      auto vote = std::make_unique<Vote>();
+      vote->set_block_hash(new_block->hash());
+      vote->set_view(new_block->view());
+      vote->set_height(new_block->height());
+      vote->set_sender(id_);
+      std::string message = GetVoteMessage(
+          new_block->view(), new_block->height(), new_block->hash());
+      if (threshold_signature_ && threshold_signature_->CanSign()) {
+        auto share_or = threshold_signature_->SignShare(message);
+        if (share_or.ok()) {
+          *vote->mutable_signature() = *share_or;
+        }
+      } else if (verifier_) {
+        auto signature_or = verifier_->SignMessage(message);
+        if (signature_or.ok()) {
+          *vote->mutable_signature() = *signature_or;
+        }
+      }
+      vote->mutable_signature()->set_node_id(id_);
+      outgoing.push_back({MessageType::VoteMsg,
+                          GetLeader(new_block->view() + 1), std::move(vote)});
+    }
+    GarbageCollect();
+  }
+  Send(&outgoing);
+  CommitTransactions(committed);
+  return true;
+}
+
+bool HotStuff::ReceiveVote(std::unique_ptr<Vote> vote) {
+  if (GetLeader(vote->view() + 1) != id_ ||
+      vote->signature().node_id() != vote->sender()) {
+    return false;
+  }
+  // Check the threshold signature shares one by one before adding them to
+  // votes_, otherwise the combination would always pick a corrupted share
+  // of a low id.
+  std::string message =
+      GetVoteMessage(vote->view(), vote->height(), vote->block_hash());
+  bool valid = true;
+  if (threshold_signature_) {
+    valid = threshold_signature_->VerifyShare(message, vote->signature());
+  } else if (verifier_) {
+    valid = verifier_->VerifyMessage(message, vote->signature());
+  }
+  if (!valid) {
+    LOG(ERROR) << "invalid vote from:" << vote->sender();
+    return false;
+  }
+
+  std::vector<Outgoing> outgoing;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (vote->view() + 1 <= proposed_view_) {
+      return false;
+    }
+    // A vote signing another height could not be combined with the others.
+    const Block* block = GetBlock(vote->block_hash());
+    if (block != nullptr && block->height() != vote->height()) {
+      LOG(ERROR) << "vote height mismatch from:" << vote->sender();
+      return false;
+    }
+    auto& votes = votes_[std::make_pair(vote->view(), vote->block_hash())];
+    votes[vote->sender()] = std::move(*vote->mutable_signature());
+    if (votes.size() < static_cast<size_t>(2 * f_ + 1)) {
+      return true;
+    }
+
+    QC qc;
+    qc.set_block_hash(vote->block_hash());
+    qc.set_view(vote->view());
+    qc.set_height(vote->height());
+    if (threshold_signature_) {
+      std::vector<const SignatureInfo*> shares;
+      for (const auto& it : votes) {
+        shares.push_back(&it.second);
+      }
+      auto cert_or = threshold_signature_->Combine(
+          GetVoteMessage(vote->view(), vote->height(), vote->block_hash()),
+          shares);
+      if (!cert_or.ok()) {
+        LOG(ERROR) << "combine qc fail, view:" << vote->view()
+                   << " status:" << cert_or.status();
+        return true;
+      }
+      *qc.mutable_quorum_cert() = std::move(*cert_or);
+    } else {
+      for (const auto& it : votes) {
+        *qc.add_signatures() = it.second;
+      }
+    }
+    votes_.erase(std::make_pair(vote->view(), vote->block_hash()));
+    UpdateHighQC(qc);
+    TryPropose(vote->view() + 1, &outgoing);
+  }
+  Send(&outgoing);
+  return true;
+}
+
+bool HotStuff::ReceiveNewView(std::unique_ptr<NewView> new_view) {
+  if (GetLeader(new_view->view()) != id_ || !VerifyQC(new_view->high_qc())) {
+    return false;
+  }
+  std::vector<Outgoing> outgoing;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (new_view->view() <= proposed_view_) {
+      return false;
+    }
+    auto& new_views = new_views_[new_view->view()];
+    new_views[new_view->sender()] = new_view->high_qc();
+    UpdateHighQC(new_view->high_qc());
+    if (new_views.size() < static_cast<size_t>(2 * f_ + 1)) {
+      return true;
+    }
+    current_view_ = std::max(current_view_, new_view->view() - 1);
+    TryPropose(new_view->view(), &outgoing);
+  }
+  Send(&outgoing);
+  return true;
+}
+
+void HotStuff::OnTimeout() {
+  std::vector<Outgoing> outgoing;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    last_progress_time_ = GetCurrentTime();
+    if (!HasPendingWork()) {
+      return;
+    }
+    current_view_ = std::max(current_view_, voted_view_) + 1;
+    timeout_num_++;
+    LOG(ERROR) << "view timeout, move to view:" << current_view_
+               << " leader:" << GetLeader(current_view_);
+
+    auto new_view = std::make_unique<NewView>();
+    new_view->set_view(current_view_);
+    *new_view->mutable_high_qc() = high_qc_;
+    new_view->set_sender(id_);
+    outgoing.push_back({MessageType::NewViewMsg, GetLeader(current_view_),
+                        std::move(new_view)});
+
+    // Transactions kept for a view this replica will not lead are forwarded.
+    if (GetLeader(current_view_ + 1) != id_) {
+      while (!pending_.empty()) {
+        outgoing.push_back({MessageType::Forward, GetLeader(current_view_ + 1),
+                            std::move(pending_.front())});
+        pending_.pop_front();
+      }
+    }
+  }
+  Send(&outgoing);
+}
+
+void HotStuff::Pacemaker() {
+  while (!IsStop()) {
+    usleep(std::max(timeout_ms_ / 10, 1) * 1000);
+    bool timeout = false;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      // Back off exponentially on consecutive timeouts.
+      uint64_t timeout_us = static_cast<uint64_t>(timeout_ms_) * 1000
+                            << std::min(timeout_num_, 6);
+      timeout = GetCurrentTime() - last_progress_time_ > timeout_us;
+    }
+    if (timeout) {
+      OnTimeout();
+    }
+  }
+}
+
+void HotStuff::Send(std::vector<Outgoing>* outgoing) {
+  for (auto& it : *outgoing) {
+    if (it.to == 0) {
+      Broadcast(it.type, *it.msg);
+    } else {
+      SendMessage(it.type, *it.msg, it.to);
+    }
+  }
+  outgoing->clear();
+}
+
+void HotStuff::CommitTransactions(const std::vector<Transaction>& txns) {
+  for (const Transaction& txn : txns) {
+    ProtocolBase::Commit(txn);
+  }
+}
+
+}  // namespace hotstuff
+}  // namespace resdb
@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "common/crypto/threshold_signature.h"
+#include "platform/consensus/ordering/common/algorithm/protocol_base.h"
+#include "platform/consensus/ordering/hotstuff/proto/hotstuff.pb.h"
+
+namespace resdb {
+namespace hotstuff {
+
+// Chained HotStuff (Yin et al., PODC 2019). Each view has one leader which
+// proposes one block extending the highest QC it knows. Replicas vote to the
+// leader of the next view, whose QC on the block is carried by the next
+// proposal, so the prepare/pre-commit/commit phases of consecutive blocks
+// are pipelined: a block is committed once it heads a three-chain of blocks
+// in consecutive views.
+//
+// The pacemaker moves to the next view once a proposal is accepted. If no
+// progress is made within the timeout while there is pending work, replicas
+// move to the next view and send their highest QC to its leader only
+// (linear view change); the leader proposes once it has n-f of them.
+class HotStuff : public common::ProtocolBase {
+ public:
+  // If timeout_ms is 0 the pacemaker thread is not started and OnTimeout()
+  // has to be called explicitly.
+  HotStuff(int id, int f, int total_num, SignatureVerifier* verifier,
+           const ThresholdSignature* threshold_signature = nullptr,
+           int timeout_ms = 1000, int max_batch_num = 100);
+  ~HotStuff();
+
+  bool ReceiveTransaction(std::unique_ptr<Transaction> txn);
+  bool ReceiveProposal(std::unique_ptr<Block> block);
+  bool ReceiveVote(std::unique_ptr<Vote> vote);
+  bool ReceiveNewView(std::unique_ptr<NewView> new_view);
+
+  // Give up the current view and send the highest QC to the next leader.
+  void OnTimeout();
+
+  int GetLeader(int64_t view) const;
+  int64_t GetCurrentView();
+  int64_t GetCommittedHeight();
+
+ private:
+  struct Outgoing {
+    int type;
+    // Broadcast if to is 0.
+    int to;
+    std::unique_ptr<google::protobuf::Message> msg;
+  };
+
+  // The functions below must be called holding mutex_. Messages to send are
+  // appended to outgoing and sent after the lock is released.
+  const Block* GetBlock(const std::string& hash) const;
+  bool Extends(const Block& block, const Block& ancestor) const;
+  void Update(const Block& block, std::vector<Transaction>* committed);
+  void UpdateHighQC(const QC& qc);
+  void Commit(const Block& block, std::vector<Transaction>* committed);
+  void TryPropose(int64_t view, std::vector<Outgoing>* outgoing);
+  bool HasPendingWork() const;
+  void GarbageCollect();
+
+  std::string GetBlockHash(const Block& block) const;
+  std::string GetVoteMessage(int64_t view, int64_t height,
+                             const std::string& hash) const;
+  bool VerifyQC(const QC& qc) const;
+
+  void Send(std::vector<Outgoing>* outgoing);
+  void CommitTransactions(const std::vector<Transaction>& txns);
+  void Pacemaker();
+
+ private:
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Block>> blocks_;
+  std::string genesis_hash_;
+  // The locked block, the last committed block and the highest QC.
+  std::string lock_hash_, exec_hash_;
+  QC high_qc_;
+
+  int64_t current_view_ = 0;
+  int64_t voted_view_ = 0;
+  int64_t proposed_view_ = 0;
+  // The view this replica may propose in once it has something to propose.
+  int64_t ready_view_ = -1;
+  int64_t committed_seq_ = 0;
+
+  // Votes and new view messages collected as a leader.
+  std::map<std::pair<int64_t, std::string>, std::map<int32_t, SignatureInfo>>
+      votes_;
+  std::map<int64_t, std::map<int32_t, QC>> new_views_;
+
+  std::deque<std::unique_ptr<Transaction>> pending_;
+  int max_batch_num_;
+
+  const ThresholdSignature* threshold_signature_;
+
+  int timeout_ms_;
+  uint64_t last_progress_time_;
+  int timeout_num_ = 0;
+  std::thread pacemaker_thread_;
+};
+
+}  // namespace hotstuff
+}  // namespace resdb
@@ -0,0 +1,305 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/hotstuff/algorithm/hotstuff.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+
+namespace resdb {
+namespace hotstuff {
+namespace {
+
+// Runs n replicas in one thread, delivering the messages in FIFO order.
+class Cluster {
+ public:
+  struct Message {
+    int type;
+    std::string data;
+    int to;
+  };
+
+  Cluster(int n, const std::vector<ThresholdKeyShare>& keys = {})
+      : n_(n), committed_(n + 1) {
+    for (int i = 1; i <= n; ++i) {
+      if (!keys.empty()) {
+        signatures_.push_back(
+            std::make_unique<ThresholdSignature>(keys[i - 1]));
+      }
+      // The pacemaker is driven by the tests through OnTimeout().
+      auto replica = std::make_unique<HotStuff>(
+          i, (n - 1) / 3, n, nullptr,
+          keys.empty() ? nullptr : signatures_.back().get(),
+          /*timeout_ms=*/0);
+      replica->SetSingleCallFunc(
+          [this](int type, const google::protobuf::Message& msg, int to) {
+            queue_.push_back({type, msg.SerializeAsString(), to});
+            return 0;
+          });
+      replica->SetBroadcastCallFunc(
+          [this](int type, const google::protobuf::Message& msg) {
+            for (int j = 1; j <= n_; ++j) {
+              queue_.push_back({type, msg.SerializeAsString(), j});
+            }
+            return 0;
+          });
+      replica->SetCommitFunc([this, i](const google::protobuf::Message& msg) {
+        const Transaction& txn = dynamic_cast<const Transaction&>(msg);
+        committed_[i].push_back(txn.data());
+        EXPECT_EQ(txn.seq(), committed_[i].size());
+        return 0;
+      });
+      replicas_.push_back(std::move(replica));
+    }
+  }
+
+  void Submit(int replica, const std::string& data) {
+    auto txn = std::make_unique<Transaction>();
+    txn->set_data(data);
+    txn->set_hash("hash_" + data);
+    replicas_[replica - 1]->ReceiveTransaction(std::move(txn));
+  }
+
+  // Deliver all the messages, except those filtered out which are kept.
+  void Run(std::function<bool(const Message&)> hold = nullptr) {
+    std::deque<Message> held;
+    while (!queue_.empty()) {
+      Message msg = std::move(queue_.front());
+      queue_.pop_front();
+      if (hold && hold(msg)) {
+        held.push_back(std::move(msg));
+        continue;
+      }
+      Deliver(msg);
+    }
+    queue_ = std::move(held);
+  }
+
+  void Deliver(const Message& msg) {
+    HotStuff* replica = replicas_[msg.to - 1].get();
+    switch (msg.type) {
+      case MessageType::Forward: {
+        auto txn = std::make_unique<Transaction>();
+        ASSERT_TRUE(txn->ParseFromString(msg.data));
+        replica->ReceiveTransaction(std::move(txn));
+        break;
+      }
+      case MessageType::Propose: {
+        auto block = std::make_unique<Block>();
+        ASSERT_TRUE(block->ParseFromString(msg.data));
+        replica->ReceiveProposal(std::move(block));
+        break;
+      }
+      case MessageType::VoteMsg: {
+        auto vote = std::make_unique<Vote>();
+        ASSERT_TRUE(vote->ParseFromString(msg.data));
+        replica->ReceiveVote(std::move(vote));
+        break;
+      }
+      case MessageType::NewViewMsg: {
+        auto new_view = std::make_unique<NewView>();
+        ASSERT_TRUE(new_view->ParseFromString(msg.data));
+        replica->ReceiveNewView(std::move(new_view));
+        break;
+      }
+    }
+  }
+
+  HotStuff* GetReplica(int id) { return replicas_[id - 1].get(); }
+  const std::vector<std::string>& Committed(int id) { return committed_[id]; }
+
+ private:
+  int n_;
+  std::deque<Message> queue_;
+  std::vector<std::unique_ptr<ThresholdSignature>> signatures_;
+  std::vector<std::unique_ptr<HotStuff>> replicas_;
+  std::vector<std::vector<std::string>> committed_;
+};
+
+TEST(HotStuffTest, AllReplicasCommit) {
+  Cluster cluster(4);
+  for (int i = 0; i < 10; ++i) {
+    cluster.Submit(2, std::to_string(i));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    ASSERT_EQ(cluster.Committed(i).size(), 10) << "replica:" << i;
+    EXPECT_EQ(cluster.Committed(i), cluster.Committed(1));
+  }
+}
+
+TEST(HotStuffTest, ForwardAndRotateLeader) {
+  Cluster cluster(4);
+  for (int i = 1; i <= 4; ++i) {
+    cluster.Submit(i, std::to_string(i));
+    cluster.Run();
+  }
+  for (int i = 1; i <= 4; ++i) {
+    ASSERT_EQ(cluster.Committed(i).size(), 4);
+    EXPECT_EQ(cluster.Committed(i), cluster.Committed(1));
+    // Each committed block needs three more views to be certified on top.
+    EXPECT_GE(cluster.GetReplica(i)->GetCurrentView(), 4);
+    EXPECT_GE(cluster.GetReplica(i)->GetCommittedHeight(), 1);
+  }
+}
+
+TEST(HotStuffTest, ViewChangeOnSilentLeader) {
+  Cluster cluster(4);
+  auto silent = [](const Cluster::Message& msg) { return msg.to == 4; };
+  cluster.Submit(2, "test");
+  for (int i = 0; i < 10 && cluster.Committed(1).empty(); ++i) {
+    cluster.Run(silent);
+    if (cluster.Committed(1).empty()) {
+      for (int j = 1; j <= 3; ++j) {
+        cluster.GetReplica(j)->OnTimeout();
+      }
+    }
+  }
+  for (int i = 1; i <= 3; ++i) {
+    ASSERT_EQ(cluster.Committed(i).size(), 1) << "replica:" << i;
+    EXPECT_EQ(cluster.Committed(i)[0], "test");
+    EXPECT_GE(cluster.GetReplica(i)->GetCurrentView(), 4);
+  }
+
+  // The replica catches up from the delayed messages.
+  cluster.Run();
+  ASSERT_EQ(cluster.Committed(4).size(), 1);
+  EXPECT_EQ(cluster.Committed(4)[0], "test");
+}
+
+TEST(HotStuffTest, NoTimeoutWhenIdle) {
+  Cluster cluster(4);
+  cluster.GetReplica(1)->OnTimeout();
+  cluster.Run();
+  EXPECT_EQ(cluster.GetReplica(1)->GetCurrentView(), 0);
+}
+
+TEST(HotStuffTest, RejectProposalWithoutQuorum) {
+  Cluster cluster(4);
+  auto block = std::make_unique<Block>();
+  block->set_parent_hash("parent");
+  block->set_view(1);
+  block->set_height(2);
+  block->set_proposer(cluster.GetReplica(1)->GetLeader(1));
+  block->mutable_justify()->set_block_hash("parent");
+  block->mutable_justify()->set_height(1);
+  for (int i = 1; i <= 2; ++i) {
+    block->mutable_justify()->add_signatures()->set_node_id(i);
+  }
+  EXPECT_FALSE(cluster.GetReplica(1)->ReceiveProposal(std::move(block)));
+}
+
+TEST(HotStuffTest, ThresholdQC) {
+  auto keys = ThresholdSignature::GenerateKeys(4, 3, 512);
+  ASSERT_TRUE(keys.ok());
+  Cluster cluster(4, *keys);
+  for (int i = 0; i < 3; ++i) {
+    cluster.Submit(2, std::to_string(i));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 3);
+  }
+}
+
+TEST(HotStuffTest, DropInvalidVoteShare) {
+  auto keys = ThresholdSignature::GenerateKeys(4, 3, 512);
+  ASSERT_TRUE(keys.ok());
+  Cluster cluster(4, *keys);
+  for (int i = 0; i < 3; ++i) {
+    cluster.Submit(2, std::to_string(i));
+  }
+
+  // Replica 1 is faulty: hold its votes and send a corrupted share instead.
+  std::unique_ptr<Vote> vote;
+  int to = 0;
+  auto hold = [&](const Cluster::Message& msg) {
+    if (msg.type != MessageType::VoteMsg) {
+      return false;
+    }
+    Vote held_vote;
+    if (!held_vote.ParseFromString(msg.data) || held_vote.sender() != 1) {
+      return false;
+    }
+    if (vote == nullptr) {
+      vote = std::make_unique<Vote>(held_vote);
+      to = msg.to;
+    }
+    return true;
+  };
+  cluster.Run(hold);
+  ASSERT_NE(vote, nullptr);
+  auto share = ThresholdSignature((*keys)[0]).SignShare("other");
+  ASSERT_TRUE(share.ok());
+  *vote->mutable_signature() = *share;
+  EXPECT_FALSE(cluster.GetReplica(to)->ReceiveVote(std::move(vote)));
+
+  cluster.Run(hold);
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 3) << "replica:" << i;
+  }
+}
+
+TEST(HotStuffTest, RejectQCWithForgedHeight) {
+  auto keys = ThresholdSignature::GenerateKeys(4, 3, 512);
+  ASSERT_TRUE(keys.ok());
+  Cluster cluster(4, *keys);
+  for (int i = 0; i < 3; ++i) {
+    cluster.Submit(2, std::to_string(i));
+  }
+
+  // Keep the genesis QC and a QC certifying a block above it.
+  QC genesis_qc, qc;
+  cluster.Run([&](const Cluster::Message& msg) {
+    Block block;
+    if (msg.type == MessageType::Propose && block.ParseFromString(msg.data)) {
+      if (block.height() == 1) {
+        genesis_qc = block.justify();
+      } else if (block.justify().height() > qc.height()) {
+        qc = block.justify();
+      }
+    }
+    return false;
+  });
+  ASSERT_FALSE(genesis_qc.block_hash().empty());
+  ASSERT_GT(qc.height(), 0);
+
+  // The height is signed by the votes, it cannot be raised to pass the lock.
+  int64_t view = cluster.GetReplica(1)->GetCurrentView() + 10;
+  HotStuff* leader = cluster.GetReplica(cluster.GetReplica(1)->GetLeader(view));
+  auto new_view = std::make_unique<NewView>();
+  new_view->set_view(view);
+  new_view->set_sender(1);
+  *new_view->mutable_high_qc() = qc;
+  new_view->mutable_high_qc()->set_height(qc.height() + 10);
+  EXPECT_FALSE(leader->ReceiveNewView(std::make_unique<NewView>(*new_view)));
+
+  // Neither can the height of the genesis QC.
+  *new_view->mutable_high_qc() = genesis_qc;
+  new_view->mutable_high_qc()->set_height(5);
+  EXPECT_FALSE(leader->ReceiveNewView(std::make_unique<NewView>(*new_view)));
+
+  *new_view->mutable_high_qc() = qc;
+  EXPECT_TRUE(leader->ReceiveNewView(std::move(new_view)));
+}
+
+}  // namespace
+}  // namespace hotstuff
+}  // namespace resdb
@@ -0,0 +1,303 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/linear_pbft/algorithm/linear_pbft.h"
+
+#include <glog/logging.h>
+
+#include "common/utils/utils.h"
+
+namespace resdb {
+namespace linear_pbft {
+
+LinearPBFT::LinearPBFT(int id, int f, int total_num,
+                       SignatureVerifier* verifier,
+                       const ThresholdSignature* threshold_signature)
+    : ProtocolBase(id, f, total_num),
+      seq_(1),
+      view_(0),
+      threshold_signature_(threshold_signature) {
+  verifier_ = verifier;
+  LOG(ERROR) << "linear pbft id:" << id_ << " primary:" << GetPrimary()
+             << " threshold signature:" << (threshold_signature_ != nullptr);
+}
+
+LinearPBFT::~LinearPBFT() {}
+
+int LinearPBFT::GetPrimary() const { return view_ % total_num_ + 1; }
+
+bool LinearPBFT::IsDone(int64_t seq) const {
+  return seq < next_undone_seq_ || done_seqs_.count(seq) > 0;
+}
+
+void LinearPBFT::MarkDone(int64_t seq) {
+  instances_.erase(seq);
+  done_seqs_.insert(seq);
+  while (!done_seqs_.empty() && *done_seqs_.begin() <= next_undone_seq_) {
+    next_undone_seq_ = std::max(next_undone_seq_, *done_seqs_.begin() + 1);
+    done_seqs_.erase(done_seqs_.begin());
+  }
+}
+
+std::string LinearPBFT::GetVoteMessage(int phase, int64_t view, int64_t seq,
+                                       const std::string& hash) const {
+  return std::to_string(phase) + ":" + std::to_string(view) + ":" +
+         std::to_string(seq) + ":" + hash;
+}
+
+bool LinearPBFT::ReceiveTransaction(std::unique_ptr<Transaction> txn) {
+  if (id_ != GetPrimary()) {
+    SendMessage(MessageType::Forward, *txn, GetPrimary());
+    return true;
+  }
+  txn->set_create_time(GetCurrentTime());
+  txn->set_proposer(id_);
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    txn->set_view(view_);
+    txn->set_seq(seq_++);
+    // Votes may return before the proposal is delivered to the primary
+    // itself, so the hash to collect votes for is recorded here.
+    instances_[txn->seq()].hash = txn->hash();
+  }
+  Broadcast(MessageType::Propose, *txn);
+  return true;
+}
+
+std::unique_ptr<Vote> LinearPBFT::NewVote(int phase, const Instance& instance,
+                                          int64_t seq) {
+  auto vote = std::make_unique<Vote>();
+  vote->set_hash(instance.hash);
+  vote->set_seq(seq);
+  vote->set_view(view_);
+  vote->set_sender(id_);
+  std::string message = GetVoteMessage(phase, view_, seq, instance.hash);
+  if (threshold_signature_ && threshold_signature_->CanSign()) {
+    auto share_or = threshold_signature_->SignShare(message);
+    if (share_or.ok()) {
+      *vote->mutable_signature() = *share_or;
+    }
+  } else if (verifier_) {
+    auto signature_or = verifier_->SignMessage(message);
+    if (signature_or.ok()) {
+      *vote->mutable_signature() = *signature_or;
+    }
+  }
+  vote->mutable_signature()->set_node_id(id_);
+  return vote;
+}
+
+bool LinearPBFT::ReceivePropose(std::unique_ptr<Transaction> txn) {
+  if (txn->proposer() != GetPrimary() || txn->view() != view_) {
+    LOG(ERROR) << "proposal from invalid primary:" << txn->proposer()
+               << " view:" << txn->view();
+    return false;
+  }
+  int64_t seq = txn->seq();
+  std::unique_ptr<Vote> prepare_vote, commit_vote;
+  std::unique_ptr<Transaction> commit_txn;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (IsDone(seq)) {
+      return false;
+    }
+    Instance& instance = instances_[seq];
+    if (instance.txn != nullptr) {
+      return false;
+    }
+    if (!instance.hash.empty() && instance.hash != txn->hash()) {
+      LOG(ERROR) << "proposal hash does not match, seq:" << seq;
+      return false;
+    }
+    instance.hash = txn->hash();
+    instance.txn = std::move(txn);
+    prepare_vote = NewVote(kPrepare, instance, seq);
+    if (instance.certified[kPrepare]) {
+      instance.commit_voted = true;
+      commit_vote = NewVote(kCommit, instance, seq);
+    }
+    if (instance.certified[kCommit]) {
+      commit_txn = std::move(instance.txn);
+      MarkDone(seq);
+    }
+  }
+  SendMessage(MessageType::PrepareVote, *prepare_vote, GetPrimary());
+  if (commit_vote) {
+    SendMessage(MessageType::CommitVote, *commit_vote, GetPrimary());
+  }
+  if (commit_txn) {
+    Commit(*commit_txn);
+  }
+  return true;
+}
+
+bool LinearPBFT::VerifyVote(int phase, const Vote& vote) {
+  if (vote.signature().node_id() != vote.sender()) {
+    return false;
+  }
+  std::string message =
+      GetVoteMessage(phase, vote.view(), vote.seq(), vote.hash());
+  // Drop the invalid shares so that a faulty replica can not keep the
+  // combination of the others failing.
+  if (threshold_signature_) {
+    return threshold_signature_->VerifyShare(message, vote.signature());
+  }
+  if (verifier_ == nullptr) {
+    return true;
+  }
+  return verifier_->VerifyMessage(message, vote.signature());
+}
+
+std::unique_ptr<Certificate> LinearPBFT::NewCertificate(int phase,
+                                                        Instance* instance,
+                                                        int64_t seq) {
+  auto cert = std::make_unique<Certificate>();
+  cert->set_hash(instance->hash);
+  cert->set_seq(seq);
+  cert->set_view(view_);
+  cert->set_phase(phase);
+  if (threshold_signature_) {
+    std::vector<const SignatureInfo*> shares;
+    for (const auto& it : instance->votes[phase]) {
+      shares.push_back(&it.second);
+    }
+    auto cert_or = threshold_signature_->Combine(
+        GetVoteMessage(phase, view_, seq, instance->hash), shares);
+    if (!cert_or.ok()) {
+      // The shares are verified once received, wait for more.
+      LOG(ERROR) << "combine certificate fail, seq:" << seq
+                 << " phase:" << phase << " status:" << cert_or.status();
+      return nullptr;
+    }
+    *cert->mutable_quorum_cert() = std::move(*cert_or);
+  } else {
+    for (const auto& it : instance->votes[phase]) {
+      *cert->add_signatures() = it.second;
+    }
+  }
+  return cert;
+}
+
+bool LinearPBFT::ReceiveVote(int type, std::unique_ptr<Vote> vote) {
+  if (id_ != GetPrimary() || vote->view() != view_) {
+    return false;
+  }
+  int phase = type == MessageType::PrepareVote ? kPrepare : kCommit;
+  if (!VerifyVote(phase, *vote)) {
+    LOG(ERROR) << "invalid vote from:" << vote->sender();
+    return false;
+  }
+
+  std::unique_ptr<Certificate> cert;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    auto it = instances_.find(vote->seq());
+    if (it == instances_.end()) {
+      return false;
+    }
+    Instance& instance = it->second;
+    if (instance.cert_sent[phase] || instance.hash != vote->hash()) {
+      return false;
+    }
+    instance.votes[phase][vote->sender()] =
+        std::move(*vote->mutable_signature());
+    if (instance.votes[phase].size() < static_cast<size_t>(2 * f_ + 1)) {
+      return true;
+    }
+    cert = NewCertificate(phase, &instance, vote->seq());
+    if (cert == nullptr) {
+      return true;
+    }
+    instance.cert_sent[phase] = true;
+  }
+  Broadcast(phase == kPrepare ? MessageType::PrepareCert
+                              : MessageType::CommitCert,
+            *cert);
+  return true;
+}
+
+bool LinearPBFT::VerifyCertificate(const Certificate& cert) {
+  if (threshold_signature_) {
+    return cert.has_quorum_cert() &&
+           threshold_signature_->Verify(
+               GetVoteMessage(cert.phase(), cert.view(), cert.seq(),
+                              cert.hash()),
+               cert.quorum_cert());
+  }
+  std::set<int64_t> signers;
+  std::string message =
+      GetVoteMessage(cert.phase(), cert.view(), cert.seq(), cert.hash());
+  for (const auto& signature : cert.signatures()) {
+    if (verifier_ && !verifier_->VerifyMessage(message, signature)) {
+      return false;
+    }
+    signers.insert(signature.node_id());
+  }
+  return signers.size() >= static_cast<size_t>(2 * f_ + 1);
+}
+
+bool LinearPBFT::ReceiveCertificate(std::unique_ptr<Certificate> cert) {
+  if (cert->view() != view_ || cert->phase() < kPrepare ||
+      cert->phase() > kCommit) {
+    return false;
+  }
+  if (!VerifyCertificate(*cert)) {
+    LOG(ERROR) << "invalid certificate, seq:" << cert->seq()
+               << " phase:" << cert->phase();
+    return false;
+  }
+
+  int64_t seq = cert->seq();
+  std::unique_ptr<Vote> commit_vote;
+  std::unique_ptr<Transaction> commit_txn;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (IsDone(seq)) {
+      return false;
+    }
+    Instance& instance = instances_[seq];
+    if (!instance.hash.empty() && instance.hash != cert->hash()) {
+      LOG(ERROR) << "certificate hash does not match, seq:" << seq;
+      return false;
+    }
+    instance.hash = cert->hash();
+    instance.certified[cert->phase()] = true;
+    if (instance.txn == nullptr) {
+      // Wait for the proposal.
+      return true;
+    }
+    if (cert->phase() == kPrepare && !instance.commit_voted) {
+      instance.commit_voted = true;
+      commit_vote = NewVote(kCommit, instance, seq);
+    } else if (cert->phase() == kCommit) {
+      commit_txn = std::move(instance.txn);
+      MarkDone(seq);
+    }
+  }
+  if (commit_vote) {
+    SendMessage(MessageType::CommitVote, *commit_vote, GetPrimary());
+  }
+  if (commit_txn) {
+    Commit(*commit_txn);
+  }
+  return true;
+}
+
+}  // namespace linear_pbft
+}  // namespace resdb
@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "common/crypto/threshold_signature.h"
+#include "platform/consensus/ordering/common/algorithm/protocol_base.h"
+#include "platform/consensus/ordering/linear_pbft/proto/linear_pbft.pb.h"
+
+namespace resdb {
+namespace linear_pbft {
+
+// LinearPBFT runs the PBFT phases with linear communication, in the style of
+// SBFT: the primary broadcasts the proposal, the replicas send their prepare
+// and commit votes to the primary only, and the primary aggregates 2f+1 votes
+// of each phase into a certificate which is broadcast once. Each instance
+// costs O(n) messages instead of the O(n^2) of all-to-all PBFT.
+//
+// If a threshold key is provided, votes are signature shares and
+// certificates carry one combined signature, otherwise they carry the 2f+1
+// vote signatures.
+class LinearPBFT : public common::ProtocolBase {
+ public:
+  LinearPBFT(int id, int f, int total_num, SignatureVerifier* verifier,
+             const ThresholdSignature* threshold_signature = nullptr);
+  ~LinearPBFT();
+
+  bool ReceiveTransaction(std::unique_ptr<Transaction> txn);
+  bool ReceivePropose(std::unique_ptr<Transaction> txn);
+  // Only processed by the primary. type is PrepareVote or CommitVote.
+  bool ReceiveVote(int type, std::unique_ptr<Vote> vote);
+  bool ReceiveCertificate(std::unique_ptr<Certificate> cert);
+
+  int GetPrimary() const;
+
+ private:
+  enum Phase { kPrepare = 0, kCommit = 1, kPhaseNum = 2 };
+
+  struct Instance {
+    std::unique_ptr<Transaction> txn;
+    std::string hash;
+    // Votes collected by the primary.
+    std::map<int32_t, SignatureInfo> votes[kPhaseNum];
+    bool cert_sent[kPhaseNum] = {false, false};
+    // Certificates received, they may arrive before the proposal.
+    bool certified[kPhaseNum] = {false, false};
+    bool commit_voted = false;
+  };
+
+  std::string GetVoteMessage(int phase, int64_t view, int64_t seq,
+                             const std::string& hash) const;
+  std::unique_ptr<Vote> NewVote(int phase, const Instance& instance,
+                                int64_t seq);
+  std::unique_ptr<Certificate> NewCertificate(int phase, Instance* instance,
+                                              int64_t seq);
+  bool VerifyVote(int phase, const Vote& vote);
+  bool VerifyCertificate(const Certificate& cert);
+
+  // Must be called holding mutex_.
+  bool IsDone(int64_t seq) const;
+  void MarkDone(int64_t seq);
+
+ private:
+  std::mutex mutex_;
+  std::map<int64_t, Instance> instances_;
+  // Committed seqs below next_undone_seq_ and in done_seqs_ are released.
+  int64_t next_undone_seq_ = 1;
+  std::set<int64_t> done_seqs_;
+
+  int64_t seq_;
+  int64_t view_;
+  const ThresholdSignature* threshold_signature_;
+};
+
+}  // namespace linear_pbft
+}  // namespace resdb
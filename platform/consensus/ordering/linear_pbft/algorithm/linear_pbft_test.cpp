@@ -0,0 +1,243 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/linear_pbft/algorithm/linear_pbft.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+
+namespace resdb {
+namespace linear_pbft {
+namespace {
+
+// Runs n replicas in one thread, delivering the messages in FIFO order.
+class Cluster {
+ public:
+  struct Message {
+    int type;
+    std::string data;
+    int to;
+  };
+
+  Cluster(int n, const std::vector<ThresholdKeyShare>& keys = {})
+      : n_(n), committed_(n + 1) {
+    for (int i = 1; i <= n; ++i) {
+      if (!keys.empty()) {
+        signatures_.push_back(
+            std::make_unique<ThresholdSignature>(keys[i - 1]));
+      }
+      auto replica = std::make_unique<LinearPBFT>(
+          i, (n - 1) / 3, n, nullptr,
+          keys.empty() ? nullptr : signatures_.back().get());
+      replica->SetSingleCallFunc(
+          [this](int type, const google::protobuf::Message& msg, int to) {
+            queue_.push_back({type, msg.SerializeAsString(), to});
+            return 0;
+          });
+      replica->SetBroadcastCallFunc(
+          [this](int type, const google::protobuf::Message& msg) {
+            for (int j = 1; j <= n_; ++j) {
+              queue_.push_back({type, msg.SerializeAsString(), j});
+            }
+            return 0;
+          });
+      replica->SetCommitFunc([this, i](const google::protobuf::Message& msg) {
+        committed_[i].push_back(dynamic_cast<const Transaction&>(msg).seq());
+        return 0;
+      });
+      replicas_.push_back(std::move(replica));
+    }
+  }
+
+  void Submit(int replica, const std::string& data) {
+    auto txn = std::make_unique<Transaction>();
+    txn->set_data(data);
+    txn->set_hash("hash_" + data);
+    replicas_[replica - 1]->ReceiveTransaction(std::move(txn));
+  }
+
+  // Deliver all the messages, except those filtered out which are kept.
+  void Run(std::function<bool(const Message&)> hold = nullptr) {
+    std::deque<Message> held;
+    while (!queue_.empty()) {
+      Message msg = std::move(queue_.front());
+      queue_.pop_front();
+      if (hold && hold(msg)) {
+        held.push_back(std::move(msg));
+        continue;
+      }
+      Deliver(msg);
+    }
+    queue_ = std::move(held);
+  }
+
+  void Deliver(const Message& msg) {
+    message_num_++;
+    LinearPBFT* replica = replicas_[msg.to - 1].get();
+    switch (msg.type) {
+      case MessageType::Forward:
+      case MessageType::Propose: {
+        auto txn = std::make_unique<Transaction>();
+        ASSERT_TRUE(txn->ParseFromString(msg.data));
+        if (msg.type == MessageType::Forward) {
+          replica->ReceiveTransaction(std::move(txn));
+        } else {
+          replica->ReceivePropose(std::move(txn));
+        }
+        break;
+      }
+      case MessageType::PrepareVote:
+      case MessageType::CommitVote: {
+        auto vote = std::make_unique<Vote>();
+        ASSERT_TRUE(vote->ParseFromString(msg.data));
+        replica->ReceiveVote(msg.type, std::move(vote));
+        break;
+      }
+      default: {
+        auto cert = std::make_unique<Certificate>();
+        ASSERT_TRUE(cert->ParseFromString(msg.data));
+        replica->ReceiveCertificate(std::move(cert));
+      }
+    }
+  }
+
+  LinearPBFT* GetReplica(int id) { return replicas_[id - 1].get(); }
+  const std::vector<int64_t>& Committed(int id) { return committed_[id]; }
+  int MessageNum() const { return message_num_; }
+
+ private:
+  int n_;
+  int message_num_ = 0;
+  std::deque<Message> queue_;
+  std::vector<std::unique_ptr<ThresholdSignature>> signatures_;
+  std::vector<std::unique_ptr<LinearPBFT>> replicas_;
+  std::vector<std::vector<int64_t>> committed_;
+};
+
+TEST(LinearPBFTTest, AllReplicasCommit) {
+  Cluster cluster(4);
+  for (int i = 0; i < 10; ++i) {
+    cluster.Submit(1, std::to_string(i));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 10) << "replica:" << i;
+  }
+}
+
+TEST(LinearPBFTTest, LinearMessages) {
+  Cluster cluster(16);
+  cluster.Submit(1, "test");
+  cluster.Run();
+  for (int i = 1; i <= 16; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 1);
+  }
+  // Proposal, two rounds of votes to the primary and two certificates.
+  EXPECT_EQ(cluster.MessageNum(), 5 * 16);
+}
+
+TEST(LinearPBFTTest, ForwardToPrimary) {
+  Cluster cluster(4);
+  cluster.Submit(3, "test");
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    ASSERT_EQ(cluster.Committed(i).size(), 1);
+    EXPECT_EQ(cluster.Committed(i)[0], 1);
+  }
+}
+
+TEST(LinearPBFTTest, CertificateBeforeProposal) {
+  Cluster cluster(4);
+  cluster.Submit(1, "test");
+  cluster.Run([](const Cluster::Message& msg) {
+    return msg.to == 4 && msg.type == MessageType::Propose;
+  });
+  EXPECT_EQ(cluster.Committed(1).size(), 1);
+  EXPECT_EQ(cluster.Committed(4).size(), 0);
+  cluster.Run();
+  EXPECT_EQ(cluster.Committed(4).size(), 1);
+}
+
+TEST(LinearPBFTTest, RejectCertificateWithoutQuorum) {
+  Cluster cluster(4);
+  auto cert = std::make_unique<Certificate>();
+  cert->set_hash("hash");
+  cert->set_seq(1);
+  cert->set_phase(1);
+  for (int i = 1; i <= 2; ++i) {
+    cert->add_signatures()->set_node_id(i);
+  }
+  EXPECT_FALSE(cluster.GetReplica(2)->ReceiveCertificate(std::move(cert)));
+}
+
+TEST(LinearPBFTTest, ThresholdCertificate) {
+  auto keys = ThresholdSignature::GenerateKeys(4, 3, 512);
+  ASSERT_TRUE(keys.ok());
+  Cluster cluster(4, *keys);
+  for (int i = 0; i < 3; ++i) {
+    cluster.Submit(1, std::to_string(i));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 3);
+  }
+}
+
+TEST(LinearPBFTTest, DropInvalidVoteShare) {
+  auto keys = ThresholdSignature::GenerateKeys(4, 3, 512);
+  ASSERT_TRUE(keys.ok());
+  Cluster cluster(4, *keys);
+  cluster.Submit(1, "test");
+
+  // Hold the prepare vote of replica 2.
+  std::unique_ptr<Vote> vote;
+  auto hold = [&](const Cluster::Message& msg) {
+    if (msg.type != MessageType::PrepareVote) {
+      return false;
+    }
+    Vote prepare_vote;
+    if (!prepare_vote.ParseFromString(msg.data) ||
+        prepare_vote.sender() != 2) {
+      return false;
+    }
+    if (vote == nullptr) {
+      vote = std::make_unique<Vote>(prepare_vote);
+    }
+    return true;
+  };
+  cluster.Run(hold);
+  ASSERT_NE(vote, nullptr);
+
+  // Replica 2 is faulty and votes with a share of another message.
+  auto share = ThresholdSignature((*keys)[1]).SignShare("other");
+  ASSERT_TRUE(share.ok());
+  *vote->mutable_signature() = *share;
+  EXPECT_FALSE(cluster.GetReplica(1)->ReceiveVote(MessageType::PrepareVote,
+                                                  std::move(vote)));
+
+  cluster.Run(hold);
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 1) << "replica:" << i;
+  }
+}
+
+}  // namespace
+}  // namespace linear_pbft
+}  // namespace resdb
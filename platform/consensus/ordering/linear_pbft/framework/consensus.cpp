@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/linear_pbft/framework/consensus.h"
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include "common/utils/utils.h"
+
+namespace resdb {
+namespace linear_pbft {
+
+Consensus::Consensus(const ResDBConfig& config,
+                     std::unique_ptr<TransactionManager> executor)
+    : common::Consensus(config, std::move(executor)) {
+  int total_replicas = config_.GetReplicaNum();
+  int f = (total_replicas - 1) / 3;
+
+  Init();
+
+  if (config_.GetPublicKeyCertificateInfo()
+          .public_key()
+          .public_key_info()
+          .type() != CertificateKeyInfo::CLIENT) {
+    if (config_.GetThresholdKeyShare()) {
+      threshold_signature_ =
+          std::make_unique<ThresholdSignature>(*config_.GetThresholdKeyShare());
+    }
+    linear_pbft_ = std::make_unique<LinearPBFT>(
+        config_.GetSelfInfo().id(), f, total_replicas, GetSignatureVerifier(),
+        threshold_signature_.get());
+    InitProtocol(linear_pbft_.get());
+  }
+}
+
+int Consensus::ProcessCustomConsensus(std::unique_ptr<Request> request) {
+  switch (request->user_type()) {
+    case MessageType::Propose:
+    case MessageType::Forward: {
+      std::unique_ptr<Transaction> txn = std::make_unique<Transaction>();
+      if (!txn->ParseFromString(request->data())) {
+        LOG(ERROR) << "parse transaction fail";
+        return -1;
+      }
+      if (request->user_type() == MessageType::Forward) {
+        return linear_pbft_->ReceiveTransaction(std::move(txn)) ? 0 : -1;
+      }
+      linear_pbft_->ReceivePropose(std::move(txn));
+      return 0;
+    }
+    case MessageType::PrepareVote:
+    case MessageType::CommitVote: {
+      std::unique_ptr<Vote> vote = std::make_unique<Vote>();
+      if (!vote->ParseFromString(request->data())) {
+        LOG(ERROR) << "parse vote fail";
+        return -1;
+      }
+      linear_pbft_->ReceiveVote(request->user_type(), std::move(vote));
+      return 0;
+    }
+    case MessageType::PrepareCert:
+    case MessageType::CommitCert: {
+      std::unique_ptr<Certificate> cert = std::make_unique<Certificate>();
+      if (!cert->ParseFromString(request->data())) {
+        LOG(ERROR) << "parse certificate fail";
+        return -1;
+      }
+      linear_pbft_->ReceiveCertificate(std::move(cert));
+      return 0;
+    }
+  }
+  return 0;
+}
+
+int Consensus::ProcessNewTransaction(std::unique_ptr<Request> request) {
+  std::unique_ptr<Transaction> txn = std::make_unique<Transaction>();
+  txn->set_data(request->data());
+  txn->set_hash(request->hash());
+  txn->set_proxy_id(request->proxy_id());
+  txn->set_uid(request->uid());
+  return linear_pbft_->ReceiveTransaction(std::move(txn));
+}
+
+int Consensus::CommitMsg(const google::protobuf::Message& msg) {
+  return CommitMsgInternal(dynamic_cast<const Transaction&>(msg));
+}
+
+int Consensus::CommitMsgInternal(const Transaction& txn) {
+  std::unique_ptr<Request> request = std::make_unique<Request>();
+  request->set_data(txn.data());
+  request->set_seq(txn.seq());
+  request->set_uid(txn.uid());
+  request->set_proxy_id(txn.proxy_id());
+
+  transaction_executor_->Commit(std::move(request));
+  return 0;
+}
+
+}  // namespace linear_pbft
+}  // namespace resdb
@@ -21,11 +21,25 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <optional>
+
 #include "platform/consensus/ordering/pbft/transaction_utils.h"
 #include "platform/proto/checkpoint_info.pb.h"
 
 namespace resdb {
 
+namespace {
+
+// The number of checkpoints above the stable one whose votes are kept, enough
+// to cover the seqs in flight.
+size_t GetCheckpointWindow(const ResDBConfig& config) {
+  return std::max<size_t>(
+      64, 2 * config.GetMaxProcessTxn() / config.GetCheckPointWaterMark());
+}
+
+}  // namespace
+
 CheckPointManager::CheckPointManager(const ResDBConfig& config,
                                      ReplicaCommunicator* replica_communicator,
                                      SignatureVerifier* verifier,
@@ -34,10 +48,22 @@ CheckPointManager::CheckPointManager(const ResDBConfig& config,
       replica_communicator_(replica_communicator),
       verifier_(verifier),
       stop_(false),
+      ckpt_votes_(GetCheckpointWindow(config)),
       txn_accessor_(config),
       highest_prepared_seq_(0),
       sys_info_(sys_info) {
   current_stable_seq_ = 0;
+  uint32_t max_replica_id = 0;
+  for (const auto& replica : config_.GetReplicaInfos()) {
+    max_replica_id = std::max<uint32_t>(max_replica_id, replica.id());
+  }
+  for (CheckpointVotes& votes : ckpt_votes_) {
+    votes.voted.resize(max_replica_id + 1);
+  }
+  if (config_.GetThresholdKeyShare()) {
+    threshold_signature_ =
+        std::make_unique<ThresholdSignature>(*config_.GetThresholdKeyShare());
+  }
   if (config_.GetConfigData().enable_viewchange()) {
     config_.EnableCheckPoint(true);
   }
@@ -94,9 +120,15 @@ void CheckPointManager::AddCommitData(std::unique_ptr<Request> request) {
 // check whether there are 2f+1 valid checkpoint proof.
 bool CheckPointManager::IsValidCheckpointProof(
     const StableCheckPoint& stable_ckpt) {
-  std::string hash = stable_ckpt_.hash();
+  std::string hash = stable_ckpt.hash();
+  if (stable_ckpt.has_quorum_cert()) {
+    return threshold_signature_ &&
+           static_cast<int>(ThresholdSignature::GetSignerNum(
+               stable_ckpt.quorum_cert())) >= config_.GetMinDataReceiveNum() &&
+           threshold_signature_->Verify(hash, stable_ckpt.quorum_cert());
+  }
   std::set<uint32_t> senders;
-  for (const auto& signature : stable_ckpt_.signatures()) {
+  for (const auto& signature : stable_ckpt.signatures()) {
     if (!verifier_->VerifyMessage(hash, signature)) {
       return false;
     }
@@ -134,38 +166,184 @@ int CheckPointManager::ProcessCheckPoint(std::unique_ptr<Context> context,
     }
   }
 
+  if (checkpoint_seq <= current_stable_seq_) {
+    // The votes of the stable checkpoints are released.
+    return 0;
+  }
+  if (AddCheckpointVote(sender_id, checkpoint_data) == 1) {
+    // Keep the votes of the replicas running ahead, f+1 of them let this
+    // replica catch up to a committable checkpoint.
+    AddFutureCheckpointVote(sender_id, checkpoint_data);
+  }
+  return 0;
+}
+
+// Returns 1 if the checkpoint is above the window.
+int CheckPointManager::AddCheckpointVote(
+    uint32_t sender_id, const CheckPointData& checkpoint_data) {
+  uint64_t checkpoint_seq = checkpoint_data.seq();
+  CheckpointVotes* votes = GetCheckpointVotes(checkpoint_seq);
+  if (votes == nullptr) {
+    LOG(ERROR) << "checkpoint out of window:" << checkpoint_seq
+               << " stable seq:" << current_stable_seq_;
+    return 1;
+  }
+
+  int num = 0;
   {
-    std::lock_guard<std::mutex> lk(mutex_);
-    auto res =
-        sender_ckpt_[std::make_pair(checkpoint_seq, checkpoint_data.hash())]
-            .insert(sender_id);
-    if (res.second) {
-      sign_ckpt_[std::make_pair(checkpoint_seq, checkpoint_data.hash())]
-          .push_back(checkpoint_data.hash_signature());
-      new_data_++;
-    }
-    if (sender_ckpt_[std::make_pair(checkpoint_seq, checkpoint_data.hash())]
-            .size() == 1) {
-      for (auto& hash_ : checkpoint_data.hashs()) {
-        hash_ckpt_[std::make_pair(checkpoint_seq, checkpoint_data.hash())]
-            .push_back(hash_);
+    std::lock_guard<std::mutex> lk(votes->mutex);
+    if (votes->seq != checkpoint_seq) {
+      if (votes->seq > current_stable_seq_) {
+        // The slot still holds the votes of a checkpoint which is not
+        // stable, do not wipe them.
+        LOG(ERROR) << "checkpoint slot is in use, seq:" << votes->seq
+                   << " vote seq:" << checkpoint_seq;
+        return 0;
       }
+      // The previous checkpoint of the slot is stable.
+      votes->seq = checkpoint_seq;
+      std::fill(votes->voted.begin(), votes->voted.end(), false);
+      votes->candidates.clear();
+    }
+    if (sender_id >= votes->voted.size()) {
+      LOG(ERROR) << "replica id out of range:" << sender_id;
+      return 0;
+    }
+    if (votes->voted[sender_id]) {
+      return 0;
     }
-    Notify();
+    votes->voted[sender_id] = true;
+    CheckpointVotes::Candidate* candidate = nullptr;
+    for (auto& it : votes->candidates) {
+      if (it->hash == checkpoint_data.hash()) {
+        candidate = it.get();
+        break;
+      }
+    }
+    if (candidate == nullptr) {
+      votes->candidates.push_back(
+          std::make_unique<CheckpointVotes::Candidate>());
+      candidate = votes->candidates.back().get();
+      candidate->hash = checkpoint_data.hash();
+    }
+    candidate->signatures.push_back(checkpoint_data.hash_signature());
+    if (checkpoint_data.has_hash_signature_share()) {
+      candidate->shares.push_back(checkpoint_data.hash_signature_share());
+    }
+    num = candidate->signatures.size();
+  }
+
+  if (num == config_.GetMinCheckpointReceiveNum()) {
+    UpdateCommittableSeq(checkpoint_seq, checkpoint_data.hash());
+  }
+  if (num == config_.GetMinDataReceiveNum()) {
+    std::lock_guard<std::mutex> lk(cv_mutex_);
+    if (checkpoint_seq > ready_stable_seq_) {
+      ready_stable_seq_ = checkpoint_seq;
+      ready_stable_hash_ = checkpoint_data.hash();
+    }
+    cv_.notify_all();
   }
   return 0;
 }
 
-void CheckPointManager::Notify() {
-  std::lock_guard<std::mutex> lk(cv_mutex_);
-  cv_.notify_all();
+void CheckPointManager::UpdateCommittableSeq(uint64_t seq,
+                                             const std::string& hash) {
+  {
+    std::lock_guard<std::mutex> lk(lt_mutex_);
+    if (seq > committable_seq_) {
+      committable_seq_ = seq;
+      committable_hash_ = hash;
+    }
+  }
+  sem_post(&committable_seq_signal_);
+}
+
+// Each replica keeps at most the window size of its highest votes, so a
+// faulty one can not push out the others.
+void CheckPointManager::AddFutureCheckpointVote(
+    uint32_t sender_id, const CheckPointData& checkpoint_data) {
+  uint64_t checkpoint_seq = checkpoint_data.seq();
+  int num = 0;
+  {
+    std::lock_guard<std::mutex> lk(future_votes_mutex_);
+    auto& sender_votes = future_votes_[sender_id];
+    if (!sender_votes.emplace(checkpoint_seq, checkpoint_data).second) {
+      return;
+    }
+    if (sender_votes.size() > ckpt_votes_.size()) {
+      sender_votes.erase(sender_votes.begin());
+      if (sender_votes.find(checkpoint_seq) == sender_votes.end()) {
+        return;
+      }
+    }
+    for (const auto& [id, votes] : future_votes_) {
+      auto it = votes.find(checkpoint_seq);
+      if (it != votes.end() && it->second.hash() == checkpoint_data.hash()) {
+        num++;
+      }
+    }
+  }
+  if (num == config_.GetMinCheckpointReceiveNum()) {
+    UpdateCommittableSeq(checkpoint_seq, checkpoint_data.hash());
+  }
+}
+
+// Move the votes kept above the window into the window once the stable
+// checkpoint moves, and drop the ones which are stable.
+void CheckPointManager::ReplayFutureCheckpointVotes() {
+  std::vector<std::pair<uint32_t, CheckPointData>> replay;
+  {
+    std::lock_guard<std::mutex> lk(future_votes_mutex_);
+    for (auto it = future_votes_.begin(); it != future_votes_.end();) {
+      auto& sender_votes = it->second;
+      sender_votes.erase(sender_votes.begin(),
+                         sender_votes.upper_bound(current_stable_seq_));
+      while (!sender_votes.empty() &&
+             GetCheckpointVotes(sender_votes.begin()->first) != nullptr) {
+        replay.emplace_back(it->first,
+                            std::move(sender_votes.begin()->second));
+        sender_votes.erase(sender_votes.begin());
+      }
+      if (sender_votes.empty()) {
+        it = future_votes_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (const auto& [sender_id, checkpoint_data] : replay) {
+    AddCheckpointVote(sender_id, checkpoint_data);
+  }
 }
 
-bool CheckPointManager::Wait() {
-  int timeout_ms = 1000;
-  std::unique_lock<std::mutex> lk(cv_mutex_);
-  return cv_.wait_for(lk, std::chrono::milliseconds(timeout_ms),
-                      [&] { return new_data_ > 0; });
+CheckPointManager::CheckpointVotes* CheckPointManager::GetCheckpointVotes(
+    uint64_t seq) {
+  uint64_t water_mark = config_.GetCheckPointWaterMark();
+  uint64_t ckpt = seq / water_mark;
+  if (ckpt >= current_stable_seq_ / water_mark + ckpt_votes_.size()) {
+    return nullptr;
+  }
+  return &ckpt_votes_[ckpt % ckpt_votes_.size()];
+}
+
+void CheckPointManager::ResetCheckpointVotes(uint64_t from_seq,
+                                             uint64_t to_seq) {
+  uint64_t water_mark = config_.GetCheckPointWaterMark();
+  uint64_t from = from_seq / water_mark + 1;
+  uint64_t to = to_seq / water_mark;
+  if (to - from >= ckpt_votes_.size()) {
+    from = to - ckpt_votes_.size() + 1;
+  }
+  for (uint64_t ckpt = from; ckpt <= to; ++ckpt) {
+    CheckpointVotes& votes = ckpt_votes_[ckpt % ckpt_votes_.size()];
+    std::lock_guard<std::mutex> lk(votes.mutex);
+    if (votes.seq <= to_seq) {
+      votes.seq = 0;
+      std::fill(votes.voted.begin(), votes.voted.end(), false);
+      votes.candidates.clear();
+    }
+  }
 }
 
 void CheckPointManager::CheckHealthy() {
@@ -206,63 +384,69 @@ void CheckPointManager::CheckHealthy() {
 }
 
 void CheckPointManager::UpdateStableCheckPointStatus() {
-  uint64_t last_committable_seq = 0;
   while (!stop_) {
-    if (!Wait()) {
-      continue;
-    }
     uint64_t stable_seq = 0;
     std::string stable_hash;
     {
-      std::lock_guard<std::mutex> lk(mutex_);
-      for (auto it : sender_ckpt_) {
-        if (it.second.size() >=
-            static_cast<size_t>(config_.GetMinCheckpointReceiveNum())) {
-          committable_seq_ = it.first.first;
-          committable_hash_ = it.first.second;
-          std::set<uint32_t> senders_ =
-              sender_ckpt_[std::make_pair(committable_seq_, committable_hash_)];
-          sem_post(&committable_seq_signal_);
-        }
-        if (it.second.size() >=
-            static_cast<size_t>(config_.GetMinDataReceiveNum())) {
-          stable_seq = it.first.first;
-          stable_hash = it.first.second;
-        }
+      std::unique_lock<std::mutex> lk(cv_mutex_);
+      if (!cv_.wait_for(lk, std::chrono::milliseconds(1000), [&] {
+            return ready_stable_seq_ > current_stable_seq_;
+          })) {
+        continue;
       }
-      new_data_ = 0;
+      stable_seq = ready_stable_seq_;
+      stable_hash = ready_stable_hash_;
     }
 
     LOG(ERROR) << "current stable seq:" << current_stable_seq_
                << " stable seq:" << stable_seq;
-    if (stable_seq == 0) {
-      continue;
+    std::vector<SignatureInfo> votes, shares;
+    {
+      CheckpointVotes* ckpt_votes = GetCheckpointVotes(stable_seq);
+      std::lock_guard<std::mutex> lk(ckpt_votes->mutex);
+      for (const auto& candidate : ckpt_votes->candidates) {
+        if (ckpt_votes->seq == stable_seq && candidate->hash == stable_hash) {
+          votes = candidate->signatures;
+          shares = candidate->shares;
+        }
+      }
     }
-    std::vector<SignatureInfo> votes;
-    if (current_stable_seq_ < stable_seq) {
-      std::lock_guard<std::mutex> lk(mutex_);
-      votes = sign_ckpt_[std::make_pair(stable_seq, stable_hash)];
-      std::set<uint32_t> senders_ =
-          sender_ckpt_[std::make_pair(stable_seq, stable_hash)];
-
-      auto it = sender_ckpt_.begin();
-      while (it != sender_ckpt_.end()) {
-        if (it->first.first <= stable_seq) {
-          sign_ckpt_.erase(sign_ckpt_.find(it->first));
-          auto tmp = it++;
-          sender_ckpt_.erase(tmp);
+    {
+      // Combine the shares outside the lock, it costs a few exponentiations.
+      std::optional<QuorumCertificate> quorum_cert;
+      if (threshold_signature_ && !shares.empty()) {
+        std::vector<const SignatureInfo*> share_ptrs;
+        for (const auto& share : shares) {
+          share_ptrs.push_back(&share);
+        }
+        auto cert_or = threshold_signature_->Combine(stable_hash, share_ptrs);
+        if (cert_or.ok()) {
+          quorum_cert = std::move(*cert_or);
         } else {
-          it++;
+          LOG(ERROR) << "combine checkpoint certificate fail:"
+                     << cert_or.status();
         }
       }
-      stable_ckpt_.set_seq(stable_seq);
-      stable_ckpt_.set_hash(stable_hash);
-      stable_ckpt_.mutable_signatures()->Clear();
-      for (auto vote : votes) {
-        *stable_ckpt_.add_signatures() = vote;
+
+      uint64_t last_stable_seq = current_stable_seq_;
+      {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stable_ckpt_.set_seq(stable_seq);
+        stable_ckpt_.set_hash(stable_hash);
+        stable_ckpt_.mutable_signatures()->Clear();
+        stable_ckpt_.clear_quorum_cert();
+        if (quorum_cert.has_value()) {
+          *stable_ckpt_.mutable_quorum_cert() = std::move(*quorum_cert);
+        } else {
+          for (auto vote : votes) {
+            *stable_ckpt_.add_signatures() = vote;
+          }
+        }
+        current_stable_seq_ = stable_seq;
       }
-      current_stable_seq_ = stable_seq;
+      ResetCheckpointVotes(last_stable_seq, stable_seq);
     }
+    ReplayFutureCheckpointVotes();
     UpdateStableCheckPointCallback(current_stable_seq_);
   }
 }
@@ -463,6 +647,14 @@ void CheckPointManager::BroadcastCheckPoint(
     }
     *checkpoint_data.mutable_hash_signature() = *signature_or;
   }
+  if (threshold_signature_ && threshold_signature_->CanSign()) {
+    auto share_or = threshold_signature_->SignShare(hash);
+    if (!share_or.ok()) {
+      LOG(ERROR) << "Sign message share fail";
+      return;
+    }
+    *checkpoint_data.mutable_hash_signature_share() = *share_or;
+  }
 
   checkpoint_data.SerializeToString(checkpoint_request->mutable_data());
   replica_communicator_->BroadCast(*checkpoint_request);
@@ -21,8 +21,14 @@
 
 #include <semaphore.h>
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include "chain/state/chain_state.h"
 #include "common/crypto/signature_verifier.h"
+#include "common/crypto/threshold_signature.h"
 #include "interface/common/resdb_txn_accessor.h"
 #include "platform/config/resdb_config.h"
 #include "platform/consensus/checkpoint/checkpoint.h"
@@ -95,8 +101,6 @@ class CheckPointManager : public CheckPoint {
                            const std::vector<std::string>& stable_hashs,
                            const std::vector<uint64_t>& stable_seqs);
 
-  void Notify();
-  bool Wait();
   void BroadcastRecovery(uint64_t min_seq, uint64_t max_seq);
 
   void SyncStatus();
@@ -105,6 +109,38 @@ class CheckPointManager : public CheckPoint {
   void CheckSysStatus();
   void CheckHealthy();
 
+  // The votes of one checkpoint. They are kept in a ring indexed by the
+  // checkpoint number, seq / water mark, and reset once the checkpoint is
+  // stable. All the fields are guarded by mutex.
+  struct CheckpointVotes {
+    struct Candidate {
+      std::string hash;
+      // One per sender, a replica only votes for one candidate.
+      std::vector<SignatureInfo> signatures;
+      // Threshold signature shares, combined into the quorum certificate of
+      // the stable checkpoint.
+      std::vector<SignatureInfo> shares;
+    };
+
+    std::mutex mutex;
+    uint64_t seq = 0;
+    // The replicas which have voted for a hash of the checkpoint, indexed by
+    // the replica id.
+    std::vector<bool> voted;
+    std::vector<std::unique_ptr<Candidate>> candidates;
+  };
+
+  CheckpointVotes* GetCheckpointVotes(uint64_t seq);
+  // Reset the votes of the checkpoints in (from_seq, to_seq].
+  void ResetCheckpointVotes(uint64_t from_seq, uint64_t to_seq);
+  // Returns 1 if the checkpoint is above the window.
+  int AddCheckpointVote(uint32_t sender_id,
+                        const CheckPointData& checkpoint_data);
+  void AddFutureCheckpointVote(uint32_t sender_id,
+                               const CheckPointData& checkpoint_data);
+  void ReplayFutureCheckpointVotes();
+  void UpdateCommittableSeq(uint64_t seq, const std::string& hash);
+
  protected:
   uint64_t last_executed_seq_ = 0;
   ResDBConfig config_;
@@ -112,19 +148,21 @@ class CheckPointManager : public CheckPoint {
   std::thread checkpoint_thread_, stable_checkpoint_thread_, status_thread_;
   SignatureVerifier* verifier_;
   std::atomic<bool> stop_;
-  std::map<std::pair<uint64_t, std::string>, std::set<uint32_t>> sender_ckpt_;
-  std::map<std::pair<uint64_t, std::string>, std::vector<SignatureInfo>>
-      sign_ckpt_;
-  std::map<std::pair<uint64_t, std::string>, std::vector<std::string>>
-      hash_ckpt_;
+  std::vector<CheckpointVotes> ckpt_votes_;
+  std::mutex future_votes_mutex_;
+  // The votes above the window by sender and seq.
+  std::map<uint32_t, std::map<uint64_t, CheckPointData>> future_votes_;
+  std::unique_ptr<ThresholdSignature> threshold_signature_;
   std::atomic<uint64_t> current_stable_seq_;
   std::mutex mutex_;
   LockFreeQueue<Request> data_queue_;
   std::mutex cv_mutex_;
   std::condition_variable cv_;
+  // The highest checkpoint having 2f+1 votes, guarded by cv_mutex_.
+  uint64_t ready_stable_seq_ = 0;
+  std::string ready_stable_hash_;
   std::function<void(int)> timeout_handler_;
   StableCheckPoint stable_ckpt_;
-  int new_data_ = 0;
   LockFreeQueue<std::pair<uint64_t, std::string>> stable_hash_queue_;
   std::condition_variable signal_;
   ResDBTxnAccessor txn_accessor_;
@@ -60,7 +60,7 @@ class MyCheckPointManager : public CheckPointManager {
   SystemInfo sys_info_;
 };
 
-ResConfigData GetConfigData() {
+ResConfigData GetConfigData(int last_replica_id = 4) {
   Stats::GetGlobalStats(/*int sleep_seconds = */ 1);
   std::string json =
       "{ "
@@ -81,7 +81,9 @@ ResConfigData GetConfigData() {
       "  \"port\": 1236 "
       "   },"
       "  \"replica_info\": { "
-      "  \"id\": 4, "
+      "  \"id\": " +
+      std::to_string(last_replica_id) +
+      ", "
       "  \"ip\": \"127.0.0.1\", "
       "  \"port\": 1237 "
       "   },"
@@ -253,6 +255,144 @@ TEST_F(CheckPointManagerTest, StableCkptNotEnough) {
   EXPECT_EQ(manager.GetStableCheckpoint(), 5);
 }
 
+TEST_F(CheckPointManagerTest, DuplicateVotes) {
+  config_.SetViewchangeCommitTimeout(100);
+  std::promise<bool> ckp_done;
+  std::future<bool> ckp_done_future = ckp_done.get_future();
+  bool set_done = false;
+  MyCheckPointManager manager(config_, &replica_communicator_, nullptr,
+                              [&](int64_t seq) {
+                                if (seq > 0 && !set_done) {
+                                  set_done = true;
+                                  ckp_done.set_value(true);
+                                }
+                              });
+  auto send_vote = [&](int sender, uint64_t seq) {
+    CheckPointData checkpoint_data;
+    std::unique_ptr<Request> checkpoint_request =
+        NewRequest(Request::TYPE_CHECKPOINT, Request(), sender);
+    checkpoint_data.set_seq(seq);
+    checkpoint_data.set_hash("1234");
+    checkpoint_data.SerializeToString(checkpoint_request->mutable_data());
+    return manager.ProcessCheckPoint(std::make_unique<Context>(),
+                                     std::move(checkpoint_request));
+  };
+
+  // Repeated votes from the same replica are counted once.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(send_vote(1, 5), 0);
+  }
+  EXPECT_EQ(send_vote(2, 5), 0);
+  EXPECT_EQ(ckp_done_future.wait_for(std::chrono::milliseconds(200)),
+            std::future_status::timeout);
+  EXPECT_EQ(manager.GetStableCheckpoint(), 0);
+
+  // The votes beyond the window of the stable checkpoint are kept aside.
+  EXPECT_EQ(send_vote(1, 1000), 0);
+  // So are the ones of a seq which is not a checkpoint.
+  EXPECT_EQ(send_vote(1, 6), -2);
+
+  EXPECT_EQ(send_vote(3, 5), 0);
+  ckp_done_future.get();
+  EXPECT_EQ(manager.GetStableCheckpoint(), 5);
+}
+
+TEST_F(CheckPointManagerTest, LargeReplicaIds) {
+  ResDBConfig config(GetConfigData(/*last_replica_id=*/200),
+                     GenerateReplicaInfo(1, "127.0.0.1", 1234), KeyInfo(),
+                     CertificateInfo());
+  config.EnableCheckPoint(true);
+  config.SetViewchangeCommitTimeout(100);
+  std::promise<bool> ckp_done;
+  std::future<bool> ckp_done_future = ckp_done.get_future();
+  bool set_done = false;
+  MyCheckPointManager manager(config, &replica_communicator_, nullptr,
+                              [&](int64_t seq) {
+                                if (seq > 0 && !set_done) {
+                                  set_done = true;
+                                  ckp_done.set_value(true);
+                                }
+                              });
+  auto send_vote = [&](int sender, uint64_t seq) {
+    CheckPointData checkpoint_data;
+    std::unique_ptr<Request> checkpoint_request =
+        NewRequest(Request::TYPE_CHECKPOINT, Request(), sender);
+    checkpoint_data.set_seq(seq);
+    checkpoint_data.set_hash("1234");
+    checkpoint_data.SerializeToString(checkpoint_request->mutable_data());
+    return manager.ProcessCheckPoint(std::make_unique<Context>(),
+                                     std::move(checkpoint_request));
+  };
+
+  // The vote of replica 200 is counted once, like the others.
+  EXPECT_EQ(send_vote(200, 5), 0);
+  EXPECT_EQ(send_vote(200, 5), 0);
+  EXPECT_EQ(send_vote(1, 5), 0);
+  EXPECT_EQ(ckp_done_future.wait_for(std::chrono::milliseconds(200)),
+            std::future_status::timeout);
+  EXPECT_EQ(send_vote(2, 5), 0);
+  ckp_done_future.get();
+  EXPECT_EQ(manager.GetStableCheckpoint(), 5);
+}
+
+TEST_F(CheckPointManagerTest, CommittableSeqAboveWindow) {
+  config_.SetViewchangeCommitTimeout(100);
+  MyCheckPointManager manager(config_, &replica_communicator_, nullptr);
+  auto send_vote = [&](int sender, uint64_t seq, const std::string& hash) {
+    CheckPointData checkpoint_data;
+    std::unique_ptr<Request> checkpoint_request =
+        NewRequest(Request::TYPE_CHECKPOINT, Request(), sender);
+    checkpoint_data.set_seq(seq);
+    checkpoint_data.set_hash(hash);
+    checkpoint_data.SerializeToString(checkpoint_request->mutable_data());
+    return manager.ProcessCheckPoint(std::make_unique<Context>(),
+                                     std::move(checkpoint_request));
+  };
+
+  // f+1 replicas running ahead agree on a checkpoint above the window.
+  EXPECT_EQ(send_vote(2, 1000, "1234"), 0);
+  EXPECT_EQ(send_vote(3, 1000, "5678"), 0);
+  EXPECT_EQ(manager.GetCommittableSeq(), 0);
+  EXPECT_EQ(send_vote(4, 1000, "1234"), 0);
+  sem_wait(manager.CommitableSeqSignal());
+  EXPECT_EQ(manager.GetCommittableSeq(), 1000);
+  EXPECT_EQ(manager.GetStableCheckpoint(), 0);
+}
+
+TEST_F(CheckPointManagerTest, StableCkptMoveWindow) {
+  config_.SetViewchangeCommitTimeout(100);
+  const uint64_t last_seq = 5000;
+  std::promise<bool> ckp_done;
+  std::future<bool> ckp_done_future = ckp_done.get_future();
+  bool set_done = false;
+  MyCheckPointManager manager(config_, &replica_communicator_, nullptr,
+                              [&](int64_t seq) {
+                                if (seq == last_seq && !set_done) {
+                                  set_done = true;
+                                  ckp_done.set_value(true);
+                                }
+                              });
+  // Each checkpoint becomes stable before its slot in the window is reused.
+  for (uint64_t seq = 5; seq <= last_seq; seq += 5) {
+    for (int i = 1; i <= 3; ++i) {
+      CheckPointData checkpoint_data;
+      std::unique_ptr<Request> checkpoint_request =
+          NewRequest(Request::TYPE_CHECKPOINT, Request(), i);
+      checkpoint_data.set_seq(seq);
+      checkpoint_data.set_hash("1234");
+      checkpoint_data.SerializeToString(checkpoint_request->mutable_data());
+      EXPECT_EQ(manager.ProcessCheckPoint(std::make_unique<Context>(),
+                                          std::move(checkpoint_request)),
+                0);
+    }
+    while (manager.GetStableCheckpoint() + 100 < seq) {
+      usleep(1000);
+    }
+  }
+  ckp_done_future.get();
+  EXPECT_EQ(manager.GetStableCheckpoint(), last_seq);
+}
+
 TEST_F(CheckPointManagerTest, Votes) {
   config_.SetViewchangeCommitTimeout(100);
   MockSignatureVerifier mock_verifier;
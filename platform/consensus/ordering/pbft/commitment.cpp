@@ -27,6 +27,12 @@
 
 namespace resdb {
 
+namespace {
+
+constexpr size_t kErasureCodedMinBytes = 64 << 10;
+
+}  // namespace
+
 Commitment::Commitment(const ResDBConfig& config,
                        MessageManager* message_manager,
                        ReplicaCommunicator* replica_communicator,
@@ -46,6 +52,23 @@ Commitment::Commitment(const ResDBConfig& config,
       config_.GetSelfInfo().port(), config_.GetConfigData().enable_resview(),
       config_.GetConfigData().enable_faulty_switch());
   global_stats_->SetPrimaryId(message_manager_->GetCurrentPrimary());
+
+  // The chunks are authenticated by the signature of their sender, they are
+  // all rejected if the replicas do not sign the messages.
+  if (config_.GetConfigData().enable_erasure_coded_proposal() &&
+      (config_.GetConfigData().not_need_signature() ||
+       !config_.SignatureVerifierEnabled())) {
+    LOG(ERROR) << "erasure coded proposal needs signed messages, disable it";
+  } else if (config_.GetConfigData().enable_erasure_coded_proposal()) {
+    // Any f + 1 shards rebuild the data.
+    proposal_dissemination_ = std::make_unique<ProposalDissemination>(
+        config_.GetReplicaInfos().size(),
+        config_.GetMaxMaliciousReplicaNum() + 1);
+    erasure_coded_min_bytes_ =
+        config_.GetConfigData().erasure_coded_min_bytes() > 0
+            ? config_.GetConfigData().erasure_coded_min_bytes()
+            : kErasureCodedMinBytes;
+  }
 }
 
 Commitment::~Commitment() {
@@ -62,6 +85,25 @@ void Commitment::SetPreVerifyFunc(
 
 void Commitment::SetNeedCommitQC(bool need_qc) { need_qc_ = need_qc; }
 
+void Commitment::SetMempoolManager(MempoolManager* mempool_manager) {
+  mempool_manager_ = mempool_manager;
+}
+
+// The batches disseminated through the mempool only carry their hash.
+bool Commitment::IsDigestOnly(const Request& request) {
+  return request.data().empty() && request.has_availability_cert();
+}
+
+// A digest-only batch is checked by its availability certificate instead of
+// the signature of the proxy on the data.
+bool Commitment::VerifyBatch(const Request& request) {
+  if (IsDigestOnly(request)) {
+    return mempool_manager_ != nullptr &&
+           mempool_manager_->VerifyCertificate(request);
+  }
+  return verifier_->VerifyMessage(request.data(), request.data_signature());
+}
+
 // Handle the user request and send a pre-prepare message to others.
 // TODO if not a primary, redicet to the primary replica.
 int Commitment::ProcessNewRequest(std::unique_ptr<Context> context,
@@ -98,8 +140,7 @@ int Commitment::ProcessNewRequest(std::unique_ptr<Context> context,
   }
 
   // check signatures
-  bool valid = verifier_->VerifyMessage(user_request->data(),
-                                        user_request->data_signature());
+  bool valid = VerifyBatch(*user_request);
   if (!valid) {
     LOG(ERROR) << "request is not valid:"
                << user_request->data_signature().DebugString();
@@ -107,7 +148,9 @@ int Commitment::ProcessNewRequest(std::unique_ptr<Context> context,
     return -2;
   }
 
-  if (pre_verify_func_ && !pre_verify_func_(*user_request)) {
+  // The mempools have checked the payload before acking it.
+  if (pre_verify_func_ && !IsDigestOnly(*user_request) &&
+      !pre_verify_func_(*user_request)) {
     LOG(ERROR) << " check by the user func fail";
     return -2;
   }
@@ -143,11 +186,59 @@ int Commitment::ProcessNewRequest(std::unique_ptr<Context> context,
   user_request->set_sender_id(config_.GetSelfInfo().id());
   user_request->set_primary_id(config_.GetSelfInfo().id());
 
+  if (proposal_dissemination_ != nullptr &&
+      user_request->data().size() >= erasure_coded_min_bytes_) {
+    return DisseminateProposal(*user_request);
+  }
   replica_communicator_->BroadCast(*user_request);
 
   return 0;
 }
 
+// Send the whole pre-prepare to the primary itself and one shard of its data
+// to each of the other replicas.
+int Commitment::DisseminateProposal(const Request& pre_prepare) {
+  std::vector<std::unique_ptr<Request>> chunks =
+      proposal_dissemination_->Split(pre_prepare);
+  const std::vector<ReplicaInfo>& replicas = config_.GetReplicaInfos();
+  for (size_t i = 0; i < replicas.size() && i < chunks.size(); ++i) {
+    if (replicas[i].id() == config_.GetSelfInfo().id()) {
+      replica_communicator_->SendMessage(pre_prepare, replicas[i]);
+    } else {
+      replica_communicator_->SendMessage(*chunks[i], replicas[i]);
+    }
+  }
+  return 0;
+}
+
+// The shard sent by the primary is forwarded to the other replicas. The
+// primary and the sender itself ignore the forwarded shards.
+std::pair<std::unique_ptr<Context>, std::unique_ptr<Request>>
+Commitment::ProcessProposeChunkMsg(std::unique_ptr<Context> context,
+                                   std::unique_ptr<Request> request) {
+  if (proposal_dissemination_ == nullptr || context == nullptr ||
+      context->signature.signature().empty()) {
+    LOG(ERROR) << "proposal chunk is not accepted";
+    return std::make_pair(nullptr, nullptr);
+  }
+  int32_t self_id = config_.GetSelfInfo().id();
+  int32_t primary_id = message_manager_->GetCurrentPrimary();
+  // The sender is taken from the verified signature, the sender_id in the
+  // request is not signed by the primary once forwarded.
+  int32_t sender_id = context->signature.node_id();
+  if (self_id == primary_id || sender_id == self_id) {
+    return std::make_pair(nullptr, nullptr);
+  }
+
+  bool from_primary = sender_id == primary_id;
+  if (from_primary) {
+    request->set_sender_id(self_id);
+    replica_communicator_->BroadCast(*request);
+  }
+  return proposal_dissemination_->AddChunk(std::move(context), *request,
+                                           from_primary);
+}
+
 // Receive the pre-prepare message from the primary.
 // TODO check whether the sender is the primary.
 int Commitment::ProcessProposeMsg(std::unique_ptr<Context> context,
@@ -203,7 +294,8 @@ int Commitment::ProcessProposeMsg(std::unique_ptr<Context> context,
   }
 
   if (request->sender_id() != config_.GetSelfInfo().id()) {
-    if (pre_verify_func_ && !pre_verify_func_(*request)) {
+    if (pre_verify_func_ && !IsDigestOnly(*request) &&
+        !pre_verify_func_(*request)) {
       LOG(ERROR) << " check by the user func fail";
       return -2;
     }
@@ -214,8 +306,7 @@ int Commitment::ProcessProposeMsg(std::unique_ptr<Context> context,
     std::string data;
     batch_request.SerializeToString(&data);
     // check signatures
-    bool valid =
-        verifier_->VerifyMessage(request->data(), request->data_signature());
+    bool valid = VerifyBatch(*request);
     if (!valid) {
       LOG(ERROR) << "request is not valid:"
                  << request->data_signature().DebugString();
@@ -230,9 +321,8 @@ int Commitment::ProcessProposeMsg(std::unique_ptr<Context> context,
 
   global_stats_->IncPropose();
   global_stats_->RecordStateTime("pre-prepare");
-  std::unique_ptr<Request> prepare_request = resdb::NewRequest(
+  std::unique_ptr<Request> prepare_request = resdb::NewRequestWithoutData(
       Request::TYPE_PREPARE, *request, config_.GetSelfInfo().id());
-  prepare_request->clear_data();
 
   // Add request to message_manager.
   // If it has received enough same requests(2f+1), broadcast the prepare
@@ -277,8 +367,19 @@ int Commitment::ProcessPrepareMsg(std::unique_ptr<Context> context,
     if (message_manager_->GetHighestPreparedSeq() < seq) {
       message_manager_->SetHighestPreparedSeq(seq);
     }
-    // If need qc, sign the data
-    if (need_qc_ && verifier_) {
+    // If need qc, sign the data. With a threshold key, sign a share which is
+    // combined into a constant-size certificate by the collector.
+    const ThresholdSignature* threshold_signature =
+        message_manager_->GetThresholdSignature();
+    if (need_qc_ && threshold_signature && threshold_signature->CanSign()) {
+      auto signature_or =
+          threshold_signature->SignShare(commit_request->hash());
+      if (!signature_or.ok()) {
+        LOG(ERROR) << "Sign message share fail";
+        return -2;
+      }
+      *commit_request->mutable_data_signature() = *signature_or;
+    } else if (need_qc_ && verifier_) {
       auto signature_or = verifier_->SignMessage(commit_request->hash());
       if (!signature_or.ok()) {
         LOG(ERROR) << "Sign message fail";
@@ -22,7 +22,9 @@
 #include "platform/common/queue/batch_queue.h"
 #include "platform/config/resdb_config.h"
 #include "platform/consensus/execution/duplicate_manager.h"
+#include "platform/consensus/ordering/pbft/mempool_manager.h"
 #include "platform/consensus/ordering/pbft/message_manager.h"
+#include "platform/consensus/ordering/pbft/proposal_dissemination.h"
 #include "platform/consensus/ordering/pbft/response_manager.h"
 #include "platform/networkstrate/replica_communicator.h"
 #include "platform/statistic/stats.h"
@@ -45,9 +47,17 @@ class Commitment {
                                 std::unique_ptr<Request> request);
   virtual int ProcessCommitMsg(std::unique_ptr<Context> context,
                                std::unique_ptr<Request> request);
+  // Receive a shard of an erasure coded pre-prepare. Returns the pre-prepare
+  // once it is rebuilt, which is then processed by ProcessProposeMsg.
+  std::pair<std::unique_ptr<Context>, std::unique_ptr<Request>>
+  ProcessProposeChunkMsg(std::unique_ptr<Context> context,
+                         std::unique_ptr<Request> request);
 
   void SetPreVerifyFunc(std::function<bool(const Request& request)> func);
   void SetNeedCommitQC(bool need_qc);
+  // Accept the batches ordered by their hash with an availability
+  // certificate.
+  void SetMempoolManager(MempoolManager* mempool_manager);
 
   std::queue<std::pair<std::unique_ptr<Context>, std::unique_ptr<Request>>>
       request_complained_;
@@ -58,6 +68,9 @@ class Commitment {
 
  protected:
   virtual int PostProcessExecutedMsg();
+  int DisseminateProposal(const Request& pre_prepare);
+  bool IsDigestOnly(const Request& request);
+  bool VerifyBatch(const Request& request);
 
  protected:
   ResDBConfig config_;
@@ -77,6 +90,9 @@ class Commitment {
            std::pair<std::unique_ptr<Context>, std::unique_ptr<Request>>>
       pending_recovery_;
   std::unique_ptr<DuplicateManager> duplicate_manager_;
+  std::unique_ptr<ProposalDissemination> proposal_dissemination_;
+  size_t erasure_coded_min_bytes_ = 0;
+  MempoolManager* mempool_manager_ = nullptr;
 };
 
 }  // namespace resdb
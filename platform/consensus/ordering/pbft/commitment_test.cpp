@@ -41,14 +41,21 @@ using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::Test;
 
-ResDBConfig GenerateConfig() {
+ResDBConfig GenerateConfig(bool erasure_coded = false, int self_id = 1,
+                           bool need_signature = true) {
   ResConfigData data;
   data.set_duplicate_check_frequency_useconds(100000);
+  data.set_not_need_signature(!need_signature);
+  if (erasure_coded) {
+    data.set_enable_erasure_coded_proposal(true);
+    data.set_erasure_coded_min_bytes(1);
+  }
   return ResDBConfig({GenerateReplicaInfo(1, "127.0.0.1", 1234),
                       GenerateReplicaInfo(2, "127.0.0.1", 1235),
                       GenerateReplicaInfo(3, "127.0.0.1", 1236),
                       GenerateReplicaInfo(4, "127.0.0.1", 1237)},
-                     GenerateReplicaInfo(1, "127.0.0.1", 1234), data);
+                     GenerateReplicaInfo(self_id, "127.0.0.1", 1233 + self_id),
+                     data);
 }
 
 class CommitmentTest : public Test {
@@ -66,8 +73,9 @@ class CommitmentTest : public Test {
             std::make_unique<Commitment>(config_, message_manager_.get(),
                                          &replica_communicator_, &verifier_)) {}
 
-  std::unique_ptr<Context> GetContext() {
+  std::unique_ptr<Context> GetContext(int node_id = 0) {
     auto context = std::make_unique<Context>();
+    context->signature.set_node_id(node_id);
     context->signature.set_signature("signature");
     return context;
   }
@@ -175,6 +183,185 @@ TEST_F(CommitmentTest, NewRequest) {
   propose_done_future.get();
 }
 
+TEST_F(CommitmentTest, NewRequestWithAvailabilityCert) {
+  Request request;
+  request.set_hash("hash");
+  for (int id : {2, 3}) {
+    SignatureInfo* signature =
+        request.mutable_availability_cert()->add_committed_certs();
+    signature->set_node_id(id);
+    signature->set_signature("ack");
+  }
+
+  // Not accepted without the mempool.
+  EXPECT_EQ(commitment_->ProcessNewRequest(GetContext(),
+                                           std::make_unique<Request>(request)),
+            -2);
+
+  MempoolManager mempool_manager(config_, &replica_communicator_, &verifier_);
+  commitment_->SetMempoolManager(&mempool_manager);
+  EXPECT_CALL(verifier_, VerifyMessage("hash", ::testing::_))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+
+  std::promise<bool> propose_done;
+  std::future<bool> propose_done_future = propose_done.get_future();
+  EXPECT_CALL(replica_communicator_, BroadCast)
+      .WillOnce(Invoke([&](const google::protobuf::Message& message) {
+        const Request& pre_prepare = dynamic_cast<const Request&>(message);
+        EXPECT_EQ(pre_prepare.type(), Request::TYPE_PRE_PREPARE);
+        EXPECT_TRUE(pre_prepare.data().empty());
+        EXPECT_EQ(pre_prepare.availability_cert().committed_certs_size(), 2);
+        propose_done.set_value(true);
+      }));
+  EXPECT_EQ(commitment_->ProcessNewRequest(GetContext(),
+                                           std::make_unique<Request>(request)),
+            0);
+  propose_done_future.get();
+}
+
+TEST_F(CommitmentTest, NewRequestInChunks) {
+  commitment_ = nullptr;
+  commitment_ = std::make_unique<Commitment>(
+      GenerateConfig(true), message_manager_.get(), &replica_communicator_,
+      &verifier_);
+  auto context = std::make_unique<Context>();
+  context->signature.set_signature("signature");
+  Request request;
+  request.set_data(std::string(1000, 'd'));
+
+  EXPECT_CALL(verifier_,
+              VerifyMessage(::testing::_, EqualsProto(SignatureInfo())))
+      .WillOnce(Return(true));
+  EXPECT_CALL(replica_communicator_, BroadCast).Times(0);
+  std::set<int> receivers;
+  EXPECT_CALL(replica_communicator_,
+              SendMessage(::testing::_, ::testing::An<const ReplicaInfo&>()))
+      .Times(4)
+      .WillRepeatedly(Invoke([&](const google::protobuf::Message& message,
+                                 const ReplicaInfo& replica) {
+        const Request& request = dynamic_cast<const Request&>(message);
+        // The primary keeps the whole batch, the others get a shard.
+        if (replica.id() == 1) {
+          EXPECT_EQ(request.type(), Request::TYPE_PRE_PREPARE);
+        } else {
+          EXPECT_EQ(request.type(), Request::TYPE_PRE_PREPARE_CHUNK);
+          EXPECT_LT(request.data().size(), 700);
+        }
+        receivers.insert(replica.id());
+        return 0;
+      }));
+
+  EXPECT_EQ(commitment_->ProcessNewRequest(std::move(context),
+                                           std::make_unique<Request>(request)),
+            0);
+  EXPECT_EQ(receivers, std::set<int>({1, 2, 3, 4}));
+}
+
+// The chunks can not be authenticated without signatures, the whole
+// pre-prepare is broadcast instead.
+TEST_F(CommitmentTest, NoChunksWithoutSignature) {
+  commitment_ = nullptr;
+  commitment_ = std::make_unique<Commitment>(
+      GenerateConfig(true, 1, /*need_signature=*/false),
+      message_manager_.get(), &replica_communicator_, &verifier_);
+  Request request;
+  request.set_data(std::string(1000, 'd'));
+
+  EXPECT_CALL(verifier_,
+              VerifyMessage(::testing::_, EqualsProto(SignatureInfo())))
+      .WillOnce(Return(true));
+  EXPECT_CALL(replica_communicator_,
+              SendMessage(::testing::_, ::testing::An<const ReplicaInfo&>()))
+      .Times(0);
+  EXPECT_CALL(replica_communicator_, BroadCast).Times(1);
+  EXPECT_EQ(commitment_->ProcessNewRequest(GetContext(),
+                                           std::make_unique<Request>(request)),
+            0);
+}
+
+TEST_F(CommitmentTest, ProposeChunkMsgFromFakePrimary) {
+  ResDBConfig config = GenerateConfig(true, 2);
+  SystemInfo system_info(config);
+  CheckPointManager checkpoint_manager(config, &replica_communicator_,
+                                       &verifier_, &system_info);
+  MessageManager message_manager(config, nullptr, &checkpoint_manager,
+                                 &system_info);
+  Commitment commitment(config, &message_manager, &replica_communicator_,
+                        &verifier_);
+
+  Request pre_prepare;
+  pre_prepare.set_type(Request::TYPE_PRE_PREPARE);
+  pre_prepare.set_current_view(1);
+  pre_prepare.set_seq(1);
+  pre_prepare.set_sender_id(1);
+  pre_prepare.set_primary_id(1);
+  pre_prepare.set_data(std::string(1000, 'd'));
+  pre_prepare.set_hash(SignatureVerifier::CalculateHash(pre_prepare.data()));
+  std::vector<std::unique_ptr<Request>> chunks =
+      ProposalDissemination(4, 2).Split(pre_prepare);
+
+  // The replica 3 claims to be the primary in the request, but the chunk is
+  // signed by itself, so it is neither forwarded nor taken as the header.
+  EXPECT_CALL(replica_communicator_, BroadCast).Times(0);
+  auto proposal = commitment.ProcessProposeChunkMsg(
+      GetContext(3), std::make_unique<Request>(*chunks[1]));
+  EXPECT_EQ(proposal.second, nullptr);
+  proposal = commitment.ProcessProposeChunkMsg(
+      GetContext(4), std::make_unique<Request>(*chunks[2]));
+  EXPECT_EQ(proposal.second, nullptr);
+}
+
+TEST_F(CommitmentTest, ProposeChunkMsg) {
+  ResDBConfig config = GenerateConfig(true, 2);
+  SystemInfo system_info(config);
+  CheckPointManager checkpoint_manager(config, &replica_communicator_,
+                                       &verifier_, &system_info);
+  MessageManager message_manager(config, nullptr, &checkpoint_manager,
+                                 &system_info);
+  Commitment commitment(config, &message_manager, &replica_communicator_,
+                        &verifier_);
+
+  BatchUserRequest batch_request;
+  batch_request.add_user_requests()->mutable_request()->set_data(
+      std::string(1000, 'd'));
+  Request pre_prepare;
+  pre_prepare.set_type(Request::TYPE_PRE_PREPARE);
+  pre_prepare.set_current_view(1);
+  pre_prepare.set_seq(1);
+  pre_prepare.set_sender_id(1);
+  pre_prepare.set_primary_id(1);
+  batch_request.SerializeToString(pre_prepare.mutable_data());
+  pre_prepare.set_hash(SignatureVerifier::CalculateHash(pre_prepare.data()));
+  std::vector<std::unique_ptr<Request>> chunks =
+      ProposalDissemination(4, 2).Split(pre_prepare);
+
+  // The shard from the primary is forwarded to the others.
+  EXPECT_CALL(replica_communicator_, BroadCast)
+      .WillOnce(Invoke([&](const google::protobuf::Message& message) {
+        const Request& request = dynamic_cast<const Request&>(message);
+        EXPECT_EQ(request.type(), Request::TYPE_PRE_PREPARE_CHUNK);
+        EXPECT_EQ(request.sender_id(), 2);
+      }));
+  auto proposal = commitment.ProcessProposeChunkMsg(
+      GetContext(1), std::make_unique<Request>(*chunks[1]));
+  EXPECT_EQ(proposal.second, nullptr);
+
+  chunks[2]->set_sender_id(3);
+  proposal = commitment.ProcessProposeChunkMsg(GetContext(3),
+                                               std::move(chunks[2]));
+  ASSERT_NE(proposal.second, nullptr);
+  EXPECT_THAT(*proposal.second, EqualsProto(pre_prepare));
+
+  // The rebuilt pre-prepare is processed as a whole one.
+  EXPECT_CALL(verifier_, VerifyMessage(pre_prepare.data(), ::testing::_))
+      .WillOnce(Return(true));
+  EXPECT_CALL(replica_communicator_, BroadCast).Times(1);
+  EXPECT_EQ(commitment.ProcessProposeMsg(std::move(proposal.first),
+                                         std::move(proposal.second)),
+            0);
+}
+
 TEST_F(CommitmentTest, SeqConsumeAll) {
   config_.SetMaxProcessTxn(2);
   commitment_ = nullptr;
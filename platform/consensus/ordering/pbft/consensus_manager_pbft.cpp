@@ -56,6 +56,9 @@ ConsensusManagerPBFT::ConsensusManagerPBFT(
       recovery_(std::make_unique<Recovery>(config_, checkpoint_manager_.get(),
                                            system_info_.get(),
                                            message_manager_->GetStorage())),
+      retention_manager_(std::make_unique<RetentionManager>(
+          config_, checkpoint_manager_.get(), message_manager_->GetStorage(),
+          recovery_.get())),
       query_(std::make_unique<Query>(config_, recovery_.get(),
                                      std::move(query_executor))) {
   LOG(INFO) << "is running is performance mode:"
@@ -64,6 +67,16 @@ ConsensusManagerPBFT::ConsensusManagerPBFT(
 
   view_change_manager_->SetDuplicateManager(commitment_->GetDuplicateManager());
 
+  if (config_.GetConfigData().enable_mempool()) {
+    mempool_manager_ = std::make_unique<MempoolManager>(
+        config_, GetBroadCastClient(), GetSignatureVerifier());
+    message_manager_->SetMempool(mempool_manager_->GetMempool());
+    commitment_->SetMempoolManager(mempool_manager_.get());
+    if (response_manager_) {
+      response_manager_->SetMempoolManager(mempool_manager_.get());
+    }
+  }
+
   recovery_->ReadLogs(
       [&](const SystemInfoData& data) {
         LOG(ERROR) << " read data info:" << data.view()
@@ -78,6 +91,13 @@ ConsensusManagerPBFT::ConsensusManagerPBFT(
   LOG(ERROR) << " recovery is done";
 }
 
+ConsensusManagerPBFT::~ConsensusManagerPBFT() {
+  Stop();
+  if (recovery_thread_.joinable()) {
+    recovery_thread_.join();
+  }
+}
+
 void ConsensusManagerPBFT::SetNeedCommitQC(bool need_qc) {
   commitment_->SetNeedCommitQC(need_qc);
 }
@@ -161,6 +181,7 @@ int ConsensusManagerPBFT::ConsensusCommit(std::unique_ptr<Context> context,
       switch (request->type()) {
         case Request::TYPE_NEW_TXNS:
         case Request::TYPE_PRE_PREPARE:
+        case Request::TYPE_PRE_PREPARE_CHUNK:
         case Request::TYPE_PREPARE:
         case Request::TYPE_COMMIT:
           AddPendingRequest(std::move(context), std::move(request));
@@ -241,6 +262,35 @@ int ConsensusManagerPBFT::InternalConsensusCommit(
     case Request::TYPE_PRE_PREPARE:
       return commitment_->ProcessProposeMsg(std::move(context),
                                             std::move(request));
+    case Request::TYPE_PRE_PREPARE_CHUNK: {
+      auto proposal = commitment_->ProcessProposeChunkMsg(std::move(context),
+                                                          std::move(request));
+      if (proposal.second == nullptr) {
+        return 0;
+      }
+      // Log the rebuilt pre-prepare, the chunks are not logged.
+      recovery_->AddRequest(proposal.first.get(), proposal.second.get());
+      return commitment_->ProcessProposeMsg(std::move(proposal.first),
+                                            std::move(proposal.second));
+    }
+    case Request::TYPE_MEMPOOL_BATCH:
+      if (mempool_manager_ == nullptr) {
+        return 0;
+      }
+      return mempool_manager_->ProcessBatch(std::move(context),
+                                            std::move(request));
+    case Request::TYPE_MEMPOOL_ACK:
+      if (response_manager_ == nullptr) {
+        return 0;
+      }
+      return response_manager_->ProcessMempoolAck(std::move(context),
+                                                   std::move(request));
+    case Request::TYPE_MEMPOOL_FETCH:
+      if (mempool_manager_ == nullptr) {
+        return 0;
+      }
+      return mempool_manager_->ProcessFetch(std::move(context),
+                                            std::move(request));
     case Request::TYPE_PREPARE:
       return commitment_->ProcessPrepareMsg(std::move(context),
                                             std::move(request));
@@ -259,6 +309,12 @@ int ConsensusManagerPBFT::InternalConsensusCommit(
     case Request::TYPE_NEWVIEW:
       return view_change_manager_->ProcessNewView(std::move(context),
                                                   std::move(request));
+    case Request::TYPE_PREPARED_DATA_FETCH:
+      return view_change_manager_->ProcessPreparedDataFetch(
+          std::move(context), std::move(request));
+    case Request::TYPE_PREPARED_DATA:
+      return view_change_manager_->ProcessPreparedData(std::move(context),
+                                                       std::move(request));
     case Request::TYPE_QUERY:
       return query_->ProcessQuery(std::move(context), std::move(request));
     case Request::TYPE_REPLICA_STATE:
@@ -283,6 +339,9 @@ void ConsensusManagerPBFT::SetupPerformanceDataFunc(
 void ConsensusManagerPBFT::SetPreVerifyFunc(
     std::function<bool(const Request&)> func) {
   commitment_->SetPreVerifyFunc(func);
+  if (mempool_manager_) {
+    mempool_manager_->SetPreVerifyFunc(func);
+  }
 }
 
 int ConsensusManagerPBFT::ProcessRecoveryData(
@@ -23,12 +23,14 @@
 #include "platform/config/resdb_config.h"
 #include "platform/consensus/ordering/pbft/checkpoint_manager.h"
 #include "platform/consensus/ordering/pbft/commitment.h"
+#include "platform/consensus/ordering/pbft/mempool_manager.h"
 #include "platform/consensus/ordering/pbft/message_manager.h"
 #include "platform/consensus/ordering/pbft/performance_manager.h"
 #include "platform/consensus/ordering/pbft/query.h"
 #include "platform/consensus/ordering/pbft/response_manager.h"
 #include "platform/consensus/ordering/pbft/viewchange_manager.h"
 #include "platform/consensus/recovery/recovery.h"
+#include "platform/consensus/retention/retention_manager.h"
 #include "platform/networkstrate/consensus_manager.h"
 
 namespace resdb {
@@ -38,7 +40,7 @@ class ConsensusManagerPBFT : public ConsensusManager {
   ConsensusManagerPBFT(const ResDBConfig& config,
                        std::unique_ptr<TransactionManager> executor,
                        std::unique_ptr<CustomQuery> query_executor = nullptr);
-  virtual ~ConsensusManagerPBFT() = default;
+  virtual ~ConsensusManagerPBFT();
 
   int ConsensusCommit(std::unique_ptr<Context> context,
                       std::unique_ptr<Request> request) override;
@@ -78,6 +80,8 @@ class ConsensusManagerPBFT : public ConsensusManager {
  protected:
   std::unique_ptr<SystemInfo> system_info_;
   std::unique_ptr<CheckPointManager> checkpoint_manager_;
+  // Outlives message_manager_ whose executor reads its mempool.
+  std::unique_ptr<MempoolManager> mempool_manager_;
   std::unique_ptr<MessageManager> message_manager_;
   std::unique_ptr<Commitment> commitment_;
   std::unique_ptr<Query> query_;
@@ -85,6 +89,7 @@ class ConsensusManagerPBFT : public ConsensusManager {
   std::unique_ptr<PerformanceManager> performance_manager_;
   std::unique_ptr<ViewChangeManager> view_change_manager_;
   std::unique_ptr<Recovery> recovery_;
+  std::unique_ptr<RetentionManager> retention_manager_;
   Stats* global_stats_;
   std::queue<std::pair<std::unique_ptr<Context>, std::unique_ptr<Request>>>
       request_pending_;
@@ -35,19 +35,29 @@ uint32_t GetCapacity(uint32_t size) {
 LockFreeCollectorPool::LockFreeCollectorPool(const std::string& name,
                                              uint32_t size,
                                              TransactionExecutor* executor,
-                                             bool enable_viewchange)
+                                             bool enable_viewchange,
+                                             bool use_arena,
+                                             const ThresholdSignature*
+                                                 threshold_signature,
+                                             PreparedCertificateIndex*
+                                                 prepared_index)
     : name_(name),
       capacity_(GetCapacity(size * 2)),
       mask_((capacity_ << 1) - 1),
       executor_(executor),
-      enable_viewchange_(enable_viewchange) {
+      enable_viewchange_(enable_viewchange),
+      use_arena_(use_arena),
+      threshold_signature_(threshold_signature),
+      prepared_index_(prepared_index) {
   collector_.resize(capacity_ << 1);
   for (size_t i = 0; i < (capacity_ << 1); ++i) {
-    collector_[i] = std::make_unique<TransactionCollector>(i, executor_,
-                                                           enable_viewchange_);
+    collector_[i] = std::make_unique<TransactionCollector>(
+        i, executor_, enable_viewchange_, use_arena_, threshold_signature_,
+        prepared_index_);
   }
   LOG(ERROR) << "name:" << name_ << " create pool done. capacity:" << capacity_
-             << " enable viewchange:" << enable_viewchange_ << " done";
+             << " enable viewchange:" << enable_viewchange_
+             << " use arena:" << use_arena_ << " done";
 }
 
 void LockFreeCollectorPool::Reset(uint64_t start_seq) {
@@ -57,7 +67,8 @@ void LockFreeCollectorPool::Reset(uint64_t start_seq) {
   for (size_t i = 0; i < (capacity_ << 1); ++i) {
     int pos = (i + idx) % (capacity_ << 1);
     collector_[pos] = std::make_unique<TransactionCollector>(
-        seq++, executor_, enable_viewchange_);
+        seq++, executor_, enable_viewchange_, use_arena_, threshold_signature_,
+        prepared_index_);
   }
   LOG(ERROR) << " reset collector:" << start_seq;
 }
@@ -71,7 +82,8 @@ void LockFreeCollectorPool::Update(uint64_t seq) {
   LOG(ERROR) << " update:" << (idx ^ capacity_) << " seq:" << seq + capacity_
              << " cap:" << capacity_ << " update seq:" << seq;
   collector_[idx ^ capacity_] = std::make_unique<TransactionCollector>(
-      seq + capacity_, executor_, enable_viewchange_);
+      seq + capacity_, executor_, enable_viewchange_, use_arena_,
+      threshold_signature_, prepared_index_);
 }
 
 TransactionCollector* LockFreeCollectorPool::GetCollector(uint64_t seq) {
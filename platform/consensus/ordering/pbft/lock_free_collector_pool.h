@@ -27,11 +27,15 @@ namespace resdb {
 
 class LockFreeCollectorPool {
  public:
-  LockFreeCollectorPool(const std::string& name, uint32_t size,
-                        TransactionExecutor* executor,
-                        bool enable_viewchange = false);
+  LockFreeCollectorPool(
+      const std::string& name, uint32_t size, TransactionExecutor* executor,
+      bool enable_viewchange = false, bool use_arena = true,
+      const ThresholdSignature* threshold_signature = nullptr,
+      PreparedCertificateIndex* prepared_index = nullptr);
 
   TransactionCollector* GetCollector(uint64_t seq);
+  // Recycle the slot of seq for seq + capacity. The messages owned by the
+  // old collector, including its arena, are released at once.
   void Update(uint64_t seq);
   void Reset(uint64_t start_seq);
 
@@ -42,6 +46,9 @@ class LockFreeCollectorPool {
   TransactionExecutor* executor_;
   std::vector<std::unique_ptr<TransactionCollector>> collector_;
   bool enable_viewchange_;
+  bool use_arena_;
+  const ThresholdSignature* threshold_signature_;
+  PreparedCertificateIndex* prepared_index_;
 };
 
 }  // namespace resdb
@@ -0,0 +1,250 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/pbft/mempool_manager.h"
+
+#include <glog/logging.h>
+
+namespace resdb {
+
+namespace {
+
+constexpr size_t kMempoolMaxBatchNum = 4096;
+
+}  // namespace
+
+MempoolManager::MempoolManager(const ResDBConfig& config,
+                               ReplicaCommunicator* replica_communicator,
+                               SignatureVerifier* verifier)
+    : config_(config),
+      replica_communicator_(replica_communicator),
+      verifier_(verifier) {
+  mempool_max_batch_num_ = config_.GetConfigData().mempool_max_batch_num() > 0
+                               ? config_.GetConfigData().mempool_max_batch_num()
+                               : kMempoolMaxBatchNum;
+  for (const auto& replica : config_.GetReplicaInfos()) {
+    replica_ids_.insert(replica.id());
+  }
+  mempool_ =
+      std::make_unique<Mempool>(mempool_max_batch_num_, replica_ids_.size());
+  mempool_->SetFetchFunc([&](const Request& request) { Fetch(request); });
+}
+
+Mempool* MempoolManager::GetMempool() { return mempool_.get(); }
+
+void MempoolManager::SetPreVerifyFunc(
+    std::function<bool(const Request&)> func) {
+  pre_verify_func_ = func;
+}
+
+int MempoolManager::Disseminate(const Request& batch) {
+  auto request = std::make_unique<Request>();
+  request->set_type(Request::TYPE_NEW_TXNS);
+  request->set_hash(batch.hash());
+  request->set_proxy_id(batch.proxy_id());
+  request->set_sender_id(batch.sender_id());
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    PrunePending();
+    if (pending_.size() >= mempool_max_batch_num_) {
+      LOG(ERROR) << "too many batches waiting for acks:" << pending_.size();
+      return -2;
+    }
+    PendingBatch& pending = pending_[batch.hash()];
+    pending.request = std::move(request);
+    pending.stable_seq = mempool_->GetStableSeq();
+  }
+
+  Request mempool_batch(batch);
+  mempool_batch.set_type(Request::TYPE_MEMPOOL_BATCH);
+  replica_communicator_->BroadCast(mempool_batch);
+  return 0;
+}
+
+int MempoolManager::ProcessBatch(std::unique_ptr<Context> context,
+                                 std::unique_ptr<Request> request) {
+  if (context == nullptr || context->signature.signature().empty()) {
+    LOG(ERROR) << "mempool batch doesn't contain signature, reject";
+    return -2;
+  }
+  if (mempool_->Contains(request->hash())) {
+    return 0;
+  }
+  if (SignatureVerifier::CalculateHash(request->data()) != request->hash()) {
+    LOG(ERROR) << "mempool batch hash not match, from:"
+               << request->sender_id();
+    return -2;
+  }
+  if (verifier_ &&
+      !verifier_->VerifyMessage(request->data(), request->data_signature())) {
+    LOG(ERROR) << "mempool batch is not valid, from:" << request->sender_id();
+    return -2;
+  }
+  if (pre_verify_func_ && !pre_verify_func_(*request)) {
+    LOG(ERROR) << " check by the user func fail";
+    return -2;
+  }
+
+  // Only the batches sent by the replicas building them are acked. The
+  // others are the replies of the fetches of this replica.
+  bool need_ack = context->signature.node_id() == request->proxy_id();
+  if (!need_ack && !TakeFetching(request->hash())) {
+    LOG(ERROR) << "mempool batch is not fetched, from:"
+               << context->signature.node_id();
+    return -2;
+  }
+  Request ack;
+  ack.set_type(Request::TYPE_MEMPOOL_ACK);
+  ack.set_hash(request->hash());
+  ack.set_proxy_id(request->proxy_id());
+  ack.set_sender_id(config_.GetSelfInfo().id());
+  // The batches fetched to be executed are kept even if the mempool is
+  // full. The others are not acked if they can not be kept until executed.
+  if (!mempool_->Add(std::move(request), /*force=*/!need_ack) || !need_ack) {
+    return 0;
+  }
+
+  if (verifier_) {
+    auto signature_or = verifier_->SignMessage(ack.hash());
+    if (!signature_or.ok()) {
+      LOG(ERROR) << "Sign message fail";
+      return -2;
+    }
+    *ack.mutable_data_signature() = *signature_or;
+  } else {
+    ack.mutable_data_signature()->set_node_id(config_.GetSelfInfo().id());
+  }
+  replica_communicator_->SendMessage(ack, ack.proxy_id());
+  return 0;
+}
+
+std::unique_ptr<Request> MempoolManager::ProcessAck(
+    std::unique_ptr<Context> context, std::unique_ptr<Request> request) {
+  if (context == nullptr || context->signature.signature().empty()) {
+    LOG(ERROR) << "mempool ack doesn't contain signature, reject";
+    return nullptr;
+  }
+  const SignatureInfo& signature = request->data_signature();
+  if (signature.node_id() != request->sender_id() ||
+      replica_ids_.count(signature.node_id()) == 0) {
+    LOG(ERROR) << "mempool ack from an unknown replica:"
+               << request->sender_id();
+    return nullptr;
+  }
+  if (verifier_ && !verifier_->VerifyMessage(request->hash(), signature)) {
+    LOG(ERROR) << "mempool ack is not valid, from:" << request->sender_id();
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = pending_.find(request->hash());
+  if (it == pending_.end() ||
+      !it->second.acked.insert(signature.node_id()).second) {
+    return nullptr;
+  }
+  *it->second.request->mutable_availability_cert()->add_committed_certs() =
+      signature;
+  if (static_cast<int>(it->second.acked.size()) <
+      config_.GetMaxMaliciousReplicaNum() + 1) {
+    return nullptr;
+  }
+  std::unique_ptr<Request> certified = std::move(it->second.request);
+  pending_.erase(it);
+  return certified;
+}
+
+int MempoolManager::ProcessFetch(std::unique_ptr<Context> context,
+                                 std::unique_ptr<Request> request) {
+  std::unique_ptr<Request> batch = mempool_->Get(request->hash());
+  if (batch == nullptr) {
+    LOG(ERROR) << "fetched batch is not in the mempool, from:"
+               << request->sender_id();
+    return 0;
+  }
+  batch->set_sender_id(config_.GetSelfInfo().id());
+  replica_communicator_->SendMessage(*batch, request->sender_id());
+  return 0;
+}
+
+bool MempoolManager::VerifyCertificate(const Request& request) {
+  std::set<int32_t> acked;
+  for (const SignatureInfo& signature :
+       request.availability_cert().committed_certs()) {
+    if (replica_ids_.count(signature.node_id()) == 0) {
+      continue;
+    }
+    if (verifier_ && !verifier_->VerifyMessage(request.hash(), signature)) {
+      LOG(ERROR) << "availability cert is not valid, from:"
+                 << signature.node_id();
+      continue;
+    }
+    acked.insert(signature.node_id());
+  }
+  return static_cast<int>(acked.size()) >=
+         config_.GetMaxMaliciousReplicaNum() + 1;
+}
+
+// Drop the batches which did not get enough acks within two checkpoints,
+// their clients time out and resend the requests.
+void MempoolManager::PrunePending() {
+  uint64_t stable_seq = mempool_->GetStableSeq();
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (it->second.stable_seq + config_.GetCheckPointWaterMark() < stable_seq) {
+      it = pending_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t MempoolManager::GetPendingNum() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return pending_.size();
+}
+
+bool MempoolManager::TakeFetching(const std::string& hash) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return fetching_.erase(hash) > 0;
+}
+
+// Ask one of the replicas in the certificate each time, so a faulty one
+// only delays the batch until the next fetch.
+void MempoolManager::Fetch(const Request& request) {
+  const auto& certs = request.availability_cert().committed_certs();
+  if (certs.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    fetching_.insert(request.hash());
+  }
+  int64_t node_id = certs[fetch_num_++ % certs.size()].node_id();
+  if (node_id == config_.GetSelfInfo().id()) {
+    node_id = certs[fetch_num_++ % certs.size()].node_id();
+  }
+  Request fetch;
+  fetch.set_type(Request::TYPE_MEMPOOL_FETCH);
+  fetch.set_hash(request.hash());
+  fetch.set_seq(request.seq());
+  fetch.set_sender_id(config_.GetSelfInfo().id());
+  LOG(ERROR) << "fetch batch seq:" << request.seq() << " from:" << node_id;
+  replica_communicator_->SendMessage(fetch, node_id);
+}
+
+}  // namespace resdb
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "common/crypto/signature_verifier.h"
+#include "platform/config/resdb_config.h"
+#include "platform/consensus/execution/mempool.h"
+#include "platform/networkstrate/replica_communicator.h"
+#include "platform/networkstrate/server_comm.h"
+#include "platform/proto/resdb.pb.h"
+
+namespace resdb {
+
+// MempoolManager disseminates the batches of client transactions outside of
+// the consensus. Each replica broadcasts the batches it builds once to the
+// mempools of all the replicas, which store them and ack their hash. The
+// acks of f + 1 replicas form the availability certificate: at least one
+// non-faulty replica holds the batch. Only the hash and the certificate are
+// then sent to the primary and ordered, so the primary no longer uploads
+// every batch to every replica. The executor takes the payloads from the
+// local mempool and fetches the missing ones from the replicas in the
+// certificate.
+class MempoolManager {
+ public:
+  MempoolManager(const ResDBConfig& config,
+                 ReplicaCommunicator* replica_communicator,
+                 SignatureVerifier* verifier);
+
+  Mempool* GetMempool();
+
+  // The batches failing the user func are not acked.
+  void SetPreVerifyFunc(std::function<bool(const Request&)> func);
+
+  // Broadcast a TYPE_NEW_TXNS batch built by this replica. Fails if too many
+  // batches are waiting for acks.
+  int Disseminate(const Request& batch);
+
+  // Store a TYPE_MEMPOOL_BATCH message and ack it to the replica which built
+  // it.
+  int ProcessBatch(std::unique_ptr<Context> context,
+                   std::unique_ptr<Request> request);
+
+  // Collect the acks of the batches built by this replica. Returns the
+  // TYPE_NEW_TXNS request carrying the hash and the availability certificate
+  // of the batch once f + 1 replicas have acked it, nullptr otherwise.
+  std::unique_ptr<Request> ProcessAck(std::unique_ptr<Context> context,
+                                      std::unique_ptr<Request> request);
+
+  // Send the batch in the local mempool to the replica asking for it.
+  int ProcessFetch(std::unique_ptr<Context> context,
+                   std::unique_ptr<Request> request);
+
+  // Whether the availability certificate of the request holds the acks of
+  // f + 1 different replicas on its hash.
+  bool VerifyCertificate(const Request& request);
+
+  // The number of the batches of this replica waiting for acks.
+  size_t GetPendingNum();
+
+ private:
+  void Fetch(const Request& request);
+  // Whether the batch of hash is fetched by this replica, it is not fetched
+  // any more.
+  bool TakeFetching(const std::string& hash);
+  // Must be called holding mutex_.
+  void PrunePending();
+
+ private:
+  ResDBConfig config_;
+  ReplicaCommunicator* replica_communicator_;
+  SignatureVerifier* verifier_;
+  size_t mempool_max_batch_num_;
+  std::unique_ptr<Mempool> mempool_;
+  std::function<bool(const Request&)> pre_verify_func_;
+  std::set<int64_t> replica_ids_;
+
+  struct PendingBatch {
+    std::unique_ptr<Request> request;
+    std::set<int32_t> acked;
+    // The stable checkpoint of the mempool when it is disseminated.
+    uint64_t stable_seq = 0;
+  };
+  std::mutex mutex_;
+  std::map<std::string, PendingBatch> pending_;
+  // The hash of the batches fetched by the executor, which are kept even if
+  // the mempool is full.
+  std::set<std::string> fetching_;
+  std::atomic<uint64_t> fetch_num_ = 0;
+};
+
+}  // namespace resdb
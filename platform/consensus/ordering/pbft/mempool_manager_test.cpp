@@ -0,0 +1,275 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/pbft/mempool_manager.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "platform/config/resdb_config_utils.h"
+#include "platform/networkstrate/mock_replica_communicator.h"
+
+namespace resdb {
+namespace {
+
+using ::testing::_;
+using ::testing::A;
+using ::testing::Invoke;
+using ::testing::Test;
+
+ResDBConfig GenerateConfig(int self_id,
+                           ResConfigData config_data = ResConfigData()) {
+  return ResDBConfig({GenerateReplicaInfo(1, "127.0.0.1", 1234),
+                      GenerateReplicaInfo(2, "127.0.0.1", 1235),
+                      GenerateReplicaInfo(3, "127.0.0.1", 1236),
+                      GenerateReplicaInfo(4, "127.0.0.1", 1237)},
+                     GenerateReplicaInfo(self_id, "127.0.0.1", 1233 + self_id),
+                     config_data);
+}
+
+// The context of a message sent by the replica node_id.
+std::unique_ptr<Context> GetContext(int64_t node_id = 1) {
+  auto context = std::make_unique<Context>();
+  context->signature.set_signature("signature");
+  context->signature.set_node_id(node_id);
+  return context;
+}
+
+// A batch built by the replica 1.
+Request GetBatch(const std::string& data = "batch data") {
+  Request batch;
+  batch.set_type(Request::TYPE_NEW_TXNS);
+  batch.set_data(data);
+  batch.set_hash(SignatureVerifier::CalculateHash(batch.data()));
+  batch.set_sender_id(1);
+  batch.set_proxy_id(1);
+  return batch;
+}
+
+class MempoolManagerTest : public Test {
+ public:
+  MempoolManagerTest() {
+    for (int i = 1; i <= 4; ++i) {
+      managers_.push_back(std::make_unique<MempoolManager>(
+          GenerateConfig(i), &replica_communicator_, nullptr));
+    }
+  }
+
+  // The ack of the replica id on the batch.
+  std::unique_ptr<Request> GetAck(int id, const Request& batch) {
+    std::unique_ptr<Request> ack;
+    EXPECT_CALL(replica_communicator_, SendMessage(_, 1))
+        .WillOnce(Invoke([&](const google::protobuf::Message& message,
+                             int64_t node_id) {
+          ack = std::make_unique<Request>(
+              dynamic_cast<const Request&>(message));
+        }));
+    EXPECT_EQ(managers_[id - 1]->ProcessBatch(
+                  GetContext(), std::make_unique<Request>(batch)),
+              0);
+    return ack;
+  }
+
+ protected:
+  MockReplicaCommunicator replica_communicator_;
+  std::vector<std::unique_ptr<MempoolManager>> managers_;
+};
+
+TEST_F(MempoolManagerTest, CertifyBatch) {
+  Request mempool_batch;
+  EXPECT_CALL(replica_communicator_, BroadCast)
+      .WillOnce(Invoke([&](const google::protobuf::Message& message) {
+        mempool_batch = dynamic_cast<const Request&>(message);
+      }));
+  EXPECT_EQ(managers_[0]->Disseminate(GetBatch()), 0);
+  EXPECT_EQ(mempool_batch.type(), Request::TYPE_MEMPOOL_BATCH);
+  EXPECT_EQ(mempool_batch.data(), GetBatch().data());
+  EXPECT_EQ(managers_[0]->GetPendingNum(), 1);
+
+  std::unique_ptr<Request> ack = GetAck(2, mempool_batch);
+  ASSERT_NE(ack, nullptr);
+  EXPECT_EQ(ack->type(), Request::TYPE_MEMPOOL_ACK);
+  EXPECT_EQ(ack->sender_id(), 2);
+  EXPECT_TRUE(managers_[1]->GetMempool()->Contains(GetBatch().hash()));
+
+  EXPECT_EQ(managers_[0]->ProcessAck(GetContext(),
+                                     std::make_unique<Request>(*ack)),
+            nullptr);
+  // The same replica does not count twice.
+  EXPECT_EQ(managers_[0]->ProcessAck(GetContext(),
+                                     std::make_unique<Request>(*ack)),
+            nullptr);
+
+  std::unique_ptr<Request> certified = managers_[0]->ProcessAck(
+      GetContext(), GetAck(3, mempool_batch));
+  ASSERT_NE(certified, nullptr);
+  EXPECT_EQ(certified->type(), Request::TYPE_NEW_TXNS);
+  EXPECT_EQ(certified->hash(), GetBatch().hash());
+  EXPECT_TRUE(certified->data().empty());
+  EXPECT_EQ(certified->availability_cert().committed_certs_size(), 2);
+  EXPECT_EQ(managers_[0]->GetPendingNum(), 0);
+
+  EXPECT_TRUE(managers_[3]->VerifyCertificate(*certified));
+  Request request(*certified);
+  request.mutable_availability_cert()->mutable_committed_certs()->RemoveLast();
+  EXPECT_FALSE(managers_[3]->VerifyCertificate(request));
+  // Acks from the replicas out of the configuration are not counted.
+  request.mutable_availability_cert()->add_committed_certs()->set_node_id(9);
+  EXPECT_FALSE(managers_[3]->VerifyCertificate(request));
+}
+
+TEST_F(MempoolManagerTest, RejectBatch) {
+  Request batch = GetBatch();
+  batch.set_type(Request::TYPE_MEMPOOL_BATCH);
+  batch.set_hash("bad hash");
+  EXPECT_CALL(replica_communicator_, SendMessage(_, A<int64_t>())).Times(0);
+  EXPECT_EQ(managers_[1]->ProcessBatch(GetContext(),
+                                       std::make_unique<Request>(batch)),
+            -2);
+  EXPECT_EQ(managers_[1]->ProcessBatch(std::make_unique<Context>(),
+                                       std::make_unique<Request>(GetBatch())),
+            -2);
+
+  managers_[1]->SetPreVerifyFunc([](const Request&) { return false; });
+  EXPECT_EQ(managers_[1]->ProcessBatch(GetContext(),
+                                       std::make_unique<Request>(GetBatch())),
+            -2);
+  EXPECT_EQ(managers_[1]->GetMempool()->Size(), 0);
+}
+
+TEST_F(MempoolManagerTest, FetchMissingBatch) {
+  Request mempool_batch = GetBatch();
+  mempool_batch.set_type(Request::TYPE_MEMPOOL_BATCH);
+  std::unique_ptr<Request> ack = GetAck(2, mempool_batch);
+
+  // The batch is ordered by its hash with the ack of the replica 2.
+  Request ordered;
+  ordered.set_type(Request::TYPE_PRE_PREPARE);
+  ordered.set_seq(1);
+  ordered.set_hash(GetBatch().hash());
+  *ordered.mutable_availability_cert()->add_committed_certs() =
+      ack->data_signature();
+
+  std::unique_ptr<Request> fetch;
+  EXPECT_CALL(replica_communicator_, SendMessage(_, 2))
+      .WillOnce(Invoke([&](const google::protobuf::Message& message,
+                           int64_t node_id) {
+        fetch =
+            std::make_unique<Request>(dynamic_cast<const Request&>(message));
+      }));
+  EXPECT_FALSE(managers_[3]->GetMempool()->FillData(&ordered, 1000));
+  ASSERT_NE(fetch, nullptr);
+  EXPECT_EQ(fetch->type(), Request::TYPE_MEMPOOL_FETCH);
+  EXPECT_EQ(fetch->sender_id(), 4);
+
+  std::unique_ptr<Request> fetched;
+  EXPECT_CALL(replica_communicator_, SendMessage(_, 4))
+      .WillOnce(Invoke([&](const google::protobuf::Message& message,
+                           int64_t node_id) {
+        fetched =
+            std::make_unique<Request>(dynamic_cast<const Request&>(message));
+      }));
+  EXPECT_EQ(managers_[1]->ProcessFetch(GetContext(4), std::move(fetch)), 0);
+  ASSERT_NE(fetched, nullptr);
+  EXPECT_EQ(fetched->sender_id(), 2);
+
+  // The fetched batch is stored without acking.
+  EXPECT_EQ(managers_[3]->ProcessBatch(GetContext(2), std::move(fetched)), 0);
+  EXPECT_TRUE(managers_[3]->GetMempool()->FillData(&ordered, 0));
+  EXPECT_EQ(ordered.data(), GetBatch().data());
+}
+
+TEST_F(MempoolManagerTest, BoundedBatches) {
+  ResConfigData config_data;
+  config_data.set_mempool_max_batch_num(1);
+  MempoolManager manager(GenerateConfig(2, config_data),
+                         &replica_communicator_, nullptr);
+
+  // Only one batch of this replica waits for acks.
+  EXPECT_CALL(replica_communicator_, BroadCast).Times(1);
+  EXPECT_EQ(manager.Disseminate(GetBatch("batch 1")), 0);
+  EXPECT_EQ(manager.Disseminate(GetBatch("batch 2")), -2);
+  EXPECT_EQ(manager.GetPendingNum(), 1);
+
+  // A full mempool does not ack new batches.
+  Request batch1 = GetBatch("batch 1");
+  batch1.set_type(Request::TYPE_MEMPOOL_BATCH);
+  Request batch2 = GetBatch("batch 2");
+  batch2.set_type(Request::TYPE_MEMPOOL_BATCH);
+  EXPECT_CALL(replica_communicator_, SendMessage(_, 1)).Times(1);
+  EXPECT_EQ(manager.ProcessBatch(GetContext(),
+                                 std::make_unique<Request>(batch1)),
+            0);
+  EXPECT_EQ(manager.ProcessBatch(GetContext(),
+                                 std::make_unique<Request>(batch2)),
+            0);
+  EXPECT_FALSE(manager.GetMempool()->Contains(batch2.hash()));
+
+  // A batch sent by a replica not building it is only kept if it is
+  // fetched.
+  batch2.set_sender_id(3);
+  EXPECT_EQ(manager.ProcessBatch(GetContext(3),
+                                 std::make_unique<Request>(batch2)),
+            -2);
+  EXPECT_FALSE(manager.GetMempool()->Contains(batch2.hash()));
+
+  // A batch fetched to be executed is always kept.
+  Request ordered;
+  ordered.set_seq(1);
+  ordered.set_hash(batch2.hash());
+  ordered.mutable_availability_cert()->add_committed_certs()->set_node_id(3);
+  EXPECT_CALL(replica_communicator_, SendMessage(_, 3)).Times(1);
+  EXPECT_FALSE(manager.GetMempool()->FillData(&ordered, 0));
+  EXPECT_EQ(manager.ProcessBatch(GetContext(3),
+                                 std::make_unique<Request>(batch2)),
+            0);
+  EXPECT_TRUE(manager.GetMempool()->Contains(batch2.hash()));
+}
+
+TEST_F(MempoolManagerTest, BuilderShare) {
+  ResConfigData config_data;
+  config_data.set_mempool_max_batch_num(4);
+  MempoolManager manager(GenerateConfig(2, config_data),
+                         &replica_communicator_, nullptr);
+
+  // Each of the 4 builders holds one batch.
+  auto get_batch = [](const std::string& data, int builder) {
+    Request batch = GetBatch(data);
+    batch.set_type(Request::TYPE_MEMPOOL_BATCH);
+    batch.set_sender_id(builder);
+    batch.set_proxy_id(builder);
+    return std::make_unique<Request>(batch);
+  };
+  EXPECT_CALL(replica_communicator_, SendMessage(_, 3)).Times(1);
+  EXPECT_EQ(manager.ProcessBatch(GetContext(3), get_batch("batch 1", 3)), 0);
+  EXPECT_EQ(manager.ProcessBatch(GetContext(3), get_batch("batch 2", 3)), 0);
+  EXPECT_EQ(manager.GetMempool()->Size(), 1);
+
+  // A builder can not claim another one's batch.
+  EXPECT_EQ(manager.ProcessBatch(GetContext(3), get_batch("batch 3", 1)),
+            -2);
+
+  // The full share of the replica 3 does not block the others.
+  EXPECT_CALL(replica_communicator_, SendMessage(_, 1)).Times(1);
+  EXPECT_EQ(manager.ProcessBatch(GetContext(1), get_batch("batch 3", 1)), 0);
+  EXPECT_EQ(manager.GetMempool()->Size(), 2);
+}
+
+}  // namespace
+}  // namespace resdb
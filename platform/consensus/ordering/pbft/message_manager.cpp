@@ -33,6 +33,10 @@ MessageManager::MessageManager(
       queue_("executed"),
       system_info_(system_info),
       checkpoint_manager_(checkpoint_manager),
+      threshold_signature_(config.GetThresholdKeyShare()
+                               ? std::make_unique<ThresholdSignature>(
+                                     *config.GetThresholdKeyShare())
+                               : nullptr),
       transaction_executor_(std::make_unique<TransactionExecutor>(
           config,
           [&](std::unique_ptr<Request> request,
@@ -47,6 +51,12 @@ MessageManager::MessageManager(
             resp_msg->set_seq(request->seq());
             resp_msg->set_current_view(request->current_view());
             resp_msg->set_primary_id(GetCurrentPrimary());
+            if (request->committed_certs().has_quorum_cert()) {
+              // Let the client verify the batch is committed.
+              resp_msg->set_hash(request->hash());
+              *resp_msg->mutable_quorum_cert() =
+                  request->committed_certs().quorum_cert();
+            }
             if (transaction_executor_->NeedResponse() &&
                 resp_msg->proxy_id() != 0) {
               queue_.Push(std::move(resp_msg));
@@ -58,10 +68,21 @@ MessageManager::MessageManager(
           system_info_, std::move(transaction_manager))),
       collector_pool_(std::make_unique<LockFreeCollectorPool>(
           "txn", config_.GetMaxProcessTxn(), transaction_executor_.get(),
-          config_.GetConfigData().enable_viewchange())) {
+          config_.GetConfigData().enable_viewchange(), /*use_arena=*/true,
+          threshold_signature_.get(),
+          config_.GetConfigData().enable_viewchange() ? &prepared_index_
+                                                      : nullptr)) {
   global_stats_ = Stats::GetGlobalStats();
-  transaction_executor_->SetSeqUpdateNotifyFunc(
-      [&](uint64_t seq) { collector_pool_->Update(seq - 1); });
+  transaction_executor_->SetSeqUpdateNotifyFunc([&](uint64_t seq) {
+    collector_pool_->Update(seq - 1);
+    if (seq % config_.GetCheckPointWaterMark() == 0) {
+      uint64_t stable_seq = checkpoint_manager_->GetStableCheckpoint();
+      prepared_index_.Prune(stable_seq);
+      if (mempool_ != nullptr) {
+        mempool_->Prune(stable_seq);
+      }
+    }
+  });
   checkpoint_manager_->SetExecutor(transaction_executor_.get());
   checkpoint_manager_->SetResetExecute(
       [&](uint64_t seq) { SetNextCommitSeq(seq); });
@@ -219,6 +240,19 @@ std::vector<RequestInfo> MessageManager::GetPreparedProof(uint64_t seq) {
   return collector_pool_->GetCollector(seq)->GetPreparedProof();
 }
 
+PreparedCertificateIndex* MessageManager::GetPreparedCertificateIndex() {
+  return &prepared_index_;
+}
+
+bool MessageManager::GetPreparedData(uint64_t seq, const std::string& hash,
+                                     std::string* data) {
+  TransactionCollector* collector = collector_pool_->GetCollector(seq);
+  if (collector->Seq() != seq) {
+    return false;
+  }
+  return collector->GetPreparedData(hash, data);
+}
+
 int MessageManager::GetReplicaState(ReplicaState* state) {
   *state->mutable_replica_config() = config_.GetConfigData();
   return 0;
@@ -266,6 +300,11 @@ void MessageManager::SetDuplicateManager(DuplicateManager* manager) {
   transaction_executor_->SetDuplicateManager(manager);
 }
 
+void MessageManager::SetMempool(Mempool* mempool) {
+  mempool_ = mempool;
+  transaction_executor_->SetMempool(mempool);
+}
+
 void MessageManager::SendResponse(std::unique_ptr<Request> request) {
   std::unique_ptr<BatchUserResponse> response =
       std::make_unique<BatchUserResponse>();
@@ -281,6 +320,10 @@ void MessageManager::SendResponse(std::unique_ptr<Request> request) {
   }
 }
 
+const ThresholdSignature* MessageManager::GetThresholdSignature() const {
+  return threshold_signature_.get();
+}
+
 LockFreeCollectorPool* MessageManager::GetCollectorPool() {
   return collector_pool_.get();
 }
@@ -77,6 +77,13 @@ class MessageManager {
   // pre-prepare messages.
   std::vector<RequestInfo> GetPreparedProof(uint64_t seq);
 
+  // The prepared certificates registered by the collectors, used to build
+  // the view change messages.
+  PreparedCertificateIndex* GetPreparedCertificateIndex();
+  // Get the payload of a prepared seq if the collector still holds it.
+  bool GetPreparedData(uint64_t seq, const std::string& hash,
+                       std::string* data);
+
   void SetNextCommitSeq(int seq);
 
   // =============  System information ========
@@ -102,11 +109,15 @@ class MessageManager {
   void SetHighestPreparedSeq(uint64_t seq);
 
   void SetDuplicateManager(DuplicateManager* manager);
+  void SetMempool(Mempool* mempool);
 
   void SendResponse(std::unique_ptr<Request> request);
 
   LockFreeCollectorPool* GetCollectorPool();
 
+  // Returns nullptr if the replica does not own a threshold key share.
+  const ThresholdSignature* GetThresholdSignature() const;
+
  private:
   bool IsValidMsg(const Request& request);
 
@@ -122,11 +133,15 @@ class MessageManager {
   ChainState* txn_db_;
   SystemInfo* system_info_;
   CheckPointManager* checkpoint_manager_;
+  // Pruned at the stable checkpoints, nullptr if the mempool is disabled.
+  Mempool* mempool_ = nullptr;
   std::map<uint64_t, std::vector<std::unique_ptr<RequestInfo>>>
       committed_proof_;
   std::map<uint64_t, Request> committed_data_;
 
   std::mutex data_mutex_, seq_mutex_;
+  PreparedCertificateIndex prepared_index_;
+  std::unique_ptr<ThresholdSignature> threshold_signature_;
   std::unique_ptr<TransactionExecutor> transaction_executor_;
   std::unique_ptr<LockFreeCollectorPool> collector_pool_;
 
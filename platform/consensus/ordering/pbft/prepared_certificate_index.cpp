@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/pbft/prepared_certificate_index.h"
+
+#include <vector>
+
+namespace resdb {
+
+void PreparedCertificateIndex::Add(uint64_t seq, std::string digest,
+                                   std::string data) {
+  auto cert = std::make_shared<PreparedCertificate>();
+  cert->seq = seq;
+  cert->digest = std::move(digest);
+  cert->data = std::move(data);
+  std::lock_guard<std::mutex> lk(mutex_);
+  certs_[seq] = std::move(cert);
+}
+
+std::shared_ptr<const PreparedCertificate> PreparedCertificateIndex::Get(
+    uint64_t seq) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = certs_.find(seq);
+  if (it == certs_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+int PreparedCertificateIndex::AppendTo(uint64_t min_seq, uint64_t max_seq,
+                                       std::string* data) {
+  std::vector<std::shared_ptr<const PreparedCertificate>> certs;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (auto it = certs_.upper_bound(min_seq);
+         it != certs_.end() && it->first <= max_seq; ++it) {
+      certs.push_back(it->second);
+    }
+  }
+  // Append outside the lock, the certificates are immutable.
+  for (const auto& cert : certs) {
+    data->append(cert->data);
+  }
+  return certs.size();
+}
+
+void PreparedCertificateIndex::Prune(uint64_t seq) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  certs_.erase(certs_.begin(), certs_.upper_bound(seq));
+}
+
+size_t PreparedCertificateIndex::Size() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return certs_.size();
+}
+
+}  // namespace resdb
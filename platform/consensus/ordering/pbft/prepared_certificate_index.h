@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace resdb {
+
+// The prepared certificate of a seq. data is a serialized ViewChangeMessage
+// holding only the PreparedMessage of seq, so that it can be appended to a
+// serialized ViewChangeMessage as is.
+struct PreparedCertificate {
+  uint64_t seq;
+  std::string digest;
+  std::string data;
+};
+
+// PreparedCertificateIndex keeps the prepared certificates registered by the
+// collectors once their seqs reach READY_COMMIT. A view change message is
+// built from it in O(in-flight) without copying the proofs out of the
+// collectors.
+class PreparedCertificateIndex {
+ public:
+  PreparedCertificateIndex() = default;
+
+  // A certificate from a later view replaces the old one.
+  void Add(uint64_t seq, std::string digest, std::string data);
+  std::shared_ptr<const PreparedCertificate> Get(uint64_t seq);
+
+  // Append the certificates of (min_seq, max_seq] to a serialized
+  // ViewChangeMessage. Returns the number of certificates appended.
+  int AppendTo(uint64_t min_seq, uint64_t max_seq, std::string* data);
+
+  // Drop the certificates up to seq, e.g. the stable checkpoint.
+  void Prune(uint64_t seq);
+  size_t Size();
+
+ private:
+  std::mutex mutex_;
+  std::map<uint64_t, std::shared_ptr<const PreparedCertificate>> certs_;
+};
+
+}  // namespace resdb
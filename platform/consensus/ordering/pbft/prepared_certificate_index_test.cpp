@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/pbft/prepared_certificate_index.h"
+
+#include <gtest/gtest.h>
+
+#include "platform/proto/viewchange_message.pb.h"
+
+namespace resdb {
+namespace {
+
+std::string NewCertificate(uint64_t seq, const std::string& hash) {
+  ViewChangeMessage message;
+  PreparedMessage* prepared = message.add_prepared_msg();
+  prepared->set_seq(seq);
+  for (int i = 1; i <= 3; ++i) {
+    PreparedProof* proof = prepared->add_proof();
+    proof->mutable_request()->set_seq(seq);
+    proof->mutable_request()->set_hash(hash);
+    proof->mutable_request()->set_sender_id(i);
+    proof->mutable_signature()->set_node_id(i);
+  }
+  return message.SerializeAsString();
+}
+
+TEST(PreparedCertificateIndexTest, AppendToViewChangeMessage) {
+  PreparedCertificateIndex index;
+  for (uint64_t seq = 1; seq <= 10; ++seq) {
+    index.Add(seq, "hash" + std::to_string(seq),
+              NewCertificate(seq, "hash" + std::to_string(seq)));
+  }
+
+  ViewChangeMessage header;
+  header.set_view_number(2);
+  header.mutable_stable_ckpt()->set_seq(3);
+  std::string data = header.SerializeAsString();
+  EXPECT_EQ(index.AppendTo(3, 7, &data), 4);
+
+  ViewChangeMessage message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(message.view_number(), 2);
+  EXPECT_EQ(message.stable_ckpt().seq(), 3);
+  ASSERT_EQ(message.prepared_msg_size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(message.prepared_msg(i).seq(), i + 4);
+    ASSERT_EQ(message.prepared_msg(i).proof_size(), 3);
+    EXPECT_EQ(message.prepared_msg(i).proof(0).request().hash(),
+              "hash" + std::to_string(i + 4));
+  }
+}
+
+TEST(PreparedCertificateIndexTest, ReplaceAndPrune) {
+  PreparedCertificateIndex index;
+  index.Add(1, "hash1", NewCertificate(1, "hash1"));
+  index.Add(2, "hash2", NewCertificate(2, "hash2"));
+  index.Add(2, "hash2'", NewCertificate(2, "hash2'"));
+  EXPECT_EQ(index.Size(), 2);
+  EXPECT_EQ(index.Get(2)->digest, "hash2'");
+
+  auto cert = index.Get(1);
+  index.Prune(1);
+  EXPECT_EQ(index.Size(), 1);
+  EXPECT_EQ(index.Get(1), nullptr);
+  // The pruned certificate stays valid for its readers.
+  EXPECT_EQ(cert->digest, "hash1");
+}
+
+}  // namespace
+}  // namespace resdb
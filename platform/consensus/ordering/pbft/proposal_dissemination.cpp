@@ -0,0 +1,201 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/pbft/proposal_dissemination.h"
+
+#include <glog/logging.h>
+
+#include "common/crypto/signature_verifier.h"
+
+namespace resdb {
+
+namespace {
+
+// Only the proposals within kMaxPendingSeq seqs of the latest seq proposed
+// by the primary are kept.
+constexpr uint64_t kMaxPendingSeq = 1024;
+
+}  // namespace
+
+ProposalDissemination::ProposalDissemination(int replica_num,
+                                             int data_shard_num)
+    : replica_num_(replica_num),
+      data_shard_num_(data_shard_num),
+      rs_(data_shard_num, replica_num - data_shard_num) {}
+
+std::vector<std::unique_ptr<Request>> ProposalDissemination::Split(
+    const Request& pre_prepare) {
+  std::vector<std::string> shards = rs_.Encode(pre_prepare.data());
+  ProposalChunk chunk;
+  *chunk.mutable_header() = pre_prepare;
+  chunk.mutable_header()->clear_data();
+  chunk.set_data_shard_num(data_shard_num_);
+  chunk.set_data_size(pre_prepare.data().size());
+  for (const std::string& shard : shards) {
+    chunk.add_shard_hashes(SignatureVerifier::CalculateHash(shard));
+  }
+
+  std::vector<std::unique_ptr<Request>> chunks;
+  for (int i = 0; i < replica_num_; ++i) {
+    chunk.set_index(i);
+    chunk.mutable_shard()->swap(shards[i]);
+    auto request = std::make_unique<Request>();
+    request->set_type(Request::TYPE_PRE_PREPARE_CHUNK);
+    request->set_current_view(pre_prepare.current_view());
+    request->set_seq(pre_prepare.seq());
+    request->set_hash(pre_prepare.hash());
+    request->set_sender_id(pre_prepare.sender_id());
+    request->set_primary_id(pre_prepare.primary_id());
+    chunk.SerializeToString(request->mutable_data());
+    chunks.push_back(std::move(request));
+  }
+  return chunks;
+}
+
+std::pair<std::unique_ptr<Context>, std::unique_ptr<Request>>
+ProposalDissemination::AddChunk(std::unique_ptr<Context> context,
+                                const Request& request, bool from_primary) {
+  auto chunk = std::make_unique<ProposalChunk>();
+  if (!chunk->ParseFromString(request.data()) ||
+      chunk->index() >= static_cast<uint32_t>(replica_num_)) {
+    LOG(ERROR) << "invalid proposal chunk from:" << request.sender_id();
+    return std::make_pair(nullptr, nullptr);
+  }
+
+  uint64_t seq = request.seq();
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (seq + kMaxPendingSeq < max_seq_ ||
+      (!from_primary && seq > max_seq_ + kMaxPendingSeq)) {
+    return std::make_pair(nullptr, nullptr);
+  }
+
+  auto it = proposals_.find(seq);
+  if (it != proposals_.end() && it->second.hash != request.hash()) {
+    // Only one digest is kept for each seq. The forwarded chunks can not
+    // replace it, the primary of a newer view can.
+    if (!from_primary || (it->second.view >= request.current_view() &&
+                          it->second.header != nullptr)) {
+      return std::make_pair(nullptr, nullptr);
+    }
+    proposals_.erase(it);
+    it = proposals_.end();
+  }
+  if (it == proposals_.end()) {
+    it = proposals_.emplace(seq, Proposal()).first;
+    it->second.hash = request.hash();
+    it->second.view = request.current_view();
+  }
+  Proposal& proposal = it->second;
+  if (proposal.done) {
+    return std::make_pair(nullptr, nullptr);
+  }
+  if (from_primary) {
+    if (proposal.header != nullptr) {
+      return std::make_pair(nullptr, nullptr);
+    }
+    if (chunk->header().seq() != seq ||
+        chunk->header().hash() != request.hash() ||
+        chunk->data_shard_num() != static_cast<uint32_t>(data_shard_num_) ||
+        chunk->shard_hashes_size() != replica_num_) {
+      LOG(ERROR) << "invalid proposal header, seq:" << seq;
+      return std::make_pair(nullptr, nullptr);
+    }
+    proposal.context = std::move(context);
+    proposal.view = request.current_view();
+    proposal.header = std::make_unique<ProposalChunk>(*chunk);
+    proposal.header->clear_shard();
+    proposal.shards.resize(replica_num_);
+    AddShard(&proposal, std::move(chunk));
+    for (auto& unchecked : proposal.unchecked) {
+      AddShard(&proposal, std::move(unchecked.second));
+    }
+    proposal.unchecked.clear();
+    if (seq > max_seq_) {
+      max_seq_ = seq;
+      Prune();
+    }
+  } else if (proposal.header == nullptr) {
+    // A faulty sender can only hold one shard of each index, it can not
+    // take the room of the others.
+    int32_t sender_id =
+        context != nullptr ? context->signature.node_id() : request.sender_id();
+    proposal.unchecked.emplace(std::make_pair(sender_id, chunk->index()),
+                               std::move(chunk));
+    return std::make_pair(nullptr, nullptr);
+  } else {
+    AddShard(&proposal, std::move(chunk));
+  }
+
+  if (proposal.shard_num < data_shard_num_) {
+    return std::make_pair(nullptr, nullptr);
+  }
+  // Keep the shards if the rebuild fails, the shards received later may
+  // rebuild it.
+  std::unique_ptr<Request> pre_prepare = Rebuild(&proposal);
+  if (pre_prepare == nullptr) {
+    return std::make_pair(nullptr, nullptr);
+  }
+  proposal.done = true;
+  std::unique_ptr<Context> primary_context = std::move(proposal.context);
+  proposal.shards.clear();
+  proposal.header = nullptr;
+  return std::make_pair(std::move(primary_context), std::move(pre_prepare));
+}
+
+void ProposalDissemination::AddShard(Proposal* proposal,
+                                     std::unique_ptr<ProposalChunk> chunk) {
+  uint32_t index = chunk->index();
+  if (!proposal->shards[index].empty() || chunk->shard().empty() ||
+      SignatureVerifier::CalculateHash(chunk->shard()) !=
+          proposal->header->shard_hashes(index)) {
+    return;
+  }
+  proposal->shards[index] = std::move(*chunk->mutable_shard());
+  proposal->shard_num++;
+}
+
+std::unique_ptr<Request> ProposalDissemination::Rebuild(Proposal* proposal) {
+  auto pre_prepare = std::make_unique<Request>(proposal->header->header());
+  if (!rs_.Decode(proposal->shards, proposal->header->data_size(),
+                  pre_prepare->mutable_data()) ||
+      SignatureVerifier::CalculateHash(pre_prepare->data()) !=
+          pre_prepare->hash()) {
+    LOG(ERROR) << "rebuild proposal fail, seq:" << pre_prepare->seq();
+    return nullptr;
+  }
+  return pre_prepare;
+}
+
+void ProposalDissemination::Prune() {
+  while (!proposals_.empty() &&
+         proposals_.begin()->first + kMaxPendingSeq < max_seq_) {
+    proposals_.erase(proposals_.begin());
+  }
+}
+
+size_t ProposalDissemination::GetPendingNum() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  size_t num = 0;
+  for (const auto& proposal : proposals_) {
+    num += !proposal.second.done;
+  }
+  return num;
+}
+
+}  // namespace resdb
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+
+#include "common/utils/reed_solomon.h"
+#include "platform/networkstrate/server_comm.h"
+#include "platform/proto/resdb.pb.h"
+
+namespace resdb {
+
+// ProposalDissemination spreads the data of a large pre-prepare by erasure
+// coding instead of sending the whole batch to every replica. The primary
+// encodes the data into one shard per replica, f + 1 data shards and the
+// rest parity, and sends each replica its own shard. The replicas forward
+// their shards to each other and rebuild the pre-prepare from any f + 1 of
+// them, so the primary uploads O(B) bytes instead of O(n * B). The votes
+// only carry the digest of the batch as before.
+//
+// The header and the shard hashes are only taken from the chunk sent by the
+// primary. The forwarded shards are checked against the shard hashes and
+// the rebuilt data against the digest of the pre-prepare. The proposals are
+// bounded by a window around the latest seq proposed by the primary.
+class ProposalDissemination {
+ public:
+  ProposalDissemination(int replica_num, int data_shard_num);
+
+  // The chunks of the pre-prepare, the chunk i is for the replica i in the
+  // configuration order.
+  std::vector<std::unique_ptr<Request>> Split(const Request& pre_prepare);
+
+  // Add a TYPE_PRE_PREPARE_CHUNK message. from_primary tells whether it is
+  // the chunk signed by the primary, the context carries the signature of
+  // its sender. Returns the rebuilt pre-prepare with the
+  // context of the primary's chunk once enough shards are received, or
+  // nullptrs otherwise.
+  std::pair<std::unique_ptr<Context>, std::unique_ptr<Request>> AddChunk(
+      std::unique_ptr<Context> context, const Request& request,
+      bool from_primary);
+
+  // The number of the proposals being rebuilt.
+  size_t GetPendingNum();
+
+ private:
+  struct Proposal {
+    std::string hash;
+    uint64_t view = 0;
+    std::unique_ptr<Context> context;
+    std::unique_ptr<ProposalChunk> header;
+    // The shards checked against the shard hashes.
+    std::vector<std::string> shards;
+    int shard_num = 0;
+    // The shards forwarded before the chunk of the primary, the first one
+    // of each <sender, index>.
+    std::map<std::pair<int32_t, uint32_t>, std::unique_ptr<ProposalChunk>>
+        unchecked;
+    bool done = false;
+  };
+
+  void AddShard(Proposal* proposal, std::unique_ptr<ProposalChunk> chunk);
+  std::unique_ptr<Request> Rebuild(Proposal* proposal);
+  void Prune();
+
+ private:
+  int replica_num_;
+  int data_shard_num_;
+  ReedSolomon rs_;
+  std::mutex mutex_;
+  // Indexed by the seq of the pre-prepares, one digest for each seq.
+  std::map<uint64_t, Proposal> proposals_;
+  // The latest seq proposed by the primary.
+  uint64_t max_seq_ = 0;
+};
+
+}  // namespace resdb
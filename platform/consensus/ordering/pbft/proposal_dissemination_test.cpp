@@ -0,0 +1,206 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/pbft/proposal_dissemination.h"
+
+#include <gtest/gtest.h>
+
+#include "common/crypto/signature_verifier.h"
+
+namespace resdb {
+namespace {
+
+Request GetPrePrepare(size_t size) {
+  Request request;
+  request.set_type(Request::TYPE_PRE_PREPARE);
+  request.set_seq(1);
+  request.set_sender_id(1);
+  request.set_primary_id(1);
+  for (size_t i = 0; i < size; ++i) {
+    request.mutable_data()->push_back('a' + i % 26);
+  }
+  request.set_hash(SignatureVerifier::CalculateHash(request.data()));
+  return request;
+}
+
+std::unique_ptr<Context> GetContext(int sender_id) {
+  auto context = std::make_unique<Context>();
+  context->signature.set_node_id(sender_id);
+  context->signature.set_signature("sign");
+  return context;
+}
+
+// Forward the chunk as the replica sender_id.
+std::unique_ptr<Request> Forward(const Request& chunk, int sender_id) {
+  auto request = std::make_unique<Request>(chunk);
+  request->set_sender_id(sender_id);
+  return request;
+}
+
+TEST(ProposalDisseminationTest, SplitAndRebuild) {
+  // n = 4, f = 1.
+  ProposalDissemination primary(4, 2), replica(4, 2);
+  Request pre_prepare = GetPrePrepare(1000);
+  std::vector<std::unique_ptr<Request>> chunks = primary.Split(pre_prepare);
+  ASSERT_EQ(chunks.size(), 4);
+  for (const auto& chunk : chunks) {
+    EXPECT_EQ(chunk->type(), Request::TYPE_PRE_PREPARE_CHUNK);
+    EXPECT_EQ(chunk->seq(), 1);
+    EXPECT_EQ(chunk->hash(), pre_prepare.hash());
+    // Each chunk carries half of the data.
+    EXPECT_LT(chunk->data().size(), 700);
+  }
+
+  // The shard forwarded by the replica 3 comes before the one sent by the
+  // primary.
+  auto ret = replica.AddChunk(GetContext(3), *Forward(*chunks[2], 3), false);
+  EXPECT_EQ(ret.second, nullptr);
+  EXPECT_EQ(replica.GetPendingNum(), 1);
+
+  ret = replica.AddChunk(GetContext(1), *chunks[1], true);
+  ASSERT_NE(ret.second, nullptr);
+  EXPECT_EQ(ret.second->SerializeAsString(), pre_prepare.SerializeAsString());
+  // The context of the primary's chunk.
+  EXPECT_EQ(ret.first->signature.node_id(), 1);
+  EXPECT_EQ(replica.GetPendingNum(), 0);
+
+  // The late shards are ignored.
+  ret = replica.AddChunk(GetContext(4), *Forward(*chunks[3], 4), false);
+  EXPECT_EQ(ret.second, nullptr);
+}
+
+TEST(ProposalDisseminationTest, RejectForgedShards) {
+  ProposalDissemination primary(4, 2), replica(4, 2);
+  Request pre_prepare = GetPrePrepare(1000);
+  std::vector<std::unique_ptr<Request>> chunks = primary.Split(pre_prepare);
+
+  auto ret = replica.AddChunk(GetContext(1), *chunks[1], true);
+  EXPECT_EQ(ret.second, nullptr);
+
+  // A shard which does not match the hash signed by the primary.
+  ProposalChunk chunk;
+  ASSERT_TRUE(chunk.ParseFromString(chunks[2]->data()));
+  chunk.mutable_shard()->at(0) ^= 1;
+  auto forged = Forward(*chunks[2], 3);
+  chunk.SerializeToString(forged->mutable_data());
+  ret = replica.AddChunk(GetContext(3), *forged, false);
+  EXPECT_EQ(ret.second, nullptr);
+
+  // A header from a replica other than the primary is not trusted.
+  ret = replica.AddChunk(GetContext(3), *Forward(*chunks[1], 3), false);
+  EXPECT_EQ(ret.second, nullptr);
+
+  ret = replica.AddChunk(GetContext(4), *Forward(*chunks[3], 4), false);
+  ASSERT_NE(ret.second, nullptr);
+  EXPECT_EQ(ret.second->data(), pre_prepare.data());
+}
+
+TEST(ProposalDisseminationTest, UncheckedShardsPerSender) {
+  ProposalDissemination primary(4, 2), replica(4, 2);
+  Request pre_prepare = GetPrePrepare(1000);
+  std::vector<std::unique_ptr<Request>> chunks = primary.Split(pre_prepare);
+
+  // The replica 4 sends forged shards of every index before the chunk of
+  // the primary arrives.
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      ProposalChunk chunk;
+      ASSERT_TRUE(chunk.ParseFromString(chunks[i]->data()));
+      chunk.mutable_shard()->at(0) ^= j + 1;
+      auto forged = Forward(*chunks[i], 4);
+      chunk.SerializeToString(forged->mutable_data());
+      auto ret = replica.AddChunk(GetContext(4), *forged, false);
+      EXPECT_EQ(ret.second, nullptr);
+    }
+  }
+
+  // The shard of the replica 3 is still kept.
+  auto ret = replica.AddChunk(GetContext(3), *Forward(*chunks[2], 3), false);
+  EXPECT_EQ(ret.second, nullptr);
+  ret = replica.AddChunk(GetContext(1), *chunks[1], true);
+  ASSERT_NE(ret.second, nullptr);
+  EXPECT_EQ(ret.second->data(), pre_prepare.data());
+}
+
+TEST(ProposalDisseminationTest, RejectInvalidData) {
+  ProposalDissemination primary(4, 2), replica(4, 2);
+  Request pre_prepare = GetPrePrepare(1000);
+  // The data does not match the digest the replicas vote on.
+  pre_prepare.set_hash(SignatureVerifier::CalculateHash("other"));
+  std::vector<std::unique_ptr<Request>> chunks = primary.Split(pre_prepare);
+
+  auto ret = replica.AddChunk(GetContext(1), *chunks[1], true);
+  EXPECT_EQ(ret.second, nullptr);
+  ret = replica.AddChunk(GetContext(3), *Forward(*chunks[2], 3), false);
+  EXPECT_EQ(ret.second, nullptr);
+  // The proposal is not done, the later shards can still rebuild it.
+  EXPECT_EQ(replica.GetPendingNum(), 1);
+}
+
+TEST(ProposalDisseminationTest, OneDigestPerSeq) {
+  ProposalDissemination primary(4, 2), replica(4, 2);
+  Request pre_prepare = GetPrePrepare(1000);
+  std::vector<std::unique_ptr<Request>> chunks = primary.Split(pre_prepare);
+  Request other = GetPrePrepare(500);
+  std::vector<std::unique_ptr<Request>> other_chunks = primary.Split(other);
+
+  auto ret = replica.AddChunk(GetContext(1), *chunks[1], true);
+  EXPECT_EQ(ret.second, nullptr);
+  // The shards of another digest of the same seq are dropped.
+  ret = replica.AddChunk(GetContext(3), *Forward(*other_chunks[2], 3), false);
+  EXPECT_EQ(ret.second, nullptr);
+  ret = replica.AddChunk(GetContext(4), *Forward(*other_chunks[3], 4), false);
+  EXPECT_EQ(ret.second, nullptr);
+  EXPECT_EQ(replica.GetPendingNum(), 1);
+
+  ret = replica.AddChunk(GetContext(3), *Forward(*chunks[2], 3), false);
+  ASSERT_NE(ret.second, nullptr);
+  EXPECT_EQ(ret.second->data(), pre_prepare.data());
+}
+
+TEST(ProposalDisseminationTest, BoundedBySeqWindow) {
+  ProposalDissemination primary(4, 2), replica(4, 2);
+  Request pre_prepare = GetPrePrepare(1000);
+
+  // The forwarded shards far beyond the latest proposed seq are dropped.
+  pre_prepare.set_seq(100000);
+  std::vector<std::unique_ptr<Request>> chunks = primary.Split(pre_prepare);
+  auto ret = replica.AddChunk(GetContext(3), *Forward(*chunks[2], 3), false);
+  EXPECT_EQ(ret.second, nullptr);
+  EXPECT_EQ(replica.GetPendingNum(), 0);
+
+  for (uint64_t seq = 1; seq <= 2000; ++seq) {
+    pre_prepare.set_seq(seq);
+    chunks = primary.Split(pre_prepare);
+    replica.AddChunk(GetContext(1), *chunks[1], true);
+  }
+  // Only the proposals within the window are kept.
+  EXPECT_LE(replica.GetPendingNum(), 1025);
+
+  // The shards of the pruned seqs are dropped.
+  pre_prepare.set_seq(1);
+  chunks = primary.Split(pre_prepare);
+  ret = replica.AddChunk(GetContext(1), *chunks[1], true);
+  EXPECT_EQ(ret.second, nullptr);
+  ret = replica.AddChunk(GetContext(3), *Forward(*chunks[2], 3), false);
+  EXPECT_EQ(ret.second, nullptr);
+}
+
+}  // namespace
+}  // namespace resdb
@@ -54,7 +54,12 @@ ResponseManager::ResponseManager(const ResDBConfig& config,
           "context", config_.GetMaxProcessTxn(), nullptr)),
       batch_queue_("user request"),
       system_info_(system_info),
-      verifier_(verifier) {
+      verifier_(verifier),
+      threshold_signature_(
+          config.GetThresholdKeyShare()
+              ? std::make_unique<ThresholdSignature>(
+                    config.GetThresholdKeyShare()->public_key())
+              : nullptr) {
   stop_ = false;
   local_id_ = 1;
   timeout_length_ = 5000000;
@@ -114,6 +119,26 @@ int ResponseManager::NewUserRequest(std::unique_ptr<Context> context,
   return 0;
 }
 
+void ResponseManager::SetMempoolManager(MempoolManager* mempool_manager) {
+  mempool_manager_ = mempool_manager;
+}
+
+int ResponseManager::ProcessMempoolAck(std::unique_ptr<Context> context,
+                                       std::unique_ptr<Request> request) {
+  if (mempool_manager_ == nullptr) {
+    return 0;
+  }
+  std::unique_ptr<Request> certified =
+      mempool_manager_->ProcessAck(std::move(context), std::move(request));
+  if (certified == nullptr) {
+    return 0;
+  }
+  replica_communicator_->SendMessage(*certified, GetPrimary());
+  LOG(INFO) << "send certified batch to primary:" << GetPrimary();
+  AddWaitingResponseRequest(std::move(certified));
+  return 0;
+}
+
 // =================== response ========================
 // handle the response message. If receive f+1 commit messages, send back to the
 // caller.
@@ -195,6 +220,11 @@ CollectorResultCode ResponseManager::AddResponseMsg(
                << " type:" << request->type();
     return CollectorResultCode::INVALID;
   }
+  if (!VerifyQuorumCert(*batch_response)) {
+    LOG(ERROR) << "invalid commit certificate, local id:" << seq
+               << " sender:" << signature.node_id();
+    return CollectorResultCode::INVALID;
+  }
 
   int type = request->type();
   int resp_received_count = 0;
@@ -214,12 +244,56 @@ CollectorResultCode ResponseManager::AddResponseMsg(
   LOG(ERROR) << " get receive count:" << resp_received_count << " seq:" << seq;
   if (resp_received_count > 0) {
     collector_pool_->Update(seq);
+    RemoveBatchHash(seq);
     RemoveWaitingResponseRequest(hash);
     return CollectorResultCode::STATE_CHANGED;
   }
   return CollectorResultCode::OK;
 }
 
+bool ResponseManager::VerifyQuorumCert(
+    const BatchUserResponse& batch_response) {
+  if (threshold_signature_ == nullptr || !batch_response.has_quorum_cert()) {
+    return true;
+  }
+  std::string hash;
+  {
+    std::lock_guard<std::mutex> lk(batch_hash_mutex_);
+    auto it = batch_hash_.find(batch_response.local_id());
+    if (it == batch_hash_.end()) {
+      // The batch has been acked, or it is sent in the performance mode.
+      return true;
+    }
+    hash = it->second;
+  }
+  return batch_response.hash() == hash &&
+         threshold_signature_->Verify(hash, batch_response.quorum_cert());
+}
+
+void ResponseManager::AddBatchHash(uint64_t local_id,
+                                   const std::string& hash) {
+  if (threshold_signature_ == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(batch_hash_mutex_);
+  batch_hash_[local_id] = hash;
+  // At most GetMaxProcessTxn() batches are in flight, drop the ones which
+  // never got enough responses.
+  uint64_t window = 2 * config_.GetMaxProcessTxn();
+  if (local_id > window) {
+    batch_hash_.erase(batch_hash_.begin(),
+                      batch_hash_.lower_bound(local_id - window));
+  }
+}
+
+void ResponseManager::RemoveBatchHash(uint64_t local_id) {
+  if (threshold_signature_ == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(batch_hash_mutex_);
+  batch_hash_.erase(local_id);
+}
+
 void ResponseManager::SendResponseToClient(
     const BatchUserResponse& batch_response) {
   uint64_t create_time = batch_response.createtime();
@@ -309,6 +383,7 @@ int ResponseManager::DoBatch(
   }
   std::vector<std::unique_ptr<Context>> context_list;
 
+  uint64_t local_id = 0;
   BatchUserRequest batch_request;
   for (size_t i = 0; i < batch_req.size(); ++i) {
     BatchUserRequest::UserRequest* req = batch_request.add_user_requests();
@@ -322,8 +397,9 @@ int ResponseManager::DoBatch(
     LOG(ERROR) << "add context list:" << new_request->seq()
                << " list size:" << context_list.size()
                << " local_id:" << local_id_;
-    batch_request.set_local_id(local_id_);
-    int ret = AddContextList(std::move(context_list), local_id_++);
+    local_id = local_id_++;
+    batch_request.set_local_id(local_id);
+    int ret = AddContextList(std::move(context_list), local_id);
     if (ret != 0) {
       LOG(ERROR) << "add context list fail:";
       return ret;
@@ -344,6 +420,18 @@ int ResponseManager::DoBatch(
   batch_request.SerializeToString(new_request->mutable_data());
   new_request->set_hash(SignatureVerifier::CalculateHash(new_request->data()));
   new_request->set_proxy_id(config_.GetSelfInfo().id());
+  if (local_id > 0) {
+    AddBatchHash(local_id, new_request->hash());
+  }
+  if (mempool_manager_ != nullptr) {
+    send_num_++;
+    int ret = mempool_manager_->Disseminate(*new_request);
+    if (ret != 0) {
+      send_num_--;
+      RemoveBatchHash(local_id);
+    }
+    return ret;
+  }
   replica_communicator_->SendMessage(*new_request, GetPrimary());
   send_num_++;
   LOG(INFO) << "send msg to primary:" << GetPrimary()
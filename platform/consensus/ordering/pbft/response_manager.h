@@ -20,8 +20,10 @@
 #pragma once
 #include <semaphore.h>
 
+#include "common/crypto/threshold_signature.h"
 #include "platform/config/resdb_config.h"
 #include "platform/consensus/ordering/pbft/lock_free_collector_pool.h"
+#include "platform/consensus/ordering/pbft/mempool_manager.h"
 #include "platform/consensus/ordering/pbft/transaction_utils.h"
 #include "platform/networkstrate/replica_communicator.h"
 #include "platform/statistic/stats.h"
@@ -56,6 +58,15 @@ class ResponseManager {
   int ProcessResponseMsg(std::unique_ptr<Context> context,
                          std::unique_ptr<Request> request);
 
+  // Disseminate the batches through the mempools and send the primary only
+  // their hash once they are certified.
+  void SetMempoolManager(MempoolManager* mempool_manager);
+
+  // Receive an ack of a batch in the mempools. Send the batch to the primary
+  // once it is certified.
+  int ProcessMempoolAck(std::unique_ptr<Context> context,
+                        std::unique_ptr<Request> request);
+
  private:
   // Add response messages which will be sent back to the caller
   // if there are f+1 same messages.
@@ -65,6 +76,11 @@ class ResponseManager {
                          const TransactionCollector::CollectorDataType*)>
           call_back);
   void SendResponseToClient(const BatchUserResponse& batch_response);
+  // Verify the commit certificate of the response against the hash of the
+  // batch sent with its local id.
+  bool VerifyQuorumCert(const BatchUserResponse& batch_response);
+  void AddBatchHash(uint64_t local_id, const std::string& hash);
+  void RemoveBatchHash(uint64_t local_id);
 
   struct QueueItem {
     std::unique_ptr<Context> context;
@@ -95,6 +111,11 @@ class ResponseManager {
   SystemInfo* system_info_;
   std::atomic<int> send_num_;
   SignatureVerifier* verifier_;
+  MempoolManager* mempool_manager_ = nullptr;
+  std::unique_ptr<ThresholdSignature> threshold_signature_;
+  std::mutex batch_hash_mutex_;
+  // The hash of the batches waiting for the responses, by local id.
+  std::map<uint64_t, std::string> batch_hash_;
 
   std::thread checking_timeout_thread_;
   std::map<std::string, std::unique_ptr<Request>> waiting_response_batches_;
@@ -23,6 +23,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "common/crypto/threshold_signature.h"
 #include "common/test/test_macros.h"
 #include "interface/rdbc/mock_net_channel.h"
 #include "platform/config/resdb_config_utils.h"
@@ -139,6 +140,60 @@ TEST_F(ResponseManagerTest, ProcessResponse) {
   EXPECT_EQ(AddResponseMsg(2, batch_resp), 0);
 }
 
+TEST_F(ResponseManagerTest, VerifyQuorumCert) {
+  auto keys = ThresholdSignature::GenerateKeys(4, 3, 512);
+  ASSERT_TRUE(keys.ok());
+  ThresholdKeyShare public_key;
+  *public_key.mutable_public_key() = (*keys)[0].public_key();
+  ResDBConfig config = config_;
+  config.SetThresholdKeyShare(public_key);
+
+  std::promise<std::string> propose_done;
+  std::future<std::string> propose_done_future = propose_done.get_future();
+  EXPECT_CALL(replica_communicator_, SendMessage(_, 1))
+      .WillOnce(Invoke([&](const google::protobuf::Message& message, int64_t) {
+        propose_done.set_value(dynamic_cast<const Request&>(message).hash());
+      }));
+
+  ResponseManager manager(config, &replica_communicator_, &system_info_,
+                          nullptr);
+  auto context = std::make_unique<Context>();
+  context->signature.set_signature("signature");
+  EXPECT_EQ(
+      manager.NewUserRequest(std::move(context), std::make_unique<Request>()),
+      0);
+  std::string hash = propose_done_future.get();
+
+  std::vector<SignatureInfo> shares;
+  for (int i = 0; i < 3; ++i) {
+    auto share = ThresholdSignature((*keys)[i]).SignShare(hash);
+    ASSERT_TRUE(share.ok());
+    shares.push_back(*share);
+  }
+  auto cert = ThresholdSignature((*keys)[0]).Combine(
+      hash, {&shares[0], &shares[1], &shares[2]});
+  ASSERT_TRUE(cert.ok());
+
+  auto process_response = [&](int sender_id, const std::string& batch_hash) {
+    BatchUserResponse batch_resp;
+    batch_resp.set_local_id(1);
+    batch_resp.set_hash(batch_hash);
+    *batch_resp.mutable_quorum_cert() = *cert;
+    Request request;
+    request.set_type(Request::TYPE_RESPONSE);
+    request.set_sender_id(sender_id);
+    batch_resp.SerializeToString(request.mutable_data());
+    auto response_context = std::make_unique<Context>();
+    response_context->signature.set_node_id(sender_id);
+    return manager.ProcessResponseMsg(std::move(response_context),
+                                      std::make_unique<Request>(request));
+  };
+
+  // The certificate does not match the batch.
+  EXPECT_EQ(process_response(1, "other hash"), -2);
+  EXPECT_EQ(process_response(1, hash), 0);
+}
+
 TEST_F(ResponseManagerTest, ProcessResponseWithMoreResp) {
   std::unique_ptr<MockNetChannel> channel =
       std::make_unique<MockNetChannel>("127.0.0.1", 0);
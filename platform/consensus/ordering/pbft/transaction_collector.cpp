@@ -22,11 +22,63 @@
 #include <glog/logging.h>
 
 #include "common/crypto/signature_verifier.h"
+#include "platform/proto/viewchange_message.pb.h"
 
 namespace resdb {
 
+namespace {
+
+// Pre-prepare payloads are not kept in the arena, only the prepare votes and
+// their signatures, so a small first block covers most of the slots.
+constexpr size_t kArenaStartBlockSize = 4096;
+constexpr size_t kArenaMaxBlockSize = 64 << 10;
+
+std::unique_ptr<google::protobuf::Arena> NewArena() {
+  google::protobuf::ArenaOptions options;
+  options.start_block_size = kArenaStartBlockSize;
+  options.max_block_size = kArenaMaxBlockSize;
+  return std::make_unique<google::protobuf::Arena>(options);
+}
+
+}  // namespace
+
+TransactionCollector::TransactionCollector(uint64_t seq,
+                                           TransactionExecutor* executor,
+                                           bool enable_viewchange,
+                                           bool use_arena,
+                                           const ThresholdSignature*
+                                               threshold_signature,
+                                           PreparedCertificateIndex*
+                                               prepared_index)
+    : seq_(seq),
+      executor_(executor),
+      status_(TransactionStatue::None),
+      enable_viewchange_(enable_viewchange),
+      threshold_signature_(threshold_signature),
+      prepared_index_(prepared_index),
+      view_(0) {
+  if (use_arena) {
+    arena_ = NewArena();
+  }
+}
+
 uint64_t TransactionCollector::Seq() { return seq_; }
 
+google::protobuf::Arena* TransactionCollector::GetArena() {
+  return arena_.get();
+}
+
+template <typename T>
+T* TransactionCollector::CreateMessage() {
+  if (arena_) {
+    return google::protobuf::Arena::CreateMessage<T>(arena_.get());
+  }
+  auto message = std::make_unique<T>();
+  T* ptr = message.get();
+  heap_messages_.push_back(std::move(message));
+  return ptr;
+}
+
 bool TransactionCollector::IsPrepared() { return is_prepared_; }
 
 TransactionStatue TransactionCollector::GetStatus() const { return status_; }
@@ -59,13 +111,43 @@ std::vector<RequestInfo> TransactionCollector::GetPreparedProof() {
   std::vector<RequestInfo> prepared_info;
   for (const auto& proof : prepared_proof_) {
     RequestInfo info;
-    info.signature = proof->signature;
-    info.request = std::make_unique<Request>(*proof->request);
+    info.signature = *proof.signature;
+    info.request = std::make_unique<Request>(*proof.request);
     prepared_info.push_back(std::move(info));
   }
   return prepared_info;
 }
 
+bool TransactionCollector::GetPreparedData(const std::string& hash,
+                                           std::string* data) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto main_request = atomic_mian_request_.Reference();
+  if (main_request == nullptr || main_request->request == nullptr ||
+      main_request->request->hash() != hash) {
+    return false;
+  }
+  *data = main_request->request->data();
+  return true;
+}
+
+void TransactionCollector::RegisterPreparedCertificate(
+    const std::string& hash) {
+  if (prepared_index_ == nullptr) {
+    return;
+  }
+  ViewChangeMessage message;
+  PreparedMessage* prepared = message.add_prepared_msg();
+  prepared->set_seq(seq_);
+  for (const auto& proof : prepared_proof_) {
+    PreparedProof* prepared_proof = prepared->add_proof();
+    *prepared_proof->mutable_request() = *proof.request;
+    *prepared_proof->mutable_signature() = *proof.signature;
+  }
+  std::string data;
+  message.SerializeToString(&data);
+  prepared_index_->Add(seq_, hash, std::move(data));
+}
+
 int TransactionCollector::AddRequest(
     std::unique_ptr<Request> request, const SignatureInfo& signature,
     bool is_main_request,
@@ -78,7 +160,6 @@ int TransactionCollector::AddRequest(
   }
 
   int32_t sender_id = request->sender_id();
-  std::string hash = request->hash();
   int type = request->type();
   uint64_t seq = request->seq();
   uint64_t view = request->current_view();
@@ -120,17 +201,21 @@ int TransactionCollector::AddRequest(
     call_back(*main_request->request.get(), 1, nullptr, &status_, force);
     return 0;
   } else {
+    // request is kept alive until the end of this branch, no need to copy.
+    const std::string& hash = request->hash();
     if (enable_viewchange_) {
       if (type == Request::TYPE_PREPARE) {
         if (status_.load() <= TransactionStatue::READY_PREPARE) {
-          auto request_info = std::make_unique<RequestInfo>();
-          request_info->signature = signature;
-          request_info->request = std::make_unique<Request>(*request);
           std::lock_guard<std::mutex> lk(mutex_);
           if (is_prepared_) {
             return 0;
           }
-          prepared_proof_.push_back(std::move(request_info));
+          PreparedRequestInfo request_info;
+          request_info.signature = CreateMessage<SignatureInfo>();
+          request_info.signature->CopyFrom(signature);
+          request_info.request = CreateMessage<Request>();
+          request_info.request->CopyFrom(*request);
+          prepared_proof_.push_back(request_info);
           if (senders_[type].count(hash) == 0) {
             senders_[type].insert(std::make_pair(hash, std::bitset<128>()));
           }
@@ -156,12 +241,13 @@ int TransactionCollector::AddRequest(
             }
             int pos = 0;
             for (size_t i = 0; i < prepared_proof_.size(); i++) {
-              if (prepared_proof_[i]->request->hash() == hash) {
-                prepared_proof_[pos++] = std::move(prepared_proof_[i]);
+              if (prepared_proof_[i].request->hash() == hash) {
+                prepared_proof_[pos++] = prepared_proof_[i];
               }
             }
             prepared_proof_.erase(prepared_proof_.begin() + pos,
                                   prepared_proof_.end());
+            RegisterPreparedCertificate(hash);
           }
         }
         return 0;
@@ -211,18 +297,60 @@ int TransactionCollector::Commit() {
 
   is_committed_ = true;
   if (executor_ && main_request->request) {
-    if (!commit_certs_.empty()) {
-      for (const auto& sig : commit_certs_) {
-        *main_request->request->mutable_committed_certs()
-             ->add_committed_certs() = sig;
-        // LOG(ERROR) << "add sig:" << sig.DebugString();
+    std::vector<SignatureInfo> commit_certs;
+    {
+      // Late commit messages may still append to commit_certs_.
+      std::lock_guard<std::mutex> lk(mutex_);
+      commit_certs = commit_certs_;
+    }
+    if (!commit_certs.empty()) {
+      if (!AddQuorumCert(main_request->request.get(), commit_certs)) {
+        for (const auto& sig : commit_certs) {
+          *main_request->request->mutable_committed_certs()
+               ->add_committed_certs() = sig;
+          // LOG(ERROR) << "add sig:" << sig.DebugString();
+        }
       }
     }
-    executor_->Commit(std::move(main_request->request));
+    std::unique_ptr<Request> request;
+    {
+      // GetPreparedData() may read the main request concurrently.
+      std::lock_guard<std::mutex> lk(mutex_);
+      request = std::move(main_request->request);
+    }
+    executor_->Commit(std::move(request));
   }
   return 0;
 }
 
+// Combine the signature shares of the commit messages into one certificate.
+// It runs outside mutex_ on a copy of the shares. Corrupted shares are
+// skipped by Combine(); if there are not enough valid ones, the shares are
+// kept as they are.
+// This is on the commit path: the 2f+1 exponentiations of Combine() delay
+// the execution of each committed request, longer as the replicas grow and
+// much longer if a share is corrupted. The other seqs keep being collected
+// meanwhile.
+bool TransactionCollector::AddQuorumCert(
+    Request* request, const std::vector<SignatureInfo>& commit_certs) {
+  if (threshold_signature_ == nullptr) {
+    return false;
+  }
+  std::vector<const SignatureInfo*> shares;
+  for (const auto& sig : commit_certs) {
+    shares.push_back(&sig);
+  }
+  auto cert_or = threshold_signature_->Combine(request->hash(), shares);
+  if (!cert_or.ok()) {
+    LOG(ERROR) << "combine commit certificate fail, seq:" << seq_
+               << " status:" << cert_or.status();
+    return false;
+  }
+  *request->mutable_committed_certs()->mutable_quorum_cert() =
+      std::move(*cert_or);
+  return true;
+}
+
 std::vector<std::string> TransactionCollector::GetAllStoredHash() {
   std::vector<std::string> v;
   auto main_request = atomic_mian_request_.Reference();
@@ -19,9 +19,13 @@
 
 #pragma once
 
+#include <google/protobuf/arena.h>
+
 #include <bitset>
 
+#include "common/crypto/threshold_signature.h"
 #include "platform/consensus/execution/transaction_executor.h"
+#include "platform/consensus/ordering/pbft/prepared_certificate_index.h"
 #include "platform/networkstrate/server_comm.h"
 #include "platform/proto/resdb.pb.h"
 #include "platform/statistic/stats.h"
@@ -42,6 +46,14 @@ struct RequestInfo {
   SignatureInfo signature;
 };
 
+// Prepared proof kept inside the collector. Both messages are owned by the
+// collector (allocated on its arena when enabled) and are released together
+// with the collector.
+struct PreparedRequestInfo {
+  Request* request = nullptr;
+  SignatureInfo* signature = nullptr;
+};
+
 template <typename T>
 class AtomicUniquePtr {
  public:
@@ -78,13 +90,18 @@ class AtomicUniquePtr {
 
 class TransactionCollector {
  public:
-  TransactionCollector(uint64_t seq, TransactionExecutor* executor,
-                       bool enable_viewchange = false)
-      : seq_(seq),
-        executor_(executor),
-        status_(TransactionStatue::None),
-        enable_viewchange_(enable_viewchange),
-        view_(0) {}
+  // If use_arena is true, the messages kept by the collector for this seq are
+  // allocated on a per-collector arena and released in bulk once the slot is
+  // recycled by LockFreeCollectorPool.
+  // If threshold_signature is set, the commit signature shares are combined
+  // into one quorum certificate before committing.
+  // If prepared_index is set, the prepared proof is registered to it once
+  // the seq reaches READY_COMMIT.
+  TransactionCollector(
+      uint64_t seq, TransactionExecutor* executor,
+      bool enable_viewchange = false, bool use_arena = true,
+      const ThresholdSignature* threshold_signature = nullptr,
+      PreparedCertificateIndex* prepared_index = nullptr);
 
   ~TransactionCollector() = default;
 
@@ -108,6 +125,9 @@ class TransactionCollector {
           call_back);
 
   std::vector<RequestInfo> GetPreparedProof();
+  // Copy the data of the main request to data if its hash matches, used to
+  // serve the payload of a prepared seq during a view change.
+  bool GetPreparedData(const std::string& hash, std::string* data);
   TransactionStatue GetStatus() const;
 
   uint64_t Seq();
@@ -116,8 +136,19 @@ class TransactionCollector {
 
   std::vector<std::string> GetAllStoredHash();
 
+  // Return the arena used by this collector, nullptr if it is disabled.
+  google::protobuf::Arena* GetArena();
+
  private:
   int Commit();
+  bool AddQuorumCert(Request* request,
+                     const std::vector<SignatureInfo>& commit_certs);
+  // Must be called holding mutex_.
+  void RegisterPreparedCertificate(const std::string& hash);
+
+  // Create a message owned by the collector.
+  template <typename T>
+  T* CreateMessage();
 
  private:
   uint64_t seq_;
@@ -127,15 +158,21 @@ class TransactionCollector {
   std::vector<std::unique_ptr<Context>> context_list_;
   std::map<std::string, std::list<std::unique_ptr<RequestInfo>>>
       data_[Request::NUM_OF_TYPE];
-  std::vector<std::unique_ptr<RequestInfo>> prepared_proof_;
+  std::vector<PreparedRequestInfo> prepared_proof_;
   AtomicUniquePtr<RequestInfo> atomic_mian_request_;
   std::atomic<TransactionStatue> status_ = TransactionStatue::None;
   bool enable_viewchange_;
   std::mutex mutex_;
   std::vector<SignatureInfo> commit_certs_;
+  const ThresholdSignature* threshold_signature_;
+  PreparedCertificateIndex* prepared_index_;
   std::map<std::string, std::bitset<128>> senders_[Request::NUM_OF_TYPE];
   std::set<std::unique_ptr<RequestInfo>> other_main_request_;
   uint64_t view_;
+  // Owns the messages in prepared_proof_. heap_messages_ is only used if the
+  // arena is disabled.
+  std::unique_ptr<google::protobuf::Arena> arena_;
+  std::vector<std::unique_ptr<google::protobuf::Message>> heap_messages_;
 };
 
 }  // namespace resdb
@@ -24,6 +24,7 @@
 #include <gtest/gtest.h>
 
 #include "common/test/test_macros.h"
+#include "platform/proto/viewchange_message.pb.h"
 
 namespace resdb {
 namespace {
@@ -392,6 +393,98 @@ TEST(TransactionCollectorTest, DelayMainRequest) {
   }
 }
 
+TEST(TransactionCollectorTest, PreparedProofOnArena) {
+  int64_t seq = 11111;
+  for (bool use_arena : {true, false}) {
+    TransactionCollector collector(seq, nullptr, /*enable_viewchange=*/true,
+                                   use_arena);
+    EXPECT_EQ(collector.GetArena() != nullptr, use_arena);
+
+    for (int i = 1; i <= 3; ++i) {
+      Request request;
+      request.set_seq(seq);
+      request.set_hash("hash_main");
+      request.set_type(Request::TYPE_PREPARE);
+      request.set_sender_id(i);
+      SignatureInfo signature;
+      signature.set_node_id(i);
+      EXPECT_EQ(collector.AddRequest(
+                    std::make_unique<Request>(request), signature,
+                    /* is_main_request =*/false,
+                    [&](const Request& request, int received_count,
+                        TransactionCollector::CollectorDataType* data,
+                        std::atomic<TransactionStatue>* status, bool) {}),
+                0);
+    }
+
+    std::vector<RequestInfo> proof = collector.GetPreparedProof();
+    ASSERT_EQ(proof.size(), 3);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(proof[i].request->sender_id(), i + 1);
+      EXPECT_EQ(proof[i].request->hash(), "hash_main");
+      EXPECT_EQ(proof[i].signature.node_id(), i + 1);
+      EXPECT_EQ(proof[i].request->GetArena(), nullptr);
+    }
+  }
+}
+
+TEST(TransactionCollectorTest, RegisterPreparedCertificate) {
+  int64_t seq = 11111;
+  PreparedCertificateIndex index;
+  TransactionCollector collector(seq, nullptr, /*enable_viewchange=*/true,
+                                 /*use_arena=*/true,
+                                 /*threshold_signature=*/nullptr, &index);
+
+  Request main_request;
+  main_request.set_seq(seq);
+  main_request.set_hash("hash_main");
+  main_request.set_data("main_data");
+  main_request.set_type(Request::TYPE_PRE_PREPARE);
+  EXPECT_EQ(collector.AddRequest(
+                std::make_unique<Request>(main_request), SignatureInfo(),
+                /* is_main_request =*/true,
+                [&](const Request& request, int received_count,
+                    TransactionCollector::CollectorDataType* data,
+                    std::atomic<TransactionStatue>* status, bool) {}),
+            0);
+
+  for (int i = 1; i <= 3; ++i) {
+    EXPECT_EQ(index.Get(seq), nullptr);
+    Request request;
+    request.set_seq(seq);
+    request.set_hash("hash_main");
+    request.set_type(Request::TYPE_PREPARE);
+    request.set_sender_id(i);
+    SignatureInfo signature;
+    signature.set_node_id(i);
+    EXPECT_EQ(collector.AddRequest(
+                  std::make_unique<Request>(request), signature,
+                  /* is_main_request =*/false,
+                  [&](const Request& request, int received_count,
+                      TransactionCollector::CollectorDataType* data,
+                      std::atomic<TransactionStatue>* status, bool) {
+                    if (received_count == 3) {
+                      *status = TransactionStatue::READY_COMMIT;
+                    }
+                  }),
+              0);
+  }
+
+  auto cert = index.Get(seq);
+  ASSERT_NE(cert, nullptr);
+  EXPECT_EQ(cert->digest, "hash_main");
+  ViewChangeMessage message;
+  ASSERT_TRUE(message.ParseFromString(cert->data));
+  ASSERT_EQ(message.prepared_msg_size(), 1);
+  EXPECT_EQ(message.prepared_msg(0).seq(), seq);
+  EXPECT_EQ(message.prepared_msg(0).proof_size(), 3);
+
+  std::string data;
+  EXPECT_TRUE(collector.GetPreparedData("hash_main", &data));
+  EXPECT_EQ(data, "main_data");
+  EXPECT_FALSE(collector.GetPreparedData("hash_other", &data));
+}
+
 }  // namespace
 
 }  // namespace resdb
@@ -19,6 +19,8 @@
 
 #include "platform/consensus/ordering/pbft/transaction_utils.h"
 
+#include <google/protobuf/util/field_mask_util.h>
+
 namespace resdb {
 
 std::unique_ptr<Request> NewRequest(Request::Type type, const Request& request,
@@ -38,4 +40,36 @@ std::unique_ptr<Request> NewRequest(Request::Type type, const Request& request,
   return new_request;
 }
 
+namespace {
+
+// All the fields of Request except the payload.
+const google::protobuf::FieldMask& FieldsWithoutData() {
+  static const google::protobuf::FieldMask mask = [] {
+    google::protobuf::FieldMask mask;
+    const google::protobuf::Descriptor* descriptor = Request::descriptor();
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      if (descriptor->field(i)->number() != Request::kDataFieldNumber) {
+        mask.add_paths(descriptor->field(i)->name());
+      }
+    }
+    return mask;
+  }();
+  return mask;
+}
+
+}  // namespace
+
+std::unique_ptr<Request> NewRequestWithoutData(Request::Type type,
+                                               const Request& request,
+                                               int sender_id) {
+  auto new_request = std::make_unique<Request>();
+  google::protobuf::util::FieldMaskUtil::MergeMessageTo(
+      request, FieldsWithoutData(),
+      google::protobuf::util::FieldMaskUtil::MergeOptions(),
+      new_request.get());
+  new_request->set_type(type);
+  new_request->set_sender_id(sender_id);
+  return new_request;
+}
+
 }  // namespace resdb
@@ -35,4 +35,9 @@ std::unique_ptr<Request> NewRequest(Request::Type type, const Request& request,
 std::unique_ptr<Request> NewRequest(Request::Type type, const Request& request,
                                     int sender_id, int region_info);
 
+// Same as NewRequest, but the payload in request.data() is not copied.
+std::unique_ptr<Request> NewRequestWithoutData(Request::Type type,
+                                               const Request& request,
+                                               int sender_id);
+
 }  // namespace resdb
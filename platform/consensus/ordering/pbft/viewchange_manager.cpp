@@ -21,6 +21,7 @@
 
 #include <glog/logging.h>
 
+#include "common/crypto/signature_verifier.h"
 #include "common/utils/utils.h"
 #include "platform/consensus/ordering/pbft/transaction_utils.h"
 #include "platform/proto/viewchange_message.pb.h"
@@ -207,14 +208,20 @@ void ViewChangeManager::SetCurrentViewAndNewPrimary(uint64_t view_number) {
 
 std::vector<std::unique_ptr<Request>> ViewChangeManager::GetPrepareMsg(
     const NewViewMessage& new_view_message, bool need_sign) {
-  std::map<uint64_t, Request> prepared_msg;  // <sequence, digest>
+  // <sequence, proof>, the proofs are referenced in new_view_message.
+  std::map<uint64_t, const Request*> prepared_msg;
   for (const auto& msg : new_view_message.viewchange_messages()) {
     for (const auto& msg : msg.prepared_msg()) {
+      if (msg.proof_size() == 0) {
+        continue;
+      }
       uint64_t seq = msg.seq();
-      if (prepared_msg.find(seq) == prepared_msg.end()) {
-        prepared_msg[seq] = msg.proof(0).request();
-      } else if (prepared_msg[seq].type() < msg.proof(0).request().type()) {
-        prepared_msg[seq] = msg.proof(0).request();
+      const Request* proof = &msg.proof(0).request();
+      auto it = prepared_msg.find(seq);
+      if (it == prepared_msg.end()) {
+        prepared_msg[seq] = proof;
+      } else if (it->second->type() < proof->type()) {
+        it->second = proof;
       }
     }
   }
@@ -241,13 +248,18 @@ std::vector<std::unique_ptr<Request>> ViewChangeManager::GetPrepareMsg(
       LOG(ERROR) << " seq:" << i << " not prepared, in new view";
     } else {
       LOG(ERROR) << " seq:" << i
-                 << " prepared, type:" << prepared_msg[i].type();
+                 << " prepared, type:" << prepared_msg[i]->type();
     }
     std::unique_ptr<Request> user_request = resdb::NewRequest(
         Request::TYPE_PRE_PREPARE, Request(), config_.GetSelfInfo().id());
     user_request->set_seq(i);
     user_request->set_current_view(new_view_message.view_number());
-    user_request->set_hash("null" + std::to_string(i));
+    // The prepared seqs keep their digest, the payload is set by the new
+    // primary in FillPreparedData().
+    auto prepared_it = prepared_msg.find(i);
+    user_request->set_hash(prepared_it == prepared_msg.end()
+                               ? "null" + std::to_string(i)
+                               : prepared_it->second->hash());
     if (verifier_ && need_sign) {
       std::string data;
       auto signature_or = verifier_->SignMessage(data);
@@ -306,9 +318,17 @@ int ViewChangeManager::ProcessNewView(std::unique_ptr<Context> context,
   }
 
   std::set<uint64_t> seq_set;
-  // only check the data.
+  // Check the digests, the prepared seqs must carry the payloads of their
+  // digests.
   for (size_t i = 0; i < request_list.size(); ++i) {
-    if (request_list[i]->data() != new_view_message.request(i).data()) {
+    const Request& redo_request = new_view_message.request(i);
+    if (request_list[i]->hash() != redo_request.hash()) {
+      LOG(ERROR) << "hash not match";
+      return -2;
+    }
+    if (redo_request.hash() != "null" + std::to_string(redo_request.seq()) &&
+        SignatureVerifier::CalculateHash(redo_request.data()) !=
+            redo_request.hash()) {
       LOG(ERROR) << "data not match";
       return -2;
     }
@@ -423,6 +443,16 @@ void ViewChangeManager::SendNewViewMsg(uint64_t view_number) {
 
   std::vector<std::unique_ptr<Request>> request_list =
       GetPrepareMsg(new_view_message);
+  std::vector<const Request*> missing = FillPreparedData(request_list);
+  if (!missing.empty()) {
+    // Fetch the missing payloads once, the new view is sent once all of
+    // them arrive. If they never do, the view change times out.
+    new_view_is_sent_ = false;
+    if (fetch_view_ != view_number) {
+      FetchPreparedData(view_number, missing);
+    }
+    return;
+  }
   for (const auto& request : request_list) {
     *new_view_message.add_request() = *request;
   }
@@ -435,6 +465,114 @@ void ViewChangeManager::SendNewViewMsg(uint64_t view_number) {
   replica_communicator_->BroadCast(*request);
 }
 
+std::vector<const Request*> ViewChangeManager::FillPreparedData(
+    const std::vector<std::unique_ptr<Request>>& request_list) {
+  std::vector<const Request*> missing;
+  for (const auto& request : request_list) {
+    uint64_t seq = request->seq();
+    if (request->hash() == "null" + std::to_string(seq)) {
+      continue;
+    }
+    if (message_manager_->GetPreparedData(seq, request->hash(),
+                                          request->mutable_data())) {
+      continue;
+    }
+    auto it = fetched_data_.find(seq);
+    if (it != fetched_data_.end() && it->second.first == request->hash()) {
+      request->set_data(it->second.second);
+      continue;
+    }
+    missing.push_back(request.get());
+  }
+  return missing;
+}
+
+void ViewChangeManager::FetchPreparedData(
+    uint64_t view_number, const std::vector<const Request*>& missing) {
+  fetch_view_ = view_number;
+  fetched_data_.clear();
+  missing_data_.clear();
+  fetch_responders_.clear();
+
+  PreparedData fetch;
+  fetch.set_view_number(view_number);
+  for (const Request* request : missing) {
+    Request* fetch_request = fetch.add_request();
+    fetch_request->set_seq(request->seq());
+    fetch_request->set_hash(request->hash());
+    missing_data_.insert(request->seq());
+  }
+  LOG(ERROR) << "fetch " << missing.size()
+             << " prepared payloads for view:" << view_number;
+
+  std::unique_ptr<Request> request = NewRequest(
+      Request::TYPE_PREPARED_DATA_FETCH, Request(), config_.GetSelfInfo().id());
+  fetch.SerializeToString(request->mutable_data());
+  replica_communicator_->BroadCast(*request);
+}
+
+int ViewChangeManager::ProcessPreparedDataFetch(
+    std::unique_ptr<Context> context, std::unique_ptr<Request> request) {
+  PreparedData fetch;
+  if (!fetch.ParseFromString(request->data())) {
+    LOG(ERROR) << "parse prepared data fetch fail";
+    return -2;
+  }
+
+  // Always respond so that the new primary does not wait for the replicas
+  // lacking the payloads as well.
+  PreparedData resp;
+  resp.set_view_number(fetch.view_number());
+  for (const auto& fetch_request : fetch.request()) {
+    std::string data;
+    if (message_manager_->GetPreparedData(fetch_request.seq(),
+                                          fetch_request.hash(), &data)) {
+      Request* resp_request = resp.add_request();
+      resp_request->set_seq(fetch_request.seq());
+      resp_request->set_hash(fetch_request.hash());
+      resp_request->set_data(std::move(data));
+    }
+  }
+
+  std::unique_ptr<Request> resp_request = NewRequest(
+      Request::TYPE_PREPARED_DATA, Request(), config_.GetSelfInfo().id());
+  resp.SerializeToString(resp_request->mutable_data());
+  replica_communicator_->SendMessage(*resp_request, request->sender_id());
+  return 0;
+}
+
+int ViewChangeManager::ProcessPreparedData(std::unique_ptr<Context> context,
+                                           std::unique_ptr<Request> request) {
+  PreparedData resp;
+  if (!resp.ParseFromString(request->data())) {
+    LOG(ERROR) << "parse prepared data fail";
+    return -2;
+  }
+
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (resp.view_number() != fetch_view_ || new_view_is_sent_) {
+    return 0;
+  }
+  for (const auto& resp_request : resp.request()) {
+    if (missing_data_.count(resp_request.seq()) == 0 ||
+        SignatureVerifier::CalculateHash(resp_request.data()) !=
+            resp_request.hash()) {
+      continue;
+    }
+    fetched_data_[resp_request.seq()] =
+        std::make_pair(resp_request.hash(), resp_request.data());
+    missing_data_.erase(resp_request.seq());
+  }
+  fetch_responders_.insert(request->sender_id());
+  if (missing_data_.empty()) {
+    SendNewViewMsg(fetch_view_);
+  } else if (fetch_responders_.size() >= config_.GetMinDataReceiveNum()) {
+    LOG(ERROR) << missing_data_.size() << " prepared payloads are missing, "
+               << fetch_responders_.size() << " replicas responded";
+  }
+  return 0;
+}
+
 void ViewChangeManager::SendViewChangeMsg() {
   // PBFT Paper - <VIEW-CHANGE, v + x, n, C, P)
   ViewChangeMessage view_change_message;
@@ -462,26 +600,14 @@ void ViewChangeManager::SendViewChangeMsg() {
   LOG(ERROR) << "Check prepared or committed txns from " << min_seq + 1
              << " to " << max_seq;
 
-  for (int i = min_seq + 1; i <= max_seq; ++i) {
-    // seq i has been prepared or committed.
-    if (checkpoint_manager_->IsCommitted(i)) {
-      std::vector<RequestInfo> proof_info =
-          message_manager_->GetPreparedProof(i);
-      assert(proof_info.size() >= config_.GetMinDataReceiveNum());
-      auto txn = view_change_message.add_prepared_msg();
-      txn->set_seq(i);
-      for (const auto& info : proof_info) {
-        auto proof = txn->add_proof();
-        *proof->mutable_request() = *info.request;
-        *proof->mutable_signature() = info.signature;
-      }
-    }
-  }
-
-  // Broadcast my view change request.
+  // Broadcast my view change request. The prepared certificates are
+  // serialized when they are registered, append them as they are.
   std::unique_ptr<Request> request = NewRequest(
       Request::TYPE_VIEWCHANGE, Request(), config_.GetSelfInfo().id());
   view_change_message.SerializeToString(request->mutable_data());
+  int num = message_manager_->GetPreparedCertificateIndex()->AppendTo(
+      min_seq, max_seq, request->mutable_data());
+  LOG(ERROR) << "view change with " << num << " prepared certificates";
   replica_communicator_->BroadCast(*request);
 }
 
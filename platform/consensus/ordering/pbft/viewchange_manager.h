@@ -91,6 +91,11 @@ class ViewChangeManager {
                         std::unique_ptr<Request> request);
   int ProcessNewView(std::unique_ptr<Context> context,
                      std::unique_ptr<Request> request);
+  // The new primary fetches the payloads of the prepared seqs it lacks.
+  int ProcessPreparedDataFetch(std::unique_ptr<Context> context,
+                               std::unique_ptr<Request> request);
+  int ProcessPreparedData(std::unique_ptr<Context> context,
+                          std::unique_ptr<Request> request);
   bool IsInViewChange();
   // If the monitor is not running, start to monitor.
   void MayStart();
@@ -118,6 +123,12 @@ class ViewChangeManager {
   bool IsNextPrimary(uint64_t view_number);
   std::vector<std::unique_ptr<Request>> GetPrepareMsg(
       const NewViewMessage& new_view_message, bool need_sign = true);
+  // Set the payloads of the prepared seqs in request_list from the local
+  // collectors or the fetched ones. Returns the requests still lacking it.
+  std::vector<const Request*> FillPreparedData(
+      const std::vector<std::unique_ptr<Request>>& request_list);
+  void FetchPreparedData(uint64_t view_number,
+                         const std::vector<const Request*>& missing);
 
   bool ChangeStatue(ViewChangeStatus status);
 
@@ -154,6 +165,12 @@ class ViewChangeManager {
   uint64_t timeout_length_ = 10000000;
 
   LockFreeCollectorPool* collector_pool_;
+  // The payloads fetched for the new view, <seq, <hash, data>>, guarded by
+  // mutex_.
+  uint64_t fetch_view_ = 0;
+  std::map<uint64_t, std::pair<std::string, std::string>> fetched_data_;
+  std::set<uint64_t> missing_data_;
+  std::set<int32_t> fetch_responders_;
   DuplicateManager* duplicate_manager_;
 };
 
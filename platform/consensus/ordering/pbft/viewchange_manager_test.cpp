@@ -26,6 +26,7 @@
 #include <future>
 
 #include "common/crypto/mock_signature_verifier.h"
+#include "common/crypto/signature_verifier.h"
 #include "common/test/test_macros.h"
 #include "platform/config/resdb_config_utils.h"
 #include "platform/consensus/execution/system_info.h"
@@ -56,7 +57,7 @@ class ViewChangeManagerTest : public Test {
     config_.EnableCheckPoint(true);
     config_.SetViewchangeCommitTimeout(1000);  // set to 1s
     checkpoint_manager_ = std::make_unique<CheckPointManager>(
-        config_, &replica_communicator_, &mock_verifier_);
+        config_, &replica_communicator_, &mock_verifier_, &system_info_);
     message_manager_ = std::make_unique<MessageManager>(
         config_, nullptr, checkpoint_manager_.get(), &system_info_);
     manager_ = std::make_unique<ViewChangeManager>(
@@ -119,6 +120,50 @@ TEST_F(ViewChangeManagerTest, SendNewView) {
   propose_done_future.get();
 }
 
+TEST_F(ViewChangeManagerTest, NewViewWithoutPreparedData) {
+  std::string data = "prepared_data";
+  NewViewMessage new_view_message;
+  new_view_message.set_view_number(system_info_.GetCurrentView() + 1);
+  for (int i = 0; i < 3; ++i) {
+    ViewChangeMessage* viewchange_message =
+        new_view_message.add_viewchange_messages();
+    viewchange_message->set_view_number(new_view_message.view_number());
+    auto prepared_msg = viewchange_message->add_prepared_msg();
+    prepared_msg->set_seq(1);
+    Request* proof = prepared_msg->add_proof()->mutable_request();
+    proof->set_type(Request::TYPE_PREPARE);
+    proof->set_seq(1);
+    proof->set_hash(SignatureVerifier::CalculateHash(data));
+  }
+  Request* redo_request = new_view_message.add_request();
+  redo_request->set_type(Request::TYPE_PRE_PREPARE);
+  redo_request->set_seq(1);
+  redo_request->set_hash(SignatureVerifier::CalculateHash(data));
+
+  // The prepared seq carries its digest but not the payload.
+  std::unique_ptr<Request> request =
+      NewRequest(Request::TYPE_NEWVIEW, Request(), 2);
+  new_view_message.SerializeToString(request->mutable_data());
+  EXPECT_EQ(manager_->ProcessNewView(std::make_unique<Context>(),
+                                     std::move(request)),
+            -2);
+
+  // The payload does not match the digest.
+  redo_request->set_data("other_data");
+  request = NewRequest(Request::TYPE_NEWVIEW, Request(), 2);
+  new_view_message.SerializeToString(request->mutable_data());
+  EXPECT_EQ(manager_->ProcessNewView(std::make_unique<Context>(),
+                                     std::move(request)),
+            -2);
+
+  redo_request->set_data(data);
+  request = NewRequest(Request::TYPE_NEWVIEW, Request(), 2);
+  new_view_message.SerializeToString(request->mutable_data());
+  EXPECT_EQ(manager_->ProcessNewView(std::make_unique<Context>(),
+                                     std::move(request)),
+            0);
+}
+
 }  // namespace
 
 }  // namespace resdb
@@ -19,29 +19,85 @@
 
 #include "platform/consensus/ordering/poc/pow/merkle.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <string_view>
+
+#include "common/crypto/sha256_multi.h"
 #include "platform/consensus/ordering/poc/pow/miner_utils.h"
 
 namespace resdb {
 namespace {
 
-std::string TrverseMakeHash(const BatchClientTransactions& transaction,
-                            int l_idx, int r_idx) {
-  if (l_idx == r_idx) {
-    return GetHashValue(transaction.transactions(l_idx).transaction_data());
-  }
-  int mid = (l_idx + r_idx) >> 1;
+struct Node {
+  int left_child = -1;
+  int right_child = -1;
+  // The distance to the leaves.
+  int height = 0;
+  uint8_t digest[32];
+};
 
-  std::string l_chd = TrverseMakeHash(transaction, l_idx, mid);
-  std::string r_chd = TrverseMakeHash(transaction, mid + 1, r_idx);
-  return GetHashValue(l_chd + r_chd);
+// Build the tree of [l_idx, r_idx] split at the middle, the children are
+// added before their parent and the leaves from left to right.
+int BuildTree(int l_idx, int r_idx, std::vector<Node>* nodes) {
+  Node node;
+  if (l_idx != r_idx) {
+    int mid = (l_idx + r_idx) >> 1;
+    node.left_child = BuildTree(l_idx, mid, nodes);
+    node.right_child = BuildTree(mid + 1, r_idx, nodes);
+    node.height = std::max((*nodes)[node.left_child].height,
+                           (*nodes)[node.right_child].height) +
+                  1;
+  }
+  nodes->push_back(node);
+  return nodes->size() - 1;
 }
 
 }  // namespace
 
+// The nodes of the same height do not depend on each other, each level is
+// hashed by one multi-buffer call.
 HashValue Merkle::MakeHash(const BatchClientTransactions& transaction) {
-  std::string root_hash =
-      TrverseMakeHash(transaction, 0, transaction.transactions_size() - 1);
-  return DigestToHash(root_hash);
+  if (transaction.transactions_size() == 0) {
+    return HashValue();
+  }
+  std::vector<Node> nodes;
+  BuildTree(0, transaction.transactions_size() - 1, &nodes);
+  int max_height = nodes.back().height;
+
+  std::vector<Node*> level;
+  std::vector<std::string_view> data;
+  std::vector<uint8_t> messages;
+  std::vector<uint8_t> digests;
+  for (int height = 0; height <= max_height; ++height) {
+    level.clear();
+    for (Node& node : nodes) {
+      if (node.height == height) {
+        level.push_back(&node);
+      }
+    }
+    data.clear();
+    messages.resize(64 * level.size());
+    for (size_t i = 0; i < level.size(); ++i) {
+      if (height == 0) {
+        data.push_back(transaction.transactions(i).transaction_data());
+        continue;
+      }
+      uint8_t* message = &messages[64 * i];
+      memcpy(message, nodes[level[i]->left_child].digest, 32);
+      memcpy(message + 32, nodes[level[i]->right_child].digest, 32);
+      data.push_back(
+          std::string_view(reinterpret_cast<const char*>(message), 64));
+    }
+    digests.resize(32 * level.size());
+    utils::MultiDoubleSHA256(data.data(), data.size(), digests.data());
+    for (size_t i = 0; i < level.size(); ++i) {
+      memcpy(level[i]->digest, &digests[32 * i], 32);
+    }
+  }
+  return DigestToHash(std::string(
+      reinterpret_cast<const char*>(nodes.back().digest), 32));
 }
 
 }  // namespace resdb
@@ -25,7 +25,7 @@
 #include <boost/format.hpp>
 #include <thread>
 
-#include "common/crypto/signature_verifier.h"
+#include "common/crypto/sha256_multi.h"
 #include "platform/consensus/ordering/poc/pow/miner_utils.h"
 
 namespace resdb {
@@ -112,25 +112,35 @@ absl::Status Miner::Mine(Block* new_block) {
 
       ths.push_back(std::thread(
           [&](Block::Header header, std::pair<uint64_t, uint64_t> slice) {
-            std::string header_hash;
-            header_hash += GetHashDigest(header.pre_hash());
-            header_hash += GetHashDigest(header.merkle_hash());
-
-            for (uint64_t nonce = slice.first;
-                 nonce <= max_slice && !stop_ && !solution_found;
-                 nonce += step) {
-              // LOG(ERROR)<<" miner min:"<<slice.first<<" max:"<<max_slice<<"
-              // nonce"<<nonce;
-              header.set_nonce(nonce);
-              std::string str_value =
-                  header_hash + std::to_string(header.nonce());
-              std::string hash_digest = GetHashValue(str_value);
-
-              if (IsValidDigest(hash_digest, difficulty_)) {
+            utils::NonceSHA256 hasher(GetHeaderHashPrefix(header));
+            // The nonces are hashed in batches, one per lane of the SHA-256
+            // kernel.
+            constexpr size_t kBatchSize = 64;
+            uint64_t nonces[kBatchSize];
+            uint8_t digests[32 * kBatchSize];
+
+            uint64_t nonce = slice.first;
+            bool has_next = nonce <= max_slice;
+            while (has_next && !stop_ && !solution_found) {
+              size_t num = 0;
+              while (has_next && num < kBatchSize) {
+                nonces[num++] = nonce;
+                has_next = nonce + step > nonce && nonce + step <= max_slice;
+                nonce += step;
+              }
+              hasher.DoubleHash(nonces, num, digests);
+
+              for (size_t i = 0; i < num; ++i) {
+                if (!IsValidDigest(digests + 32 * i, 32, difficulty_)) {
+                  continue;
+                }
+                std::string hash_digest(
+                    reinterpret_cast<const char*>(digests + 32 * i), 32);
+                header.set_nonce(nonces[i]);
                 solution_found = true;
                 *new_block->mutable_hash() = DigestToHash(hash_digest);
                 *new_block->mutable_header() = header;
-                LOG(ERROR) << "nonce:" << nonce
+                LOG(ERROR) << "nonce:" << nonces[i]
                            << " hex string:" << GetDigestHexString(hash_digest)
                            << " target:" << difficulty_;
                 return;
@@ -164,15 +174,18 @@ void Miner::Terminate() {
   stop_ = true;
 }
 
-// Calculate the hash value: SHA256(SHA256(header))
+std::string Miner::GetHeaderHashPrefix(const Block::Header& header) {
+  return GetHashDigest(header.pre_hash()) + GetHashDigest(header.merkle_hash());
+}
+
+// Calculate the hash value: SHA256(SHA256(header)), where the nonce of the
+// header is encoded as 8 big-endian bytes.
 // The hash value will be a 32bit integer.
 std::string Miner::CalculatePoWHashDigest(const Block::Header& header) {
-  std::string str_value;
-  str_value += GetHashDigest(header.pre_hash());
-  str_value += GetHashDigest(header.merkle_hash());
-  str_value += std::to_string(header.nonce());
-  return SignatureVerifier::CalculateHash(
-      SignatureVerifier::CalculateHash(str_value));
+  uint64_t nonce = header.nonce();
+  uint8_t digest[32];
+  utils::NonceSHA256(GetHeaderHashPrefix(header)).DoubleHash(&nonce, 1, digest);
+  return std::string(reinterpret_cast<const char*>(digest), 32);
 }
 
 HashValue Miner::CalculatePoWHash(const Block* new_block) {
@@ -47,6 +47,8 @@ class Miner {
   void SetTargetValue(const HashValue& target_value);
 
  private:
+  // The pre hash and the merkle hash, hashed before the nonce.
+  static std::string GetHeaderHashPrefix(const Block::Header& header);
   std::string CalculatePoWHashDigest(const Block::Header& header);
   HashValue CalculatePoWHash(const Block* new_block);
 
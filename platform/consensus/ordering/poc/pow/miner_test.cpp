@@ -25,6 +25,7 @@
 
 #include <boost/format.hpp>
 
+#include "common/crypto/sha256_multi.h"
 #include "common/test/test_macros.h"
 #include "platform/config/resdb_config_utils.h"
 #include "platform/consensus/ordering/poc/pow/miner_utils.h"
@@ -110,12 +111,10 @@ TEST_F(MinerTest, Mine) {
   block.mutable_header()->set_height(1);
   block.mutable_header()->set_nonce(524292);
 
-  std::string expected_hash_header;
-  expected_hash_header += GetHashDigest(block.header().pre_hash());
-  expected_hash_header += GetHashDigest(block.header().merkle_hash());
-  expected_hash_header += std::to_string(block.header().nonce());
-
-  std::string expected_hash = GetHashValue(expected_hash_header);
+  std::string expected_hash = GetHashValue(utils::NonceSHA256::GetMessage(
+      GetHashDigest(block.header().pre_hash()) +
+          GetHashDigest(block.header().merkle_hash()),
+      block.header().nonce()));
 
   EXPECT_TRUE(miner.Mine(&block).ok());
   EXPECT_TRUE(
@@ -149,12 +148,10 @@ TEST_F(MinerTest, HashValid) {
   block.mutable_header()->set_height(1);
   block.mutable_header()->set_nonce(4);
 
-  std::string expected_hash_header;
-  expected_hash_header += GetHashDigest(block.header().pre_hash());
-  expected_hash_header += GetHashDigest(block.header().merkle_hash());
-  expected_hash_header += std::to_string(block.header().nonce());
-
-  std::string expected_hash = GetHashValue(expected_hash_header);
+  std::string expected_hash = GetHashValue(utils::NonceSHA256::GetMessage(
+      GetHashDigest(block.header().pre_hash()) +
+          GetHashDigest(block.header().merkle_hash()),
+      block.header().nonce()));
   *block.mutable_hash() = DigestToHash(expected_hash);
   EXPECT_TRUE(miner.IsValidHash(&block));
 }
@@ -173,12 +170,10 @@ TEST_F(MinerTest, HashNotValid) {
   block.mutable_header()->set_height(1);
   block.mutable_header()->set_nonce(4);
 
-  std::string expected_hash_header;
-  expected_hash_header += GetHashDigest(block.header().pre_hash());
-  expected_hash_header += GetHashDigest(block.header().merkle_hash());
-  expected_hash_header += std::to_string(block.header().nonce());
-
-  std::string expected_hash = GetHashValue(expected_hash_header);
+  std::string expected_hash = GetHashValue(utils::NonceSHA256::GetMessage(
+      GetHashDigest(block.header().pre_hash()) +
+          GetHashDigest(block.header().merkle_hash()),
+      block.header().nonce()));
   *block.mutable_hash() = DigestToHash(expected_hash);
   block.mutable_header()->set_nonce(5);
 
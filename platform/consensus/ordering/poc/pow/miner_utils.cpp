@@ -66,8 +66,13 @@ std::string GetDigestHexString(const std::string digest) {
 }
 
 bool IsValidDigest(const std::string& digest, uint32_t difficulty) {
+  return IsValidDigest(reinterpret_cast<const uint8_t*>(digest.data()),
+                       digest.size(), difficulty);
+}
+
+bool IsValidDigest(const uint8_t* digest, size_t size, uint32_t difficulty) {
   uint32_t num = 0;
-  for (size_t i = 0; i < digest.size(); ++i) {
+  for (size_t i = 0; i < size; ++i) {
     int zeros = 8;
     if (digest[i] == 0) {
     } else {
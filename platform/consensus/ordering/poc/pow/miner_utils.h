@@ -39,6 +39,7 @@ std::string GetDigestHexString(const std::string digest);
 
 // Check if the digest contains 'difficulty' number of zeros.
 bool IsValidDigest(const std::string& digest, uint32_t difficulty);
+bool IsValidDigest(const uint8_t* digest, size_t size, uint32_t difficulty);
 
 bool operator<(const HashValue& h1, const HashValue& h2);
 bool operator<=(const HashValue& h1, const HashValue& h2);
@@ -21,43 +21,174 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
+#include "common/crypto/hash.h"
 #include "common/crypto/signature_verifier.h"
 #include "common/utils/utils.h"
 
 namespace resdb {
 namespace poe {
 
-PoE::PoE(int id, int f, int total_num, SignatureVerifier* verifier)
-    : ProtocolBase(id, f, total_num), verifier_(verifier) {
+PoE::PoE(int id, int f, int total_num, SignatureVerifier* verifier,
+         int window_size)
+    : ProtocolBase(id, f, total_num),
+      window_size_(window_size),
+      slots_(window_size),
+      parked_num_(total_num + 1),
+      verifier_(verifier) {
   LOG(ERROR) << "get proposal graph";
   id_ = id;
   total_num_ = total_num;
   f_ = f;
   is_stop_ = false;
-  seq_ = 0;
+  seq_ = 1;
 }
 
 PoE::~PoE() { is_stop_ = true; }
 
 bool PoE::IsStop() { return is_stop_; }
 
-bool PoE::ReceiveTransaction(std::unique_ptr<Transaction> txn) {
+int64_t PoE::GetStableSeq() const { return stable_seq_; }
+
+void PoE::SetCheckpointInterval(int interval) {
+  checkpoint_interval_ = interval;
+}
+
+void PoE::SetStableCheckpointFunc(std::function<void(int64_t)> func) {
+  stable_checkpoint_func_ = func;
+}
+
+int64_t PoE::GetStableCheckpoint() {
+  std::unique_lock<std::mutex> lk(checkpoint_mutex_);
+  return stable_checkpoint_;
+}
+
+// The worker is not blocked while the ring is full, the transaction is
+// queued and proposed once the stable seq frees its slot.
+int PoE::ReceiveTransaction(std::unique_ptr<Transaction> txn) {
   // LOG(ERROR)<<"recv txn:";
+  {
+    std::unique_lock<std::mutex> lk(stable_mutex_);
+    if (!pending_txns_.empty() || seq_ > stable_seq_ + window_size_) {
+      if (pending_txns_.size() >= static_cast<size_t>(window_size_)) {
+        LOG(ERROR) << "too many pending transactions, drop it";
+        return -2;
+      }
+      pending_txns_.push_back(std::move(txn));
+      return 1;
+    }
+    txn->set_seq(seq_++);
+  }
+  Propose(std::move(txn));
+  return 0;
+}
+
+void PoE::Propose(std::unique_ptr<Transaction> txn) {
   txn->set_create_time(GetCurrentTime());
-  txn->set_seq(seq_++);
   txn->set_proposer(id_);
-
   Broadcast(MessageType::Propose, *txn);
+}
+
+PoE::Slot* PoE::AcquireSlot(int64_t seq, std::unique_lock<std::mutex>* lock) {
+  if (seq <= stable_seq_) {
+    return nullptr;
+  }
+  Slot* slot = &slots_[seq % window_size_];
+  *lock = std::unique_lock<std::mutex>(slot->mutex);
+  if (slot->seq != seq) {
+    // The previous seq of the slot is below the stable seq.
+    slot->seq = seq;
+    slot->txn = nullptr;
+    slot->hash.clear();
+    slot->prepares.clear();
+    slot->committed = false;
+  }
+  if (slot->committed) {
+    return nullptr;
+  }
+  return slot;
+}
+
+bool PoE::Park(int64_t seq, Parked* parked) {
+  std::unique_lock<std::mutex> lk(parked_mutex_);
+  if (seq <= stable_seq_ + window_size_) {
+    return false;
+  }
+  // Keep one more window, a proposal and a prepare from each sender per
+  // seq, so a faulty sender can not take the room of the others.
+  size_t& parked_num = parked_num_[parked->sender];
+  if (seq > stable_seq_ + 2 * window_size_ ||
+      parked_num >= 2 * static_cast<size_t>(window_size_)) {
+    LOG(ERROR) << "drop the message of seq:" << seq
+               << " from:" << parked->sender << " stable seq:" << stable_seq_;
+    return true;
+  }
+  ++parked_num;
+  parked_.emplace(seq, std::move(*parked));
   return true;
 }
 
+void PoE::Replay() {
+  std::vector<Parked> ready;
+  {
+    std::unique_lock<std::mutex> lk(parked_mutex_);
+    while (!parked_.empty() &&
+           parked_.begin()->first <= stable_seq_ + window_size_) {
+      --parked_num_[parked_.begin()->second.sender];
+      ready.push_back(std::move(parked_.begin()->second));
+      parked_.erase(parked_.begin());
+    }
+  }
+  for (Parked& parked : ready) {
+    if (parked.txn != nullptr) {
+      ReceivePropose(std::move(parked.txn));
+    } else {
+      ReceivePrepare(std::move(parked.proposal));
+    }
+  }
+}
+
+std::unique_ptr<Transaction> PoE::TryCommit(Slot* slot) {
+  if (slot->txn == nullptr) {
+    return nullptr;
+  }
+  for (const auto& it : slot->prepares) {
+    if (it.first != slot->hash) {
+      continue;
+    }
+    if (std::count(it.second.begin(), it.second.end(), true) < 2 * f_ + 1) {
+      return nullptr;
+    }
+    slot->committed = true;
+    slot->prepares.clear();
+    return std::move(slot->txn);
+  }
+  return nullptr;
+}
+
 bool PoE::ReceivePropose(std::unique_ptr<Transaction> txn) {
+  if (txn->proposer() < 1 || txn->proposer() > total_num_) {
+    return false;
+  }
   std::string hash = txn->hash();
   int64_t seq = txn->seq();
-  int proposer = txn->proposer();
+  int sender = txn->proposer();
+  Parked parked{std::move(txn), nullptr, sender};
+  if (Park(seq, &parked)) {
+    return true;
+  }
+  txn = std::move(parked.txn);
+  std::unique_ptr<Transaction> committed_txn;
   {
-    std::unique_lock<std::mutex> lk(mutex_);
-    data_[txn->hash()] = std::move(txn);
+    std::unique_lock<std::mutex> lk;
+    Slot* slot = AcquireSlot(seq, &lk);
+    if (slot == nullptr || slot->txn != nullptr) {
+      return false;
+    }
+    slot->hash = hash;
+    slot->txn = std::move(txn);
+    committed_txn = TryCommit(slot);
   }
 
   Proposal proposal;
@@ -65,24 +196,140 @@ bool PoE::ReceivePropose(std::unique_ptr<Transaction> txn) {
   proposal.set_seq(seq);
   proposal.set_proposer(id_);
   Broadcast(MessageType::Prepare, proposal);
+
+  if (committed_txn != nullptr) {
+    commit_(*committed_txn);
+    AdvanceStableSeq();
+  }
   return true;
 }
 
 bool PoE::ReceivePrepare(std::unique_ptr<Proposal> proposal) {
+  if (proposal->proposer() < 1 || proposal->proposer() > total_num_) {
+    return false;
+  }
+  int64_t seq = proposal->seq();
+  int sender = proposal->proposer();
+  Parked parked{nullptr, std::move(proposal), sender};
+  if (Park(seq, &parked)) {
+    return true;
+  }
+  proposal = std::move(parked.proposal);
   std::unique_ptr<Transaction> txn = nullptr;
   {
-    std::unique_lock<std::mutex> lk(mutex_);
-    received_[proposal->hash()].insert(proposal->proposer());
-    auto it = data_.find(proposal->hash());
-    if (it != data_.end()) {
-      if (received_[proposal->hash()].size() >= 2 * f_ + 1) {
-        txn = std::move(it->second);
-        data_.erase(it);
+    std::unique_lock<std::mutex> lk;
+    Slot* slot = AcquireSlot(seq, &lk);
+    if (slot == nullptr) {
+      return false;
+    }
+    std::vector<bool>* senders = nullptr;
+    for (auto& it : slot->prepares) {
+      if (it.first == proposal->hash()) {
+        senders = &it.second;
       }
     }
+    if (senders == nullptr) {
+      slot->prepares.emplace_back(proposal->hash(),
+                                  std::vector<bool>(total_num_ + 1));
+      senders = &slot->prepares.back().second;
+    }
+    (*senders)[proposal->proposer()] = true;
+    txn = TryCommit(slot);
   }
   if (txn != nullptr) {
     commit_(*txn);
+    AdvanceStableSeq();
+  }
+  return true;
+}
+
+void PoE::AdvanceStableSeq() {
+  std::vector<Checkpoint> checkpoints;
+  std::vector<std::unique_ptr<Transaction>> txns;
+  {
+    std::unique_lock<std::mutex> lk(stable_mutex_);
+    while (true) {
+      int64_t next = stable_seq_ + 1;
+      Slot* slot = &slots_[next % window_size_];
+      std::unique_lock<std::mutex> slot_lk(slot->mutex);
+      if (slot->seq != next || !slot->committed) {
+        break;
+      }
+      stable_seq_ = next;
+      if (checkpoint_interval_ <= 0) {
+        continue;
+      }
+      checkpoint_data_ += slot->hash;
+      if (next % checkpoint_interval_ == 0) {
+        last_digest_ =
+            utils::CalculateSHA256Hash(last_digest_ + checkpoint_data_);
+        checkpoint_data_.clear();
+        Checkpoint checkpoint;
+        checkpoint.set_seq(next);
+        checkpoint.set_digest(last_digest_);
+        checkpoint.set_sender(id_);
+        checkpoints.push_back(std::move(checkpoint));
+      }
+    }
+    while (!pending_txns_.empty() && seq_ <= stable_seq_ + window_size_) {
+      pending_txns_.front()->set_seq(seq_++);
+      txns.push_back(std::move(pending_txns_.front()));
+      pending_txns_.pop_front();
+    }
+  }
+  for (auto& txn : txns) {
+    Propose(std::move(txn));
+  }
+  for (const Checkpoint& checkpoint : checkpoints) {
+    {
+      std::unique_lock<std::mutex> lk(checkpoint_mutex_);
+      digests_[checkpoint.seq()] = checkpoint.digest();
+    }
+    Broadcast(MessageType::CheckpointMsg, checkpoint);
+  }
+  Replay();
+}
+
+bool PoE::TryStableCheckpoint(int64_t seq) {
+  auto digest_it = digests_.find(seq);
+  if (seq <= stable_checkpoint_ || digest_it == digests_.end()) {
+    return false;
+  }
+  auto seq_it = votes_.find(seq);
+  if (seq_it == votes_.end()) {
+    return false;
+  }
+  auto vote_it = seq_it->second.find(digest_it->second);
+  if (vote_it == seq_it->second.end() ||
+      std::count(vote_it->second.begin(), vote_it->second.end(), true) <
+          2 * f_ + 1) {
+    return false;
+  }
+  stable_checkpoint_ = seq;
+  digests_.erase(digests_.begin(), ++digest_it);
+  votes_.erase(votes_.begin(), ++seq_it);
+  return true;
+}
+
+bool PoE::ReceiveCheckpoint(std::unique_ptr<Checkpoint> checkpoint) {
+  if (checkpoint->sender() < 1 || checkpoint->sender() > total_num_) {
+    return false;
+  }
+  int64_t seq = checkpoint->seq();
+  {
+    std::unique_lock<std::mutex> lk(checkpoint_mutex_);
+    if (seq <= stable_checkpoint_) {
+      return false;
+    }
+    std::vector<bool>& senders = votes_[seq][checkpoint->digest()];
+    senders.resize(total_num_ + 1);
+    senders[checkpoint->sender()] = true;
+    if (!TryStableCheckpoint(seq)) {
+      return true;
+    }
+  }
+  if (stable_checkpoint_func_) {
+    stable_checkpoint_func_(seq);
   }
   return true;
 }
@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <queue>
 #include <thread>
@@ -34,22 +36,92 @@ namespace poe {
 
 class PoE : public common::ProtocolBase {
  public:
-  PoE(int id, int f, int total_num, SignatureVerifier* verifier);
+  // The in-flight transactions are kept in a ring of window_size slots
+  // indexed by seq.
+  PoE(int id, int f, int total_num, SignatureVerifier* verifier,
+      int window_size = 1 << 16);
   ~PoE();
 
-  bool ReceiveTransaction(std::unique_ptr<Transaction> txn);
+  // Returns 0 if the transaction is proposed, 1 if the ring is full and it
+  // is queued to be proposed later, -2 if the queue is full as well and it
+  // is dropped.
+  int ReceiveTransaction(std::unique_ptr<Transaction> txn);
   bool ReceivePropose(std::unique_ptr<Transaction> txn);
   bool ReceivePrepare(std::unique_ptr<Proposal> proposal);
+  bool ReceiveCheckpoint(std::unique_ptr<Checkpoint> checkpoint);
+
+  // All the seqs up to it are committed and their slots are free.
+  int64_t GetStableSeq() const;
+
+  // A checkpoint is broadcast every interval committed seqs and becomes
+  // stable once 2f+1 replicas agree on its digest.
+  void SetCheckpointInterval(int interval);
+  void SetStableCheckpointFunc(std::function<void(int64_t)> func);
+  int64_t GetStableCheckpoint();
 
  private:
   bool IsStop();
 
+  // The state of one seq. A slot is reused for seq + window_size once seq
+  // is committed and the stable seq passed it.
+  struct Slot {
+    std::mutex mutex;
+    int64_t seq = 0;
+    std::unique_ptr<Transaction> txn;
+    std::string hash;
+    // The prepare senders of each hash, prepares can arrive before the
+    // proposal.
+    std::vector<std::pair<std::string, std::vector<bool>>> prepares;
+    bool committed = false;
+  };
+
+  // Messages above the window of a replica lagging behind, replayed once
+  // the stable seq moves.
+  struct Parked {
+    std::unique_ptr<Transaction> txn;
+    std::unique_ptr<Proposal> proposal;
+    int sender = 0;
+  };
+
+  // Returns the slot locked for seq, nullptr if seq is committed.
+  Slot* AcquireSlot(int64_t seq, std::unique_lock<std::mutex>* lock);
+  // Park the message if seq is above the window. Returns true if it is
+  // above the window, the message is dropped if it is too far away or its
+  // sender has too many messages parked.
+  bool Park(int64_t seq, Parked* parked);
+  void Replay();
+  void Propose(std::unique_ptr<Transaction> txn);
+  // Must be called holding the slot mutex.
+  std::unique_ptr<Transaction> TryCommit(Slot* slot);
+  void AdvanceStableSeq();
+  // Must be called holding checkpoint_mutex_.
+  bool TryStableCheckpoint(int64_t seq);
+
  private:
-  std::mutex mutex_;
-  std::map<std::string, std::set<int32_t> > received_;
-  std::map<std::string, std::unique_ptr<Transaction> > data_;
+  const int window_size_;
+  std::vector<Slot> slots_;
+  std::atomic<int64_t> stable_seq_ = 0;
+  std::mutex stable_mutex_;
+  // The transactions waiting for a free slot, guarded by stable_mutex_.
+  std::deque<std::unique_ptr<Transaction>> pending_txns_;
+  std::mutex parked_mutex_;
+  std::multimap<int64_t, Parked> parked_;
+  // The number of parked messages of each sender.
+  std::vector<size_t> parked_num_;
+
+  int checkpoint_interval_ = 0;
+  std::function<void(int64_t)> stable_checkpoint_func_;
+  // The hashes committed since the last checkpoint, guarded by
+  // stable_mutex_.
+  std::string checkpoint_data_;
+  std::string last_digest_;
+  std::mutex checkpoint_mutex_;
+  int64_t stable_checkpoint_ = 0;
+  // The digests of the local checkpoints above the stable one.
+  std::map<int64_t, std::string> digests_;
+  std::map<int64_t, std::map<std::string, std::vector<bool>>> votes_;
 
-  int64_t seq_;
+  std::atomic<int64_t> seq_;
   bool is_stop_;
   SignatureVerifier* verifier_;
   Stats* global_stats_;
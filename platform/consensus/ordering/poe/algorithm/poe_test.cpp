@@ -0,0 +1,255 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/poe/algorithm/poe.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+
+namespace resdb {
+namespace poe {
+namespace {
+
+// Runs n replicas in one thread, delivering the messages in FIFO order.
+class Cluster {
+ public:
+  struct Message {
+    int type;
+    std::string data;
+    int to;
+  };
+
+  Cluster(int n, int window_size, int checkpoint_interval = 0)
+      : n_(n), committed_(n + 1), stable_checkpoints_(n + 1) {
+    for (int i = 1; i <= n; ++i) {
+      auto replica =
+          std::make_unique<PoE>(i, (n - 1) / 3, n, nullptr, window_size);
+      replica->SetCheckpointInterval(checkpoint_interval);
+      replica->SetStableCheckpointFunc([this, i](int64_t seq) {
+        stable_checkpoints_[i].push_back(seq);
+      });
+      replica->SetBroadcastCallFunc(
+          [this](int type, const google::protobuf::Message& msg) {
+            for (int j = 1; j <= n_; ++j) {
+              queue_.push_back({type, msg.SerializeAsString(), j});
+            }
+            return 0;
+          });
+      replica->SetCommitFunc([this, i](const google::protobuf::Message& msg) {
+        committed_[i].push_back(dynamic_cast<const Transaction&>(msg).seq());
+        return 0;
+      });
+      replicas_.push_back(std::move(replica));
+    }
+  }
+
+  void Submit(const std::string& data) {
+    auto txn = std::make_unique<Transaction>();
+    txn->set_data(data);
+    txn->set_hash("hash_" + data);
+    replicas_[0]->ReceiveTransaction(std::move(txn));
+  }
+
+  // Deliver all the messages, except those filtered out which are dropped.
+  void Run(std::function<bool(const Message&)> drop = nullptr) {
+    while (!queue_.empty()) {
+      Message msg = std::move(queue_.front());
+      queue_.pop_front();
+      if (!drop || !drop(msg)) {
+        Deliver(msg);
+      }
+    }
+  }
+
+  void Deliver(const Message& msg) {
+    PoE* replica = replicas_[msg.to - 1].get();
+    if (msg.type == MessageType::Propose) {
+      auto txn = std::make_unique<Transaction>();
+      ASSERT_TRUE(txn->ParseFromString(msg.data));
+      replica->ReceivePropose(std::move(txn));
+    } else if (msg.type == MessageType::CheckpointMsg) {
+      auto checkpoint = std::make_unique<Checkpoint>();
+      ASSERT_TRUE(checkpoint->ParseFromString(msg.data));
+      replica->ReceiveCheckpoint(std::move(checkpoint));
+    } else {
+      auto proposal = std::make_unique<Proposal>();
+      ASSERT_TRUE(proposal->ParseFromString(msg.data));
+      replica->ReceivePrepare(std::move(proposal));
+    }
+  }
+
+  PoE* GetReplica(int id) { return replicas_[id - 1].get(); }
+  const std::vector<int64_t>& Committed(int id) { return committed_[id]; }
+  const std::vector<int64_t>& StableCheckpoints(int id) {
+    return stable_checkpoints_[id];
+  }
+
+ private:
+  int n_;
+  std::deque<Message> queue_;
+  std::vector<std::unique_ptr<PoE>> replicas_;
+  std::vector<std::vector<int64_t>> committed_;
+  std::vector<std::vector<int64_t>> stable_checkpoints_;
+};
+
+TEST(PoETest, CommitFromSeqOne) {
+  Cluster cluster(4, 16);
+  for (int i = 0; i < 10; ++i) {
+    cluster.Submit(std::to_string(i));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    ASSERT_EQ(cluster.Committed(i).size(), 10);
+    EXPECT_EQ(cluster.Committed(i).front(), 1);
+    EXPECT_EQ(cluster.Committed(i).back(), 10);
+    EXPECT_EQ(cluster.GetReplica(i)->GetStableSeq(), 10);
+  }
+}
+
+TEST(PoETest, ReuseSlots) {
+  Cluster cluster(4, 4);
+  for (int i = 0; i < 50; ++i) {
+    cluster.Submit(std::to_string(i));
+    if (i % 3 == 2) {
+      cluster.Run();
+    }
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 50);
+    EXPECT_EQ(cluster.GetReplica(i)->GetStableSeq(), 50);
+  }
+}
+
+TEST(PoETest, QueueTransactionsWhenRingIsFull) {
+  Cluster cluster(4, 4);
+  // Only the transactions within the window are proposed, the others wait
+  // for free slots instead of blocking the caller. One window of them is
+  // queued, the rest are dropped.
+  for (int i = 0; i < 10; ++i) {
+    auto txn = std::make_unique<Transaction>();
+    txn->set_data(std::to_string(i));
+    txn->set_hash("hash_" + std::to_string(i));
+    EXPECT_EQ(cluster.GetReplica(1)->ReceiveTransaction(std::move(txn)),
+              i < 4 ? 0 : (i < 8 ? 1 : -2));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 8);
+    EXPECT_EQ(cluster.GetReplica(i)->GetStableSeq(), 8);
+  }
+}
+
+TEST(PoETest, DropMessagesTooFarAway) {
+  Cluster cluster(4, 4);
+  auto prepare = std::make_unique<Proposal>();
+  prepare->set_hash("hash_test");
+  prepare->set_seq(100);
+  prepare->set_proposer(2);
+  EXPECT_TRUE(cluster.GetReplica(1)->ReceivePrepare(std::move(prepare)));
+  // Nothing is replayed for it.
+  cluster.Submit("test");
+  cluster.Run();
+  EXPECT_EQ(cluster.GetReplica(1)->GetStableSeq(), 1);
+}
+
+TEST(PoETest, IgnoreCommittedAndParkOutOfWindow) {
+  Cluster cluster(4, 4);
+  cluster.Submit("test");
+  cluster.Run();
+
+  auto prepare = std::make_unique<Proposal>();
+  prepare->set_hash("hash_test");
+  prepare->set_seq(1);
+  prepare->set_proposer(2);
+  EXPECT_FALSE(cluster.GetReplica(2)->ReceivePrepare(std::move(prepare)));
+
+  // Replica 4 misses seq 2 to 6 while the others move on, the messages
+  // above its window are replayed once it catches up.
+  std::vector<Cluster::Message> delayed;
+  auto delay = [&](const Cluster::Message& msg) {
+    if (msg.to == 4) {
+      delayed.push_back(msg);
+      return true;
+    }
+    return false;
+  };
+  for (int i = 2; i <= 6; ++i) {
+    cluster.Submit(std::to_string(i));
+    cluster.Run(delay);
+  }
+  EXPECT_EQ(cluster.GetReplica(1)->GetStableSeq(), 6);
+  EXPECT_EQ(cluster.GetReplica(4)->GetStableSeq(), 1);
+  for (auto it = delayed.rbegin(); it != delayed.rend(); ++it) {
+    cluster.Deliver(*it);
+  }
+  EXPECT_EQ(cluster.GetReplica(4)->GetStableSeq(), 6);
+  EXPECT_EQ(cluster.Committed(4).size(), 6);
+}
+
+TEST(PoETest, ParkedMessagesLimitedPerSender) {
+  Cluster cluster(4, 4);
+  cluster.Submit("test");
+  cluster.Run();
+
+  std::vector<Cluster::Message> delayed;
+  auto delay = [&](const Cluster::Message& msg) {
+    if (msg.to == 4) {
+      delayed.push_back(msg);
+      return true;
+    }
+    return false;
+  };
+  for (int i = 2; i <= 6; ++i) {
+    cluster.Submit(std::to_string(i));
+    cluster.Run(delay);
+  }
+
+  // The replica 2 floods the lagging replica with prepares above its
+  // window, only its own share is parked.
+  for (int i = 0; i < 20; ++i) {
+    auto prepare = std::make_unique<Proposal>();
+    prepare->set_hash("fake_" + std::to_string(i));
+    prepare->set_seq(6);
+    prepare->set_proposer(2);
+    EXPECT_TRUE(cluster.GetReplica(4)->ReceivePrepare(std::move(prepare)));
+  }
+  for (auto it = delayed.rbegin(); it != delayed.rend(); ++it) {
+    cluster.Deliver(*it);
+  }
+  cluster.Run();
+  EXPECT_EQ(cluster.GetReplica(4)->GetStableSeq(), 6);
+}
+
+TEST(PoETest, StableCheckpoint) {
+  Cluster cluster(4, 16, 5);
+  for (int i = 0; i < 12; ++i) {
+    cluster.Submit(std::to_string(i));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.StableCheckpoints(i), std::vector<int64_t>({5, 10}));
+    EXPECT_EQ(cluster.GetReplica(i)->GetStableCheckpoint(), 10);
+  }
+}
+
+}  // namespace
+}  // namespace poe
+}  // namespace resdb
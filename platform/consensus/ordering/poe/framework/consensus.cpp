@@ -58,6 +58,15 @@ Consensus::Consensus(const ResDBConfig& config,
     poe_ = std::make_unique<PoE>(config_.GetSelfInfo().id(), f, total_replicas,
                                  GetSignatureVerifier());
     InitProtocol(poe_.get());
+
+    speculative_storage_ = dynamic_cast<storage::SpeculativeStorage*>(
+        transaction_executor_->GetStorage());
+    if (speculative_storage_ != nullptr) {
+      poe_->SetCheckpointInterval(config_.GetCheckPointWaterMark());
+      poe_->SetStableCheckpointFunc([&](int64_t seq) {
+        speculative_storage_->Stabilize(seq);
+      });
+    }
   }
 }
 
@@ -69,6 +78,12 @@ int Consensus::ProcessCustomConsensus(std::unique_ptr<Request> request) {
       LOG(ERROR) << "parse proposal fail";
       return -1;
     }
+    // The parked messages are limited by the sender.
+    if (txn->proposer() != request->sender_id()) {
+      LOG(ERROR) << "proposer " << txn->proposer()
+                 << " is not the sender:" << request->sender_id();
+      return -2;
+    }
     poe_->ReceivePropose(std::move(txn));
     return 0;
   } else if (request->user_type() == MessageType::Prepare) {
@@ -78,8 +93,21 @@ int Consensus::ProcessCustomConsensus(std::unique_ptr<Request> request) {
       assert(1 == 0);
       return -1;
     }
+    if (proposal->proposer() != request->sender_id()) {
+      LOG(ERROR) << "proposer " << proposal->proposer()
+                 << " is not the sender:" << request->sender_id();
+      return -2;
+    }
     poe_->ReceivePrepare(std::move(proposal));
     return 0;
+  } else if (request->user_type() == MessageType::CheckpointMsg) {
+    std::unique_ptr<Checkpoint> checkpoint = std::make_unique<Checkpoint>();
+    if (!checkpoint->ParseFromString(request->data())) {
+      LOG(ERROR) << "parse checkpoint fail";
+      return -1;
+    }
+    poe_->ReceiveCheckpoint(std::move(checkpoint));
+    return 0;
   }
   return 0;
 }
@@ -90,7 +118,11 @@ int Consensus::ProcessNewTransaction(std::unique_ptr<Request> request) {
   txn->set_hash(request->hash());
   txn->set_proxy_id(request->proxy_id());
   txn->set_uid(request->uid());
-  return poe_->ReceiveTransaction(std::move(txn));
+  // The queued transactions are proposed once the ring has a free slot.
+  if (poe_->ReceiveTransaction(std::move(txn)) < 0) {
+    return -2;
+  }
+  return 0;
 }
 
 int Consensus::CommitMsg(const google::protobuf::Message& msg) {
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "chain/storage/speculative_storage.h"
 #include "executor/common/transaction_manager.h"
 #include "platform/consensus/ordering/common/framework/consensus.h"
 #include "platform/consensus/ordering/poe/algorithm/poe.h"
@@ -46,6 +47,8 @@ class Consensus : public common::Consensus {
 
  protected:
   std::unique_ptr<PoE> poe_;
+  // Set if the executor runs on a speculative storage.
+  storage::SpeculativeStorage* speculative_storage_ = nullptr;
   Stats* global_stats_;
   int64_t start_;
   std::mutex mutex_;
@@ -0,0 +1,613 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/rcc/algorithm/rcc.h"
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include "common/utils/utils.h"
+
+namespace resdb {
+namespace rcc {
+
+RCC::RCC(int id, int f, int total_num, int instance_num,
+         SignatureVerifier* verifier, int timeout_ms)
+    : ProtocolBase(id, f, total_num),
+      instance_num_(std::max(1, std::min(instance_num, total_num))),
+      orderer_(instance_num_,
+               [this](std::unique_ptr<Transaction> txn) {
+                 ProtocolBase::Commit(*txn);
+               }),
+      timeout_ms_(timeout_ms) {
+  verifier_ = verifier;
+  for (int i = 0; i < instance_num_; ++i) {
+    instances_.push_back(std::make_unique<Instance>());
+  }
+  if (timeout_ms_ > 0) {
+    monitor_thread_ = std::thread(&RCC::Monitor, this);
+  }
+  LOG(ERROR) << "rcc id:" << id_ << " instances:" << instance_num_
+             << " timeout:" << timeout_ms_;
+}
+
+RCC::~RCC() {
+  Stop();
+  if (monitor_thread_.joinable()) {
+    monitor_thread_.join();
+  }
+}
+
+int RCC::GetLeader(int instance, int64_t view) const {
+  return (instance - 1 + view) % total_num_ + 1;
+}
+
+int RCC::GetInstanceNum() const { return instance_num_; }
+
+int64_t RCC::GetView(int instance) {
+  Instance* inst = instances_[instance - 1].get();
+  std::unique_lock<std::mutex> lk(inst->mutex);
+  return inst->view;
+}
+
+void RCC::UpdateMaxRound(int64_t round) {
+  int64_t current = max_round_.load();
+  while (current < round && !max_round_.compare_exchange_weak(current, round)) {
+  }
+}
+
+std::vector<int> RCC::GetLeadInstances() {
+  std::vector<int> lead;
+  for (int k = 1; k <= instance_num_; ++k) {
+    Instance* inst = instances_[k - 1].get();
+    std::unique_lock<std::mutex> lk(inst->mutex);
+    if (GetLeader(k, inst->view) == id_ && inst->pending_view == inst->view) {
+      lead.push_back(k);
+    }
+  }
+  return lead;
+}
+
+bool RCC::ReceiveTransaction(std::unique_ptr<Transaction> txn) {
+  std::vector<int> lead = GetLeadInstances();
+  if (lead.empty()) {
+    // Each replica sends its clients' transactions to one instance.
+    int instance = (id_ - 1) % instance_num_ + 1;
+    int leader = GetLeader(instance, GetView(instance));
+    SendMessage(MessageType::Forward, *txn, leader);
+    return true;
+  }
+  txn->set_noop(false);
+  return Propose(lead[next_lead_++ % lead.size()], std::move(txn));
+}
+
+bool RCC::Propose(int instance, std::unique_ptr<Transaction> txn) {
+  Instance* inst = instances_[instance - 1].get();
+  {
+    std::unique_lock<std::mutex> lk(inst->mutex);
+    if (GetLeader(instance, inst->view) != id_ ||
+        inst->pending_view != inst->view) {
+      return false;
+    }
+    txn->set_instance(instance);
+    txn->set_round(inst->next_round++);
+    txn->set_view(inst->view);
+    txn->set_proposer(id_);
+    txn->set_create_time(GetCurrentTime());
+  }
+  Broadcast(MessageType::Propose, *txn);
+  return true;
+}
+
+void RCC::FillNoop() {
+  int64_t target = max_round_.load();
+  for (int k = 1; k <= instance_num_; ++k) {
+    std::vector<Transaction> noops;
+    Instance* inst = instances_[k - 1].get();
+    {
+      std::unique_lock<std::mutex> lk(inst->mutex);
+      if (GetLeader(k, inst->view) != id_ ||
+          inst->pending_view != inst->view) {
+        continue;
+      }
+      while (inst->next_round <= target) {
+        Transaction noop;
+        noop.set_hash("noop");
+        noop.set_noop(true);
+        noop.set_instance(k);
+        noop.set_round(inst->next_round++);
+        noop.set_view(inst->view);
+        noop.set_proposer(id_);
+        noops.push_back(std::move(noop));
+      }
+    }
+    for (const Transaction& noop : noops) {
+      Broadcast(MessageType::Propose, noop);
+    }
+  }
+}
+
+bool RCC::IsCommitted(const Instance& instance, int64_t round) const {
+  return round <= instance.committed_round || instance.committed.count(round);
+}
+
+std::string RCC::GetPrepareMessage(int instance, int64_t round, int64_t view,
+                                   const std::string& hash) const {
+  return "rcc:prepare:" + std::to_string(instance) + ":" +
+         std::to_string(round) + ":" + std::to_string(view) + ":" + hash;
+}
+
+// The prepared transactions are covered by the signatures of their prepares,
+// so only their rounds, views and hashes are signed again.
+std::string RCC::GetViewChangeMessage(const ViewChange& view_change) const {
+  std::string message =
+      "rcc:view_change:" + std::to_string(view_change.instance()) + ":" +
+      std::to_string(view_change.view()) + ":" +
+      std::to_string(view_change.sender()) + ":" +
+      std::to_string(view_change.committed_round());
+  for (const PreparedProof& proof : view_change.prepared()) {
+    message += ":" + std::to_string(proof.txn().round()) + ":" +
+               std::to_string(proof.txn().view()) + ":" + proof.txn().hash();
+  }
+  return message;
+}
+
+std::unique_ptr<Prepare> RCC::NewPrepare(const Transaction& txn) const {
+  auto prepare = std::make_unique<Prepare>();
+  prepare->set_hash(txn.hash());
+  prepare->set_instance(txn.instance());
+  prepare->set_round(txn.round());
+  prepare->set_view(txn.view());
+  prepare->set_sender(id_);
+  if (verifier_) {
+    auto signature_or = verifier_->SignMessage(GetPrepareMessage(
+        txn.instance(), txn.round(), txn.view(), txn.hash()));
+    if (signature_or.ok()) {
+      *prepare->mutable_signature() = *signature_or;
+    }
+  }
+  prepare->mutable_signature()->set_node_id(id_);
+  return prepare;
+}
+
+bool RCC::VerifyPreparedProof(int instance, const PreparedProof& proof) const {
+  const Transaction& txn = proof.txn();
+  if (txn.instance() != instance) {
+    return false;
+  }
+  std::string message =
+      GetPrepareMessage(instance, txn.round(), txn.view(), txn.hash());
+  std::set<int64_t> signers;
+  for (const SignatureInfo& signature : proof.signatures()) {
+    if (verifier_ && !verifier_->VerifyMessage(message, signature)) {
+      return false;
+    }
+    signers.insert(signature.node_id());
+  }
+  return signers.size() >= static_cast<size_t>(2 * f_ + 1);
+}
+
+bool RCC::VerifyViewChange(const ViewChange& view_change) const {
+  if (view_change.signature().node_id() != view_change.sender()) {
+    return false;
+  }
+  if (verifier_ && !verifier_->VerifyMessage(GetViewChangeMessage(view_change),
+                                             view_change.signature())) {
+    return false;
+  }
+  for (const PreparedProof& proof : view_change.prepared()) {
+    if (proof.txn().view() >= view_change.view() ||
+        !VerifyPreparedProof(view_change.instance(), proof)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<Transaction> RCC::TryCommit(Instance* instance,
+                                            int64_t round) {
+  auto it = instance->proposals.find(round);
+  if (it == instance->proposals.end() || IsCommitted(*instance, round)) {
+    return nullptr;
+  }
+  auto prepare_it = instance->prepares.find(
+      std::make_tuple(round, it->second->view(), it->second->hash()));
+  if (prepare_it == instance->prepares.end() ||
+      prepare_it->second.size() < static_cast<size_t>(2 * f_ + 1)) {
+    return nullptr;
+  }
+
+  PreparedProof& proof = instance->prepared[round];
+  *proof.mutable_txn() = *it->second;
+  for (const auto& signature : prepare_it->second) {
+    *proof.add_signatures() = signature.second;
+  }
+
+  instance->committed.insert(round);
+  while (instance->committed.count(instance->committed_round + 1)) {
+    instance->committed.erase(++instance->committed_round);
+  }
+  while (!instance->prepares.empty() &&
+         std::get<0>(instance->prepares.begin()->first) <=
+             instance->committed_round) {
+    instance->prepares.erase(instance->prepares.begin());
+  }
+  while (!instance->proposals.empty() &&
+         instance->proposals.begin()->first + kRetainRounds <=
+             instance->committed_round) {
+    instance->proposals.erase(instance->proposals.begin());
+  }
+  while (!instance->prepared.empty() &&
+         instance->prepared.begin()->first + kRetainRounds <=
+             instance->committed_round) {
+    instance->prepared.erase(instance->prepared.begin());
+  }
+  return std::make_unique<Transaction>(proof.txn());
+}
+
+bool RCC::ReceivePropose(std::unique_ptr<Transaction> txn) {
+  int k = txn->instance();
+  if (k < 1 || k > instance_num_) {
+    return false;
+  }
+  Instance* inst = instances_[k - 1].get();
+  std::vector<Outgoing> outgoing;
+  std::vector<std::unique_ptr<Transaction>> committed;
+  {
+    std::unique_lock<std::mutex> lk(inst->mutex);
+    if (txn->view() != inst->view || inst->pending_view != inst->view ||
+        txn->proposer() != GetLeader(k, inst->view) ||
+        IsCommitted(*inst, txn->round())) {
+      return false;
+    }
+    auto it = inst->proposals.find(txn->round());
+    if (it != inst->proposals.end() && it->second->view() == txn->view()) {
+      if (it->second->hash() != txn->hash()) {
+        LOG(ERROR) << "conflicting proposals from leader:" << txn->proposer()
+                   << " instance:" << k << " round:" << txn->round();
+      }
+      return false;
+    }
+    outgoing.push_back({MessageType::PrepareMsg, 0, NewPrepare(*txn)});
+    int64_t round = txn->round();
+    inst->proposals[round] = std::move(txn);
+    auto txn_committed = TryCommit(inst, round);
+    if (txn_committed) {
+      committed.push_back(std::move(txn_committed));
+    }
+  }
+  Send(&outgoing);
+  Release(&committed);
+  return true;
+}
+
+bool RCC::ReceivePrepare(std::unique_ptr<Prepare> prepare) {
+  int k = prepare->instance();
+  if (k < 1 || k > instance_num_ ||
+      prepare->signature().node_id() != prepare->sender()) {
+    return false;
+  }
+  if (verifier_ && !verifier_->VerifyMessage(
+                       GetPrepareMessage(k, prepare->round(), prepare->view(),
+                                         prepare->hash()),
+                       prepare->signature())) {
+    LOG(ERROR) << "invalid prepare from:" << prepare->sender();
+    return false;
+  }
+  Instance* inst = instances_[k - 1].get();
+  std::vector<std::unique_ptr<Transaction>> committed;
+  {
+    std::unique_lock<std::mutex> lk(inst->mutex);
+    // Prepares of a view not installed yet are kept.
+    if (prepare->view() < inst->view ||
+        IsCommitted(*inst, prepare->round())) {
+      return false;
+    }
+    inst->prepares[std::make_tuple(prepare->round(), prepare->view(),
+                                   prepare->hash())][prepare->sender()] =
+        std::move(*prepare->mutable_signature());
+    auto txn = TryCommit(inst, prepare->round());
+    if (txn) {
+      committed.push_back(std::move(txn));
+    }
+  }
+  Release(&committed);
+  return true;
+}
+
+void RCC::StartViewChange(int instance) {
+  if (instance < 1 || instance > instance_num_) {
+    return;
+  }
+  Instance* inst = instances_[instance - 1].get();
+  std::vector<Outgoing> outgoing;
+  {
+    std::unique_lock<std::mutex> lk(inst->mutex);
+    StartViewChange(instance, inst, inst->pending_view + 1, &outgoing);
+  }
+  Send(&outgoing);
+}
+
+void RCC::StartViewChange(int index, Instance* instance, int64_t view,
+                          std::vector<Outgoing>* outgoing) {
+  if (view <= instance->pending_view) {
+    return;
+  }
+  LOG(ERROR) << "instance:" << index << " view change to:" << view
+             << " new leader:" << GetLeader(index, view);
+  instance->pending_view = view;
+  instance->view_change_time = GetCurrentTime();
+
+  auto view_change = std::make_unique<ViewChange>();
+  view_change->set_instance(index);
+  view_change->set_view(view);
+  view_change->set_sender(id_);
+  view_change->set_committed_round(instance->committed_round);
+  for (const auto& it : instance->prepared) {
+    *view_change->add_prepared() = it.second;
+  }
+  if (verifier_) {
+    auto signature_or =
+        verifier_->SignMessage(GetViewChangeMessage(*view_change));
+    if (signature_or.ok()) {
+      *view_change->mutable_signature() = *signature_or;
+    }
+  }
+  view_change->mutable_signature()->set_node_id(id_);
+  outgoing->push_back({MessageType::ViewChangeMsg, 0, std::move(view_change)});
+}
+
+bool RCC::ReceiveViewChange(std::unique_ptr<ViewChange> view_change) {
+  int k = view_change->instance();
+  if (k < 1 || k > instance_num_) {
+    return false;
+  }
+  if (!VerifyViewChange(*view_change)) {
+    LOG(ERROR) << "invalid view change from:" << view_change->sender()
+               << " instance:" << k;
+    return false;
+  }
+  Instance* inst = instances_[k - 1].get();
+  std::vector<Outgoing> outgoing;
+  {
+    std::unique_lock<std::mutex> lk(inst->mutex);
+    int64_t view = view_change->view();
+    if (view <= inst->view) {
+      return false;
+    }
+    auto& view_changes = inst->view_changes[view];
+    view_changes[view_change->sender()] = std::move(*view_change);
+
+    // Join the view change once f+1 replicas asked for it.
+    if (view_changes.size() >= static_cast<size_t>(f_ + 1) &&
+        inst->pending_view < view) {
+      StartViewChange(k, inst, view, &outgoing);
+    }
+    if (view_changes.size() >= static_cast<size_t>(2 * f_ + 1) &&
+        GetLeader(k, view) == id_ && inst->new_view_sent < view) {
+      inst->new_view_sent = view;
+      auto new_view = std::make_unique<NewView>();
+      new_view->set_instance(k);
+      new_view->set_view(view);
+      new_view->set_sender(id_);
+      for (const auto& it : view_changes) {
+        *new_view->add_view_changes() = it.second;
+      }
+      outgoing.push_back({MessageType::NewViewMsg, 0, std::move(new_view)});
+    }
+  }
+  Send(&outgoing);
+  return true;
+}
+
+std::vector<std::unique_ptr<Transaction>> RCC::GetNewViewProposals(
+    const NewView& new_view) const {
+  int64_t min_committed = -1, max_round = 0;
+  // The certified transaction of the highest view for each round. The
+  // certificates were checked by ReceiveNewView().
+  std::map<int64_t, const Transaction*> prepared;
+  for (const ViewChange& view_change : new_view.view_changes()) {
+    if (min_committed < 0 || view_change.committed_round() < min_committed) {
+      min_committed = view_change.committed_round();
+    }
+    max_round = std::max(max_round, view_change.committed_round());
+    for (const PreparedProof& proof : view_change.prepared()) {
+      const Transaction& txn = proof.txn();
+      auto& best = prepared[txn.round()];
+      if (best == nullptr || best->view() < txn.view()) {
+        best = &txn;
+      }
+      max_round = std::max(max_round, txn.round());
+    }
+  }
+
+  // Only the rounds certified by 2f+1 prepares are re-proposed, the others
+  // become no-ops. A sender keeps its certificates kRetainRounds after it
+  // commits them, replicas lagging further behind need a state transfer.
+  int64_t max_committed = 0;
+  for (const ViewChange& view_change : new_view.view_changes()) {
+    max_committed = std::max(max_committed, view_change.committed_round());
+  }
+  min_committed = std::max(min_committed, max_committed - kRetainRounds);
+
+  std::vector<std::unique_ptr<Transaction>> proposals;
+  for (int64_t round = min_committed + 1; round <= max_round; ++round) {
+    auto txn = std::make_unique<Transaction>();
+    auto it = prepared.find(round);
+    if (it != prepared.end()) {
+      *txn = *it->second;
+    } else {
+      txn->set_hash("noop");
+      txn->set_noop(true);
+    }
+    txn->set_instance(new_view.instance());
+    txn->set_round(round);
+    txn->set_view(new_view.view());
+    txn->set_proposer(new_view.sender());
+    proposals.push_back(std::move(txn));
+  }
+  return proposals;
+}
+
+bool RCC::ReceiveNewView(std::unique_ptr<NewView> new_view) {
+  int k = new_view->instance();
+  if (k < 1 || k > instance_num_ ||
+      new_view->sender() != GetLeader(k, new_view->view())) {
+    return false;
+  }
+  std::set<int32_t> senders;
+  for (const ViewChange& view_change : new_view->view_changes()) {
+    if (view_change.instance() != k ||
+        view_change.view() != new_view->view() ||
+        !VerifyViewChange(view_change)) {
+      LOG(ERROR) << "new view with an invalid view change, instance:" << k;
+      return false;
+    }
+    senders.insert(view_change.sender());
+  }
+  if (senders.size() < static_cast<size_t>(2 * f_ + 1)) {
+    LOG(ERROR) << "new view without enough view changes, instance:" << k;
+    return false;
+  }
+
+  Instance* inst = instances_[k - 1].get();
+  std::vector<Outgoing> outgoing;
+  std::vector<std::unique_ptr<Transaction>> committed;
+  {
+    std::unique_lock<std::mutex> lk(inst->mutex);
+    if (new_view->view() <= inst->view) {
+      return false;
+    }
+    ApplyNewView(k, inst, *new_view, &outgoing, &committed);
+  }
+  Send(&outgoing);
+  Release(&committed);
+  FillNoop();
+  return true;
+}
+
+void RCC::ApplyNewView(int index, Instance* instance, const NewView& new_view,
+                       std::vector<Outgoing>* outgoing,
+                       std::vector<std::unique_ptr<Transaction>>* committed) {
+  instance->view = instance->pending_view = new_view.view();
+  while (!instance->view_changes.empty() &&
+         instance->view_changes.begin()->first <= instance->view) {
+    instance->view_changes.erase(instance->view_changes.begin());
+  }
+  for (auto it = instance->prepares.begin(); it != instance->prepares.end();) {
+    if (std::get<1>(it->first) < instance->view) {
+      it = instance->prepares.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  int64_t last_round = instance->committed_round;
+  for (auto& txn : GetNewViewProposals(new_view)) {
+    int64_t round = txn->round();
+    last_round = std::max(last_round, round);
+    if (IsCommitted(*instance, round)) {
+      auto it = instance->proposals.find(round);
+      if (it != instance->proposals.end() &&
+          it->second->hash() != txn->hash()) {
+        LOG(ERROR) << "new view changes committed round:" << round
+                   << " instance:" << index;
+        continue;
+      }
+      // Help the replicas which did not commit the round.
+      outgoing->push_back({MessageType::PrepareMsg, 0, NewPrepare(*txn)});
+      continue;
+    }
+    outgoing->push_back({MessageType::PrepareMsg, 0, NewPrepare(*txn)});
+    instance->proposals[round] = std::move(txn);
+    auto txn_committed = TryCommit(instance, round);
+    if (txn_committed) {
+      committed->push_back(std::move(txn_committed));
+    }
+  }
+  // Uncommitted proposals of the old view above the new view are dropped.
+  for (auto it = instance->proposals.upper_bound(last_round);
+       it != instance->proposals.end();) {
+    it = IsCommitted(*instance, it->first) ? std::next(it)
+                                           : instance->proposals.erase(it);
+  }
+  if (GetLeader(index, instance->view) == id_) {
+    instance->next_round = last_round + 1;
+  }
+  LOG(ERROR) << "instance:" << index << " enter view:" << instance->view
+             << " leader:" << GetLeader(index, instance->view);
+}
+
+void RCC::CheckInstances() {
+  uint64_t now = GetCurrentTime();
+  uint64_t timeout_us = static_cast<uint64_t>(timeout_ms_) * 1000;
+  int waiting_instance = orderer_.GetNextInstance();
+  bool stalled = max_round_.load() >= orderer_.GetNextRound() &&
+                 now - orderer_.GetLastReleaseTime() > timeout_us;
+
+  for (int k = 1; k <= instance_num_; ++k) {
+    Instance* inst = instances_[k - 1].get();
+    std::vector<Outgoing> outgoing;
+    {
+      std::unique_lock<std::mutex> lk(inst->mutex);
+      if (inst->pending_view != inst->view) {
+        // The new leader did not show up either.
+        if (now - inst->view_change_time > 2 * timeout_us) {
+          StartViewChange(k, inst, inst->pending_view + 1, &outgoing);
+        }
+      } else if (stalled && k == waiting_instance) {
+        StartViewChange(k, inst, inst->view + 1, &outgoing);
+      }
+    }
+    Send(&outgoing);
+  }
+}
+
+void RCC::Monitor() {
+  while (!IsStop()) {
+    usleep(std::max(timeout_ms_ / 10, 1) * 1000);
+    CheckInstances();
+  }
+}
+
+void RCC::Send(std::vector<Outgoing>* outgoing) {
+  for (auto& it : *outgoing) {
+    if (it.to == 0) {
+      Broadcast(it.type, *it.msg);
+    } else {
+      SendMessage(it.type, *it.msg, it.to);
+    }
+  }
+  outgoing->clear();
+}
+
+void RCC::Release(std::vector<std::unique_ptr<Transaction>>* committed) {
+  if (committed->empty()) {
+    return;
+  }
+  for (auto& txn : *committed) {
+    UpdateMaxRound(txn->round());
+    orderer_.Add(std::move(txn));
+  }
+  committed->clear();
+  FillNoop();
+}
+
+}  // namespace rcc
+}  // namespace resdb
@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+
+#include "platform/consensus/ordering/common/algorithm/protocol_base.h"
+#include "platform/consensus/ordering/rcc/algorithm/round_robin_orderer.h"
+#include "platform/consensus/ordering/rcc/proto/rcc.pb.h"
+
+namespace resdb {
+namespace rcc {
+
+// RCC runs instance_num concurrent PoE-style instances, in the style of
+// Resilient Concurrent Consensus. Replica i leads instance i, so the client
+// load and the proposal bandwidth are spread over instance_num leaders
+// instead of one primary. Each instance commits a transaction per round once
+// 2f+1 replicas prepared it, and the committed rounds of all the instances
+// are merged by the RoundRobinOrderer before they reach the executor. A
+// leader without client transactions proposes no-ops to keep its instance
+// in step with the others.
+//
+// A leader holding back the ordering is replaced by a view change of its
+// instance only; the other instances keep running. The leader of instance k
+// in view v is replica (k - 1 + v) % n + 1. Prepares and view changes are
+// signed, and a view change only carries the transactions certified by 2f+1
+// prepares, so the new leader can only re-propose certified transactions.
+class RCC : public common::ProtocolBase {
+ public:
+  RCC(int id, int f, int total_num, int instance_num,
+      SignatureVerifier* verifier, int timeout_ms = 0);
+  ~RCC();
+
+  bool ReceiveTransaction(std::unique_ptr<Transaction> txn);
+  bool ReceivePropose(std::unique_ptr<Transaction> txn);
+  bool ReceivePrepare(std::unique_ptr<Prepare> prepare);
+  bool ReceiveViewChange(std::unique_ptr<ViewChange> view_change);
+  bool ReceiveNewView(std::unique_ptr<NewView> new_view);
+
+  // Vote to replace the current leader of the instance.
+  void StartViewChange(int instance);
+  // Start a view change on the instance holding back the ordering for
+  // longer than the timeout. Called periodically if timeout_ms > 0.
+  void CheckInstances();
+
+  int GetLeader(int instance, int64_t view) const;
+  int64_t GetView(int instance);
+  int GetInstanceNum() const;
+
+ private:
+  struct Instance {
+    std::mutex mutex;
+    int64_t view = 0;
+    // The view being changed to, larger than view during a view change.
+    int64_t pending_view = 0;
+    uint64_t view_change_time = 0;
+    int64_t new_view_sent = 0;
+    // The next round to propose if this replica is the leader.
+    int64_t next_round = 1;
+    // Rounds up to committed_round and in committed are committed.
+    int64_t committed_round = 0;
+    std::set<int64_t> committed;
+    // Proposals by round, kept kRetainRounds after commit for view changes.
+    std::map<int64_t, std::unique_ptr<Transaction>> proposals;
+    // The committed proposals with their prepares, kept as long as the
+    // proposals.
+    std::map<int64_t, PreparedProof> prepared;
+    std::map<std::tuple<int64_t, int64_t, std::string>,
+             std::map<int32_t, SignatureInfo>>
+        prepares;
+    std::map<int64_t, std::map<int32_t, ViewChange>> view_changes;
+  };
+
+  struct Outgoing {
+    int type;
+    // 0 to broadcast.
+    int to;
+    std::unique_ptr<google::protobuf::Message> msg;
+  };
+
+  std::vector<int> GetLeadInstances();
+  bool Propose(int instance, std::unique_ptr<Transaction> txn);
+  // Propose no-ops on the instances led by this replica up to the highest
+  // round committed by any instance.
+  void FillNoop();
+  void UpdateMaxRound(int64_t round);
+
+  // Must be called holding the instance mutex.
+  bool IsCommitted(const Instance& instance, int64_t round) const;
+  std::unique_ptr<Transaction> TryCommit(Instance* instance, int64_t round);
+  std::unique_ptr<Prepare> NewPrepare(const Transaction& txn) const;
+
+  std::string GetPrepareMessage(int instance, int64_t round, int64_t view,
+                                const std::string& hash) const;
+  std::string GetViewChangeMessage(const ViewChange& view_change) const;
+  bool VerifyPreparedProof(int instance, const PreparedProof& proof) const;
+  bool VerifyViewChange(const ViewChange& view_change) const;
+  void StartViewChange(int index, Instance* instance, int64_t view,
+                       std::vector<Outgoing>* outgoing);
+  // The rounds re-proposed in a new view, derived from 2f+1 view changes.
+  std::vector<std::unique_ptr<Transaction>> GetNewViewProposals(
+      const NewView& new_view) const;
+  void ApplyNewView(int index, Instance* instance, const NewView& new_view,
+                    std::vector<Outgoing>* outgoing,
+                    std::vector<std::unique_ptr<Transaction>>* committed);
+
+  void Send(std::vector<Outgoing>* outgoing);
+  void Release(std::vector<std::unique_ptr<Transaction>>* committed);
+  void Monitor();
+
+ private:
+  static constexpr int64_t kRetainRounds = 256;
+
+  int instance_num_;
+  // instances_[k - 1] is instance k.
+  std::vector<std::unique_ptr<Instance>> instances_;
+  RoundRobinOrderer orderer_;
+  std::atomic<int64_t> max_round_ = 0;
+  std::atomic<uint64_t> next_lead_ = 0;
+  int timeout_ms_;
+  std::thread monitor_thread_;
+};
+
+}  // namespace rcc
+}  // namespace resdb
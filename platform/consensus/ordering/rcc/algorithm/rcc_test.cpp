@@ -0,0 +1,286 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/rcc/algorithm/rcc.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <deque>
+
+#include "common/crypto/mock_signature_verifier.h"
+
+namespace resdb {
+namespace rcc {
+namespace {
+
+// Runs n replicas in one thread, delivering the messages in FIFO order.
+class Cluster {
+ public:
+  struct Message {
+    int type;
+    std::string data;
+    int from;
+    int to;
+  };
+
+  Cluster(int n, int instance_num, SignatureVerifier* verifier = nullptr)
+      : n_(n), committed_(n + 1) {
+    for (int i = 1; i <= n; ++i) {
+      auto replica =
+          std::make_unique<RCC>(i, (n - 1) / 3, n, instance_num, verifier);
+      replica->SetSingleCallFunc(
+          [this, i](int type, const google::protobuf::Message& msg, int to) {
+            queue_.push_back({type, msg.SerializeAsString(), i, to});
+            return 0;
+          });
+      replica->SetBroadcastCallFunc(
+          [this, i](int type, const google::protobuf::Message& msg) {
+            for (int j = 1; j <= n_; ++j) {
+              queue_.push_back({type, msg.SerializeAsString(), i, j});
+            }
+            return 0;
+          });
+      replica->SetCommitFunc([this, i](const google::protobuf::Message& msg) {
+        const Transaction& txn = dynamic_cast<const Transaction&>(msg);
+        committed_[i].push_back(txn.data());
+        EXPECT_EQ(txn.seq(), committed_[i].size());
+        return 0;
+      });
+      replicas_.push_back(std::move(replica));
+    }
+  }
+
+  void Submit(int replica, const std::string& data) {
+    auto txn = std::make_unique<Transaction>();
+    txn->set_data(data);
+    txn->set_hash("hash_" + data);
+    replicas_[replica - 1]->ReceiveTransaction(std::move(txn));
+  }
+
+  // Deliver all the messages, dropping the ones filtered out.
+  void Run(std::function<bool(const Message&)> drop = nullptr) {
+    while (!queue_.empty()) {
+      Message msg = std::move(queue_.front());
+      queue_.pop_front();
+      if (drop && drop(msg)) {
+        continue;
+      }
+      Deliver(msg);
+    }
+  }
+
+  void Deliver(const Message& msg) {
+    RCC* replica = replicas_[msg.to - 1].get();
+    switch (msg.type) {
+      case MessageType::Forward:
+      case MessageType::Propose: {
+        auto txn = std::make_unique<Transaction>();
+        ASSERT_TRUE(txn->ParseFromString(msg.data));
+        if (msg.type == MessageType::Forward) {
+          replica->ReceiveTransaction(std::move(txn));
+        } else {
+          replica->ReceivePropose(std::move(txn));
+        }
+        break;
+      }
+      case MessageType::PrepareMsg: {
+        auto prepare = std::make_unique<Prepare>();
+        ASSERT_TRUE(prepare->ParseFromString(msg.data));
+        replica->ReceivePrepare(std::move(prepare));
+        break;
+      }
+      case MessageType::ViewChangeMsg: {
+        auto view_change = std::make_unique<ViewChange>();
+        ASSERT_TRUE(view_change->ParseFromString(msg.data));
+        replica->ReceiveViewChange(std::move(view_change));
+        break;
+      }
+      case MessageType::NewViewMsg: {
+        auto new_view = std::make_unique<NewView>();
+        ASSERT_TRUE(new_view->ParseFromString(msg.data));
+        replica->ReceiveNewView(std::move(new_view));
+        break;
+      }
+    }
+  }
+
+  RCC* GetReplica(int id) { return replicas_[id - 1].get(); }
+  const std::vector<std::string>& Committed(int id) { return committed_[id]; }
+
+ private:
+  int n_;
+  std::deque<Message> queue_;
+  std::vector<std::unique_ptr<RCC>> replicas_;
+  std::vector<std::vector<std::string>> committed_;
+};
+
+TEST(RCCTest, AllLeadersCommitInSameOrder) {
+  Cluster cluster(4, 4);
+  for (int i = 0; i < 5; ++i) {
+    for (int j = 1; j <= 4; ++j) {
+      cluster.Submit(j, std::to_string(j) + ":" + std::to_string(i));
+    }
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    ASSERT_EQ(cluster.Committed(i).size(), 20) << "replica:" << i;
+    EXPECT_EQ(cluster.Committed(i), cluster.Committed(1));
+  }
+  // Round 1 of instances 1 to 4 goes first.
+  EXPECT_EQ(cluster.Committed(1)[0], "1:0");
+  EXPECT_EQ(cluster.Committed(1)[1], "2:0");
+  EXPECT_EQ(cluster.Committed(1)[3], "4:0");
+}
+
+TEST(RCCTest, IdleLeadersProposeNoop) {
+  Cluster cluster(4, 4);
+  for (int i = 0; i < 5; ++i) {
+    cluster.Submit(2, std::to_string(i));
+  }
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    ASSERT_EQ(cluster.Committed(i).size(), 5) << "replica:" << i;
+    EXPECT_EQ(cluster.Committed(i), cluster.Committed(1));
+  }
+}
+
+TEST(RCCTest, ForwardToLeader) {
+  Cluster cluster(4, 2);
+  cluster.Submit(3, "a");
+  cluster.Submit(4, "b");
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i), std::vector<std::string>({"a", "b"}));
+  }
+}
+
+TEST(RCCTest, ReplaceFaultyLeader) {
+  Cluster cluster(4, 4);
+  auto silent = [](const Cluster::Message& msg) {
+    return msg.from == 4 || msg.to == 4;
+  };
+  for (int i = 1; i <= 6; ++i) {
+    cluster.Submit((i - 1) % 3 + 1, std::to_string(i));
+  }
+  cluster.Run(silent);
+  // Instance 4 holds back the ordering from its first round.
+  EXPECT_EQ(cluster.Committed(1), std::vector<std::string>({"1", "2", "3"}));
+
+  for (int i = 1; i <= 3; ++i) {
+    cluster.GetReplica(i)->StartViewChange(4);
+  }
+  cluster.Run(silent);
+  for (int i = 1; i <= 3; ++i) {
+    EXPECT_EQ(cluster.GetReplica(i)->GetView(4), 1);
+    EXPECT_EQ(cluster.GetReplica(i)->GetView(1), 0);
+    EXPECT_EQ(cluster.Committed(i),
+              std::vector<std::string>({"1", "2", "3", "4", "5", "6"}));
+  }
+
+  // The new leader of instance 4 takes transactions as well.
+  cluster.Submit(1, "7");
+  cluster.Submit(1, "8");
+  cluster.Run(silent);
+  for (int i = 1; i <= 3; ++i) {
+    EXPECT_EQ(cluster.Committed(i).size(), 8);
+    EXPECT_EQ(cluster.Committed(i), cluster.Committed(1));
+  }
+}
+
+TEST(RCCTest, RejectViewChangeWithoutCertificate) {
+  // The signature of a message is the message itself.
+  testing::NiceMock<MockSignatureVerifier> verifier;
+  ON_CALL(verifier, SignMessage)
+      .WillByDefault([](const std::string& message) {
+        SignatureInfo signature;
+        signature.set_signature(message);
+        return signature;
+      });
+  ON_CALL(verifier, VerifyMessage)
+      .WillByDefault(
+          [](const std::string& message, const SignatureInfo& signature) {
+            return signature.signature() == message;
+          });
+
+  Cluster cluster(4, 4, &verifier);
+  cluster.Submit(1, "a");
+  cluster.Run();
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_EQ(cluster.Committed(i), std::vector<std::string>({"a"}));
+  }
+
+  ViewChange view_change;
+  cluster.GetReplica(2)->StartViewChange(1);
+  cluster.Run([&](const Cluster::Message& msg) {
+    if (msg.type == MessageType::ViewChangeMsg) {
+      EXPECT_TRUE(view_change.ParseFromString(msg.data));
+    }
+    return true;
+  });
+  ASSERT_EQ(view_change.prepared_size(), 1);
+  EXPECT_EQ(view_change.prepared(0).txn().data(), "a");
+
+  RCC* replica = cluster.GetReplica(3);
+  auto receive = [&](const ViewChange& view_change) {
+    return replica->ReceiveViewChange(
+        std::make_unique<ViewChange>(view_change));
+  };
+  // A transaction replaced under the certificate.
+  ViewChange forged = view_change;
+  forged.mutable_prepared(0)->mutable_txn()->set_hash("hash_b");
+  EXPECT_FALSE(receive(forged));
+
+  // Not enough prepares.
+  forged = view_change;
+  forged.mutable_prepared(0)->mutable_signatures()->RemoveLast();
+  forged.mutable_prepared(0)->mutable_signatures()->RemoveLast();
+  EXPECT_FALSE(receive(forged));
+
+  // A transaction which was never prepared.
+  forged = view_change;
+  PreparedProof* proof = forged.add_prepared();
+  proof->mutable_txn()->set_instance(1);
+  proof->mutable_txn()->set_round(2);
+  proof->mutable_txn()->set_hash("hash_c");
+  EXPECT_FALSE(receive(forged));
+
+  // Sent on behalf of another replica.
+  forged = view_change;
+  forged.set_sender(4);
+  EXPECT_FALSE(receive(forged));
+
+  EXPECT_TRUE(receive(view_change));
+
+  // The new view is checked by each replica as well.
+  NewView new_view;
+  new_view.set_instance(1);
+  new_view.set_view(1);
+  new_view.set_sender(replica->GetLeader(1, 1));
+  for (int i = 0; i < 3; ++i) {
+    *new_view.add_view_changes() = view_change;
+    new_view.mutable_view_changes(i)->set_sender(i + 2);
+  }
+  EXPECT_FALSE(replica->ReceiveNewView(std::make_unique<NewView>(new_view)));
+  EXPECT_EQ(replica->GetView(1), 0);
+}
+
+}  // namespace
+}  // namespace rcc
+}  // namespace resdb
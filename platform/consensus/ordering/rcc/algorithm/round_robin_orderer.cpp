@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/rcc/algorithm/round_robin_orderer.h"
+
+#include <vector>
+
+#include "common/utils/utils.h"
+
+namespace resdb {
+namespace rcc {
+
+RoundRobinOrderer::RoundRobinOrderer(int instance_num, CommitFuncType commit)
+    : instance_num_(instance_num),
+      commit_(std::move(commit)),
+      last_release_time_(GetCurrentTime()) {}
+
+void RoundRobinOrderer::Add(std::unique_ptr<Transaction> txn) {
+  std::vector<std::unique_ptr<Transaction>> released;
+  {
+    std::unique_lock<std::mutex> lk(mutex_);
+    std::pair<int64_t, int> slot(txn->round(), txn->instance());
+    if (slot < std::make_pair(next_round_, next_instance_)) {
+      return;
+    }
+    ready_.emplace(slot, std::move(txn));
+    while (!ready_.empty() && ready_.begin()->first ==
+                                  std::make_pair(next_round_, next_instance_)) {
+      std::unique_ptr<Transaction> next = std::move(ready_.begin()->second);
+      ready_.erase(ready_.begin());
+      if (!next->noop()) {
+        next->set_seq(++seq_);
+        released.push_back(std::move(next));
+      }
+      if (++next_instance_ > instance_num_) {
+        next_instance_ = 1;
+        next_round_++;
+      }
+      last_release_time_ = GetCurrentTime();
+    }
+  }
+  // The executor orders the transactions by seq, they can be passed
+  // outside the lock.
+  for (auto& it : released) {
+    commit_(std::move(it));
+  }
+}
+
+int64_t RoundRobinOrderer::GetNextRound() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return next_round_;
+}
+
+int RoundRobinOrderer::GetNextInstance() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return next_instance_;
+}
+
+uint64_t RoundRobinOrderer::GetLastReleaseTime() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return last_release_time_;
+}
+
+}  // namespace rcc
+}  // namespace resdb
@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "platform/consensus/ordering/rcc/proto/rcc.pb.h"
+
+namespace resdb {
+namespace rcc {
+
+// RoundRobinOrderer merges the transactions committed by the concurrent
+// instances into one total order: round r of instance 1, round r of
+// instance 2, ..., round r of the last instance, then round r+1. Every
+// replica commits the same transactions per (instance, round), so every
+// replica derives the same order. The transactions are released with
+// consecutive sequence numbers starting from 1; no-ops only hold a slot in
+// the round and are dropped.
+class RoundRobinOrderer {
+ public:
+  typedef std::function<void(std::unique_ptr<Transaction>)> CommitFuncType;
+
+  RoundRobinOrderer(int instance_num, CommitFuncType commit);
+
+  // Add the transaction committed by instance txn->instance() at round
+  // txn->round(). Rounds committed twice are ignored.
+  void Add(std::unique_ptr<Transaction> txn);
+
+  // The next slot to be released.
+  int64_t GetNextRound();
+  int GetNextInstance();
+  uint64_t GetLastReleaseTime();
+
+ private:
+  std::mutex mutex_;
+  int instance_num_;
+  CommitFuncType commit_;
+  std::map<std::pair<int64_t, int>, std::unique_ptr<Transaction>> ready_;
+  int64_t next_round_ = 1;
+  int next_instance_ = 1;
+  int64_t seq_ = 0;
+  uint64_t last_release_time_;
+};
+
+}  // namespace rcc
+}  // namespace resdb
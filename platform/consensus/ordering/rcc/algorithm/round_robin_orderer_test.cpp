@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/rcc/algorithm/round_robin_orderer.h"
+
+#include <gtest/gtest.h>
+
+namespace resdb {
+namespace rcc {
+namespace {
+
+std::unique_ptr<Transaction> NewTxn(int instance, int64_t round,
+                                    bool noop = false) {
+  auto txn = std::make_unique<Transaction>();
+  txn->set_data(std::to_string(round) + ":" + std::to_string(instance));
+  txn->set_instance(instance);
+  txn->set_round(round);
+  txn->set_noop(noop);
+  return txn;
+}
+
+TEST(RoundRobinOrdererTest, MergeInRoundRobin) {
+  std::vector<std::string> committed;
+  std::vector<int64_t> seqs;
+  RoundRobinOrderer orderer(3, [&](std::unique_ptr<Transaction> txn) {
+    committed.push_back(txn->data());
+    seqs.push_back(txn->seq());
+  });
+
+  orderer.Add(NewTxn(2, 1));
+  orderer.Add(NewTxn(1, 2));
+  orderer.Add(NewTxn(3, 1));
+  EXPECT_TRUE(committed.empty());
+  EXPECT_EQ(orderer.GetNextInstance(), 1);
+
+  orderer.Add(NewTxn(1, 1));
+  EXPECT_EQ(committed, std::vector<std::string>({"1:1", "1:2", "1:3", "2:1"}));
+  EXPECT_EQ(seqs, std::vector<int64_t>({1, 2, 3, 4}));
+  EXPECT_EQ(orderer.GetNextRound(), 2);
+  EXPECT_EQ(orderer.GetNextInstance(), 2);
+}
+
+TEST(RoundRobinOrdererTest, SkipNoopAndDuplicate) {
+  std::vector<std::string> committed;
+  std::vector<int64_t> seqs;
+  RoundRobinOrderer orderer(2, [&](std::unique_ptr<Transaction> txn) {
+    committed.push_back(txn->data());
+    seqs.push_back(txn->seq());
+  });
+
+  orderer.Add(NewTxn(1, 1, /*noop=*/true));
+  orderer.Add(NewTxn(2, 1));
+  orderer.Add(NewTxn(2, 1));
+  orderer.Add(NewTxn(1, 2));
+  EXPECT_EQ(committed, std::vector<std::string>({"1:2", "2:1"}));
+  EXPECT_EQ(seqs, std::vector<int64_t>({1, 2}));
+}
+
+}  // namespace
+}  // namespace rcc
+}  // namespace resdb
@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/ordering/rcc/framework/consensus.h"
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include "common/utils/utils.h"
+
+namespace resdb {
+namespace rcc {
+
+Consensus::Consensus(const ResDBConfig& config,
+                     std::unique_ptr<TransactionManager> executor)
+    : common::Consensus(config, std::move(executor)) {
+  int total_replicas = config_.GetReplicaNum();
+  int f = (total_replicas - 1) / 3;
+  int leader_num = config_.GetConfigData().rcc_leader_num() > 0
+                       ? config_.GetConfigData().rcc_leader_num()
+                       : total_replicas;
+
+  Init();
+
+  if (config_.GetPublicKeyCertificateInfo()
+          .public_key()
+          .public_key_info()
+          .type() != CertificateKeyInfo::CLIENT) {
+    rcc_ = std::make_unique<RCC>(
+        config_.GetSelfInfo().id(), f, total_replicas, leader_num,
+        GetSignatureVerifier(),
+        config_.GetConfigData().enable_viewchange()
+            ? config_.GetViewchangeCommitTimeout()
+            : 0);
+    InitProtocol(rcc_.get());
+  }
+}
+
+int Consensus::ProcessCustomConsensus(std::unique_ptr<Request> request) {
+  switch (request->user_type()) {
+    case MessageType::Propose:
+    case MessageType::Forward: {
+      std::unique_ptr<Transaction> txn = std::make_unique<Transaction>();
+      if (!txn->ParseFromString(request->data())) {
+        LOG(ERROR) << "parse transaction fail";
+        return -1;
+      }
+      if (request->user_type() == MessageType::Forward) {
+        return rcc_->ReceiveTransaction(std::move(txn)) ? 0 : -1;
+      }
+      rcc_->ReceivePropose(std::move(txn));
+      return 0;
+    }
+    case MessageType::PrepareMsg: {
+      std::unique_ptr<Prepare> prepare = std::make_unique<Prepare>();
+      if (!prepare->ParseFromString(request->data())) {
+        LOG(ERROR) << "parse prepare fail";
+        return -1;
+      }
+      rcc_->ReceivePrepare(std::move(prepare));
+      return 0;
+    }
+    case MessageType::ViewChangeMsg: {
+      std::unique_ptr<ViewChange> view_change = std::make_unique<ViewChange>();
+      if (!view_change->ParseFromString(request->data())) {
+        LOG(ERROR) << "parse view change fail";
+        return -1;
+      }
+      rcc_->ReceiveViewChange(std::move(view_change));
+      return 0;
+    }
+    case MessageType::NewViewMsg: {
+      std::unique_ptr<NewView> new_view = std::make_unique<NewView>();
+      if (!new_view->ParseFromString(request->data())) {
+        LOG(ERROR) << "parse new view fail";
+        return -1;
+      }
+      rcc_->ReceiveNewView(std::move(new_view));
+      return 0;
+    }
+  }
+  return 0;
+}
+
+int Consensus::ProcessNewTransaction(std::unique_ptr<Request> request) {
+  std::unique_ptr<Transaction> txn = std::make_unique<Transaction>();
+  txn->set_data(request->data());
+  txn->set_hash(request->hash());
+  txn->set_proxy_id(request->proxy_id());
+  txn->set_uid(request->uid());
+  return rcc_->ReceiveTransaction(std::move(txn));
+}
+
+int Consensus::CommitMsg(const google::protobuf::Message& msg) {
+  return CommitMsgInternal(dynamic_cast<const Transaction&>(msg));
+}
+
+int Consensus::CommitMsgInternal(const Transaction& txn) {
+  std::unique_ptr<Request> request = std::make_unique<Request>();
+  request->set_data(txn.data());
+  request->set_seq(txn.seq());
+  request->set_uid(txn.uid());
+  request->set_proxy_id(txn.proxy_id());
+
+  transaction_executor_->Commit(std::move(request));
+  return 0;
+}
+
+}  // namespace rcc
+}  // namespace resdb
@@ -390,6 +390,48 @@ bool Recovery::Read(int fd, size_t len, char* data) {
   return true;
 }
 
+int Recovery::PruneLogs(int64_t seq) {
+  if (recovery_enabled_ == false) {
+    return 0;
+  }
+  std::unique_lock<std::mutex> lk(mutex_);
+  seq = std::min(seq, last_ckpt_);
+
+  std::string dir = std::filesystem::path(file_path_).parent_path();
+  std::vector<std::string> list;
+  for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+    std::string file_name = std::filesystem::path(entry.path()).stem();
+    std::string ext = std::filesystem::path(entry.path()).extension();
+    if (ext != ".log") continue;
+    int pos = file_name.rfind("_");
+
+    int max_seq_pos = file_name.rfind("_", pos - 1);
+    int64_t max_seq =
+        std::stoll(file_name.substr(max_seq_pos + 1, pos - max_seq_pos - 1));
+
+    int min_seq_pos = file_name.rfind("_", max_seq_pos - 1);
+    int64_t min_seq = std::stoll(
+        file_name.substr(min_seq_pos + 1, max_seq_pos - min_seq_pos - 1));
+
+    if (min_seq == -1 || max_seq >= seq) {
+      continue;
+    }
+    list.push_back(entry.path());
+  }
+
+  int num = 0;
+  for (const std::string& path : list) {
+    std::error_code ec;
+    if (!std::filesystem::remove(path, ec)) {
+      LOG(ERROR) << "remove log file fail:" << path << " error:" << ec;
+      continue;
+    }
+    LOG(INFO) << "remove log file:" << path << " below seq:" << seq;
+    num++;
+  }
+  return num;
+}
+
 std::pair<std::vector<std::pair<int64_t, std::string>>, int64_t>
 Recovery::GetRecoveryFiles(int64_t ckpt) {
   std::string dir = std::filesystem::path(file_path_).parent_path();
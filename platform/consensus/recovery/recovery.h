@@ -51,6 +51,11 @@ class Recovery {
 
   int GetData(const RecoveryRequest& request, RecoveryResponse& response);
 
+  // Delete the finished log files whose seqs are all below seq. The files
+  // above the last checkpoint the storage was flushed at are kept.
+  // Return the number of files deleted.
+  int PruneLogs(int64_t seq);
+
   std::map<uint64_t, std::vector<std::pair<std::unique_ptr<Context>,
                                            std::unique_ptr<Request>>>>
   GetDataFromRecoveryFiles(uint64_t need_min_seq, uint64_t need_max_seq);
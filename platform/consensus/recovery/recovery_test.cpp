@@ -221,6 +221,55 @@ TEST_F(RecoveryTest, CheckPoint) {
   }
 }
 
+TEST_F(RecoveryTest, PruneLogs) {
+  ResDBConfig config(GetConfigData(1024), ReplicaInfo(), KeyInfo(),
+                     CertificateInfo());
+
+  std::promise<bool> insert_done, insert_done2, ckpt, ckpt2;
+  std::future<bool> insert_done_future = insert_done.get_future(),
+                    insert_done_future2 = insert_done2.get_future(),
+                    ckpt_future = ckpt.get_future(),
+                    ckpt_future2 = ckpt2.get_future();
+  int time = 1;
+  EXPECT_CALL(checkpoint_, GetStableCheckpoint()).WillRepeatedly(Invoke([&]() {
+    int ret = 15;
+    if (time == 1) {
+      insert_done_future.get();
+      ret = 5;
+    } else if (time == 2) {
+      ckpt.set_value(true);
+      insert_done_future2.get();
+    } else if (time == 3) {
+      ckpt2.set_value(true);
+    }
+    time++;
+    return ret;
+  }));
+
+  Recovery recovery(config, &checkpoint_, &system_info_, nullptr);
+  auto add_requests = [&](int min_seq, int max_seq) {
+    for (int i = min_seq; i <= max_seq; ++i) {
+      std::unique_ptr<Request> request =
+          NewRequest(Request::TYPE_PRE_PREPARE, Request(), i);
+      request->set_seq(i);
+      recovery.AddRequest(nullptr, request.get());
+    }
+  };
+
+  add_requests(1, 9);
+  insert_done.set_value(true);
+  ckpt_future.get();
+  add_requests(10, 19);
+  insert_done2.set_value(true);
+  ckpt_future2.get();
+  EXPECT_EQ(Listlogs(log_path).size(), 3);
+
+  // Only the file of seqs [1,9] is below the checkpoint 15.
+  EXPECT_EQ(recovery.PruneLogs(100), 1);
+  EXPECT_EQ(Listlogs(log_path).size(), 2);
+  EXPECT_EQ(recovery.PruneLogs(100), 0);
+}
+
 TEST_F(RecoveryTest, CheckPoint2) {
   ResDBConfig config(GetConfigData(1024), ReplicaInfo(), KeyInfo(),
                      CertificateInfo());
@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/retention/retention_manager.h"
+
+#include <glog/logging.h>
+
+namespace resdb {
+
+RetentionManager::RetentionManager(const ResDBConfig& config,
+                                   CheckPoint* checkpoint, Storage* storage,
+                                   Recovery* recovery)
+    : config_(config),
+      checkpoint_(checkpoint),
+      storage_(storage),
+      recovery_(recovery),
+      stop_(false) {
+  retention_seq_num_ = config_.GetConfigData().retention_seq_num();
+  interval_s_ = config_.GetConfigData().retention_interval_s();
+  if (interval_s_ <= 0) {
+    interval_s_ = 60;
+  }
+  if (config_.GetConfigData().enable_retention() && checkpoint_ != nullptr) {
+    LOG(INFO) << "enable retention, seq num:" << retention_seq_num_
+              << " interval:" << interval_s_;
+    prune_thread_ = std::thread(&RetentionManager::PruneProcess, this);
+  }
+}
+
+RetentionManager::~RetentionManager() { Stop(); }
+
+void RetentionManager::Stop() {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (prune_thread_.joinable()) {
+    prune_thread_.join();
+  }
+}
+
+void RetentionManager::PruneProcess() {
+  while (!stop_) {
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      cv_.wait_for(lk, std::chrono::seconds(interval_s_),
+                   [&] { return stop_.load(); });
+    }
+    if (stop_) {
+      break;
+    }
+    Prune();
+  }
+}
+
+uint64_t RetentionManager::Prune() {
+  uint64_t stable_seq = checkpoint_->GetStableCheckpoint();
+  if (stable_seq <= retention_seq_num_) {
+    return last_prune_seq_;
+  }
+  uint64_t seq = stable_seq - retention_seq_num_;
+  if (seq <= last_prune_seq_) {
+    return last_prune_seq_;
+  }
+
+  int version_num = 0, file_num = 0;
+  if (storage_) {
+    version_num = storage_->PruneHistory(seq);
+  }
+  if (recovery_) {
+    file_num = recovery_->PruneLogs(seq);
+  }
+  last_prune_seq_ = seq;
+  LOG(ERROR) << "prune below seq:" << seq << " stable seq:" << stable_seq
+             << " versions:" << version_num << " log files:" << file_num;
+  return last_prune_seq_;
+}
+
+}  // namespace resdb
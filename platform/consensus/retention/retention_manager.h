@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "chain/storage/storage.h"
+#include "platform/config/resdb_config.h"
+#include "platform/consensus/checkpoint/checkpoint.h"
+#include "platform/consensus/recovery/recovery.h"
+
+namespace resdb {
+
+// RetentionManager bounds the state kept below the stable checkpoint.
+// Once the stable checkpoint moves, it prunes the version history of the
+// storage and deletes the recovery log files older than retention_seq_num
+// seqs below it. The work runs in a background thread, enabled by
+// enable_retention, away from the execution of the requests.
+class RetentionManager {
+ public:
+  RetentionManager(const ResDBConfig& config, CheckPoint* checkpoint,
+                   Storage* storage, Recovery* recovery);
+  ~RetentionManager();
+
+  void Stop();
+
+  // Prune the state below the current stable checkpoint.
+  // Return the seq the state has been pruned to.
+  uint64_t Prune();
+
+ private:
+  void PruneProcess();
+
+ private:
+  ResDBConfig config_;
+  CheckPoint* checkpoint_;
+  Storage* storage_;
+  Recovery* recovery_;
+  uint64_t retention_seq_num_;
+  int interval_s_;
+  uint64_t last_prune_seq_ = 0;
+  std::atomic<bool> stop_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread prune_thread_;
+};
+
+}  // namespace resdb
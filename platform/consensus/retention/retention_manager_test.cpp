@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/consensus/retention/retention_manager.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "chain/storage/mock_storage.h"
+#include "platform/consensus/checkpoint/mock_checkpoint.h"
+
+namespace resdb {
+namespace {
+
+using ::testing::Return;
+
+ResConfigData GetConfigData() {
+  ResConfigData data;
+  data.set_retention_seq_num(10);
+  return data;
+}
+
+TEST(RetentionManagerTest, PruneBelowStableCheckpoint) {
+  ResDBConfig config(GetConfigData(), ReplicaInfo(), KeyInfo(),
+                     CertificateInfo());
+  MockCheckPoint checkpoint;
+  MockStorage storage;
+  RetentionManager manager(config, &checkpoint, &storage, nullptr);
+
+  EXPECT_CALL(checkpoint, GetStableCheckpoint())
+      .WillOnce(Return(5))
+      .WillOnce(Return(100))
+      .WillOnce(Return(100))
+      .WillOnce(Return(200));
+  EXPECT_CALL(storage, PruneHistory(90)).WillOnce(Return(3));
+  EXPECT_CALL(storage, PruneHistory(190)).WillOnce(Return(1));
+
+  // The stable checkpoint is within the retention.
+  EXPECT_EQ(manager.Prune(), 0);
+  EXPECT_EQ(manager.Prune(), 90);
+  // Nothing to do until the stable checkpoint moves.
+  EXPECT_EQ(manager.Prune(), 90);
+  EXPECT_EQ(manager.Prune(), 190);
+}
+
+}  // namespace
+}  // namespace resdb
@@ -27,12 +27,14 @@
 namespace resdb {
 
 AsyncAcceptor::Session::Session(boost::asio::io_service* io_service,
-                                CallBack call_back_func)
+                                std::shared_ptr<RecvBufferPool> pool,
+                                SliceCallBack call_back_func,
+                                std::shared_ptr<FrameCodec> codec)
     : io_service_(io_service),
       client_socket_(*io_service_),
-      recv_buffer_(nullptr),
-      status_(0),
-      call_back_func_(call_back_func) {}
+      pool_(std::move(pool)),
+      call_back_func_(call_back_func),
+      codec_(std::move(codec)) {}
 
 AsyncAcceptor::Session::~Session() { Close(); }
 
@@ -44,76 +46,141 @@ void AsyncAcceptor::Session::Close() {
   if (client_socket_.is_open()) {
     client_socket_.cancel();
   }
-  if (recv_buffer_ && status_ != 0) {
-    delete recv_buffer_;
-    recv_buffer_ = nullptr;
-  }
+  slab_ = nullptr;
 }
 
 void AsyncAcceptor::Session::StartRead() {
-  if (status_ == 0) {
-    // read len
-    recv_buffer_ = reinterpret_cast<char*>(&data_size_);
-    data_size_ = 0;
-    need_size_ = sizeof(data_size_);
-    current_idx_ = 0;
-    memset(recv_buffer_, 0, need_size_);
-    OnRead();
-  } else {
-    need_size_ = data_size_;
-    current_idx_ = 0;
-    if (recv_buffer_) {
-      delete recv_buffer_;
+  Reserve(sizeof(size_t));
+  OnRead();
+}
+
+// Make room for size bytes from the start of the frame being received. The
+// received part of the frame is moved to the front of the slab if no frame
+// before it is still in use, or to a new slab otherwise.
+void AsyncAcceptor::Session::Reserve(size_t size) {
+  size_t data_size = end_ - begin_;
+  if (slab_ != nullptr && slab_.use_count() == 1 && size <= slab_size_) {
+    if (begin_ + size > slab_size_ || data_size == 0) {
+      memmove(slab_.get(), slab_.get() + begin_, data_size);
+      begin_ = 0;
+      end_ = data_size;
     }
-    recv_buffer_ = new char[need_size_];
-    memset(recv_buffer_, 0, need_size_);
-    OnRead();
+    return;
+  }
+  if (slab_ != nullptr && begin_ + size <= slab_size_) {
+    return;
   }
+  std::shared_ptr<char> slab = pool_->Get(size, &slab_size_);
+  if (data_size > 0) {
+    memcpy(slab.get(), slab_.get() + begin_, data_size);
+  }
+  slab_ = std::move(slab);
+  begin_ = 0;
+  end_ = data_size;
 }
 
-void AsyncAcceptor::Session::ReadDone() {
-  if (status_ == 1) {
-    call_back_func_(recv_buffer_, data_size_);
-    delete recv_buffer_;
-  } else {
-    data_size_ = *reinterpret_cast<size_t*>(recv_buffer_);
-    if (data_size_ > 1e10) {
-      LOG(ERROR) << "read data size:" << data_size_
-                 << " data size:" << sizeof(data_size_) << " close socket";
-      Close();
-      return;
+// Deliver the complete frames received. need_size is set to the size the
+// next frame needs.
+bool AsyncAcceptor::Session::ReadDone(size_t* need_size) {
+  while (true) {
+    size_t data_size = end_ - begin_;
+    if (data_size < sizeof(size_t)) {
+      *need_size = sizeof(size_t);
+      return true;
+    }
+    size_t header = 0;
+    memcpy(&header, slab_.get() + begin_, sizeof(size_t));
+    size_t frame_size = header & FrameCodec::kSizeMask;
+    if (frame_size > FrameCodec::kMaxFrameBytes) {
+      LOG(ERROR) << "read data size:" << frame_size
+                 << " data size:" << sizeof(frame_size) << " close socket";
+      return false;
+    }
+    if (data_size < sizeof(size_t) + frame_size) {
+      *need_size = sizeof(size_t) + frame_size;
+      return true;
     }
+    if (!OnFrame(header, slab_.get() + begin_ + sizeof(size_t), frame_size)) {
+      return false;
+    }
+    begin_ += sizeof(size_t) + frame_size;
   }
-  status_ ^= 1;
-  recv_buffer_ = nullptr;
-  // continue to read next msg.
-  StartRead();
 }
 
+bool AsyncAcceptor::Session::OnFrame(size_t header, const char* data,
+                                     size_t size) {
+  if (header & FrameCodec::kHelloFlag) {
+    hello_reply_ = codec_ != nullptr && codec_->AcceptHello(data, size);
+    boost::asio::async_write(
+        client_socket_,
+        boost::asio::buffer(&hello_reply_, sizeof(hello_reply_)),
+        [](const boost::system::error_code& error, size_t) {
+          if (error) {
+            LOG(ERROR) << "reply hello fail:" << error.message();
+          }
+        });
+    return true;
+  }
+  if (header & FrameCodec::kCompressedFlag) {
+    if (codec_ == nullptr) {
+      LOG(ERROR) << "recv compressed frame without codec, close socket";
+      return false;
+    }
+    std::unique_ptr<DataInfo> frame = codec_->Decompress(data, size);
+    if (frame == nullptr) {
+      return false;
+    }
+    call_back_func_(std::move(frame));
+    return true;
+  }
+  if (size > 0) {
+    std::unique_ptr<DataInfo> frame = std::make_unique<DataInfo>();
+    frame->buff = const_cast<char*>(data);
+    frame->data_len = size;
+    frame->holder = slab_;
+    call_back_func_(std::move(frame));
+  }
+  return true;
+}
+
+// Read as much as the slab can hold, it may contain several frames.
 void AsyncAcceptor::Session::OnRead() {
   client_socket_.async_read_some(
-      boost::asio::buffer(recv_buffer_ + current_idx_,
-                          need_size_ - current_idx_),
+      boost::asio::buffer(slab_.get() + end_, slab_size_ - end_),
       [&](const boost::system::error_code& error,  // Result of operation.
           std::size_t bytes_transferred) {
         if (error || bytes_transferred == 0) {
           Close();
-        } else {
-          current_idx_ += bytes_transferred;
-          if (current_idx_ >= need_size_) {
-            ReadDone();
-          } else {
-            OnRead();
-          }
+          return;
+        }
+        end_ += bytes_transferred;
+        size_t need_size = 0;
+        if (!ReadDone(&need_size)) {
+          Close();
+          return;
         }
+        // continue to read next msg.
+        Reserve(need_size);
+        OnRead();
       });
 }
 
 AsyncAcceptor::AsyncAcceptor(const std::string& ip, int port, int thread_num,
                              CallBack call_back_func)
+    : AsyncAcceptor(ip, port, thread_num,
+                    [call_back_func](std::unique_ptr<DataInfo> frame) {
+                      call_back_func(static_cast<const char*>(frame->buff),
+                                     frame->data_len);
+                    }) {}
+
+AsyncAcceptor::AsyncAcceptor(const std::string& ip, int port, int thread_num,
+                             SliceCallBack call_back_func,
+                             std::shared_ptr<FrameCodec> codec)
     : endpoint_(boost::asio::ip::address::from_string(ip), port),
       acceptor_(io_service_, endpoint_),
-      call_back_func_(call_back_func) {
+      call_back_func_(call_back_func),
+      pool_(std::make_shared<RecvBufferPool>()),
+      codec_(std::move(codec)) {
   worker_ = std::make_unique<boost::asio::io_service::work>(io_service_);
   for (int i = 0; i < thread_num; ++i) {
     worker_thread_.push_back(std::thread([&]() { io_service_.run(); }));
@@ -140,7 +207,7 @@ AsyncAcceptor::~AsyncAcceptor() {
 
 void AsyncAcceptor::StartAccept() {
   boost::shared_ptr<Session> client_session(
-      new Session(&io_service_, call_back_func_));
+      new Session(&io_service_, pool_, call_back_func_, codec_));
   acceptor_.async_accept(*client_session->GetSocket(),
                          std::bind(&AsyncAcceptor::OnAccept, this,
                                    client_session, std::placeholders::_1));
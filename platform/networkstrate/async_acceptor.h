@@ -21,14 +21,26 @@
 #include <boost/asio.hpp>
 #include <memory>
 
+#include "platform/common/data_comm/data_comm.h"
+#include "platform/common/data_comm/recv_buffer_pool.h"
+#include "platform/networkstrate/frame_codec.h"
+
 namespace resdb {
 
 class AsyncAcceptor {
  public:
   typedef std::function<void(const char* buffer, size_t len)> CallBack;
+  // The frames are received into pooled slabs and delivered in place, the
+  // slab is kept alive by the holder of the DataInfo.
+  typedef std::function<void(std::unique_ptr<DataInfo>)> SliceCallBack;
 
   AsyncAcceptor(const std::string& ip, int thread_num, int port,
                 CallBack call_back_func);
+  // The frames compressed by the clients accepting the codec are delivered
+  // decompressed.
+  AsyncAcceptor(const std::string& ip, int thread_num, int port,
+                SliceCallBack call_back_func,
+                std::shared_ptr<FrameCodec> codec = nullptr);
   virtual ~AsyncAcceptor();
 
   void StartAccept();
@@ -36,7 +48,9 @@ class AsyncAcceptor {
  private:
   class Session {
    public:
-    Session(boost::asio::io_service* io_service, CallBack call_back_func);
+    Session(boost::asio::io_service* io_service,
+            std::shared_ptr<RecvBufferPool> pool,
+            SliceCallBack call_back_func, std::shared_ptr<FrameCodec> codec);
     ~Session();
 
     boost::asio::ip::tcp::socket* GetSocket();
@@ -45,18 +59,22 @@ class AsyncAcceptor {
     void Close();
 
    private:
-    void ReadDone();
+    bool ReadDone(size_t* need_size);
     void OnRead();
+    void Reserve(size_t size);
+    bool OnFrame(size_t header, const char* data, size_t size);
 
    private:
     boost::asio::io_service* io_service_ = nullptr;
     boost::asio::ip::tcp::socket client_socket_;
-    size_t data_size_ = 0;
-    size_t need_size_ = 0;
-    size_t current_idx_ = 0;
-    char* recv_buffer_ = nullptr;
-    bool status_ = 0;
-    CallBack call_back_func_;
+    std::shared_ptr<RecvBufferPool> pool_;
+    std::shared_ptr<char> slab_;
+    size_t slab_size_ = 0;
+    size_t begin_ = 0;  // the start of the frame being received.
+    size_t end_ = 0;    // the end of the received data.
+    SliceCallBack call_back_func_;
+    std::shared_ptr<FrameCodec> codec_;
+    uint8_t hello_reply_ = 0;
   };
 
  private:
@@ -68,7 +86,9 @@ class AsyncAcceptor {
   boost::asio::ip::tcp::endpoint endpoint_;
   boost::asio::ip::tcp::acceptor acceptor_;
   std::unique_ptr<boost::asio::io_service::work> worker_;
-  CallBack call_back_func_;
+  SliceCallBack call_back_func_;
+  std::shared_ptr<RecvBufferPool> pool_;
+  std::shared_ptr<FrameCodec> codec_;
   std::vector<std::thread> worker_thread_;
   std::vector<boost::shared_ptr<Session>> sessions_;
 };
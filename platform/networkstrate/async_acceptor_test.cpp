@@ -25,6 +25,7 @@
 #include <future>
 
 #include "platform/common/network/tcp_socket.h"
+#include "platform/networkstrate/async_replica_client.h"
 
 namespace resdb {
 namespace {
@@ -130,6 +131,112 @@ TEST(AsyncAcceptorTest, RecvClose) {
   bc_done.get();
 }
 
+TEST(AsyncAcceptorTest, RecvFramesInPlace) {
+  std::promise<bool> bc;
+  std::future<bool> bc_done = bc.get_future();
+  std::vector<std::string> expected_data;
+  for (int i = 0; i < 100; ++i) {
+    // Some frames are larger than a slab.
+    expected_data.push_back(
+        std::string(i % 10 == 0 ? (3 << 20) + i : 1000 * i + 1, 'a' + i % 26));
+  }
+
+  // Keep the frames so that their slabs are not reused.
+  std::vector<std::unique_ptr<DataInfo>> frames;
+  AsyncAcceptor acceptor(
+      "127.0.0.1", 1234, 1,
+      AsyncAcceptor::SliceCallBack([&](std::unique_ptr<DataInfo> frame) {
+        EXPECT_NE(frame->holder, nullptr);
+        frames.push_back(std::move(frame));
+        if (frames.size() == expected_data.size()) {
+          bc.set_value(true);
+        }
+      }));
+
+  acceptor.StartAccept();
+
+  TcpSocket client_socket;
+  int ret = client_socket.Connect("127.0.0.1", 1234);
+  ASSERT_EQ(ret, 0);
+  for (const auto& data : expected_data) {
+    ASSERT_EQ(client_socket.Send(data), 0);
+  }
+  bc_done.get();
+  for (size_t i = 0; i < expected_data.size(); ++i) {
+    EXPECT_EQ(std::string(static_cast<char*>(frames[i]->buff),
+                          frames[i]->data_len),
+              expected_data[i]);
+  }
+  client_socket.Close();
+}
+
+// Sends the messages through AsyncReplicaClient with the client codec and
+// returns the frames delivered by the acceptor with the server codec.
+std::vector<std::string> SendWithCodec(
+    const std::vector<std::string>& messages,
+    std::shared_ptr<FrameCodec> client_codec,
+    std::shared_ptr<FrameCodec> server_codec) {
+  std::promise<bool> bc;
+  std::future<bool> bc_done = bc.get_future();
+  std::vector<std::string> received;
+  AsyncAcceptor acceptor(
+      "127.0.0.1", 1234, 1,
+      AsyncAcceptor::SliceCallBack([&](std::unique_ptr<DataInfo> frame) {
+        received.push_back(
+            std::string(static_cast<char*>(frame->buff), frame->data_len));
+        if (received.size() == messages.size()) {
+          bc.set_value(true);
+        }
+      }),
+      server_codec);
+  acceptor.StartAccept();
+
+  boost::asio::io_service io_service;
+  auto work = std::make_unique<boost::asio::io_service::work>(io_service);
+  std::thread io_thread([&]() { io_service.run(); });
+  {
+    AsyncReplicaClient client(&io_service, "127.0.0.1", 1234, true, 0,
+                              client_codec);
+    for (const auto& message : messages) {
+      client.SendMessage(message);
+    }
+    bc_done.get();
+    work.reset();
+    io_service.stop();
+    io_thread.join();
+  }
+  return received;
+}
+
+std::vector<std::string> GetBatches() {
+  std::vector<std::string> messages;
+  for (int i = 0; i < 20; ++i) {
+    std::string data;
+    // Some frames are below the min bytes of the codec.
+    for (int j = 0; j < (i % 4 == 0 ? 2 : 1000); ++j) {
+      data += "key_" + std::to_string(i * 1000 + j) + "_value";
+    }
+    messages.push_back(data);
+  }
+  return messages;
+}
+
+TEST(AsyncAcceptorTest, RecvCompressedFrames) {
+  auto codec = std::make_shared<FrameCodec>("key_value", 1024);
+  std::vector<std::string> messages = GetBatches();
+  EXPECT_EQ(SendWithCodec(messages, codec, codec), messages);
+}
+
+TEST(AsyncAcceptorTest, RecvFramesWithDifferentDictionary) {
+  std::vector<std::string> messages = GetBatches();
+  EXPECT_EQ(SendWithCodec(messages, std::make_shared<FrameCodec>("key", 1024),
+                          std::make_shared<FrameCodec>("value", 1024)),
+            messages);
+  EXPECT_EQ(SendWithCodec(messages, std::make_shared<FrameCodec>("key", 1024),
+                          nullptr),
+            messages);
+}
+
 }  // namespace
 
 }  // namespace resdb
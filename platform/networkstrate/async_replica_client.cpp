@@ -19,6 +19,8 @@
 
 #include "platform/networkstrate/async_replica_client.h"
 
+#include <poll.h>
+
 #include <boost/bind/bind.hpp>
 
 #include "platform/common/queue/lock_free_queue.h"
@@ -26,17 +28,47 @@
 
 namespace resdb {
 
+namespace {
+
+constexpr size_t kMaxWriteBytes = 1 << 20;
+
+}  // namespace
+
 AsyncReplicaClient::AsyncReplicaClient(boost::asio::io_service* io_service,
                                        const std::string& ip, int port,
-                                       bool is_use_long_conn)
+                                       bool is_use_long_conn,
+                                       size_t max_write_bytes,
+                                       std::shared_ptr<FrameCodec> codec)
     : socket_(*io_service),
       endpoint_(boost::asio::ip::address::from_string(ip), port),
-      in_process_(false) {}
+      in_process_(false),
+      max_write_bytes_(max_write_bytes > 0 ? max_write_bytes
+                                           : kMaxWriteBytes),
+      codec_(std::move(codec)) {
+  for (auto& depth : queue_depth_) {
+    depth = 0;
+  }
+  if (codec_ != nullptr) {
+    hello_ = codec_->GetHello();
+    hello_header_ = FrameCodec::kHelloFlag | hello_.size();
+  }
+}
 
 AsyncReplicaClient::~AsyncReplicaClient() {}
 
 int AsyncReplicaClient::SendMessage(const std::string& data) {
-  queue_.Push(std::make_unique<std::string>(data));
+  return SendMessage(NewMessageBuffer(data));
+}
+
+int AsyncReplicaClient::SendMessage(MessageBuffer data, SendLane lane) {
+  if (data == nullptr || data->empty()) {
+    return -1;
+  }
+  auto message = std::make_unique<Message>();
+  message->data_size = data->size();
+  message->data = std::move(data);
+  queue_depth_[static_cast<int>(lane)]++;
+  queue_[static_cast<int>(lane)].Push(std::move(message));
   if (!in_process_.load()) {
     bool old_value = false;
     if (in_process_.compare_exchange_strong(old_value, true,
@@ -48,60 +80,157 @@ int AsyncReplicaClient::SendMessage(const std::string& data) {
   return 0;
 }
 
+size_t AsyncReplicaClient::GetQueueDepth(SendLane lane) const {
+  return queue_depth_[static_cast<int>(lane)];
+}
+
+// Move all the queued messages to pending_data_ and take the ones fitting
+// in max_write_bytes_ for the next write, the control lane first. A message
+// larger than the limit is sent alone.
+bool AsyncReplicaClient::PopMessages() {
+  for (int lane = 0; lane < kSendLaneNum; ++lane) {
+    while (true) {
+      std::unique_ptr<Message> message = queue_[lane].Pop(0);
+      if (message == nullptr) {
+        break;
+      }
+      pending_data_[lane].push_back(std::move(message));
+    }
+  }
+
+  sending_data_.clear();
+  size_t write_bytes = 0;
+  for (int lane = 0; lane < kSendLaneNum; ++lane) {
+    auto& pending_data = pending_data_[lane];
+    while (!pending_data.empty()) {
+      size_t size = sizeof(size_t) + pending_data.front()->data_size;
+      if (!sending_data_.empty() && write_bytes + size > max_write_bytes_) {
+        return true;
+      }
+      write_bytes += size;
+      sending_data_.push_back(std::move(pending_data.front()));
+      pending_data.pop_front();
+      queue_depth_[lane]--;
+    }
+  }
+  return !sending_data_.empty();
+}
+
 void AsyncReplicaClient::OnSendNewMessage() {
-  std::unique_ptr<std::string> data = queue_.Pop(0);
-  if (data == nullptr || data->empty()) {
+  while (!PopMessages()) {
     in_process_ = false;
-    return;
+    // A message pushed after the queue was drained may have seen
+    // in_process_ set and left the sending to this thread.
+    bool old_value = false;
+    if ((queue_[0].Empty() && queue_[1].Empty()) ||
+        !in_process_.compare_exchange_strong(old_value, true,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+      return;
+    }
   }
-  pending_data_ = std::move(data);
-  status_ = 0;
-  OnSendMessage();
+  OnSend();
 }
 
-void AsyncReplicaClient::OnSendMessage() {
-  if (status_ == 0) {
-    data_size_ = pending_data_->size();
-    sending_data_size_ = sizeof(data_size_);
-    sending_data_ptr_ = reinterpret_cast<char*>(&data_size_);
-    sending_data_idx_ = 0;
-    status_ = 1;
-    OnSend();
-  } else if (status_ == 1) {
-    sending_data_size_ = data_size_;
-    sending_data_ptr_ = pending_data_->c_str();
-    sending_data_idx_ = 0;
-    status_ = 2;
-    OnSend();
+// The replica sends nothing after the hello reply, so a pending read only
+// completes when it closes or resets the connection. The next write then
+// reconnects instead of writing to a closed connection, which would still
+// succeed locally and lose the messages. The handlers of the previous
+// connections are ignored.
+void AsyncReplicaClient::WatchClose() {
+  uint64_t conn_id = ++conn_id_;
+  peer_closed_ = false;
+  socket_.async_read_some(
+      boost::asio::buffer(&watch_byte_, sizeof(watch_byte_)),
+      [this, conn_id](const boost::system::error_code& error, size_t) {
+        if (conn_id != conn_id_) {
+          return;
+        }
+        if (error) {
+          peer_closed_ = true;
+          return;
+        }
+        WatchClose();
+      });
+}
+
+// The close seen by the kernel may not have reached the handler of
+// WatchClose() yet, e.g. if the replica closed the connection right before
+// this write. As the replica never writes after the hello reply, the socket
+// only becomes readable or hung up once it is closed.
+bool AsyncReplicaClient::IsPeerClosed() {
+  if (peer_closed_) {
+    return true;
+  }
+  pollfd pfd = {socket_.native_handle(), POLLIN, 0};
+  return poll(&pfd, 1, 0) != 0;
+}
+
+// Send the compressed frame if the replica has accepted the codec and the
+// message shrinks. It is encoded again if the message is resent after
+// reconnecting.
+void AsyncReplicaClient::Encode(Message* message) {
+  MessageBuffer compressed =
+      compress_ ? codec_->Compress(message->data) : nullptr;
+  if (compressed != nullptr) {
+    message->send_data = std::move(compressed);
+    message->header = message->send_data->size() | FrameCodec::kCompressedFlag;
   } else {
-    status_ = 0;
-    OnSendNewMessage();
+    message->send_data = message->data;
+    message->header = message->data_size;
   }
 }
 
+// Write the length header and the data of each message with one gather
+// write.
 void AsyncReplicaClient::OnSend() {
-  socket_.async_write_some(
-      boost::asio::buffer(sending_data_ptr_ + sending_data_idx_,
-                          sending_data_size_ - sending_data_idx_),
+  if (IsPeerClosed()) {
+    ReConnect();
+    return;
+  }
+  sending_buffers_.clear();
+  for (const auto& message : sending_data_) {
+    Encode(message.get());
+    sending_buffers_.push_back(
+        boost::asio::buffer(&message->header, sizeof(message->header)));
+    sending_buffers_.push_back(boost::asio::buffer(*message->send_data));
+  }
+  boost::asio::async_write(
+      socket_, sending_buffers_,
       [&](const boost::system::error_code& error, size_t send_size) {
-        if (error) {
-          ReConnect();
-        } else {
-          sending_data_idx_ += send_size;
-          if (sending_data_idx_ >= sending_data_size_) {
-            OnSendMessage();
-          } else {
-            OnSend();
-          }
-        }
+        OnSendDone(error, send_size);
       });
 }
 
+void AsyncReplicaClient::OnSendDone(const boost::system::error_code& error,
+                                    size_t send_size) {
+  if (!error) {
+    OnSendNewMessage();
+    return;
+  }
+  // Resend the messages not written completely after reconnecting.
+  size_t sent_num = 0, sent_size = 0;
+  while (sent_num < sending_data_.size()) {
+    sent_size += sizeof(size_t) + sending_data_[sent_num]->send_data->size();
+    if (sent_size > send_size) {
+      break;
+    }
+    sent_num++;
+  }
+  sending_data_.erase(sending_data_.begin(), sending_data_.begin() + sent_num);
+  ReConnect();
+}
+
 void AsyncReplicaClient::ReConnect() {
+  boost::system::error_code error;
+  socket_.close(error);
   socket_.async_connect(endpoint_, [&](const boost::system::error_code& error) {
     if (!error) {
-      status_ = 0;
-      OnSendMessage();
+      if (codec_ != nullptr) {
+        SendHello();
+      } else {
+        OnConnected();
+      }
     } else {
       usleep(10000);
       ReConnect();
@@ -109,4 +238,38 @@ void AsyncReplicaClient::ReConnect() {
   });
 }
 
+// Offer the codec to the replica, which replies whether it accepts it.
+void AsyncReplicaClient::SendHello() {
+  compress_ = false;
+  std::vector<boost::asio::const_buffer> buffers = {
+      boost::asio::buffer(&hello_header_, sizeof(hello_header_)),
+      boost::asio::buffer(hello_)};
+  boost::asio::async_write(
+      socket_, buffers, [&](const boost::system::error_code& error, size_t) {
+        if (error) {
+          ReConnect();
+          return;
+        }
+        boost::asio::async_read(
+            socket_, boost::asio::buffer(&hello_reply_, sizeof(hello_reply_)),
+            [&](const boost::system::error_code& error, size_t) {
+              if (error) {
+                ReConnect();
+                return;
+              }
+              compress_ = hello_reply_ == 1;
+              OnConnected();
+            });
+      });
+}
+
+void AsyncReplicaClient::OnConnected() {
+  WatchClose();
+  if (sending_data_.empty()) {
+    OnSendNewMessage();
+  } else {
+    OnSend();
+  }
+}
+
 }  // namespace resdb
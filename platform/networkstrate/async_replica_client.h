@@ -20,44 +20,86 @@
 #pragma once
 
 #include <boost/asio.hpp>
+#include <deque>
 
 #include "interface/rdbc/net_channel.h"
 #include "platform/common/queue/lock_free_queue.h"
+#include "platform/networkstrate/frame_codec.h"
+#include "platform/networkstrate/message_buffer.h"
+#include "platform/networkstrate/transport.h"
 #include "platform/proto/replica_info.pb.h"
 
 namespace resdb {
 
-class AsyncReplicaClient {
+// AsyncReplicaClient sends length-prefixed messages to one replica over a
+// long connection. The messages queued since the last write are sent
+// together by one gather write of at most max_write_bytes bytes. If a codec
+// is set, the messages are compressed once the replica has accepted the
+// codec after each connect.
+class AsyncReplicaClient : public TransportClient {
  public:
   AsyncReplicaClient(boost::asio::io_service* io_service, const std::string& ip,
-                     int port, bool is_use_long_conn = false);
-  virtual ~AsyncReplicaClient();
+                     int port, bool is_use_long_conn = false,
+                     size_t max_write_bytes = 0,
+                     std::shared_ptr<FrameCodec> codec = nullptr);
+  ~AsyncReplicaClient() override;
 
   virtual int SendMessage(const std::string& data);
+  int SendMessage(MessageBuffer data,
+                  SendLane lane = SendLane::kBulk) override;
+
+  size_t GetQueueDepth(SendLane lane) const override;
 
  private:
   void ReConnect();
+  void SendHello();
+  void OnConnected();
   void OnSendNewMessage();
-  void OnSendMessage();
   void OnSend();
+  void OnSendDone(const boost::system::error_code& error, size_t send_size);
+  bool PopMessages();
+  void WatchClose();
+  bool IsPeerClosed();
 
  private:
-  LockFreeQueue<std::string> queue_;
+  struct Message {
+    MessageBuffer data;
+    size_t data_size;
+    // The data or its compressed frame, and the length header sent before
+    // it.
+    MessageBuffer send_data;
+    size_t header;
+  };
+
+  void Encode(Message* message);
+
+  LockFreeQueue<Message> queue_[kSendLaneNum];
+  std::atomic<size_t> queue_depth_[kSendLaneNum];
   std::unique_ptr<NetChannel> client_;
   boost::asio::ip::tcp::socket socket_;
   boost::asio::ip::tcp::endpoint endpoint_;
   std::mutex mutex_;
   std::atomic<bool> in_process_;
+  // Set once the replica closes the current connection, or before the first
+  // connect.
+  std::atomic<bool> peer_closed_ = true;
+  std::atomic<uint64_t> conn_id_ = 0;
+  char watch_byte_ = 0;
 
   // ===== for async send =====
-  std::unique_ptr<std::string> pending_data_;
-
-  size_t data_size_ = 0;          // the size of the data needed to be sent.
-  size_t sending_data_idx_ = 0;   // the current pos to be sent in data_ptr.
-  size_t sending_data_size_ = 0;  // the size needed to be sent.
-  const char* sending_data_ptr_ = nullptr;  // point to the data.
+  size_t max_write_bytes_;
+  // Messages popped from the queues but not sent yet.
+  std::deque<std::unique_ptr<Message>> pending_data_[kSendLaneNum];
+  // Messages sent by the current write.
+  std::vector<std::unique_ptr<Message>> sending_data_;
+  std::vector<boost::asio::const_buffer> sending_buffers_;
 
-  int status_ = 0;  // sending status.
+  // ===== for compression =====
+  std::shared_ptr<FrameCodec> codec_;
+  bool compress_ = false;
+  std::string hello_;
+  size_t hello_header_ = 0;
+  uint8_t hello_reply_ = 0;
 };
 
 }  // namespace resdb
@@ -48,10 +48,10 @@ TEST(AsyncReplicaClientTest, SendMessage) {
   });
 
   boost::asio::io_service io_service;
-  std::thread t([&]() { io_service.run(); });
-
   boost::asio::io_service::work *work =
       new boost::asio::io_service::work(io_service);
+  std::thread t([&]() { io_service.run(); });
+
   AsyncReplicaClient client(&io_service, "127.0.0.1", 1234);
   EXPECT_EQ(client.SendMessage("test"), 0);
   bc_done.get();
@@ -81,10 +81,10 @@ TEST(AsyncReplicaClientTest, SendLargeMessage) {
   });
 
   boost::asio::io_service io_service;
-  std::thread t([&]() { io_service.run(); });
-
   boost::asio::io_service::work *work =
       new boost::asio::io_service::work(io_service);
+  std::thread t([&]() { io_service.run(); });
+
   AsyncReplicaClient client(&io_service, "127.0.0.1", 1234);
   EXPECT_EQ(client.SendMessage(std::string(1000000, 't')), 0);
   bc_done.get();
@@ -114,9 +114,9 @@ TEST(AsyncReplicaClientTest, MultiSendMessage) {
   });
 
   boost::asio::io_service io_service;
-  std::thread t([&]() { io_service.run(); });
   boost::asio::io_service::work *work =
       new boost::asio::io_service::work(io_service);
+  std::thread t([&]() { io_service.run(); });
   AsyncReplicaClient client(&io_service, "127.0.0.1", 1234);
   for (int i = 0; i < 10; ++i) {
     EXPECT_EQ(client.SendMessage("test"), 0);
@@ -128,6 +128,94 @@ TEST(AsyncReplicaClientTest, MultiSendMessage) {
   t.join();
 }
 
+TEST(AsyncReplicaClientTest, SendSharedMessagesInBatches) {
+  std::promise<bool> bc;
+  std::future<bool> bc_done = bc.get_future();
+
+  std::thread svr_thead = std::thread([&]() {
+    TcpSocket svr_TcpSocket;
+    svr_TcpSocket.Listen("127.0.0.1", 1234);
+    auto client_socket = svr_TcpSocket.Accept();
+    for (int i = 0; i < 1000; ++i) {
+      char *buf = nullptr;
+      size_t len = 0;
+      int ret = client_socket->Recv((void **)&buf, &len);
+      EXPECT_EQ(ret, static_cast<int>(len));
+      EXPECT_EQ(std::string(buf, len), "test" + std::to_string(i));
+      free(buf);
+    }
+    bc.set_value(true);
+  });
+
+  boost::asio::io_service io_service;
+  boost::asio::io_service::work *work =
+      new boost::asio::io_service::work(io_service);
+  std::thread t([&]() { io_service.run(); });
+  // Each write holds a few messages only.
+  AsyncReplicaClient client(&io_service, "127.0.0.1", 1234, true, 64);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(client.SendMessage(NewMessageBuffer("test" + std::to_string(i))),
+              0);
+  }
+  bc_done.get();
+  delete work;
+  work = nullptr;
+  svr_thead.join();
+  t.join();
+}
+
+TEST(AsyncReplicaClientTest, SendControlLaneFirst) {
+  std::promise<bool> bc;
+  std::future<bool> bc_done = bc.get_future();
+
+  std::thread svr_thead = std::thread([&]() {
+    TcpSocket svr_TcpSocket;
+    svr_TcpSocket.Listen("127.0.0.1", 1234);
+    auto client_socket = svr_TcpSocket.Accept();
+    std::vector<std::string> received;
+    for (int i = 0; i < 101; ++i) {
+      char *buf = nullptr;
+      size_t len = 0;
+      int ret = client_socket->Recv((void **)&buf, &len);
+      EXPECT_EQ(ret, static_cast<int>(len));
+      received.push_back(std::string(buf, len));
+      free(buf);
+    }
+    // The first bulk message was taken before the connection was set up,
+    // the control message goes right after it.
+    EXPECT_EQ(received[1], "vote");
+    received.erase(received.begin() + 1);
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(received[i], "bulk" + std::to_string(i));
+    }
+    bc.set_value(true);
+  });
+
+  boost::asio::io_service io_service;
+  boost::asio::io_service::work *work =
+      new boost::asio::io_service::work(io_service);
+  AsyncReplicaClient client(&io_service, "127.0.0.1", 1234, true, 64);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(client.SendMessage(NewMessageBuffer("bulk" + std::to_string(i)),
+                                 SendLane::kBulk),
+              0);
+  }
+  EXPECT_EQ(client.SendMessage(NewMessageBuffer("vote"), SendLane::kControl),
+            0);
+  EXPECT_EQ(client.GetQueueDepth(SendLane::kControl), 1);
+  EXPECT_EQ(client.GetQueueDepth(SendLane::kBulk), 99);
+
+  // Nothing is written before the io service runs.
+  std::thread t([&]() { io_service.run(); });
+  bc_done.get();
+  EXPECT_EQ(client.GetQueueDepth(SendLane::kControl), 0);
+  EXPECT_EQ(client.GetQueueDepth(SendLane::kBulk), 0);
+  delete work;
+  work = nullptr;
+  svr_thead.join();
+  t.join();
+}
+
 TEST(AsyncReplicaClientTest, Reconnect) {
   std::promise<bool> bc1, bc2;
   std::future<bool> bc1_done = bc1.get_future(), bc2_done = bc2.get_future();
@@ -150,13 +238,17 @@ TEST(AsyncReplicaClientTest, Reconnect) {
   });
 
   boost::asio::io_service io_service;
-  std::thread t([&]() { io_service.run(); });
   boost::asio::io_service::work *work =
       new boost::asio::io_service::work(io_service);
+  std::thread t([&]() { io_service.run(); });
   AsyncReplicaClient client(&io_service, "127.0.0.1", 1234);
   for (int i = 0; i < 2; ++i) {
     EXPECT_EQ(client.SendMessage("test"), 0);
-    if (i == 0) bc2_done.get();
+    if (i == 0) {
+      // Send the next message as soon as the server has closed the
+      // connection. It is held until the client has reconnected.
+      bc2_done.get();
+    }
   }
   bc1_done.get();
   delete work;
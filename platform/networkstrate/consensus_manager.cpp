@@ -22,6 +22,7 @@
 #include <glog/logging.h>
 #include <unistd.h>
 
+#include "platform/common/data_comm/wire_format.h"
 #include "platform/proto/broadcast.pb.h"
 
 namespace resdb {
@@ -165,15 +166,29 @@ void ConsensusManager::SendHeartBeat() {
 int ConsensusManager::Process(std::unique_ptr<Context> context,
                               std::unique_ptr<DataInfo> request_info) {
   global_stats_->IncClientCall();
-  // Decode the whole message, it includes the certificate and data.
-  ResDBMessage message;
-  if (!message.ParseFromArray(request_info->buff, request_info->data_len)) {
+  // Decode the whole message, it includes the certificate and data. The
+  // data is read in place and parsed into the request directly.
+  std::string_view data;
+  SignatureInfo signature;
+  bool has_signature = false;
+  bool ret = ForEachBytesField(
+      static_cast<const char*>(request_info->buff), request_info->data_len,
+      [&](int field_number, std::string_view value) {
+        if (field_number == ResDBMessage::kDataFieldNumber) {
+          data = value;
+        } else if (field_number == ResDBMessage::kSignatureFieldNumber) {
+          has_signature = true;
+          return signature.ParseFromArray(value.data(), value.size());
+        }
+        return true;
+      });
+  if (!ret) {
     LOG(ERROR) << "parse data info fail";
     return -1;
   }
 
   std::unique_ptr<Request> request = std::make_unique<Request>();
-  if (!request->ParseFromString(message.data())) {
+  if (!request->ParseFromArray(data.data(), data.size())) {
     LOG(ERROR) << "parse data info fail";
     return -1;
   }
@@ -183,12 +198,11 @@ int ConsensusManager::Process(std::unique_ptr<Context> context,
   }
 
   // Check if the certificate is valid.
-  if (message.has_signature() && verifier_) {
-    bool valid = verifier_->VerifyMessage(message.data(), message.signature());
+  if (has_signature && verifier_) {
+    bool valid = verifier_->VerifyMessage(std::string(data), signature);
     if (!valid) {
-      LOG(ERROR) << "request is not valid:"
-                 << message.signature().DebugString();
-      LOG(ERROR) << " msg:" << message.data().size()
+      LOG(ERROR) << "request is not valid:" << signature.DebugString();
+      LOG(ERROR) << " msg:" << data.size()
                  << " is recovery:" << request->is_recovery();
       return -2;
     }
@@ -197,7 +211,7 @@ int ConsensusManager::Process(std::unique_ptr<Context> context,
 
   // forward the signature to the request so that it can be included in the
   // request/response set if needed.
-  context->signature = message.signature();
+  context->signature = signature;
   // LOG(ERROR) << "======= server:" << config_.GetSelfInfo().id()
   //          << " get request type:" << request->type()
   //         << " from:" << request->sender_id();
@@ -356,7 +370,10 @@ std::unique_ptr<ReplicaCommunicator> ConsensusManager::GetReplicaClient(
       verifier_ == nullptr || config_.GetConfigData().not_need_signature()
           ? nullptr
           : verifier_.get(),
-      is_use_long_conn, config_.GetOutputWorkerNum(), config_.GetTcpBatchNum());
+      is_use_long_conn, config_.GetOutputWorkerNum(), config_.GetTcpBatchNum(),
+      config_.GetConfigData().tcp_max_write_bytes(),
+      FrameCodec::Create(config_.GetConfigData()),
+      GetShmRingBytes(config_.GetConfigData()), config_.GetTransport());
 }
 
 void ConsensusManager::AddNewReplica(const ReplicaInfo& info) {}
@@ -0,0 +1,363 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/frame_codec.h"
+
+#include <glog/logging.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace resdb {
+
+namespace {
+
+constexpr size_t kDefaultMinBytes = 1024;
+// The results of the frames compressed recently, enough for a broadcast to
+// be sent by all the connections before its result is dropped.
+constexpr size_t kCacheSize = 64;
+constexpr uint32_t kHelloMagic = 0x5a424452;  // "RDBZ"
+
+constexpr size_t kSegmentSize = 16;
+// The bytes of the samples scanned by TrainDictionary.
+constexpr size_t kMaxTrainBytes = 8 << 20;
+
+uint64_t GetCpuTimeUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+}  // namespace
+
+FrameCodec::FrameCodec(std::string dictionary, size_t min_bytes, int level)
+    : dictionary_(std::move(dictionary)),
+      min_bytes_(min_bytes),
+      level_(level) {
+  dictionary_id_ =
+      adler32(adler32(0L, Z_NULL, 0),
+              reinterpret_cast<const Bytef*>(dictionary_.data()),
+              dictionary_.size());
+  global_stats_ = Stats::GetGlobalStats();
+}
+
+FrameCodec::~FrameCodec() {
+  for (auto& stream : deflaters_) {
+    deflateEnd(stream.get());
+  }
+  for (auto& stream : inflaters_) {
+    inflateEnd(stream.get());
+  }
+}
+
+std::shared_ptr<FrameCodec> FrameCodec::Create(const ResConfigData& config) {
+  if (!config.enable_compression()) {
+    return nullptr;
+  }
+  std::string dictionary;
+  if (!config.compression_dictionary_path().empty()) {
+    std::ifstream file(config.compression_dictionary_path(), std::ios::binary);
+    if (!file.is_open()) {
+      LOG(ERROR) << "open compression dictionary fail:"
+                 << config.compression_dictionary_path();
+      return nullptr;
+    }
+    dictionary.assign(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+  }
+  size_t min_bytes = config.compression_min_bytes() > 0
+                         ? config.compression_min_bytes()
+                         : kDefaultMinBytes;
+  LOG(INFO) << "enable compression, dictionary size:" << dictionary.size()
+            << " min bytes:" << min_bytes;
+  return std::make_shared<FrameCodec>(std::move(dictionary), min_bytes);
+}
+
+uint32_t FrameCodec::GetDictionaryId() const { return dictionary_id_; }
+
+std::unique_ptr<z_stream> FrameCodec::GetDeflater() {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!deflaters_.empty()) {
+      auto stream = std::move(deflaters_.back());
+      deflaters_.pop_back();
+      deflateReset(stream.get());
+      return stream;
+    }
+  }
+  auto stream = std::make_unique<z_stream>();
+  // Raw deflate, the frames carry their own sizes.
+  if (deflateInit2(stream.get(), level_, Z_DEFLATED, -MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    LOG(ERROR) << "init deflate stream fail";
+    return nullptr;
+  }
+  return stream;
+}
+
+std::unique_ptr<z_stream> FrameCodec::GetInflater() {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!inflaters_.empty()) {
+      auto stream = std::move(inflaters_.back());
+      inflaters_.pop_back();
+      inflateReset(stream.get());
+      return stream;
+    }
+  }
+  auto stream = std::make_unique<z_stream>();
+  if (inflateInit2(stream.get(), -MAX_WBITS) != Z_OK) {
+    LOG(ERROR) << "init inflate stream fail";
+    return nullptr;
+  }
+  return stream;
+}
+
+MessageBuffer FrameCodec::Compress(const MessageBuffer& data) {
+  if (data == nullptr || data->size() < min_bytes_) {
+    return nullptr;
+  }
+  std::shared_ptr<CacheItem> item;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto& cache_item = cache_[data.get()];
+    // The item of a released frame is replaced. The address can not be
+    // reused before the item is dropped as it keeps the control block.
+    if (cache_item == nullptr || cache_item->data.lock() != data) {
+      if (cache_item == nullptr) {
+        cache_order_.push_back(data.get());
+      }
+      cache_item = std::make_shared<CacheItem>();
+      cache_item->data = data;
+    }
+    item = cache_item;
+    while (cache_order_.size() > kCacheSize) {
+      cache_.erase(cache_order_.front());
+      cache_order_.pop_front();
+    }
+  }
+  // The connections sending the same frame wait for the first one to
+  // compress it.
+  std::call_once(item->once, [&]() { item->result = DoCompress(*data); });
+  return item->result;
+}
+
+MessageBuffer FrameCodec::DoCompress(const std::string& data) {
+  uint64_t start_time = GetCpuTimeUs();
+  std::unique_ptr<z_stream> stream = GetDeflater();
+  if (stream == nullptr) {
+    return nullptr;
+  }
+  if (!dictionary_.empty()) {
+    deflateSetDictionary(stream.get(),
+                         reinterpret_cast<const Bytef*>(dictionary_.data()),
+                         dictionary_.size());
+  }
+
+  uint64_t raw_size = data.size();
+  std::string output(sizeof(raw_size) + deflateBound(stream.get(), raw_size),
+                     0);
+  memcpy(output.data(), &raw_size, sizeof(raw_size));
+  stream->next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream->avail_in = data.size();
+  stream->next_out = reinterpret_cast<Bytef*>(output.data() + sizeof(raw_size));
+  stream->avail_out = output.size() - sizeof(raw_size);
+  int ret = deflate(stream.get(), Z_FINISH);
+  output.resize(sizeof(raw_size) + stream->total_out);
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    deflaters_.push_back(std::move(stream));
+  }
+
+  if (ret != Z_STREAM_END) {
+    LOG(ERROR) << "compress frame fail:" << ret;
+    return nullptr;
+  }
+  bool shrunk = output.size() < data.size();
+  global_stats_->Compress(data.size(), shrunk ? output.size() : data.size(),
+                          GetCpuTimeUs() - start_time);
+  if (!shrunk) {
+    return nullptr;
+  }
+  return NewMessageBuffer(std::move(output));
+}
+
+std::unique_ptr<DataInfo> FrameCodec::Decompress(const char* data,
+                                                 size_t size) {
+  uint64_t start_time = GetCpuTimeUs();
+  uint64_t raw_size = 0;
+  if (size < sizeof(raw_size)) {
+    return nullptr;
+  }
+  memcpy(&raw_size, data, sizeof(raw_size));
+  // The size comes from the peer, check it before allocating.
+  if (raw_size == 0 || raw_size > kMaxFrameBytes ||
+      raw_size / kMaxInflateRatio > size - sizeof(raw_size)) {
+    LOG(ERROR) << "invalid frame size:" << raw_size
+               << " compressed size:" << size;
+    return nullptr;
+  }
+  char* buff = static_cast<char*>(malloc(raw_size));
+  if (buff == nullptr) {
+    LOG(ERROR) << "alloc frame fail, size:" << raw_size;
+    return nullptr;
+  }
+  // The sub messages sliced from the frame share its holder.
+  auto frame = std::make_unique<DataInfo>();
+  frame->holder = std::shared_ptr<char>(buff, free);
+  frame->buff = buff;
+  frame->data_len = raw_size;
+  std::unique_ptr<z_stream> stream = GetInflater();
+  if (stream == nullptr) {
+    return nullptr;
+  }
+
+  // A raw deflate stream does not ask for the dictionary.
+  if (!dictionary_.empty()) {
+    inflateSetDictionary(stream.get(),
+                         reinterpret_cast<const Bytef*>(dictionary_.data()),
+                         dictionary_.size());
+  }
+  stream->next_in = reinterpret_cast<Bytef*>(
+      const_cast<char*>(data + sizeof(raw_size)));
+  stream->avail_in = size - sizeof(raw_size);
+  stream->next_out = static_cast<Bytef*>(frame->buff);
+  stream->avail_out = raw_size;
+  int ret = inflate(stream.get(), Z_FINISH);
+  bool done = ret == Z_STREAM_END && stream->total_out == raw_size;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    inflaters_.push_back(std::move(stream));
+  }
+  if (!done) {
+    LOG(ERROR) << "decompress frame fail:" << ret;
+    return nullptr;
+  }
+  global_stats_->Decompress(GetCpuTimeUs() - start_time);
+  return frame;
+}
+
+std::string FrameCodec::GetHello() const {
+  std::string hello(sizeof(kHelloMagic) + sizeof(dictionary_id_), 0);
+  memcpy(hello.data(), &kHelloMagic, sizeof(kHelloMagic));
+  memcpy(hello.data() + sizeof(kHelloMagic), &dictionary_id_,
+         sizeof(dictionary_id_));
+  return hello;
+}
+
+bool FrameCodec::AcceptHello(const char* data, size_t size) const {
+  if (size != sizeof(kHelloMagic) + sizeof(dictionary_id_)) {
+    return false;
+  }
+  uint32_t magic = 0, dictionary_id = 0;
+  memcpy(&magic, data, sizeof(magic));
+  memcpy(&dictionary_id, data + sizeof(magic), sizeof(dictionary_id));
+  return magic == kHelloMagic && dictionary_id == dictionary_id_;
+}
+
+std::string TrainDictionary(const std::vector<std::string>& samples,
+                            size_t max_size) {
+  struct Segment {
+    int sample_num = 0;  // the samples containing the segment.
+    int last_sample = -1;
+    size_t first_pos = 0;  // the first occurrence in all the samples.
+  };
+  std::unordered_map<std::string_view, Segment> segments;
+  size_t scanned = 0;
+  for (size_t i = 0; i < samples.size() && scanned < kMaxTrainBytes; ++i) {
+    const std::string& sample = samples[i];
+    for (size_t pos = 0; pos + kSegmentSize <= sample.size(); ++pos) {
+      Segment& segment =
+          segments[std::string_view(sample.data() + pos, kSegmentSize)];
+      if (segment.last_sample != static_cast<int>(i)) {
+        if (segment.sample_num == 0) {
+          segment.first_pos = scanned + pos;
+        }
+        segment.sample_num++;
+        segment.last_sample = i;
+      }
+    }
+    scanned += sample.size();
+  }
+
+  std::vector<std::pair<std::string_view, Segment>> candidates;
+  for (const auto& it : segments) {
+    if (it.second.sample_num > 1) {
+      candidates.push_back(it);
+    }
+  }
+  // The overlapping segments of a common substring have the same count and
+  // are taken in their order, each extends the piece of the previous one.
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) {
+              if (a.second.sample_num != b.second.sample_num) {
+                return a.second.sample_num > b.second.sample_num;
+              }
+              return a.second.first_pos < b.second.first_pos;
+            });
+
+  std::vector<std::string> pieces;
+  // The last kSegmentSize - 1 bytes of each piece.
+  std::map<std::string, size_t> tails;
+  size_t total_size = 0;
+  for (const auto& [segment, info] : candidates) {
+    if (total_size >= max_size) {
+      break;
+    }
+    std::string head(segment.substr(0, kSegmentSize - 1));
+    auto it = tails.find(head);
+    if (it != tails.end()) {
+      size_t idx = it->second;
+      tails.erase(it);
+      pieces[idx].push_back(segment.back());
+      tails[pieces[idx].substr(pieces[idx].size() - (kSegmentSize - 1))] =
+          idx;
+      total_size++;
+      continue;
+    }
+    bool found = false;
+    for (const auto& piece : pieces) {
+      if (piece.find(segment) != std::string::npos) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      continue;
+    }
+    tails[std::string(segment.substr(1))] = pieces.size();
+    pieces.push_back(std::string(segment));
+    total_size += segment.size();
+  }
+
+  std::string dictionary;
+  for (auto it = pieces.rbegin(); it != pieces.rend(); ++it) {
+    dictionary += *it;
+  }
+  if (dictionary.size() > max_size) {
+    dictionary = dictionary.substr(dictionary.size() - max_size);
+  }
+  return dictionary;
+}
+
+}  // namespace resdb
@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <zlib.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "platform/common/data_comm/data_comm.h"
+#include "platform/networkstrate/message_buffer.h"
+#include "platform/proto/replica_info.pb.h"
+#include "platform/statistic/stats.h"
+
+namespace resdb {
+
+// FrameCodec compresses the frames sent between the replicas with raw
+// deflate and a preset dictionary shared by all the replicas. Each frame is
+// compressed on its own, so a message broadcast to all the replicas is
+// compressed once and the result is shared by their connections.
+//
+// A compressed frame is sent with kCompressedFlag set in its length header
+// and holds the uncompressed size followed by the deflate stream. A client
+// sends a hello frame, with kHelloFlag set, after connecting and compresses
+// its frames only if the acceptor replies that it has the same dictionary.
+class FrameCodec {
+ public:
+  static constexpr size_t kCompressedFlag = 1ull << 63;
+  static constexpr size_t kHelloFlag = 1ull << 62;
+  static constexpr size_t kSizeMask = kHelloFlag - 1;
+  // The largest frame the acceptors take, before or after decompressing.
+  static constexpr size_t kMaxFrameBytes = 10000000000ull;
+  // A deflate stream expands at most 1032 times.
+  static constexpr size_t kMaxInflateRatio = 1032;
+
+  // Frames smaller than min_bytes are not compressed.
+  FrameCodec(std::string dictionary = "", size_t min_bytes = 0,
+             int level = Z_BEST_SPEED);
+  ~FrameCodec();
+
+  // Returns nullptr if the compression is not enabled.
+  static std::shared_ptr<FrameCodec> Create(const ResConfigData& config);
+
+  // The adler32 checksum of the dictionary.
+  uint32_t GetDictionaryId() const;
+
+  // Returns nullptr if the frame is smaller than min_bytes or does not
+  // shrink. The results of the recent frames are kept so that the frame is
+  // compressed once for all the connections sending it.
+  MessageBuffer Compress(const MessageBuffer& data);
+  // Returns nullptr if the frame is corrupted or its uncompressed size can
+  // not be reached by the deflate stream or exceeds kMaxFrameBytes. The
+  // frame is owned by its holder.
+  std::unique_ptr<DataInfo> Decompress(const char* data, size_t size);
+
+  std::string GetHello() const;
+  // Whether the peer sending the hello uses the same dictionary.
+  bool AcceptHello(const char* data, size_t size) const;
+
+ private:
+  MessageBuffer DoCompress(const std::string& data);
+  std::unique_ptr<z_stream> GetDeflater();
+  std::unique_ptr<z_stream> GetInflater();
+
+ private:
+  struct CacheItem {
+    std::weak_ptr<const std::string> data;
+    std::once_flag once;
+    MessageBuffer result;
+  };
+
+  std::string dictionary_;
+  uint32_t dictionary_id_;
+  size_t min_bytes_;
+  int level_;
+  Stats* global_stats_;
+
+  std::mutex mutex_;
+  // The streams are reset and reused by the frames.
+  std::vector<std::unique_ptr<z_stream>> deflaters_, inflaters_;
+  std::map<const std::string*, std::shared_ptr<CacheItem>> cache_;
+  std::deque<const std::string*> cache_order_;
+};
+
+// Builds a dictionary of at most max_size bytes from the substrings shared
+// by most of the sample frames, the most common ones at the end where the
+// deflate distances to them are the shortest.
+std::string TrainDictionary(const std::vector<std::string>& samples,
+                            size_t max_size = 32 << 10);
+
+}  // namespace resdb
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/frame_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+
+namespace resdb {
+namespace {
+
+// A frame of key/value requests like a client batch.
+std::string GetBatch(int start, int num) {
+  std::string batch;
+  for (int i = start; i < start + num; ++i) {
+    batch += "\x08\x01\x12\x0cuser_key_" + std::to_string(i % 1000) +
+             "\x1a\x14value_of_the_user_" + std::to_string(i % 100);
+  }
+  return batch;
+}
+
+std::string GetData(const std::unique_ptr<DataInfo>& frame) {
+  return std::string(static_cast<char*>(frame->buff), frame->data_len);
+}
+
+TEST(FrameCodecTest, CompressAndDecompress) {
+  FrameCodec codec(GetBatch(0, 100));
+  MessageBuffer data = NewMessageBuffer(GetBatch(1000, 200));
+  MessageBuffer compressed = codec.Compress(data);
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_LT(compressed->size(), data->size());
+
+  std::unique_ptr<DataInfo> frame =
+      codec.Decompress(compressed->data(), compressed->size());
+  ASSERT_NE(frame, nullptr);
+  EXPECT_EQ(GetData(frame), *data);
+}
+
+TEST(FrameCodecTest, DecompressCorruptedFrame) {
+  FrameCodec codec;
+  MessageBuffer compressed = codec.Compress(NewMessageBuffer(GetBatch(0, 50)));
+  ASSERT_NE(compressed, nullptr);
+
+  std::string data = *compressed;
+  data[data.size() / 2] ^= 0xff;
+  data.resize(data.size() - 4);
+  EXPECT_EQ(codec.Decompress(data.data(), data.size()), nullptr);
+  EXPECT_EQ(codec.Decompress(data.data(), 4), nullptr);
+}
+
+TEST(FrameCodecTest, RejectOversizedFrame) {
+  FrameCodec codec;
+  MessageBuffer compressed = codec.Compress(NewMessageBuffer(GetBatch(0, 50)));
+  ASSERT_NE(compressed, nullptr);
+
+  // The uncompressed size in the header is beyond what the stream can
+  // inflate to, or beyond the largest frame.
+  std::string data = *compressed;
+  uint64_t raw_size = data.size() * FrameCodec::kMaxInflateRatio;
+  memcpy(data.data(), &raw_size, sizeof(raw_size));
+  EXPECT_EQ(codec.Decompress(data.data(), data.size()), nullptr);
+  raw_size = FrameCodec::kMaxFrameBytes + 1;
+  memcpy(data.data(), &raw_size, sizeof(raw_size));
+  EXPECT_EQ(codec.Decompress(data.data(), data.size()), nullptr);
+}
+
+TEST(FrameCodecTest, ShareDecompressedFrame) {
+  FrameCodec codec;
+  MessageBuffer compressed = codec.Compress(NewMessageBuffer(GetBatch(0, 50)));
+  ASSERT_NE(compressed, nullptr);
+
+  std::unique_ptr<DataInfo> frame =
+      codec.Decompress(compressed->data(), compressed->size());
+  ASSERT_NE(frame, nullptr);
+  ASSERT_NE(frame->holder, nullptr);
+
+  // A sub message sliced from the frame outlives it.
+  auto sub_message = std::make_unique<DataInfo>();
+  sub_message->buff = static_cast<char*>(frame->buff) + 1;
+  sub_message->data_len = frame->data_len - 1;
+  sub_message->holder = frame->holder;
+  std::string expected = GetData(frame).substr(1);
+  frame = nullptr;
+  EXPECT_EQ(GetData(sub_message), expected);
+}
+
+TEST(FrameCodecTest, SkipSmallFrames) {
+  FrameCodec codec("", 1024);
+  EXPECT_EQ(codec.Compress(NewMessageBuffer(std::string(1000, 'a'))),
+            nullptr);
+  EXPECT_NE(codec.Compress(NewMessageBuffer(std::string(1024, 'a'))),
+            nullptr);
+}
+
+TEST(FrameCodecTest, SkipIncompressibleFrames) {
+  FrameCodec codec;
+  std::string data(4096, 0);
+  uint32_t seed = 1;
+  for (auto& c : data) {
+    seed = seed * 1103515245 + 12345;
+    c = seed >> 24;
+  }
+  EXPECT_EQ(codec.Compress(NewMessageBuffer(data)), nullptr);
+}
+
+TEST(FrameCodecTest, CompressOnceForAllConnections) {
+  FrameCodec codec;
+  MessageBuffer data = NewMessageBuffer(GetBatch(0, 1000));
+  std::vector<MessageBuffer> results(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.push_back(
+        std::thread([&, i]() { results[i] = codec.Compress(data); }));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  ASSERT_NE(results[0], nullptr);
+  for (const auto& result : results) {
+    EXPECT_EQ(result.get(), results[0].get());
+  }
+
+  // The result of a released frame is not reused.
+  data = nullptr;
+  MessageBuffer data2 = NewMessageBuffer(GetBatch(1, 1000));
+  MessageBuffer result = codec.Compress(data2);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(GetData(codec.Decompress(result->data(), result->size())),
+            *data2);
+}
+
+TEST(FrameCodecTest, AcceptHelloWithSameDictionary) {
+  FrameCodec codec("dictionary"), same_codec("dictionary"),
+      other_codec("other dictionary"), no_dictionary_codec;
+  std::string hello = codec.GetHello();
+  EXPECT_TRUE(same_codec.AcceptHello(hello.data(), hello.size()));
+  EXPECT_FALSE(other_codec.AcceptHello(hello.data(), hello.size()));
+  EXPECT_FALSE(no_dictionary_codec.AcceptHello(hello.data(), hello.size()));
+  EXPECT_FALSE(same_codec.AcceptHello(hello.data(), hello.size() - 1));
+}
+
+TEST(FrameCodecTest, TrainedDictionaryShrinksSmallFrames) {
+  std::vector<std::string> samples;
+  for (int i = 0; i < 100; ++i) {
+    samples.push_back(GetBatch(i * 10, 10));
+  }
+  std::string dictionary = TrainDictionary(samples, 4096);
+  EXPECT_FALSE(dictionary.empty());
+  EXPECT_LE(dictionary.size(), 4096);
+
+  FrameCodec codec, trained_codec(dictionary);
+  MessageBuffer data = NewMessageBuffer(GetBatch(5000, 10));
+  MessageBuffer compressed = codec.Compress(data);
+  MessageBuffer trained_compressed = trained_codec.Compress(data);
+  ASSERT_NE(compressed, nullptr);
+  ASSERT_NE(trained_compressed, nullptr);
+  EXPECT_LT(trained_compressed->size(), compressed->size());
+  EXPECT_EQ(GetData(trained_codec.Decompress(trained_compressed->data(),
+                                             trained_compressed->size())),
+            *data);
+}
+
+}  // namespace
+}  // namespace resdb
@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/in_process_transport.h"
+
+#include <glog/logging.h>
+
+namespace resdb {
+
+namespace {
+
+std::string GetAddress(const std::string& ip, int port) {
+  return ip + ":" + std::to_string(port);
+}
+
+}  // namespace
+
+class InProcessTransport::Client : public TransportClient {
+ public:
+  Client(InProcessTransport* transport, std::string address)
+      : transport_(transport), address_(std::move(address)) {}
+
+  int SendMessage(MessageBuffer data, SendLane lane) override {
+    if (data == nullptr || data->empty()) {
+      return -1;
+    }
+    // The listener may have been restarted since the last frame, look it up
+    // again once.
+    for (int i = 0; i < 2; ++i) {
+      std::shared_ptr<Endpoint> endpoint;
+      {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (endpoint_ == nullptr || i > 0) {
+          endpoint_ = transport_->GetEndpoint(address_);
+        }
+        endpoint = endpoint_;
+      }
+      if (endpoint == nullptr) {
+        break;
+      }
+      std::shared_lock<std::shared_mutex> lk(endpoint->mutex);
+      if (endpoint->stopped) {
+        continue;
+      }
+      auto frame = std::make_unique<DataInfo>();
+      frame->buff = const_cast<char*>(data->data());
+      frame->data_len = data->size();
+      frame->holder = std::const_pointer_cast<std::string>(data);
+      endpoint->call_back_func(std::move(frame));
+      return 0;
+    }
+    LOG(ERROR) << "no listener on:" << address_;
+    return -1;
+  }
+
+  // The frames are delivered before SendMessage returns.
+  size_t GetQueueDepth(SendLane lane) const override { return 0; }
+
+ private:
+  InProcessTransport* transport_;
+  std::string address_;
+  std::mutex mutex_;
+  std::shared_ptr<Endpoint> endpoint_;
+};
+
+class InProcessTransport::Listener : public TransportListener {
+ public:
+  Listener(InProcessTransport* transport, std::string address,
+           std::shared_ptr<Endpoint> endpoint)
+      : transport_(transport),
+        address_(std::move(address)),
+        endpoint_(std::move(endpoint)) {}
+
+  ~Listener() override { Stop(); }
+
+  void Stop() override {
+    {
+      std::unique_lock<std::shared_mutex> lk(endpoint_->mutex);
+      if (endpoint_->stopped) {
+        return;
+      }
+      endpoint_->stopped = true;
+    }
+    transport_->RemoveEndpoint(address_, endpoint_.get());
+  }
+
+ private:
+  InProcessTransport* transport_;
+  std::string address_;
+  std::shared_ptr<Endpoint> endpoint_;
+};
+
+std::unique_ptr<TransportClient> InProcessTransport::CreateClient(
+    const std::string& ip, int port) {
+  return std::make_unique<Client>(this, GetAddress(ip, port));
+}
+
+std::unique_ptr<TransportListener> InProcessTransport::Listen(
+    const std::string& ip, int port, RecvCallBack call_back_func) {
+  std::string address = GetAddress(ip, port);
+  auto endpoint = std::make_shared<Endpoint>();
+  endpoint->call_back_func = std::move(call_back_func);
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (endpoints_.find(address) != endpoints_.end()) {
+      LOG(ERROR) << "address has been listened on:" << address;
+      return nullptr;
+    }
+    endpoints_[address] = endpoint;
+  }
+  return std::make_unique<Listener>(this, address, std::move(endpoint));
+}
+
+std::shared_ptr<InProcessTransport::Endpoint> InProcessTransport::GetEndpoint(
+    const std::string& address) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = endpoints_.find(address);
+  return it == endpoints_.end() ? nullptr : it->second;
+}
+
+void InProcessTransport::RemoveEndpoint(const std::string& address,
+                                        Endpoint* endpoint) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = endpoints_.find(address);
+  if (it != endpoints_.end() && it->second.get() == endpoint) {
+    endpoints_.erase(it);
+  }
+}
+
+}  // namespace resdb
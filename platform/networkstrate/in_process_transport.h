@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+
+#include "platform/networkstrate/transport.h"
+
+namespace resdb {
+
+// InProcessTransport links the replicas running in the same process, like
+// a whole cluster in a benchmark. A frame is handed to the listener on the
+// thread sending it, the listener shares the buffer of the sender instead
+// of copying it. Each lane keeps its order as long as it is sent by one
+// thread.
+class InProcessTransport : public Transport {
+ public:
+  InProcessTransport() = default;
+  ~InProcessTransport() override = default;
+
+  // The clients send to the listener of the address at the time of sending,
+  // SendMessage returns -1 if there is none.
+  std::unique_ptr<TransportClient> CreateClient(const std::string& ip,
+                                                int port) override;
+  // Returns nullptr if the address has been listened on.
+  std::unique_ptr<TransportListener> Listen(
+      const std::string& ip, int port, RecvCallBack call_back_func) override;
+
+ private:
+  class Client;
+  class Listener;
+
+  struct Endpoint {
+    // Held shared while delivering so that the listener does not stop in
+    // the middle of it.
+    std::shared_mutex mutex;
+    RecvCallBack call_back_func;
+    bool stopped = false;
+  };
+
+  std::shared_ptr<Endpoint> GetEndpoint(const std::string& address);
+  void RemoveEndpoint(const std::string& address, Endpoint* endpoint);
+
+ private:
+  std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<Endpoint>> endpoints_;
+};
+
+}  // namespace resdb
@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/in_process_transport.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace resdb {
+namespace {
+
+class InProcessTransportTest : public ::testing::Test {
+ protected:
+  Transport::RecvCallBack GetCallBack(std::vector<std::string>* received) {
+    return [received](std::unique_ptr<DataInfo> frame) {
+      received->push_back(
+          std::string(static_cast<char*>(frame->buff), frame->data_len));
+    };
+  }
+
+ protected:
+  InProcessTransport transport_;
+};
+
+TEST_F(InProcessTransportTest, SendToListener) {
+  std::vector<std::string> received;
+  auto listener =
+      transport_.Listen("127.0.0.1", 1234, GetCallBack(&received));
+  ASSERT_NE(listener, nullptr);
+
+  auto client = transport_.CreateClient("127.0.0.1", 1234);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("vote"), SendLane::kControl),
+            0);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("batch")), 0);
+  EXPECT_EQ(client->GetQueueDepth(SendLane::kBulk), 0);
+  EXPECT_EQ(received, std::vector<std::string>({"vote", "batch"}));
+}
+
+TEST_F(InProcessTransportTest, ShareBufferWithListener) {
+  const void* buff = nullptr;
+  std::shared_ptr<void> holder;
+  auto listener = transport_.Listen(
+      "127.0.0.1", 1234, [&](std::unique_ptr<DataInfo> frame) {
+        buff = frame->buff;
+        holder = frame->holder;
+      });
+  ASSERT_NE(listener, nullptr);
+
+  MessageBuffer data = NewMessageBuffer(std::string(1024, 'd'));
+  EXPECT_EQ(transport_.CreateClient("127.0.0.1", 1234)->SendMessage(data), 0);
+  EXPECT_EQ(buff, data->data());
+  EXPECT_EQ(holder.get(), data.get());
+}
+
+TEST_F(InProcessTransportTest, SendWithoutListener) {
+  auto client = transport_.CreateClient("127.0.0.1", 1234);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("data")), -1);
+
+  std::vector<std::string> received;
+  auto listener =
+      transport_.Listen("127.0.0.1", 1234, GetCallBack(&received));
+  ASSERT_NE(listener, nullptr);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("data")), 0);
+
+  listener->Stop();
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("data")), -1);
+  EXPECT_EQ(received.size(), 1);
+}
+
+TEST_F(InProcessTransportTest, ListenAgain) {
+  std::vector<std::string> received1, received2;
+  auto listener1 =
+      transport_.Listen("127.0.0.1", 1234, GetCallBack(&received1));
+  ASSERT_NE(listener1, nullptr);
+  EXPECT_EQ(transport_.Listen("127.0.0.1", 1234, GetCallBack(&received2)),
+            nullptr);
+
+  auto client = transport_.CreateClient("127.0.0.1", 1234);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("first")), 0);
+
+  // The client follows the listener restarted on the address.
+  listener1 = nullptr;
+  auto listener2 =
+      transport_.Listen("127.0.0.1", 1234, GetCallBack(&received2));
+  ASSERT_NE(listener2, nullptr);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("second")), 0);
+
+  EXPECT_EQ(received1, std::vector<std::string>({"first"}));
+  EXPECT_EQ(received2, std::vector<std::string>({"second"}));
+}
+
+TEST_F(InProcessTransportTest, StopWhileSending) {
+  std::atomic<int> received = 0;
+  auto listener = transport_.Listen(
+      "127.0.0.1", 1234,
+      [&](std::unique_ptr<DataInfo> frame) { received++; });
+  ASSERT_NE(listener, nullptr);
+
+  std::atomic<bool> stopped = false;
+  std::atomic<int> sent = 0;
+  std::thread sender([&]() {
+    auto client = transport_.CreateClient("127.0.0.1", 1234);
+    while (client->SendMessage(NewMessageBuffer("data")) == 0) {
+      sent++;
+      std::this_thread::yield();
+    }
+    stopped = true;
+  });
+  while (sent < 100) {
+    std::this_thread::yield();
+  }
+  listener = nullptr;
+  sender.join();
+  EXPECT_TRUE(stopped);
+  EXPECT_EQ(received, sent);
+}
+
+}  // namespace
+}  // namespace resdb
@@ -30,6 +30,7 @@ class MockAsyncReplicaClient : public AsyncReplicaClient {
   MockAsyncReplicaClient(boost::asio::io_service *io_service)
       : AsyncReplicaClient(io_service, "127.0.0.1", 0) {}
   MOCK_METHOD(int, SendMessage, (const std::string &), (override));
+  MOCK_METHOD(int, SendMessage, (MessageBuffer, SendLane), (override));
 };
 
 }  // namespace resdb
@@ -21,27 +21,52 @@
 
 #include <glog/logging.h>
 
+#include <chrono>
 #include <thread>
 
 #include "platform/proto/broadcast.pb.h"
 
 namespace resdb {
 
+namespace {
+
+// The batch queues of the control lane wait for a short time only to fill a
+// batch, the votes should not be held back.
+constexpr int kControlPopTimeoutUs = 1000;
+constexpr int kBroadcastPopTimeoutUs = 10000;
+constexpr int kSinglePopTimeoutUs = 50000;
+// The queue depths are reported to the stats at most once per interval.
+constexpr uint64_t kReportIntervalUs = 100000;
+
+uint64_t GetTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
 ReplicaCommunicator::ReplicaCommunicator(
     const std::vector<ReplicaInfo>& replicas, SignatureVerifier* verifier,
-    bool is_use_long_conn, int epoll_num, int tcp_batch)
+    bool is_use_long_conn, int epoll_num, int tcp_batch,
+    size_t max_write_bytes, std::shared_ptr<FrameCodec> codec,
+    size_t shm_ring_bytes, std::shared_ptr<Transport> transport)
     : replicas_(replicas),
       verifier_(verifier),
       is_running_(false),
+      control_batch_queue_("bc_control", tcp_batch),
       batch_queue_("bc_batch", tcp_batch),
-      is_use_long_conn_(is_use_long_conn),
+      last_report_time_(0),
+      is_use_long_conn_(is_use_long_conn || transport != nullptr),
+      transport_(std::move(transport)),
       tcp_batch_(tcp_batch) {
   global_stats_ = Stats::GetGlobalStats();
-  if (is_use_long_conn_) {
-    worker_ = std::make_unique<boost::asio::io_service::work>(io_service_);
-    for (int i = 0; i < epoll_num; ++i) {
-      worker_threads_.push_back(std::thread([&]() { io_service_.run(); }));
-    }
+  for (auto& num : queued_num_) {
+    num = 0;
+  }
+  if (is_use_long_conn_ && transport_ == nullptr) {
+    transport_ = std::make_shared<TcpTransport>(
+        epoll_num, max_write_bytes, std::move(codec), shm_ring_bytes);
   }
   LOG(ERROR) << " tcp batch:" << tcp_batch;
 
@@ -50,22 +75,18 @@ ReplicaCommunicator::ReplicaCommunicator(
 
 ReplicaCommunicator::~ReplicaCommunicator() {
   is_running_ = false;
-  if (broadcast_thread_.joinable()) {
-    broadcast_thread_.join();
-  }
-  if (is_use_long_conn_) {
-    for (auto& cli : client_pools_) {
-      cli.second.reset();
+  for (auto& th : broadcast_threads_) {
+    if (th.joinable()) {
+      th.join();
     }
-    worker_.reset();
-    worker_ = nullptr;
-    io_service_.stop();
-    for (auto& worker_th : worker_threads_) {
-      if (worker_th.joinable()) {
-        worker_th.join();
-      }
+  }
+  for (auto& th : single_thread_) {
+    if (th.joinable()) {
+      th.join();
     }
   }
+  client_pools_.clear();
+  transport_ = nullptr;
 }
 
 bool ReplicaCommunicator::IsInPool(const ReplicaInfo& replica_info) {
@@ -90,6 +111,11 @@ std::vector<ReplicaInfo> ReplicaCommunicator::GetClientReplicas() {
 }
 
 int ReplicaCommunicator::SendHeartBeat(const Request& hb_info) {
+  if (is_use_long_conn_) {
+    BroadcastData broadcast_data;
+    broadcast_data.add_data(NetChannel::GetRawMessageString(hb_info, nullptr));
+    return SendMessageFromPool(broadcast_data, replicas_, SendLane::kControl);
+  }
   int ret = 0;
   for (const auto& replica : replicas_) {
     NetChannel client(replica.ip(), replica.port());
@@ -100,32 +126,82 @@ int ReplicaCommunicator::SendHeartBeat(const Request& hb_info) {
   return ret;
 }
 
+SendLane ReplicaCommunicator::GetLane(
+    const google::protobuf::Message& message) {
+  const Request* request = dynamic_cast<const Request*>(&message);
+  if (request == nullptr) {
+    return SendLane::kBulk;
+  }
+  switch (request->type()) {
+    case Request::TYPE_HEART_BEAT:
+    case Request::TYPE_PREPARE:
+    case Request::TYPE_COMMIT:
+    case Request::TYPE_CHECKPOINT:
+    case Request::TYPE_VIEWCHANGE:
+    case Request::TYPE_NEWVIEW:
+    case Request::TYPE_STATUS_SYNC:
+    case Request::TYPE_PREPARED_DATA_FETCH:
+    case Request::TYPE_MEMPOOL_ACK:
+    case Request::TYPE_MEMPOOL_FETCH:
+      return SendLane::kControl;
+    default:
+      return SendLane::kBulk;
+  }
+}
+
+size_t ReplicaCommunicator::GetQueueDepth(SendLane lane) {
+  size_t depth = queued_num_[static_cast<int>(lane)];
+  std::lock_guard<std::mutex> lk(mutex_);
+  for (const auto& client : client_pools_) {
+    depth += client.second->GetQueueDepth(lane);
+  }
+  return depth;
+}
+
+void ReplicaCommunicator::ReportQueueDepth() {
+  uint64_t now = GetTimeUs();
+  uint64_t last_time = last_report_time_;
+  if (now - last_time < kReportIntervalUs ||
+      !last_report_time_.compare_exchange_strong(last_time, now)) {
+    return;
+  }
+  global_stats_->SetSendQueueDepth(GetQueueDepth(SendLane::kControl),
+                                   GetQueueDepth(SendLane::kBulk));
+}
+
 void ReplicaCommunicator::StartBroadcastInBackGround() {
   is_running_ = true;
-  broadcast_thread_ = std::thread([&]() {
-    while (IsRunning()) {
-      std::vector<std::unique_ptr<QueueItem>> batch_req =
-          batch_queue_.Pop(10000);
-      if (batch_req.empty()) {
-        continue;
-      }
-      BroadcastData broadcast_data;
-      for (auto& queue_item : batch_req) {
-        broadcast_data.add_data()->swap(queue_item->data);
-      }
+  for (SendLane lane : {SendLane::kControl, SendLane::kBulk}) {
+    broadcast_threads_.push_back(std::thread([this, lane]() {
+      BatchQueue<std::unique_ptr<QueueItem>>& bq =
+          lane == SendLane::kControl ? control_batch_queue_ : batch_queue_;
+      int timeout = lane == SendLane::kControl ? kControlPopTimeoutUs
+                                               : kBroadcastPopTimeoutUs;
+      while (IsRunning()) {
+        std::vector<std::unique_ptr<QueueItem>> batch_req = bq.Pop(timeout);
+        if (batch_req.empty()) {
+          continue;
+        }
+        queued_num_[static_cast<int>(lane)] -= batch_req.size();
+        BroadcastData broadcast_data;
+        for (auto& queue_item : batch_req) {
+          broadcast_data.add_data()->swap(queue_item->data);
+        }
 
-      global_stats_->SendBroadCastMsg(broadcast_data.data_size());
-      int ret = SendMessageFromPool(broadcast_data, replicas_);
-      if (ret < 0) {
-        LOG(ERROR) << "broadcast request fail:";
+        global_stats_->SendBroadCastMsg(broadcast_data.data_size());
+        int ret = SendMessageFromPool(broadcast_data, replicas_, lane);
+        if (ret < 0) {
+          LOG(ERROR) << "broadcast request fail:";
+        }
+        ReportQueueDepth();
       }
-    }
-  });
+    }));
+  }
 }
 
 void ReplicaCommunicator::StartSingleInBackGround(const std::string& ip,
-                                                  int port) {
-  single_bq_[std::make_pair(ip, port)] =
+                                                  int port, SendLane lane) {
+  single_bq_[std::make_tuple(ip, port, lane)] =
       std::make_unique<BatchQueue<std::unique_ptr<QueueItem>>>("s_batch",
                                                                tcp_batch_);
 
@@ -147,29 +223,30 @@ void ReplicaCommunicator::StartSingleInBackGround(const std::string& ip,
   }
 
   single_thread_.push_back(std::thread(
-      [&](BatchQueue<std::unique_ptr<QueueItem>>* bq,
-          ReplicaInfo replica_info) {
+      [&](BatchQueue<std::unique_ptr<QueueItem>>* bq, ReplicaInfo replica_info,
+          SendLane lane) {
+        int timeout = lane == SendLane::kControl ? kControlPopTimeoutUs
+                                                 : kSinglePopTimeoutUs;
         while (IsRunning()) {
-          std::vector<std::unique_ptr<QueueItem>> batch_req = bq->Pop(50000);
+          std::vector<std::unique_ptr<QueueItem>> batch_req = bq->Pop(timeout);
           if (batch_req.empty()) {
             continue;
           }
+          queued_num_[static_cast<int>(lane)] -= batch_req.size();
           BroadcastData broadcast_data;
           for (auto& queue_item : batch_req) {
             broadcast_data.add_data()->swap(queue_item->data);
           }
 
           global_stats_->SendBroadCastMsg(broadcast_data.data_size());
-          // LOG(ERROR)<<" send to ip:"<<replica_info.ip()<<"
-          // port:"<<replica_info.port()<<" bq size:"<<batch_req.size();
-          int ret = SendMessageFromPool(broadcast_data, {replica_info});
+          int ret = SendMessageFromPool(broadcast_data, {replica_info}, lane);
           if (ret < 0) {
             LOG(ERROR) << "broadcast request fail:";
           }
-          // LOG(ERROR)<<" send to ip:"<<replica_info.ip()<<"
+          ReportQueueDepth();
         }
       },
-      single_bq_[std::make_pair(ip, port)].get(), replica_info));
+      single_bq_[std::make_tuple(ip, port, lane)].get(), replica_info, lane));
 }
 
 int ReplicaCommunicator::SendSingleMessage(
@@ -180,14 +257,17 @@ int ReplicaCommunicator::SendSingleMessage(
   // LOG(ERROR)<<" send msg ip:"<<ip<<" port:"<<port;
   global_stats_->BroadCastMsg();
   if (is_use_long_conn_) {
+    SendLane lane = GetLane(message);
     auto item = std::make_unique<QueueItem>();
     item->data = NetChannel::GetRawMessageString(message, verifier_);
     std::lock_guard<std::mutex> lk(smutex_);
-    if (single_bq_.find(std::make_pair(ip, port)) == single_bq_.end()) {
-      StartSingleInBackGround(ip, port);
+    auto key = std::make_tuple(ip, port, lane);
+    if (single_bq_.find(key) == single_bq_.end()) {
+      StartSingleInBackGround(ip, port, lane);
     }
-    assert(single_bq_[std::make_pair(ip, port)] != nullptr);
-    single_bq_[std::make_pair(ip, port)]->Push(std::move(item));
+    assert(single_bq_[key] != nullptr);
+    queued_num_[static_cast<int>(lane)]++;
+    single_bq_[key]->Push(std::move(item));
     return 0;
   } else {
     return SendMessageInternal(message, replicas_);
@@ -197,9 +277,15 @@ int ReplicaCommunicator::SendSingleMessage(
 int ReplicaCommunicator::SendMessage(const google::protobuf::Message& message) {
   global_stats_->BroadCastMsg();
   if (is_use_long_conn_) {
+    SendLane lane = GetLane(message);
     auto item = std::make_unique<QueueItem>();
     item->data = NetChannel::GetRawMessageString(message, verifier_);
-    batch_queue_.Push(std::move(item));
+    queued_num_[static_cast<int>(lane)]++;
+    if (lane == SendLane::kControl) {
+      control_batch_queue_.Push(std::move(item));
+    } else {
+      batch_queue_.Push(std::move(item));
+    }
     return 0;
   } else {
     return SendMessageInternal(message, replicas_);
@@ -241,24 +327,32 @@ int ReplicaCommunicator::SendBatchMessage(
 
 int ReplicaCommunicator::SendMessageFromPool(
     const google::protobuf::Message& message,
-    const std::vector<ReplicaInfo>& replicas) {
-  int ret = 0;
-  std::string data;
-  message.SerializeToString(&data);
+    const std::vector<ReplicaInfo>& replicas, SendLane lane) {
+  // The message is serialized once and shared by the clients of all the
+  // replicas.
+  MessageBuffer data = NewMessageBuffer(message);
   global_stats_->SendBroadCastMsgPerRep();
-  std::lock_guard<std::mutex> lk(mutex_);
-  for (const auto& replica : replicas) {
-    auto client = GetClientFromPool(replica.ip(), replica.port());
-    if (client == nullptr) {
-      continue;
+  std::vector<std::pair<TransportClient*, const ReplicaInfo*>> clients;
+  {
+    // The clients are never removed from the pool before destruction, only
+    // the lookup needs the lock.
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (const auto& replica : replicas) {
+      auto client = GetClientFromPool(replica.ip(), replica.port());
+      if (client == nullptr) {
+        continue;
+      }
+      clients.push_back(std::make_pair(client, &replica));
     }
-    // LOG(ERROR) << "send to:" << replica.ip();
-    if (client->SendMessage(data) == 0) {
+  }
+
+  int ret = 0;
+  for (const auto& [client, replica] : clients) {
+    if (client->SendMessage(data, lane) == 0) {
       ret++;
     } else {
-      LOG(ERROR) << "send to:" << replica.ip() << " fail";
+      LOG(ERROR) << "send to:" << replica->ip() << " fail";
     }
-    // LOG(ERROR) << "send to:" << replica.ip()<<" done";
   }
   return ret;
 }
@@ -282,13 +376,11 @@ int ReplicaCommunicator::SendMessageInternal(
   return ret;
 }
 
-AsyncReplicaClient* ReplicaCommunicator::GetClientFromPool(
-    const std::string& ip, int port) {
+TransportClient* ReplicaCommunicator::GetClientFromPool(const std::string& ip,
+                                                        int port) {
   if (client_pools_.find(std::make_pair(ip, port)) == client_pools_.end()) {
-    auto client = std::make_unique<AsyncReplicaClient>(
-        &io_service_, ip, port + (is_use_long_conn_ ? 10000 : 0), true);
-    client_pools_[std::make_pair(ip, port)] = std::move(client);
-    // StartSingleInBackGround(ip, port);
+    client_pools_[std::make_pair(ip, port)] =
+        transport_->CreateClient(ip, port + 10000);
   }
   return client_pools_[std::make_pair(ip, port)].get();
 }
@@ -19,11 +19,13 @@
 
 #pragma once
 #include <thread>
+#include <tuple>
 
 #include "interface/rdbc/net_channel.h"
 #include "platform/common/queue/batch_queue.h"
 #include "platform/common/queue/lock_free_queue.h"
 #include "platform/networkstrate/async_replica_client.h"
+#include "platform/networkstrate/tcp_transport.h"
 #include "platform/proto/replica_info.pb.h"
 #include "platform/proto/resdb.pb.h"
 #include "platform/statistic/stats.h"
@@ -31,17 +33,23 @@
 namespace resdb {
 
 // ReplicaCommunicator is used for replicas to send messages
-// between replicas.
+// between replicas. The long connections are created by the transport, a
+// TcpTransport if it is not set. Setting a transport implies the long
+// connections.
 class ReplicaCommunicator {
  public:
   ReplicaCommunicator(const std::vector<ReplicaInfo>& replicas,
                       SignatureVerifier* verifier = nullptr,
                       bool is_use_long_conn = false, int epoll_num = 1,
-                      int tcp_batch = 1);
+                      int tcp_batch = 1, size_t max_write_bytes = 0,
+                      std::shared_ptr<FrameCodec> codec = nullptr,
+                      size_t shm_ring_bytes = 0,
+                      std::shared_ptr<Transport> transport = nullptr);
   virtual ~ReplicaCommunicator();
 
   // HeartBeat message is used to broadcast public keys.
-  // It doesn't need the signature.
+  // It doesn't need the signature. It is sent through the long connections
+  // if they are used.
   virtual int SendHeartBeat(const Request& hb_info);
 
   virtual int SendMessage(const google::protobuf::Message& message);
@@ -58,22 +66,31 @@ class ReplicaCommunicator {
   void UpdateClientReplicas(const std::vector<ReplicaInfo>& replicas);
   std::vector<ReplicaInfo> GetClientReplicas();
 
+  // Votes and the other protocol control messages are sent in the control
+  // lane ahead of the client requests and the batch payloads.
+  static SendLane GetLane(const google::protobuf::Message& message);
+  // The number of messages of the lane not written to the sockets yet.
+  size_t GetQueueDepth(SendLane lane);
+
  protected:
   virtual std::unique_ptr<NetChannel> GetClient(const std::string& ip,
                                                 int port);
-  virtual AsyncReplicaClient* GetClientFromPool(const std::string& ip,
-                                                int port);
+  virtual TransportClient* GetClientFromPool(const std::string& ip,
+                                             int port);
 
   void StartBroadcastInBackGround();
   int SendMessageInternal(const google::protobuf::Message& message,
                           const std::vector<ReplicaInfo>& replicas);
   int SendMessageFromPool(const google::protobuf::Message& message,
-                          const std::vector<ReplicaInfo>& replicas);
+                          const std::vector<ReplicaInfo>& replicas,
+                          SendLane lane = SendLane::kBulk);
 
   bool IsRunning() const;
   bool IsInPool(const ReplicaInfo& replica_info);
 
-  void StartSingleInBackGround(const std::string& ip, int port);
+  void StartSingleInBackGround(const std::string& ip, int port,
+                               SendLane lane);
+  void ReportQueueDepth();
 
   int SendSingleMessage(const google::protobuf::Message& message,
                         const ReplicaInfo& replica_info);
@@ -81,25 +98,27 @@ class ReplicaCommunicator {
  private:
   std::vector<ReplicaInfo> replicas_;
   SignatureVerifier* verifier_;
-  std::map<std::pair<std::string, int>, std::unique_ptr<AsyncReplicaClient>>
+  std::map<std::pair<std::string, int>, std::unique_ptr<TransportClient>>
       client_pools_;
-  std::thread broadcast_thread_;
+  std::vector<std::thread> broadcast_threads_;
   std::atomic<bool> is_running_;
   struct QueueItem {
     std::string data;
     std::vector<ReplicaInfo> dest_replicas;
   };
-  BatchQueue<std::unique_ptr<QueueItem>> batch_queue_;
+  BatchQueue<std::unique_ptr<QueueItem>> control_batch_queue_, batch_queue_;
+  // The messages of each lane in the batch queues.
+  std::atomic<size_t> queued_num_[kSendLaneNum];
+  std::atomic<uint64_t> last_report_time_;
   bool is_use_long_conn_ = false;
+  // Outlives the clients in the pool.
+  std::shared_ptr<Transport> transport_;
 
   Stats* global_stats_;
-  boost::asio::io_service io_service_;
-  std::unique_ptr<boost::asio::io_service::work> worker_;
-  std::vector<std::thread> worker_threads_;
   std::vector<ReplicaInfo> clients_;
   std::mutex mutex_;
 
-  std::map<std::pair<std::string, int>,
+  std::map<std::tuple<std::string, int, SendLane>,
            std::unique_ptr<BatchQueue<std::unique_ptr<QueueItem>>>>
       single_bq_;
   std::vector<std::thread> single_thread_;
@@ -26,10 +26,12 @@
 #include "interface/rdbc/mock_net_channel.h"
 #include "platform/common/network/mock_socket.h"
 #include "platform/networkstrate/mock_async_replica_client.h"
+#include "platform/proto/broadcast.pb.h"
 
 namespace resdb {
 namespace {
 
+using ::testing::_;
 using ::testing::Invoke;
 using ::testing::Return;
 
@@ -134,6 +136,83 @@ TEST(ReplicaCommunicatorTest, Lonnconnection) {
   bc_done.get();
 }
 
+TEST(ReplicaCommunicatorTest, BroadcastSharesBuffer) {
+  std::promise<bool> bc;
+  std::future<bool> bc_done = bc.get_future();
+  std::vector<ReplicaInfo> replicas;
+  replicas.push_back(GenerateReplicaInfo("127.0.0.1", 1234));
+  replicas.push_back(GenerateReplicaInfo("127.0.0.1", 1235));
+
+  boost::asio::io_service io_service;
+  MockAsyncReplicaClient client1(&io_service), client2(&io_service);
+  MockReplicaCommunicator client(replicas, true);
+  EXPECT_CALL(client, GetClientFromPool("127.0.0.1", 1234))
+      .WillOnce(Return(&client1));
+  EXPECT_CALL(client, GetClientFromPool("127.0.0.1", 1235))
+      .WillOnce(Return(&client2));
+
+  MessageBuffer data1;
+  EXPECT_CALL(client1, SendMessage(_, _))
+      .WillOnce(Invoke([&](MessageBuffer data, SendLane lane) {
+        data1 = data;
+        return 0;
+      }));
+  EXPECT_CALL(client2, SendMessage(_, _))
+      .WillOnce(Invoke([&](MessageBuffer data, SendLane lane) {
+        EXPECT_EQ(data, data1);
+        bc.set_value(true);
+        return 0;
+      }));
+
+  Request expected_request;
+  expected_request.set_type(Request::TYPE_HEART_BEAT);
+  EXPECT_EQ(client.SendMessage(expected_request), 0);
+  bc_done.get();
+}
+
+TEST(ReplicaCommunicatorTest, SendInLanes) {
+  std::promise<bool> bc;
+  std::future<bool> bc_done = bc.get_future();
+  std::vector<ReplicaInfo> replicas;
+  replicas.push_back(GenerateReplicaInfo("127.0.0.1", 1234));
+
+  boost::asio::io_service io_service;
+  MockAsyncReplicaClient client1(&io_service);
+  MockReplicaCommunicator client(replicas, true);
+  EXPECT_CALL(client, GetClientFromPool("127.0.0.1", 1234))
+      .WillRepeatedly(Return(&client1));
+
+  std::atomic<int> send_num = 0;
+  EXPECT_CALL(client1, SendMessage(_, _))
+      .WillRepeatedly(Invoke([&](MessageBuffer data, SendLane lane) {
+        BroadcastData broadcast_data;
+        EXPECT_TRUE(broadcast_data.ParseFromString(*data));
+        for (const auto& message_data : broadcast_data.data()) {
+          ResDBMessage message;
+          Request request;
+          EXPECT_TRUE(message.ParseFromString(message_data));
+          EXPECT_TRUE(request.ParseFromString(message.data()));
+          EXPECT_EQ(lane, ReplicaCommunicator::GetLane(request));
+          EXPECT_EQ(lane, request.type() == Request::TYPE_PRE_PREPARE
+                              ? SendLane::kBulk
+                              : SendLane::kControl);
+          if (++send_num == 3) {
+            bc.set_value(true);
+          }
+        }
+        return 0;
+      }));
+
+  Request request;
+  request.set_type(Request::TYPE_PRE_PREPARE);
+  EXPECT_EQ(client.SendMessage(request), 0);
+  request.set_type(Request::TYPE_PREPARE);
+  EXPECT_EQ(client.SendMessage(request), 0);
+  request.set_type(Request::TYPE_COMMIT);
+  EXPECT_EQ(client.SendMessage(request), 0);
+  bc_done.get();
+}
+
 }  // namespace
 
 }  // namespace resdb
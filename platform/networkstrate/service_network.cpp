@@ -24,6 +24,7 @@
 
 #include <thread>
 
+#include "platform/common/data_comm/wire_format.h"
 #include "platform/common/network/tcp_socket.h"
 #include "platform/proto/broadcast.pb.h"
 
@@ -45,29 +46,50 @@ ServiceNetwork::ServiceNetwork(const ResDBConfig& config,
 
   acceptor_ = std::make_unique<Acceptor>(config, &input_queue_);
 
-  async_acceptor_ = std::make_unique<AsyncAcceptor>(
-      config.GetSelfInfo().ip(), config_.GetSelfInfo().port() + 10000,
-      config.GetInputWorkerNum(),
-      std::bind(&ServiceNetwork::AcceptorHandler, this, std::placeholders::_1,
-                std::placeholders::_2));
-  async_acceptor_->StartAccept();
   global_stats_ = Stats::GetGlobalStats();
+
+  transport_ = config_.GetTransport();
+  if (transport_ == nullptr) {
+    transport_ = std::make_shared<TcpTransport>(
+        config_.GetInputWorkerNum(), 0,
+        FrameCodec::Create(config_.GetConfigData()),
+        GetShmRingBytes(config_.GetConfigData()));
+  }
+  listener_ = transport_->Listen(
+      config_.GetSelfInfo().ip(), config_.GetSelfInfo().port() + 10000,
+      [&](std::unique_ptr<DataInfo> frame) {
+        AcceptorHandler(std::move(frame));
+      });
+  if (listener_ == nullptr) {
+    LOG(ERROR) << "listen fail:" << config_.GetSelfInfo().ip()
+               << " port:" << config_.GetSelfInfo().port() + 10000;
+  }
 }
 
 ServiceNetwork::~ServiceNetwork() {}
 
-void ServiceNetwork::AcceptorHandler(const char* buffer, size_t data_len) {
-  BroadcastData data;
-  if (!data.ParseFromArray(buffer, data_len)) {
-    LOG(ERROR) << "parse broad cast fail:" << data_len;
+// The sub messages of the BroadcastData are passed on in place, they share
+// the receive slab of the frame.
+void ServiceNetwork::AcceptorHandler(std::unique_ptr<DataInfo> frame) {
+  std::vector<std::string_view> sub_data_list;
+  bool ret = ForEachBytesField(
+      static_cast<const char*>(frame->buff), frame->data_len,
+      [&](int field_number, std::string_view value) {
+        if (field_number == BroadcastData::kDataFieldNumber) {
+          sub_data_list.push_back(value);
+        }
+        return true;
+      });
+  if (!ret) {
+    LOG(ERROR) << "parse broad cast fail:" << frame->data_len;
     return;
   }
 
-  for (auto& sub_data : data.data()) {
+  for (const auto& sub_data : sub_data_list) {
     std::unique_ptr<DataInfo> sub_request_info = std::make_unique<DataInfo>();
     sub_request_info->data_len = sub_data.size();
-    sub_request_info->buff = new char[sub_request_info->data_len];
-    memcpy(sub_request_info->buff, sub_data.data(), sub_request_info->data_len);
+    sub_request_info->buff = const_cast<char*>(sub_data.data());
+    sub_request_info->holder = frame->holder;
     std::unique_ptr<QueueItem> item = std::make_unique<QueueItem>();
     item->socket = nullptr;
     item->data = std::move(sub_request_info);
@@ -117,9 +139,6 @@ void ServiceNetwork::Process(std::unique_ptr<QueueItem> item) {
   auto client_socket =
       item->socket == nullptr ? nullptr : std::move(item->socket);
   auto request_info = std::move(item->data);
-  if (client_socket != nullptr) {
-    client_socket->SetSendTimeout(1000000);
-  }
   std::unique_ptr<Context> context = std::make_unique<Context>();
   context->client = std::make_unique<NetChannel>(std::move(client_socket),
                                                  /*connected=*/true);
@@ -133,6 +152,9 @@ bool ServiceNetwork::IsRunning() { return service_->IsRunning(); }
 
 void ServiceNetwork::Stop() {
   acceptor_->Stop();
+  if (listener_ != nullptr) {
+    listener_->Stop();
+  }
   service_->Stop();
 }
 
@@ -24,8 +24,8 @@
 #include "platform/common/network/socket.h"
 #include "platform/common/queue/lock_free_queue.h"
 #include "platform/config/resdb_config.h"
-#include "platform/networkstrate/async_acceptor.h"
 #include "platform/networkstrate/service_interface.h"
+#include "platform/networkstrate/tcp_transport.h"
 #include "platform/rdbc/acceptor.h"
 #include "platform/statistic/stats.h"
 
@@ -53,14 +53,17 @@ class ServiceNetwork {
   void Process(std::unique_ptr<QueueItem> client_socket);
   bool IsRunning();
   void InputProcess();
-  void AcceptorHandler(const char* buffer, size_t data_len);
+  void AcceptorHandler(std::unique_ptr<DataInfo> frame);
 
  private:
   std::unique_ptr<Acceptor> acceptor_;
   std::unique_ptr<ServiceInterface> service_;
   bool is_running = false;
   LockFreeQueue<QueueItem> input_queue_, resp_queue_;
-  std::unique_ptr<AsyncAcceptor> async_acceptor_;
+  // The replicas send to the listener of the transport, the clients still
+  // connect to the acceptor.
+  std::shared_ptr<Transport> transport_;
+  std::unique_ptr<TransportListener> listener_;
   ResDBConfig config_;
   Stats* global_stats_;
 };
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/shm_ring.h"
+
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace resdb {
+
+namespace {
+
+constexpr uint64_t kRingMagic = 0x474e495242445352;  // "RSDBRING"
+constexpr size_t kCacheLineSize = 64;
+
+}  // namespace
+
+// The positions only grow, the offset in the ring is the position modulo
+// the capacity. Each one has its own cache line.
+struct ShmRing::Header {
+  uint64_t magic;
+  uint64_t capacity;
+  alignas(kCacheLineSize) std::atomic<uint64_t> head;  // written by producer.
+  alignas(kCacheLineSize) std::atomic<uint64_t> tail;  // written by consumer.
+  alignas(kCacheLineSize) std::atomic<uint32_t> reader_waiting;
+  std::atomic<uint32_t> closed;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the positions are shared by processes");
+
+ShmRing::ShmRing(int fd, void* addr, size_t map_size)
+    : fd_(fd),
+      addr_(addr),
+      map_size_(map_size),
+      header_(static_cast<Header*>(addr)),
+      data_(static_cast<char*>(addr) + sizeof(Header)),
+      capacity_(header_->capacity) {}
+
+ShmRing::~ShmRing() {
+  munmap(addr_, map_size_);
+  close(fd_);
+}
+
+std::unique_ptr<ShmRing> ShmRing::Create(size_t capacity) {
+  size_t ring_size = kCacheLineSize;
+  while (ring_size < capacity) {
+    ring_size <<= 1;
+  }
+  int fd = memfd_create("resdb_shm_ring", MFD_CLOEXEC);
+  if (fd < 0) {
+    LOG(ERROR) << "create memfd fail:" << strerror(errno);
+    return nullptr;
+  }
+  size_t map_size = sizeof(Header) + ring_size;
+  if (ftruncate(fd, map_size) != 0) {
+    LOG(ERROR) << "resize memfd fail:" << strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  void* addr =
+      mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "map memfd fail:" << strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  Header* header = new (addr) Header();
+  header->capacity = ring_size;
+  header->head = 0;
+  header->tail = 0;
+  header->reader_waiting = 0;
+  header->closed = 0;
+  header->magic = kRingMagic;
+  return std::unique_ptr<ShmRing>(new ShmRing(fd, addr, map_size));
+}
+
+std::unique_ptr<ShmRing> ShmRing::Attach(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) <= sizeof(Header)) {
+    LOG(ERROR) << "invalid ring fd:" << fd;
+    close(fd);
+    return nullptr;
+  }
+  size_t map_size = st.st_size;
+  void* addr =
+      mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "map ring fail:" << strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  Header* header = static_cast<Header*>(addr);
+  if (header->magic != kRingMagic ||
+      sizeof(Header) + header->capacity != map_size ||
+      (header->capacity & (header->capacity - 1)) != 0) {
+    LOG(ERROR) << "invalid ring header";
+    munmap(addr, map_size);
+    close(fd);
+    return nullptr;
+  }
+  return std::unique_ptr<ShmRing>(new ShmRing(fd, addr, map_size));
+}
+
+int ShmRing::GetFd() const { return fd_; }
+
+size_t ShmRing::GetCapacity() const { return capacity_; }
+
+size_t ShmRing::Write(const void* data, size_t size) {
+  uint64_t head = header_->head.load(std::memory_order_relaxed);
+  uint64_t tail = header_->tail.load(std::memory_order_acquire);
+  // The positions are clamped in case the peer has corrupted them.
+  size = std::min(size, capacity_ - std::min<size_t>(head - tail, capacity_));
+  if (size == 0) {
+    return 0;
+  }
+  size_t offset = head & (capacity_ - 1);
+  size_t first = std::min(size, capacity_ - offset);
+  memcpy(data_ + offset, data, first);
+  memcpy(data_, static_cast<const char*>(data) + first, size - first);
+  header_->head.store(head + size, std::memory_order_release);
+  return size;
+}
+
+size_t ShmRing::Read(void* data, size_t size) {
+  uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+  uint64_t head = header_->head.load(std::memory_order_acquire);
+  size = std::min<size_t>({size, head - tail, capacity_});
+  if (size == 0) {
+    return 0;
+  }
+  size_t offset = tail & (capacity_ - 1);
+  size_t first = std::min(size, capacity_ - offset);
+  memcpy(data, data_ + offset, first);
+  memcpy(static_cast<char*>(data) + first, data_, size - first);
+  header_->tail.store(tail + size, std::memory_order_release);
+  return size;
+}
+
+size_t ShmRing::GetReadableBytes() const {
+  return header_->head.load(std::memory_order_acquire) -
+         header_->tail.load(std::memory_order_relaxed);
+}
+
+void ShmRing::Close() { header_->closed = 1; }
+
+bool ShmRing::IsClosed() const { return header_->closed.load() != 0; }
+
+void ShmRing::SetReaderWaiting(bool waiting) {
+  header_->reader_waiting.store(waiting, std::memory_order_relaxed);
+}
+
+bool ShmRing::IsReaderWaiting() const {
+  return header_->reader_waiting.load(std::memory_order_relaxed) != 0;
+}
+
+}  // namespace resdb
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace resdb {
+
+// ShmRing is a single producer single consumer byte ring in a memfd shared
+// by two processes on the same host. The producer and the consumer only
+// move their own positions, so neither needs a lock. The ring is a byte
+// stream, a frame larger than the ring is written and read in pieces.
+class ShmRing {
+ public:
+  ~ShmRing();
+
+  // The capacity is rounded up to a power of two.
+  static std::unique_ptr<ShmRing> Create(size_t capacity);
+  // Maps the ring created by the peer, the fd is owned by the ring.
+  static std::unique_ptr<ShmRing> Attach(int fd);
+
+  int GetFd() const;
+  size_t GetCapacity() const;
+
+  // Returns the bytes written, at most the free space of the ring.
+  size_t Write(const void* data, size_t size);
+  // Returns the bytes read, at most the bytes in the ring.
+  size_t Read(void* data, size_t size);
+  size_t GetReadableBytes() const;
+
+  // Either side closes the ring when it leaves, the other side stops
+  // waiting for it.
+  void Close();
+  bool IsClosed() const;
+
+  // The consumer sets the flag before sleeping and the producer wakes it up
+  // if it is set after writing. Both sides need a full fence between
+  // publishing their position and checking the other side.
+  void SetReaderWaiting(bool waiting);
+  bool IsReaderWaiting() const;
+
+ private:
+  struct Header;
+
+  ShmRing(int fd, void* addr, size_t map_size);
+
+ private:
+  int fd_;
+  void* addr_;
+  size_t map_size_;
+  Header* header_;
+  char* data_;
+  size_t capacity_;
+};
+
+}  // namespace resdb
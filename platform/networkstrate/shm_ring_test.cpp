@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/shm_ring.h"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <thread>
+
+namespace resdb {
+namespace {
+
+std::string ReadString(ShmRing* ring, size_t size) {
+  std::string data(size, 0);
+  data.resize(ring->Read(data.data(), size));
+  return data;
+}
+
+TEST(ShmRingTest, WriteAndReadAcrossTheEnd) {
+  std::unique_ptr<ShmRing> ring = ShmRing::Create(64);
+  ASSERT_NE(ring, nullptr);
+  EXPECT_EQ(ring->GetCapacity(), 64);
+
+  EXPECT_EQ(ring->Write(std::string(40, 'a').data(), 40), 40);
+  EXPECT_EQ(ReadString(ring.get(), 100), std::string(40, 'a'));
+
+  std::string data;
+  for (int i = 0; i < 50; ++i) {
+    data.push_back('a' + i % 26);
+  }
+  EXPECT_EQ(ring->Write(data.data(), data.size()), data.size());
+  EXPECT_EQ(ring->GetReadableBytes(), data.size());
+  EXPECT_EQ(ReadString(ring.get(), 100), data);
+  EXPECT_EQ(ring->GetReadableBytes(), 0);
+}
+
+TEST(ShmRingTest, WriteFullRing) {
+  std::unique_ptr<ShmRing> ring = ShmRing::Create(64);
+  ASSERT_NE(ring, nullptr);
+
+  std::string data(100, 'a');
+  EXPECT_EQ(ring->Write(data.data(), data.size()), 64);
+  EXPECT_EQ(ring->Write(data.data(), data.size()), 0);
+  EXPECT_EQ(ReadString(ring.get(), 10), std::string(10, 'a'));
+  EXPECT_EQ(ring->Write(data.data(), data.size()), 10);
+  EXPECT_EQ(ring->GetReadableBytes(), 64);
+}
+
+TEST(ShmRingTest, AttachRing) {
+  std::unique_ptr<ShmRing> ring = ShmRing::Create(1000);
+  ASSERT_NE(ring, nullptr);
+  EXPECT_EQ(ring->GetCapacity(), 1024);
+
+  std::unique_ptr<ShmRing> peer = ShmRing::Attach(dup(ring->GetFd()));
+  ASSERT_NE(peer, nullptr);
+  EXPECT_EQ(peer->GetCapacity(), 1024);
+  EXPECT_EQ(ring->Write("test", 4), 4);
+  EXPECT_EQ(ReadString(peer.get(), 10), "test");
+
+  peer->SetReaderWaiting(true);
+  EXPECT_TRUE(ring->IsReaderWaiting());
+  EXPECT_FALSE(ring->IsClosed());
+  peer->Close();
+  EXPECT_TRUE(ring->IsClosed());
+}
+
+TEST(ShmRingTest, AttachInvalidRing) {
+  int fd = memfd_create("test", 0);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(ftruncate(fd, 4096), 0);
+  EXPECT_EQ(ShmRing::Attach(fd), nullptr);
+}
+
+TEST(ShmRingTest, ProduceAndConsume) {
+  std::unique_ptr<ShmRing> ring = ShmRing::Create(4096);
+  ASSERT_NE(ring, nullptr);
+  std::unique_ptr<ShmRing> peer = ShmRing::Attach(dup(ring->GetFd()));
+  ASSERT_NE(peer, nullptr);
+
+  const size_t total = 16 << 20;
+  std::thread producer([&]() {
+    char buf[1000];
+    size_t pos = 0;
+    while (pos < total) {
+      size_t len = std::min(sizeof(buf), total - pos);
+      for (size_t i = 0; i < len; ++i) {
+        buf[i] = (pos + i) % 251;
+      }
+      size_t written = 0;
+      while (written < len) {
+        size_t n = ring->Write(buf + written, len - written);
+        if (n == 0) {
+          std::this_thread::yield();
+        }
+        written += n;
+      }
+      pos += len;
+    }
+  });
+
+  size_t pos = 0;
+  bool match = true;
+  char buf[777];
+  while (pos < total) {
+    size_t len = peer->Read(buf, sizeof(buf));
+    if (len == 0) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < len; ++i) {
+      match &= buf[i] == static_cast<char>((pos + i) % 251);
+    }
+    pos += len;
+  }
+  producer.join();
+  EXPECT_TRUE(match);
+  EXPECT_EQ(peer->GetReadableBytes(), 0);
+}
+
+}  // namespace
+}  // namespace resdb
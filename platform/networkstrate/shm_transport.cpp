@@ -0,0 +1,542 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/shm_transport.h"
+
+#include <arpa/inet.h>
+#include <glog/logging.h>
+#include <ifaddrs.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+
+namespace resdb {
+
+namespace {
+
+// A client whose peer does not accept the rings tries again after the
+// interval, sending by TCP meanwhile.
+constexpr uint64_t kReconnectIntervalUs = 1000000;
+constexpr int kHandshakeTimeoutMs = 1000;
+// The times a writer yields on a full ring before sleeping on the socket.
+constexpr int kSpinNum = 64;
+// A writer waits at most this long on a ring that is not drained, then
+// sends by TCP.
+constexpr uint64_t kFullRingTimeoutUs = 100000;
+constexpr int kPollTimeoutMs = 100;
+constexpr size_t kMaxFrameBytes = 10000000000ull;
+
+uint64_t GetTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+socklen_t GetShmAddress(const std::string& ip, int port, sockaddr_un* addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  // The leading zero puts the name in the abstract namespace, it is gone
+  // with the socket.
+  std::string name = "resdb-shm-" + ip + ":" + std::to_string(port);
+  name = name.substr(0, sizeof(addr->sun_path) - 1);
+  memcpy(addr->sun_path + 1, name.data(), name.size());
+  return offsetof(sockaddr_un, sun_path) + 1 + name.size();
+}
+
+int SendFds(int socket_fd, const int* fds, int fd_num) {
+  char data = 0;
+  iovec iov = {&data, sizeof(data)};
+  char control[CMSG_SPACE(sizeof(int) * 4)];
+  memset(control, 0, sizeof(control));
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_num);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_num);
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_num);
+  return sendmsg(socket_fd, &msg, MSG_NOSIGNAL) == sizeof(data) ? 0 : -1;
+}
+
+// Returns the number of fds received.
+int RecvFds(int socket_fd, int* fds, int max_fd_num) {
+  char data = 0;
+  iovec iov = {&data, sizeof(data)};
+  char control[CMSG_SPACE(sizeof(int) * 4)];
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * max_fd_num);
+  if (recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC) != sizeof(data)) {
+    return 0;
+  }
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS) {
+    return 0;
+  }
+  int fd_num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+  memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * fd_num);
+  return fd_num;
+}
+
+}  // namespace
+
+bool IsLocalAddress(const std::string& ip) {
+  in_addr addr;
+  if (inet_pton(AF_INET, ip.c_str(), &addr) != 1) {
+    return false;
+  }
+  if ((ntohl(addr.s_addr) >> 24) == 127) {
+    return true;
+  }
+  ifaddrs* ifaddr = nullptr;
+  if (getifaddrs(&ifaddr) != 0) {
+    return false;
+  }
+  bool found = false;
+  for (ifaddrs* it = ifaddr; it != nullptr && !found; it = it->ifa_next) {
+    if (it->ifa_addr != nullptr && it->ifa_addr->sa_family == AF_INET) {
+      found = reinterpret_cast<sockaddr_in*>(it->ifa_addr)->sin_addr.s_addr ==
+              addr.s_addr;
+    }
+  }
+  freeifaddrs(ifaddr);
+  return found;
+}
+
+size_t GetShmRingBytes(const ResConfigData& config_data) {
+  if (!config_data.enable_shm_transport()) {
+    return 0;
+  }
+  return config_data.shm_ring_bytes() > 0 ? config_data.shm_ring_bytes()
+                                          : kDefaultShmRingBytes;
+}
+
+ShmReplicaClient::ShmReplicaClient(boost::asio::io_service* io_service,
+                                   const std::string& ip, int port,
+                                   size_t ring_bytes, size_t max_write_bytes,
+                                   std::shared_ptr<FrameCodec> codec)
+    : AsyncReplicaClient(io_service, ip, port, true, max_write_bytes,
+                         std::move(codec)),
+      ip_(ip),
+      port_(port),
+      ring_bytes_(ring_bytes),
+      connected_(false),
+      last_connect_time_(0) {}
+
+ShmReplicaClient::~ShmReplicaClient() { Disconnect(); }
+
+bool ShmReplicaClient::IsShmConnected() const { return connected_; }
+
+// Pass the rings and the eventfd to the acceptor and wait for it to map
+// them.
+bool ShmReplicaClient::Connect() {
+  int socket_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (socket_fd < 0) {
+    return false;
+  }
+  sockaddr_un addr;
+  socklen_t addr_len = GetShmAddress(ip_, port_, &addr);
+  if (connect(socket_fd, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0) {
+    close(socket_fd);
+    return false;
+  }
+
+  std::unique_ptr<ShmRing> rings[kSendLaneNum];
+  for (auto& ring : rings) {
+    ring = ShmRing::Create(ring_bytes_);
+    if (ring == nullptr) {
+      close(socket_fd);
+      return false;
+    }
+  }
+  int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (event_fd < 0) {
+    close(socket_fd);
+    return false;
+  }
+  int fds[kSendLaneNum + 1] = {rings[0]->GetFd(), rings[1]->GetFd(),
+                               event_fd};
+  uint8_t reply = 0;
+  pollfd pfd = {socket_fd, POLLIN, 0};
+  if (SendFds(socket_fd, fds, kSendLaneNum + 1) != 0 ||
+      poll(&pfd, 1, kHandshakeTimeoutMs) <= 0 ||
+      recv(socket_fd, &reply, sizeof(reply), 0) != sizeof(reply) ||
+      reply != 1) {
+    LOG(ERROR) << "attach shm rings to " << ip_ << ":" << port_ << " fail";
+    close(event_fd);
+    close(socket_fd);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lk0(mutex_[0]);
+  std::lock_guard<std::mutex> lk1(mutex_[1]);
+  Disconnect();
+  for (int lane = 0; lane < kSendLaneNum; ++lane) {
+    rings_[lane] = std::move(rings[lane]);
+  }
+  socket_fd_ = socket_fd;
+  event_fd_ = event_fd;
+  connected_ = true;
+  LOG(INFO) << "send to " << ip_ << ":" << port_ << " through shm";
+  return true;
+}
+
+void ShmReplicaClient::Disconnect() {
+  connected_ = false;
+  for (auto& ring : rings_) {
+    if (ring != nullptr) {
+      ring->Close();
+      ring = nullptr;
+    }
+  }
+  if (socket_fd_ >= 0) {
+    close(socket_fd_);
+    socket_fd_ = -1;
+  }
+  if (event_fd_ >= 0) {
+    close(event_fd_);
+    event_fd_ = -1;
+  }
+}
+
+// The acceptor never writes after the handshake, the socket becomes
+// readable or hung up only when it is gone.
+bool ShmReplicaClient::IsPeerClosed() {
+  pollfd pfd = {socket_fd_, POLLIN, 0};
+  return poll(&pfd, 1, 0) != 0;
+}
+
+// Write all the bytes, waking up the reader after each piece. Returns false
+// if the reader has left or has not drained the ring for
+// kFullRingTimeoutUs.
+bool ShmReplicaClient::WriteAll(ShmRing* ring, const void* data, size_t size) {
+  if (ring->IsClosed()) {
+    return false;
+  }
+  const char* pos = static_cast<const char*>(data);
+  int idle_num = 0;
+  uint64_t idle_time = 0;
+  while (size > 0) {
+    size_t len = ring->Write(pos, size);
+    if (len > 0) {
+      pos += len;
+      size -= len;
+      idle_num = 0;
+      idle_time = 0;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ring->IsReaderWaiting()) {
+        uint64_t value = 1;
+        write(event_fd_, &value, sizeof(value));
+      }
+      continue;
+    }
+    if (ring->IsClosed()) {
+      return false;
+    }
+    if (++idle_num < kSpinNum) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (idle_time == 0) {
+      idle_time = GetTimeUs();
+    } else if (GetTimeUs() - idle_time >= kFullRingTimeoutUs) {
+      LOG(ERROR) << "shm ring of " << ip_ << ":" << port_
+                 << " is not drained for " << kFullRingTimeoutUs << "us";
+      return false;
+    }
+    pollfd pfd = {socket_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, 1) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int ShmReplicaClient::SendMessage(MessageBuffer data, SendLane lane) {
+  if (data == nullptr || data->empty()) {
+    return -1;
+  }
+  if (!connected_ &&
+      GetTimeUs() - last_connect_time_ >= kReconnectIntervalUs) {
+    std::unique_lock<std::mutex> lk(connect_mutex_, std::try_to_lock);
+    if (lk.owns_lock() && !connected_) {
+      last_connect_time_ = GetTimeUs();
+      Connect();
+    }
+  }
+  if (connected_) {
+    std::lock_guard<std::mutex> lk(mutex_[static_cast<int>(lane)]);
+    ShmRing* ring = rings_[static_cast<int>(lane)].get();
+    if (connected_ && ring != nullptr) {
+      size_t data_size = data->size();
+      // A frame left unfinished in the ring is dropped with the rings, which
+      // are not written again.
+      if (!IsPeerClosed() && WriteAll(ring, &data_size, sizeof(data_size)) &&
+          WriteAll(ring, data->data(), data_size)) {
+        return 0;
+      }
+      LOG(ERROR) << "shm reader of " << ip_ << ":" << port_
+                 << " has left or stalled, send by tcp";
+      connected_ = false;
+    }
+  }
+  return AsyncReplicaClient::SendMessage(std::move(data), lane);
+}
+
+struct ShmAcceptor::Connection {
+  int socket_fd = -1;
+  int event_fd = -1;
+  std::unique_ptr<ShmRing> rings[kSendLaneNum];
+  std::thread thread;
+  std::atomic<bool> done = false;
+
+  ~Connection() {
+    if (thread.joinable()) {
+      thread.join();
+    }
+    for (auto& ring : rings) {
+      if (ring != nullptr) {
+        ring->Close();
+      }
+    }
+    if (socket_fd >= 0) {
+      close(socket_fd);
+    }
+    if (event_fd >= 0) {
+      close(event_fd);
+    }
+  }
+};
+
+// The frame being read from a ring, a frame may be written in pieces.
+struct ShmAcceptor::FrameReader {
+  size_t header = 0;
+  size_t header_read = 0;
+  std::unique_ptr<DataInfo> frame;
+  size_t data_read = 0;
+};
+
+ShmAcceptor::ShmAcceptor(const std::string& ip, int port,
+                         AsyncAcceptor::SliceCallBack call_back_func)
+    : ip_(ip), port_(port), call_back_func_(call_back_func), stop_(false) {}
+
+ShmAcceptor::~ShmAcceptor() { Stop(); }
+
+int ShmAcceptor::Start() {
+  listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    return -1;
+  }
+  sockaddr_un addr;
+  socklen_t addr_len = GetShmAddress(ip_, port_, &addr);
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0 ||
+      listen(listen_fd_, SOMAXCONN) != 0) {
+    LOG(ERROR) << "bind shm endpoint " << ip_ << ":" << port_
+               << " fail:" << strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return -1;
+  }
+  accept_thread_ = std::thread([this]() { AcceptLoop(); });
+  return 0;
+}
+
+void ShmAcceptor::Stop() {
+  stop_ = true;
+  if (accept_thread_.joinable()) {
+    accept_thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+  std::lock_guard<std::mutex> lk(mutex_);
+  connections_.clear();
+}
+
+size_t ShmAcceptor::GetConnectionNum() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  size_t num = 0;
+  for (const auto& connection : connections_) {
+    num += !connection->done;
+  }
+  return num;
+}
+
+void ShmAcceptor::ReleaseClosedConnections() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  connections_.remove_if(
+      [](const std::unique_ptr<Connection>& connection) {
+        return connection->done.load();
+      });
+}
+
+void ShmAcceptor::AcceptLoop() {
+  while (!stop_) {
+    ReleaseClosedConnections();
+    pollfd pfd = {listen_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, kPollTimeoutMs) <= 0) {
+      continue;
+    }
+    int socket_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (socket_fd < 0) {
+      continue;
+    }
+    auto connection = std::make_unique<Connection>();
+    connection->socket_fd = socket_fd;
+
+    int fds[kSendLaneNum + 1];
+    int fd_num = 0;
+    pfd = {socket_fd, POLLIN, 0};
+    if (poll(&pfd, 1, kHandshakeTimeoutMs) > 0) {
+      fd_num = RecvFds(socket_fd, fds, kSendLaneNum + 1);
+    }
+    bool attached = fd_num == kSendLaneNum + 1;
+    for (int i = 0; i < fd_num; ++i) {
+      if (!attached) {
+        close(fds[i]);
+      } else if (i < kSendLaneNum) {
+        connection->rings[i] = ShmRing::Attach(fds[i]);
+        attached = connection->rings[i] != nullptr;
+      } else {
+        connection->event_fd = fds[i];
+      }
+    }
+    uint8_t reply = attached;
+    send(socket_fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+    if (!attached) {
+      LOG(ERROR) << "attach shm rings fail, fd num:" << fd_num;
+      continue;
+    }
+    Connection* conn = connection.get();
+    conn->thread = std::thread([this, conn]() { ReadLoop(conn); });
+    std::lock_guard<std::mutex> lk(mutex_);
+    connections_.push_back(std::move(connection));
+  }
+}
+
+// Read at most one frame from the ring. Returns whether any bytes were
+// read.
+bool ShmAcceptor::ReadFrame(ShmRing* ring, FrameReader* reader,
+                            bool* error) {
+  bool progress = false;
+  if (reader->header_read < sizeof(reader->header)) {
+    size_t len =
+        ring->Read(reinterpret_cast<char*>(&reader->header) +
+                       reader->header_read,
+                   sizeof(reader->header) - reader->header_read);
+    reader->header_read += len;
+    if (reader->header_read < sizeof(reader->header)) {
+      return len > 0;
+    }
+    progress = true;
+    if (reader->header > kMaxFrameBytes) {
+      LOG(ERROR) << "read data size:" << reader->header << " close shm";
+      *error = true;
+      return false;
+    }
+    reader->data_read = 0;
+    reader->frame = std::make_unique<DataInfo>();
+    if (reader->header > 0) {
+      // Owned by the holder like a pooled receive slab, the sub messages
+      // sliced from the frame share it.
+      char* buff = static_cast<char*>(malloc(reader->header));
+      if (buff == nullptr) {
+        LOG(ERROR) << "alloc frame fail, size:" << reader->header;
+        *error = true;
+        return false;
+      }
+      reader->frame->holder = std::shared_ptr<char>(buff, free);
+      reader->frame->buff = buff;
+      reader->frame->data_len = reader->header;
+    }
+  }
+
+  size_t len = ring->Read(
+      static_cast<char*>(reader->frame->buff) + reader->data_read,
+      reader->header - reader->data_read);
+  reader->data_read += len;
+  if (reader->data_read < reader->header) {
+    return progress || len > 0;
+  }
+  if (reader->header > 0) {
+    call_back_func_(std::move(reader->frame));
+  }
+  reader->frame = nullptr;
+  reader->header_read = 0;
+  return true;
+}
+
+void ShmAcceptor::ReadLoop(Connection* connection) {
+  ShmRing* control_ring = connection->rings[0].get();
+  ShmRing* bulk_ring = connection->rings[1].get();
+  FrameReader readers[kSendLaneNum];
+  bool error = false;
+  while (!stop_ && !error) {
+    // The control frames are read before each bulk frame.
+    bool progress = false;
+    while (!error && ReadFrame(control_ring, &readers[0], &error)) {
+      progress = true;
+    }
+    if (!error && ReadFrame(bulk_ring, &readers[1], &error)) {
+      progress = true;
+    }
+    if (progress || error) {
+      continue;
+    }
+
+    control_ring->SetReaderWaiting(true);
+    bulk_ring->SetReaderWaiting(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool readable = control_ring->GetReadableBytes() > 0 ||
+                    bulk_ring->GetReadableBytes() > 0;
+    pollfd fds[2] = {{connection->event_fd, POLLIN, 0},
+                     {connection->socket_fd, POLLIN, 0}};
+    if (!readable) {
+      poll(fds, 2, kPollTimeoutMs);
+    }
+    control_ring->SetReaderWaiting(false);
+    bulk_ring->SetReaderWaiting(false);
+    if (fds[0].revents & POLLIN) {
+      uint64_t value = 0;
+      read(connection->event_fd, &value, sizeof(value));
+    }
+    // The client has left and all its frames have been read.
+    if (fds[1].revents && control_ring->GetReadableBytes() == 0 &&
+        bulk_ring->GetReadableBytes() == 0) {
+      break;
+    }
+  }
+  control_ring->Close();
+  bulk_ring->Close();
+  connection->done = true;
+}
+
+}  // namespace resdb
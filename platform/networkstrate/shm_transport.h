@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "platform/networkstrate/async_acceptor.h"
+#include "platform/networkstrate/async_replica_client.h"
+#include "platform/networkstrate/shm_ring.h"
+
+namespace resdb {
+
+// The replicas on the same host exchange the frames through shared memory
+// instead of loopback TCP. The client creates one ShmRing for each send
+// lane and an eventfd to wake up the reader, and passes them to the
+// ShmAcceptor of the peer over a unix socket in the abstract namespace
+// named by the ip and the port of the peer. The frames keep the TCP
+// framing, a size_t length header followed by the data.
+
+constexpr size_t kDefaultShmRingBytes = 8 << 20;
+
+// Whether the ip is an address of this host.
+bool IsLocalAddress(const std::string& ip);
+
+// The bytes of each ring, 0 if the transport is not enabled.
+size_t GetShmRingBytes(const ResConfigData& config_data);
+
+// ShmReplicaClient sends the messages to a replica on the same host through
+// the rings. It falls back to TCP while the replica does not accept the
+// rings, has left or does not drain them, and tries to attach new rings at
+// most once per second.
+class ShmReplicaClient : public AsyncReplicaClient {
+ public:
+  ShmReplicaClient(boost::asio::io_service* io_service, const std::string& ip,
+                   int port, size_t ring_bytes, size_t max_write_bytes = 0,
+                   std::shared_ptr<FrameCodec> codec = nullptr);
+  ~ShmReplicaClient() override;
+
+  using AsyncReplicaClient::SendMessage;
+  // Waits at most 100ms on a full ring which is not drained, then sends by
+  // TCP.
+  int SendMessage(MessageBuffer data,
+                  SendLane lane = SendLane::kBulk) override;
+
+  bool IsShmConnected() const;
+
+ private:
+  bool Connect();
+  void Disconnect();
+  bool IsPeerClosed();
+  bool WriteAll(ShmRing* ring, const void* data, size_t size);
+
+ private:
+  std::string ip_;
+  int port_;
+  size_t ring_bytes_;
+  std::mutex mutex_[kSendLaneNum];
+  std::mutex connect_mutex_;
+  std::atomic<bool> connected_;
+  std::atomic<uint64_t> last_connect_time_;
+  int socket_fd_ = -1;
+  int event_fd_ = -1;
+  std::unique_ptr<ShmRing> rings_[kSendLaneNum];
+};
+
+// ShmAcceptor receives the frames of the clients on the same host and
+// delivers them as AsyncAcceptor does. Each client is served by its own
+// thread, which reads the control ring before the bulk ring.
+class ShmAcceptor {
+ public:
+  ShmAcceptor(const std::string& ip, int port,
+              AsyncAcceptor::SliceCallBack call_back_func);
+  ~ShmAcceptor();
+
+  // Returns -1 if the unix socket can not be bound.
+  int Start();
+  void Stop();
+
+  size_t GetConnectionNum();
+
+ private:
+  struct Connection;
+  struct FrameReader;
+
+  void AcceptLoop();
+  void ReadLoop(Connection* connection);
+  bool ReadFrame(ShmRing* ring, FrameReader* reader, bool* error);
+  void ReleaseClosedConnections();
+
+ private:
+  std::string ip_;
+  int port_;
+  AsyncAcceptor::SliceCallBack call_back_func_;
+  int listen_fd_ = -1;
+  std::atomic<bool> stop_;
+  std::thread accept_thread_;
+  std::mutex mutex_;
+  std::list<std::unique_ptr<Connection>> connections_;
+};
+
+}  // namespace resdb
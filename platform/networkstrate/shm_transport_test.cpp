@@ -0,0 +1,221 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/shm_transport.h"
+
+#include <gtest/gtest.h>
+
+#include <future>
+
+#include "platform/common/data_comm/wire_format.h"
+#include "platform/proto/broadcast.pb.h"
+
+namespace resdb {
+namespace {
+
+constexpr int kPort = 25000;
+
+class ShmTransportTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    work_ = std::make_unique<boost::asio::io_service::work>(io_service_);
+    io_thread_ = std::thread([&]() { io_service_.run(); });
+  }
+
+  void TearDown() override {
+    work_.reset();
+    io_service_.stop();
+    io_thread_.join();
+  }
+
+  AsyncAcceptor::SliceCallBack GetCallBack() {
+    return [&](std::unique_ptr<DataInfo> frame) {
+      std::lock_guard<std::mutex> lk(mutex_);
+      received_.push_back(
+          std::string(static_cast<char*>(frame->buff), frame->data_len));
+      cv_.notify_all();
+    };
+  }
+
+  std::vector<std::string> WaitForMessages(size_t num) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait_for(lk, std::chrono::seconds(10),
+                 [&]() { return received_.size() >= num; });
+    return received_;
+  }
+
+ protected:
+  boost::asio::io_service io_service_;
+  std::unique_ptr<boost::asio::io_service::work> work_;
+  std::thread io_thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::string> received_;
+};
+
+TEST(IsLocalAddressTest, LocalAddress) {
+  EXPECT_TRUE(IsLocalAddress("127.0.0.1"));
+  EXPECT_TRUE(IsLocalAddress("127.0.0.2"));
+  EXPECT_FALSE(IsLocalAddress("192.0.2.1"));
+  EXPECT_FALSE(IsLocalAddress("localhost"));
+}
+
+TEST_F(ShmTransportTest, SendThroughShm) {
+  ShmAcceptor acceptor("127.0.0.1", kPort, GetCallBack());
+  ASSERT_EQ(acceptor.Start(), 0);
+
+  std::vector<std::string> control_messages, bulk_messages;
+  {
+    // The bulk frames are larger than the rings.
+    ShmReplicaClient client(&io_service_, "127.0.0.1", kPort, 4096);
+    for (int i = 0; i < 50; ++i) {
+      bulk_messages.push_back(
+          std::string(i % 5 == 0 ? (1 << 20) + i : 100 + i, 'a' + i % 26));
+      control_messages.push_back("vote" + std::to_string(i));
+      ASSERT_EQ(client.SendMessage(NewMessageBuffer(bulk_messages.back()),
+                                   SendLane::kBulk),
+                0);
+      ASSERT_EQ(client.SendMessage(NewMessageBuffer(control_messages.back()),
+                                   SendLane::kControl),
+                0);
+      EXPECT_TRUE(client.IsShmConnected());
+    }
+    std::vector<std::string> received = WaitForMessages(100);
+    ASSERT_EQ(received.size(), 100);
+    EXPECT_EQ(acceptor.GetConnectionNum(), 1);
+
+    // Each lane keeps its order.
+    std::vector<std::string> control_received, bulk_received;
+    for (const auto& data : received) {
+      if (data.compare(0, 4, "vote") == 0) {
+        control_received.push_back(data);
+      } else {
+        bulk_received.push_back(data);
+      }
+    }
+    EXPECT_EQ(control_received, control_messages);
+    EXPECT_EQ(bulk_received, bulk_messages);
+  }
+
+  // The connection is released after the client leaves.
+  for (int i = 0; i < 100 && acceptor.GetConnectionNum() > 0; ++i) {
+    usleep(10000);
+  }
+  EXPECT_EQ(acceptor.GetConnectionNum(), 0);
+}
+
+// The sub messages sliced from a frame, as the service network does, share
+// the frame buffer and outlive the frame.
+TEST_F(ShmTransportTest, SliceBatchedFrame) {
+  std::vector<std::unique_ptr<DataInfo>> sub_messages;
+  ShmAcceptor acceptor(
+      "127.0.0.1", kPort, [&](std::unique_ptr<DataInfo> frame) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        ForEachBytesField(static_cast<const char*>(frame->buff),
+                          frame->data_len,
+                          [&](int field_number, std::string_view value) {
+                            auto sub_message = std::make_unique<DataInfo>();
+                            sub_message->buff = const_cast<char*>(value.data());
+                            sub_message->data_len = value.size();
+                            sub_message->holder = frame->holder;
+                            sub_messages.push_back(std::move(sub_message));
+                            return true;
+                          });
+        cv_.notify_all();
+      });
+  ASSERT_EQ(acceptor.Start(), 0);
+
+  BroadcastData batch;
+  for (int i = 0; i < 3; ++i) {
+    batch.add_data(std::string(1000 + i, 'a' + i));
+  }
+  ShmReplicaClient client(&io_service_, "127.0.0.1", kPort, 4096);
+  ASSERT_EQ(client.SendMessage(NewMessageBuffer(batch.SerializeAsString()),
+                               SendLane::kBulk),
+            0);
+  EXPECT_TRUE(client.IsShmConnected());
+
+  std::unique_lock<std::mutex> lk(mutex_);
+  cv_.wait_for(lk, std::chrono::seconds(10),
+               [&]() { return sub_messages.size() >= 3; });
+  ASSERT_EQ(sub_messages.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(sub_messages[i]->holder, nullptr);
+    EXPECT_EQ(std::string(static_cast<char*>(sub_messages[i]->buff),
+                          sub_messages[i]->data_len),
+              batch.data(i));
+  }
+  sub_messages.clear();
+}
+
+TEST_F(ShmTransportTest, SendByTcpWithoutShmAcceptor) {
+  AsyncAcceptor acceptor("127.0.0.1", kPort, 1, GetCallBack());
+  acceptor.StartAccept();
+
+  ShmReplicaClient client(&io_service_, "127.0.0.1", kPort, 4096);
+  ASSERT_EQ(client.SendMessage("test"), 0);
+  EXPECT_FALSE(client.IsShmConnected());
+  EXPECT_EQ(WaitForMessages(1), std::vector<std::string>({"test"}));
+}
+
+TEST_F(ShmTransportTest, SendByTcpAfterShmAcceptorStops) {
+  AsyncAcceptor tcp_acceptor("127.0.0.1", kPort, 1, GetCallBack());
+  tcp_acceptor.StartAccept();
+  auto acceptor = std::make_unique<ShmAcceptor>("127.0.0.1", kPort,
+                                                GetCallBack());
+  ASSERT_EQ(acceptor->Start(), 0);
+
+  ShmReplicaClient client(&io_service_, "127.0.0.1", kPort, 4096);
+  ASSERT_EQ(client.SendMessage("shm"), 0);
+  EXPECT_TRUE(client.IsShmConnected());
+  EXPECT_EQ(WaitForMessages(1).size(), 1);
+
+  acceptor = nullptr;
+  ASSERT_EQ(client.SendMessage("tcp"), 0);
+  EXPECT_FALSE(client.IsShmConnected());
+  EXPECT_EQ(WaitForMessages(2), std::vector<std::string>({"shm", "tcp"}));
+}
+
+TEST_F(ShmTransportTest, SendByTcpWhenRingStalls) {
+  AsyncAcceptor tcp_acceptor("127.0.0.1", kPort, 1, GetCallBack());
+  tcp_acceptor.StartAccept();
+  // The reader is stuck in the first frame and never drains the ring.
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  ShmAcceptor acceptor("127.0.0.1", kPort,
+                       [&](std::unique_ptr<DataInfo> frame) {
+                         released.wait();
+                       });
+  ASSERT_EQ(acceptor.Start(), 0);
+
+  ShmReplicaClient client(&io_service_, "127.0.0.1", kPort, 4096);
+  ASSERT_EQ(client.SendMessage("stuck"), 0);
+  EXPECT_TRUE(client.IsShmConnected());
+
+  std::string data(10000, 'a');
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(client.SendMessage(data), 0);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+  EXPECT_FALSE(client.IsShmConnected());
+  EXPECT_EQ(WaitForMessages(1), std::vector<std::string>({data}));
+  release.set_value();
+}
+
+}  // namespace
+}  // namespace resdb
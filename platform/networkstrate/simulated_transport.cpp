@@ -0,0 +1,179 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/simulated_transport.h"
+
+#include <glog/logging.h>
+
+#include <chrono>
+#include <random>
+
+namespace resdb {
+
+namespace {
+
+uint64_t GetTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string GetAddress(const std::string& ip, int port) {
+  return ip + ":" + std::to_string(port);
+}
+
+}  // namespace
+
+// The state of the link from this replica to one address, kept alive by
+// the frames on it after the client has been released.
+struct SimulatedTransport::Link {
+  std::unique_ptr<TransportClient> client;
+  LinkOptions options;
+  std::mutex mutex;
+  std::mt19937_64 random;
+  // The time each lane finishes sending the frames scheduled on it so far.
+  uint64_t busy_until[kSendLaneNum] = {};
+  std::atomic<size_t> queue_depth[kSendLaneNum] = {};
+};
+
+class SimulatedTransport::Client : public TransportClient {
+ public:
+  Client(SimulatedTransport* transport, std::shared_ptr<Link> link)
+      : transport_(transport), link_(std::move(link)) {}
+
+  int SendMessage(MessageBuffer data, SendLane lane) override {
+    if (data == nullptr || data->empty()) {
+      return -1;
+    }
+    uint64_t deliver_time = 0;
+    {
+      std::lock_guard<std::mutex> lk(link_->mutex);
+      const LinkOptions& options = link_->options;
+      if (options.loss_rate > 0 &&
+          std::bernoulli_distribution(options.loss_rate)(link_->random)) {
+        return 0;
+      }
+      uint64_t& busy_until = link_->busy_until[static_cast<int>(lane)];
+      uint64_t send_time = std::max(GetTimeUs(), busy_until);
+      if (options.bandwidth_bytes_per_sec > 0) {
+        send_time += (sizeof(size_t) + data->size()) * 1000000 /
+                     options.bandwidth_bytes_per_sec;
+      }
+      busy_until = send_time;
+      deliver_time = send_time + options.latency_us;
+    }
+    link_->queue_depth[static_cast<int>(lane)]++;
+    transport_->Schedule(link_, std::move(data), lane, deliver_time);
+    return 0;
+  }
+
+  size_t GetQueueDepth(SendLane lane) const override {
+    return link_->queue_depth[static_cast<int>(lane)];
+  }
+
+ private:
+  SimulatedTransport* transport_;
+  std::shared_ptr<Link> link_;
+};
+
+SimulatedTransport::SimulatedTransport(
+    std::shared_ptr<InProcessTransport> network, const LinkOptions& options,
+    uint64_t seed)
+    : network_(std::move(network)), options_(options), seed_(seed) {
+  deliver_thread_ = std::thread(&SimulatedTransport::DeliverLoop, this);
+}
+
+SimulatedTransport::~SimulatedTransport() {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (deliver_thread_.joinable()) {
+    deliver_thread_.join();
+  }
+}
+
+void SimulatedTransport::SetLinkOptions(const std::string& ip, int port,
+                                        const LinkOptions& options) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  link_options_[GetAddress(ip, port)] = options;
+}
+
+std::unique_ptr<TransportClient> SimulatedTransport::CreateClient(
+    const std::string& ip, int port) {
+  std::string address = GetAddress(ip, port);
+  auto link = std::make_shared<Link>();
+  link->client = network_->CreateClient(ip, port);
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = link_options_.find(address);
+    link->options = it == link_options_.end() ? options_ : it->second;
+  }
+  link->random.seed(seed_ ^ std::hash<std::string>()(address));
+  return std::make_unique<Client>(this, std::move(link));
+}
+
+std::unique_ptr<TransportListener> SimulatedTransport::Listen(
+    const std::string& ip, int port, RecvCallBack call_back_func) {
+  return network_->Listen(ip, port, std::move(call_back_func));
+}
+
+void SimulatedTransport::Schedule(std::shared_ptr<Link> link,
+                                  MessageBuffer data, SendLane lane,
+                                  uint64_t deliver_time) {
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    notify = frames_.empty() || deliver_time < frames_.top().deliver_time;
+    frames_.push(
+        Frame{deliver_time, frame_id_++, std::move(link), std::move(data),
+              lane});
+  }
+  if (notify) {
+    cv_.notify_one();
+  }
+}
+
+// The frames of a lane are delivered in the order they were sent, their
+// deliver times never decrease.
+void SimulatedTransport::DeliverLoop() {
+  std::unique_lock<std::mutex> lk(mutex_);
+  while (!stop_) {
+    if (frames_.empty()) {
+      cv_.wait(lk);
+      continue;
+    }
+    uint64_t now = GetTimeUs();
+    if (frames_.top().deliver_time > now) {
+      cv_.wait_for(lk, std::chrono::microseconds(frames_.top().deliver_time -
+                                                 now));
+      continue;
+    }
+    Frame frame = frames_.top();
+    frames_.pop();
+    lk.unlock();
+    frame.link->queue_depth[static_cast<int>(frame.lane)]--;
+    frame.link->client->SendMessage(std::move(frame.data), frame.lane);
+    frame.link = nullptr;
+    lk.lock();
+  }
+}
+
+}  // namespace resdb
@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <queue>
+#include <thread>
+
+#include "platform/networkstrate/in_process_transport.h"
+
+namespace resdb {
+
+// SimulatedTransport delivers the frames through an InProcessTransport
+// after the delay of a modelled network link. Each replica has its own
+// SimulatedTransport, the links from the replica to each address are
+// configured on it, and the replicas share the InProcessTransport. Each
+// lane of a link sends its frames one after another at the bandwidth of
+// the link, so the control frames do not wait behind the bulk ones, and
+// each frame arrives after the latency of the link unless it is dropped.
+// The drops are drawn from a generator seeded by the seed and the address
+// of the link, so a run can be repeated.
+class SimulatedTransport : public Transport {
+ public:
+  struct LinkOptions {
+    // The one way delay of a frame.
+    uint64_t latency_us = 0;
+    // 0 if the bandwidth is not limited.
+    uint64_t bandwidth_bytes_per_sec = 0;
+    // The probability of dropping a frame.
+    double loss_rate = 0;
+  };
+
+  SimulatedTransport(std::shared_ptr<InProcessTransport> network,
+                     const LinkOptions& options, uint64_t seed = 0);
+  ~SimulatedTransport() override;
+
+  // Replaces the options of the links to ip:port created afterwards.
+  void SetLinkOptions(const std::string& ip, int port,
+                      const LinkOptions& options);
+
+  std::unique_ptr<TransportClient> CreateClient(const std::string& ip,
+                                                int port) override;
+  std::unique_ptr<TransportListener> Listen(
+      const std::string& ip, int port, RecvCallBack call_back_func) override;
+
+ private:
+  class Client;
+  struct Link;
+
+  struct Frame {
+    uint64_t deliver_time;
+    uint64_t id;
+    std::shared_ptr<Link> link;
+    MessageBuffer data;
+    SendLane lane;
+
+    bool operator<(const Frame& other) const {
+      return deliver_time != other.deliver_time
+                 ? deliver_time > other.deliver_time
+                 : id > other.id;
+    }
+  };
+
+  void Schedule(std::shared_ptr<Link> link, MessageBuffer data,
+                SendLane lane, uint64_t deliver_time);
+  void DeliverLoop();
+
+ private:
+  std::shared_ptr<InProcessTransport> network_;
+  LinkOptions options_;
+  uint64_t seed_;
+  std::map<std::string, LinkOptions> link_options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::priority_queue<Frame> frames_;
+  uint64_t frame_id_ = 0;
+  bool stop_ = false;
+  std::thread deliver_thread_;
+};
+
+}  // namespace resdb
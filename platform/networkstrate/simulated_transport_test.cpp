@@ -0,0 +1,208 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/simulated_transport.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace resdb {
+namespace {
+
+uint64_t GetTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+class SimulatedTransportTest : public ::testing::Test {
+ protected:
+  struct Received {
+    std::string data;
+    uint64_t time;
+  };
+
+  Transport::RecvCallBack GetCallBack() {
+    return [&](std::unique_ptr<DataInfo> frame) {
+      std::lock_guard<std::mutex> lk(mutex_);
+      received_.push_back(
+          {std::string(static_cast<char*>(frame->buff), frame->data_len),
+           GetTimeUs()});
+      cv_.notify_all();
+    };
+  }
+
+  std::vector<Received> WaitForMessages(size_t num) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait_for(lk, std::chrono::seconds(10),
+                 [&]() { return received_.size() >= num; });
+    return received_;
+  }
+
+ protected:
+  std::shared_ptr<InProcessTransport> network_ =
+      std::make_shared<InProcessTransport>();
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<Received> received_;
+};
+
+TEST_F(SimulatedTransportTest, DelayByLatency) {
+  SimulatedTransport::LinkOptions options;
+  options.latency_us = 50000;
+  SimulatedTransport transport(network_, options);
+  auto listener = transport.Listen("127.0.0.1", 1234, GetCallBack());
+  ASSERT_NE(listener, nullptr);
+
+  auto client = transport.CreateClient("127.0.0.1", 1234);
+  uint64_t start_time = GetTimeUs();
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("vote"), SendLane::kControl),
+            0);
+  EXPECT_EQ(client->GetQueueDepth(SendLane::kControl), 1);
+
+  std::vector<Received> received = WaitForMessages(1);
+  ASSERT_EQ(received.size(), 1);
+  EXPECT_EQ(received[0].data, "vote");
+  EXPECT_GE(received[0].time - start_time, options.latency_us);
+  EXPECT_EQ(client->GetQueueDepth(SendLane::kControl), 0);
+}
+
+TEST_F(SimulatedTransportTest, LimitByBandwidth) {
+  SimulatedTransport::LinkOptions options;
+  options.bandwidth_bytes_per_sec = 1 << 20;
+  SimulatedTransport transport(network_, options);
+  auto listener = transport.Listen("127.0.0.1", 1234, GetCallBack());
+  ASSERT_NE(listener, nullptr);
+
+  // Each frame takes 1/64 second of the link.
+  auto client = transport.CreateClient("127.0.0.1", 1234);
+  uint64_t start_time = GetTimeUs();
+  for (int i = 0; i < 8; ++i) {
+    std::string data = std::to_string(i);
+    data.resize((1 << 14) - sizeof(size_t), 'd');
+    EXPECT_EQ(client->SendMessage(NewMessageBuffer(data)), 0);
+  }
+
+  std::vector<Received> received = WaitForMessages(8);
+  ASSERT_EQ(received.size(), 8);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(received[i].data[0], '0' + i);
+    EXPECT_GE(received[i].time - start_time, 1000000 / 64 * (i + 1));
+  }
+}
+
+TEST_F(SimulatedTransportTest, LanesDoNotWaitForEachOther) {
+  SimulatedTransport::LinkOptions options;
+  options.bandwidth_bytes_per_sec = 1 << 20;
+  SimulatedTransport transport(network_, options);
+  auto listener = transport.Listen("127.0.0.1", 1234, GetCallBack());
+  ASSERT_NE(listener, nullptr);
+
+  // The bulk frames take half a second of the link.
+  auto client = transport.CreateClient("127.0.0.1", 1234);
+  uint64_t start_time = GetTimeUs();
+  for (int i = 0; i < 8; ++i) {
+    std::string data(1 << 16, 'b');
+    EXPECT_EQ(client->SendMessage(NewMessageBuffer(data), SendLane::kBulk),
+              0);
+  }
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("vote"), SendLane::kControl),
+            0);
+
+  std::vector<Received> received = WaitForMessages(9);
+  ASSERT_EQ(received.size(), 9);
+  EXPECT_EQ(received[0].data, "vote");
+  EXPECT_LT(received[0].time - start_time, 1000000 / 16);
+}
+
+TEST_F(SimulatedTransportTest, DropByLossRate) {
+  SimulatedTransport::LinkOptions options;
+  options.loss_rate = 0.5;
+  std::vector<std::string> runs;
+  for (int run = 0; run < 2; ++run) {
+    SimulatedTransport transport(network_, options, /*seed=*/7);
+    transport.SetLinkOptions("127.0.0.1", 1235,
+                             SimulatedTransport::LinkOptions());
+    auto listener = transport.Listen("127.0.0.1", 1234, GetCallBack());
+    auto end_listener = transport.Listen("127.0.0.1", 1235, GetCallBack());
+    ASSERT_NE(listener, nullptr);
+
+    auto client = transport.CreateClient("127.0.0.1", 1234);
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_EQ(client->SendMessage(NewMessageBuffer(std::to_string(i))), 0);
+    }
+    // The frames are delivered in the order they are due, the one sent last
+    // through a lossless link shows the others have been delivered.
+    EXPECT_EQ(transport.CreateClient("127.0.0.1", 1235)
+                  ->SendMessage(NewMessageBuffer("end")),
+              0);
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait_for(lk, std::chrono::seconds(10), [&]() {
+      return !received_.empty() && received_.back().data == "end";
+    });
+    std::string delivered;
+    for (const auto& received : received_) {
+      delivered += received.data + ",";
+    }
+    runs.push_back(delivered);
+    EXPECT_GT(received_.size(), 400);
+    EXPECT_LT(received_.size(), 600);
+    lk.unlock();
+    received_.clear();
+  }
+  // The same seed drops the same frames.
+  EXPECT_EQ(runs[0], runs[1]);
+}
+
+TEST_F(SimulatedTransportTest, SetLinkOptions) {
+  SimulatedTransport::LinkOptions options;
+  options.latency_us = 1000000;
+  SimulatedTransport transport(network_, options);
+  options.latency_us = 0;
+  transport.SetLinkOptions("127.0.0.1", 1235, options);
+
+  auto listener1 = transport.Listen("127.0.0.1", 1234, GetCallBack());
+  auto listener2 = transport.Listen("127.0.0.1", 1235, GetCallBack());
+  auto client1 = transport.CreateClient("127.0.0.1", 1234);
+  auto client2 = transport.CreateClient("127.0.0.1", 1235);
+  EXPECT_EQ(client1->SendMessage(NewMessageBuffer("slow")), 0);
+  EXPECT_EQ(client2->SendMessage(NewMessageBuffer("fast")), 0);
+
+  std::vector<Received> received = WaitForMessages(2);
+  ASSERT_EQ(received.size(), 2);
+  EXPECT_EQ(received[0].data, "fast");
+  EXPECT_EQ(received[1].data, "slow");
+}
+
+TEST_F(SimulatedTransportTest, ReleaseWithFramesOnTheWay) {
+  SimulatedTransport::LinkOptions options;
+  options.latency_us = 1000000;
+  {
+    SimulatedTransport transport(network_, options);
+    auto listener = transport.Listen("127.0.0.1", 1234, GetCallBack());
+    auto client = transport.CreateClient("127.0.0.1", 1234);
+    EXPECT_EQ(client->SendMessage(NewMessageBuffer("data")), 0);
+  }
+  std::lock_guard<std::mutex> lk(mutex_);
+  EXPECT_TRUE(received_.empty());
+}
+
+}  // namespace
+}  // namespace resdb
@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/tcp_transport.h"
+
+#include <glog/logging.h>
+
+namespace resdb {
+
+namespace {
+
+class TcpListener : public TransportListener {
+ public:
+  TcpListener(std::unique_ptr<AsyncAcceptor> async_acceptor,
+              std::unique_ptr<ShmAcceptor> shm_acceptor)
+      : async_acceptor_(std::move(async_acceptor)),
+        shm_acceptor_(std::move(shm_acceptor)) {}
+
+  ~TcpListener() override { Stop(); }
+
+  void Stop() override {
+    if (shm_acceptor_ != nullptr) {
+      shm_acceptor_->Stop();
+    }
+    async_acceptor_ = nullptr;
+  }
+
+ private:
+  std::unique_ptr<AsyncAcceptor> async_acceptor_;
+  std::unique_ptr<ShmAcceptor> shm_acceptor_;
+};
+
+}  // namespace
+
+TcpTransport::TcpTransport(int thread_num, size_t max_write_bytes,
+                           std::shared_ptr<FrameCodec> codec,
+                           size_t shm_ring_bytes)
+    : thread_num_(thread_num),
+      max_write_bytes_(max_write_bytes),
+      codec_(std::move(codec)),
+      shm_ring_bytes_(shm_ring_bytes) {}
+
+TcpTransport::~TcpTransport() {
+  worker_ = nullptr;
+  io_service_.stop();
+  for (auto& worker_th : worker_threads_) {
+    if (worker_th.joinable()) {
+      worker_th.join();
+    }
+  }
+}
+
+std::unique_ptr<TransportClient> TcpTransport::CreateClient(
+    const std::string& ip, int port) {
+  std::call_once(start_once_, [&]() {
+    worker_ = std::make_unique<boost::asio::io_service::work>(io_service_);
+    for (int i = 0; i < thread_num_; ++i) {
+      worker_threads_.push_back(std::thread([&]() { io_service_.run(); }));
+    }
+  });
+  if (shm_ring_bytes_ > 0 && IsLocalAddress(ip)) {
+    return std::make_unique<ShmReplicaClient>(
+        &io_service_, ip, port, shm_ring_bytes_, max_write_bytes_, codec_);
+  }
+  return std::make_unique<AsyncReplicaClient>(&io_service_, ip, port, true,
+                                              max_write_bytes_, codec_);
+}
+
+// The replicas on the same host send through shared memory, the others
+// still connect to the async acceptor.
+std::unique_ptr<TransportListener> TcpTransport::Listen(
+    const std::string& ip, int port, RecvCallBack call_back_func) {
+  auto async_acceptor = std::make_unique<AsyncAcceptor>(
+      ip, port, thread_num_, call_back_func, codec_);
+  async_acceptor->StartAccept();
+
+  std::unique_ptr<ShmAcceptor> shm_acceptor;
+  if (shm_ring_bytes_ > 0) {
+    shm_acceptor = std::make_unique<ShmAcceptor>(ip, port, call_back_func);
+    if (shm_acceptor->Start() != 0) {
+      LOG(ERROR) << "start shm acceptor fail:" << ip << " port:" << port;
+      shm_acceptor = nullptr;
+    }
+  }
+  return std::make_unique<TcpListener>(std::move(async_acceptor),
+                                       std::move(shm_acceptor));
+}
+
+}  // namespace resdb
@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <mutex>
+#include <thread>
+
+#include "platform/networkstrate/shm_transport.h"
+#include "platform/networkstrate/transport.h"
+
+namespace resdb {
+
+// TcpTransport links the replicas by long TCP connections, AsyncReplicaClient
+// to AsyncAcceptor. If shm_ring_bytes is set, the replicas on the same host
+// are linked by the shared memory rings instead.
+class TcpTransport : public Transport {
+ public:
+  // The clients are run by thread_num threads, and so are the acceptors.
+  TcpTransport(int thread_num = 1, size_t max_write_bytes = 0,
+               std::shared_ptr<FrameCodec> codec = nullptr,
+               size_t shm_ring_bytes = 0);
+  ~TcpTransport() override;
+
+  std::unique_ptr<TransportClient> CreateClient(const std::string& ip,
+                                                int port) override;
+  std::unique_ptr<TransportListener> Listen(
+      const std::string& ip, int port, RecvCallBack call_back_func) override;
+
+ private:
+  int thread_num_;
+  size_t max_write_bytes_;
+  // Shared by the clients so that a broadcast is compressed once.
+  std::shared_ptr<FrameCodec> codec_;
+  size_t shm_ring_bytes_;
+
+  // The threads are started with the first client.
+  std::once_flag start_once_;
+  boost::asio::io_service io_service_;
+  std::unique_ptr<boost::asio::io_service::work> worker_;
+  std::vector<std::thread> worker_threads_;
+};
+
+}  // namespace resdb
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/networkstrate/tcp_transport.h"
+
+#include <gtest/gtest.h>
+
+namespace resdb {
+namespace {
+
+constexpr int kPort = 26000;
+
+class TcpTransportTest : public ::testing::Test {
+ protected:
+  Transport::RecvCallBack GetCallBack() {
+    return [&](std::unique_ptr<DataInfo> frame) {
+      std::lock_guard<std::mutex> lk(mutex_);
+      received_.push_back(
+          std::string(static_cast<char*>(frame->buff), frame->data_len));
+      cv_.notify_all();
+    };
+  }
+
+  std::vector<std::string> WaitForMessages(size_t num) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    cv_.wait_for(lk, std::chrono::seconds(10),
+                 [&]() { return received_.size() >= num; });
+    return received_;
+  }
+
+ protected:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::string> received_;
+};
+
+TEST_F(TcpTransportTest, SendThroughTcp) {
+  TcpTransport transport;
+  auto listener = transport.Listen("127.0.0.1", kPort, GetCallBack());
+  ASSERT_NE(listener, nullptr);
+
+  auto client = transport.CreateClient("127.0.0.1", kPort);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("vote"), SendLane::kControl),
+            0);
+  EXPECT_EQ(WaitForMessages(1), std::vector<std::string>({"vote"}));
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer("batch")), 0);
+  EXPECT_EQ(WaitForMessages(2), std::vector<std::string>({"vote", "batch"}));
+}
+
+TEST_F(TcpTransportTest, SendThroughShm) {
+  TcpTransport transport(1, 0, nullptr, /*shm_ring_bytes=*/4096);
+  auto listener = transport.Listen("127.0.0.1", kPort + 1, GetCallBack());
+  ASSERT_NE(listener, nullptr);
+
+  auto client = transport.CreateClient("127.0.0.1", kPort + 1);
+  ASSERT_NE(dynamic_cast<ShmReplicaClient*>(client.get()), nullptr);
+  EXPECT_EQ(client->SendMessage(NewMessageBuffer(std::string(10000, 'd'))),
+            0);
+  std::vector<std::string> received = WaitForMessages(1);
+  ASSERT_EQ(received.size(), 1);
+  EXPECT_EQ(received[0], std::string(10000, 'd'));
+  EXPECT_TRUE(static_cast<ShmReplicaClient*>(client.get())->IsShmConnected());
+}
+
+}  // namespace
+}  // namespace resdb
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "platform/common/data_comm/data_comm.h"
+#include "platform/networkstrate/message_buffer.h"
+
+namespace resdb {
+
+// The messages of the control lane, the votes and the other protocol control
+// messages, are written before the queued messages of the bulk lane so that
+// they are not delayed by large payloads. Each lane keeps its own order.
+enum class SendLane { kControl = 0, kBulk = 1 };
+constexpr int kSendLaneNum = 2;
+
+// TransportClient sends length-prefixed frames to the replica listening on
+// one address.
+class TransportClient {
+ public:
+  virtual ~TransportClient() = default;
+
+  // The buffer is shared with the client until it has been sent.
+  virtual int SendMessage(MessageBuffer data,
+                          SendLane lane = SendLane::kBulk) = 0;
+  // The number of messages of the lane waiting to be sent.
+  virtual size_t GetQueueDepth(SendLane lane) const = 0;
+};
+
+// TransportListener delivers the frames sent to its address until it is
+// stopped or released.
+class TransportListener {
+ public:
+  virtual ~TransportListener() = default;
+
+  virtual void Stop() = 0;
+};
+
+// Transport creates the links the replicas exchange the protocol messages
+// through: the clients sending the frames and the listeners receiving them.
+// The frames are delivered as they were sent, whatever the transport puts
+// between the replicas.
+class Transport {
+ public:
+  // Receives the data of one frame.
+  typedef std::function<void(std::unique_ptr<DataInfo>)> RecvCallBack;
+
+  virtual ~Transport() = default;
+
+  // The clients must be released before the transport.
+  virtual std::unique_ptr<TransportClient> CreateClient(const std::string& ip,
+                                                        int port) = 0;
+  // Returns nullptr if the address can not be listened on.
+  virtual std::unique_ptr<TransportListener> Listen(
+      const std::string& ip, int port, RecvCallBack call_back_func) = 0;
+};
+
+}  // namespace resdb
@@ -19,80 +19,155 @@
 
 #include "platform/rdbc/acceptor.h"
 
+#include <arpa/inet.h>
 #include <glog/logging.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
-#include <thread>
-
-#include "platform/common/network/tcp_socket.h"
+#include <cstring>
 
 namespace resdb {
 
+namespace {
+
+// How long accepting pauses at most once the fds have run out, and how
+// often it checks for a closed connection meanwhile.
+constexpr int kAcceptBackoffMs = 1000;
+constexpr int kAcceptCheckMs = 10;
+
+}  // namespace
+
 Acceptor::Acceptor(const ResDBConfig& config,
                    LockFreeQueue<QueueItem>* input_queue)
-    : socket_(std::make_unique<TcpSocket>()),
-      config_(config),
-      input_queue_(input_queue) {
-  socket_->SetRecvTimeout(1000000);  // set 1s timeout.
+    : config_(config), input_queue_(input_queue) {
+  is_stop_ = false;
+  global_stats_ = Stats::GetGlobalStats();
 
   LOG(ERROR) << "listen ip:" << config.GetSelfInfo().ip()
              << " port:" << config.GetSelfInfo().port();
-  assert(socket_->Listen(config.GetSelfInfo().ip(),
-                         config.GetSelfInfo().port()) == 0);
-  is_stop_ = false;
-  global_stats_ = Stats::GetGlobalStats();
+  int ret = Listen(config.GetSelfInfo().ip(), config.GetSelfInfo().port());
+  assert(ret == 0);
+  (void)ret;
+
+  // The requests are small, their buffers come from 4KB slabs.
+  auto pool = std::make_shared<RecvBufferPool>(4 << 10, 256);
+  int loop_num = std::max<int>(config_.GetInputWorkerNum(), 1);
+  for (int i = 0; i < loop_num; ++i) {
+    loops_.push_back(std::make_unique<EventLoop>(
+        pool, [this](std::unique_ptr<Socket> socket,
+                     std::unique_ptr<DataInfo> request_info) {
+          std::unique_ptr<QueueItem> item = std::make_unique<QueueItem>();
+          item->socket = std::move(socket);
+          item->data = std::move(request_info);
+          global_stats_->ServerCall();
+          input_queue_->Push(std::move(item));
+        }));
+  }
+}
+
+Acceptor::~Acceptor() {
+  loops_.clear();
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+  }
 }
 
-Acceptor::~Acceptor() {}
+int Acceptor::Listen(const std::string& ip, int port) {
+  listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    LOG(ERROR) << "create socket error: " << strerror(errno);
+    return -1;
+  }
+  int on = 1;
+  if (setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0) {
+    LOG(ERROR) << "set socket opt fail, error" << strerror(errno);
+    return -1;
+  }
+
+  struct sockaddr_in servaddr;
+  memset(&servaddr, 0, sizeof(servaddr));
+  servaddr.sin_family = AF_INET;
+  servaddr.sin_addr.s_addr = inet_addr(ip.data());
+  servaddr.sin_port = htons(port);
+  if (bind(listen_fd_, (struct sockaddr*)&servaddr, sizeof(servaddr)) == -1) {
+    LOG(ERROR) << "bind socket error: " << strerror(errno);
+    return -1;
+  }
+  if (listen(listen_fd_, SOMAXCONN) == -1) {
+    LOG(ERROR) << "listen socket error: " << strerror(errno);
+    return -1;
+  }
+  return 0;
+}
 
 void Acceptor::Run() {
   LOG(ERROR) << "server:" << config_.GetSelfInfo().id() << " start running";
-
-  LockFreeQueue<Socket> socket_queue("server");
-  std::vector<std::thread> threads;
-  int woker_num = config_.GetInputWorkerNum();
-  for (int i = 0; i < woker_num; ++i) {
-    threads.push_back(std::thread([&]() {
-      while (IsRunning()) {
-        auto client_socket = socket_queue.Pop();
-        if (client_socket == nullptr) {
-          continue;
-        }
-        std::unique_ptr<DataInfo> request_info = std::make_unique<DataInfo>();
-        int ret =
-            client_socket->Recv(&request_info->buff, &request_info->data_len);
-        if (ret <= 0) {
-          continue;
-        }
-        std::unique_ptr<QueueItem> item = std::make_unique<QueueItem>();
-        item->socket = std::move(client_socket);
-        item->data = std::move(request_info);
-        global_stats_->ServerCall();
-        input_queue_->Push(std::move(item));
-      }
-    }));
+  while (IsRunning()) {
+    if (accept_paused_) {
+      WaitForFreeFd();
+    }
+    struct pollfd listen_poll = {listen_fd_, POLLIN, 0};
+    if (poll(&listen_poll, 1, 1000) > 0) {
+      AcceptConnections();
+    }
   }
+}
 
+// Hand the new connections to the event loops in turn.
+void Acceptor::AcceptConnections() {
   while (IsRunning()) {
-    auto client_socket = socket_->Accept();
-    if (client_socket == nullptr) {
-      continue;
+    int fd = accept4(listen_fd_, nullptr, nullptr,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EMFILE || errno == ENFILE) {
+        paused_connection_num_ = GetConnectionNum();
+        accept_paused_ = true;
+        LOG(ERROR) << "accept fail:" << strerror(errno)
+                   << ", pause accepting with " << paused_connection_num_
+                   << " connections";
+      } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        LOG(ERROR) << "accept fail:" << strerror(errno);
+      }
+      return;
     }
-    socket_queue.Push(std::move(client_socket));
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    loops_[next_loop_++ % loops_.size()]->AddConnection(fd);
   }
+}
 
-  for (auto& th : threads) {
-    if (th.joinable()) {
-      th.join();
+// The pending connection keeps the listen fd readable while accept fails for
+// the lack of fds, so polling it would spin. Wait until one of the
+// connections is closed, or kAcceptBackoffMs in case the fds are released
+// outside the acceptor.
+void Acceptor::WaitForFreeFd() {
+  for (int i = 0; i < kAcceptBackoffMs / kAcceptCheckMs && IsRunning(); ++i) {
+    if (GetConnectionNum() < paused_connection_num_) {
+      break;
     }
+    usleep(kAcceptCheckMs * 1000);
   }
+  accept_paused_ = false;
 }
 
 void Acceptor::Stop() {
   is_stop_ = true;
-  socket_->Close();
+  if (listen_fd_ >= 0) {
+    shutdown(listen_fd_, SHUT_RDWR);
+  }
 }
 
 bool Acceptor::IsRunning() { return !is_stop_; }
 
+size_t Acceptor::GetConnectionNum() {
+  size_t num = 0;
+  for (auto& loop : loops_) {
+    num += loop->GetConnectionNum();
+  }
+  return num;
+}
+
 }  // namespace resdb
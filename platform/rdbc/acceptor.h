@@ -25,6 +25,7 @@
 #include "platform/common/network/socket.h"
 #include "platform/common/queue/lock_free_queue.h"
 #include "platform/config/resdb_config.h"
+#include "platform/rdbc/event_loop.h"
 #include "platform/statistic/stats.h"
 
 namespace resdb {
@@ -32,7 +33,11 @@ namespace resdb {
 // Acceptor is a service running in BFT environment.
 // It receives messages from other servers or clients and delivers them to
 // ServiceInterface to process.
-// service will be running in a multi-thread module.
+// The connections are non-blocking and spread over input_worker_num event
+// loops, each serving its connections from one thread with epoll. A
+// connection may carry any number of requests; the socket passed on with a
+// request sends the response through the event loop without blocking the
+// caller.
 class Acceptor {
  public:
   // While running Acceptor, it will lisenten to ip:port.
@@ -43,15 +48,26 @@ class Acceptor {
   void Run();
   void Stop();
 
+  // The number of the client connections being served.
+  size_t GetConnectionNum();
+
  private:
   bool IsRunning();
+  int Listen(const std::string& ip, int port);
+  void AcceptConnections();
+  void WaitForFreeFd();
 
  private:
-  std::unique_ptr<Socket> socket_;
+  int listen_fd_ = -1;
   ResDBConfig config_;
   LockFreeQueue<QueueItem>* input_queue_;
   Stats* global_stats_;
   std::atomic<bool> is_stop_;
+  std::vector<std::unique_ptr<EventLoop>> loops_;
+  size_t next_loop_ = 0;
+  // Set when accept runs out of fds, with the connection number then.
+  bool accept_paused_ = false;
+  size_t paused_connection_num_ = 0;
 };
 
 }  // namespace resdb
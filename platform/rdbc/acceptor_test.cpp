@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/rdbc/acceptor.h"
+
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "platform/common/network/tcp_socket.h"
+
+namespace resdb {
+namespace {
+
+ResDBConfig GetConfig(int port) {
+  ReplicaInfo self_info;
+  self_info.set_ip("127.0.0.1");
+  self_info.set_port(port);
+  ResConfigData config_data;
+  config_data.set_input_worker_num(2);
+  return ResDBConfig({self_info}, self_info, config_data);
+}
+
+class AcceptorTest : public ::testing::Test {
+ public:
+  AcceptorTest()
+      : input_queue_("input"),
+        acceptor_(GetConfig(kPort), &input_queue_),
+        thread_([&]() { acceptor_.Run(); }) {}
+
+  ~AcceptorTest() {
+    acceptor_.Stop();
+    thread_.join();
+  }
+
+  std::unique_ptr<TcpSocket> Connect() {
+    auto client = std::make_unique<TcpSocket>();
+    client->SetRecvTimeout(5000000);
+    EXPECT_EQ(client->Connect("127.0.0.1", kPort), 0);
+    return client;
+  }
+
+  std::unique_ptr<QueueItem> PopRequest() {
+    for (int i = 0; i < 50; ++i) {
+      auto item = input_queue_.Pop(100);
+      if (item != nullptr) {
+        return item;
+      }
+    }
+    return nullptr;
+  }
+
+  std::string Recv(Socket* client) {
+    std::unique_ptr<DataInfo> data = std::make_unique<DataInfo>();
+    if (client->Recv(&data->buff, &data->data_len) <= 0) {
+      return "";
+    }
+    return std::string(static_cast<char*>(data->buff), data->data_len);
+  }
+
+ protected:
+  static constexpr int kPort = 23456;
+  LockFreeQueue<QueueItem> input_queue_;
+  Acceptor acceptor_;
+  std::thread thread_;
+};
+
+TEST_F(AcceptorTest, SendResponse) {
+  auto client = Connect();
+  EXPECT_EQ(client->Send("request"), 0);
+
+  auto item = PopRequest();
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(std::string(static_cast<char*>(item->data->buff),
+                        item->data->data_len),
+            "request");
+  EXPECT_EQ(item->socket->Send("response"), 0);
+  EXPECT_EQ(Recv(client.get()), "response");
+}
+
+TEST_F(AcceptorTest, RequestsOnOneConnection) {
+  auto client = Connect();
+  std::string large_request(4 << 20, 'r');
+  EXPECT_EQ(client->Send("request_1"), 0);
+  EXPECT_EQ(client->Send(large_request), 0);
+  EXPECT_EQ(client->Send("request_3"), 0);
+
+  std::vector<std::unique_ptr<QueueItem>> items;
+  for (int i = 0; i < 3; ++i) {
+    items.push_back(PopRequest());
+    ASSERT_NE(items.back(), nullptr);
+  }
+  EXPECT_EQ(std::string(static_cast<char*>(items[0]->data->buff),
+                        items[0]->data->data_len),
+            "request_1");
+  EXPECT_EQ(std::string(static_cast<char*>(items[1]->data->buff),
+                        items[1]->data->data_len),
+            large_request);
+  EXPECT_EQ(std::string(static_cast<char*>(items[2]->data->buff),
+                        items[2]->data->data_len),
+            "request_3");
+
+  // The large response does not fit in the socket buffer and is finished by
+  // the event loop.
+  std::string large_response(8 << 20, 'p');
+  EXPECT_EQ(items[1]->socket->Send(large_response), 0);
+  EXPECT_EQ(items[0]->socket->Send("response_1"), 0);
+  EXPECT_EQ(Recv(client.get()), large_response);
+  EXPECT_EQ(Recv(client.get()), "response_1");
+}
+
+TEST_F(AcceptorTest, ManyConnections) {
+  constexpr int kClientNum = 200;
+  std::vector<std::unique_ptr<TcpSocket>> clients;
+  for (int i = 0; i < kClientNum; ++i) {
+    clients.push_back(Connect());
+    EXPECT_EQ(clients.back()->Send("request_" + std::to_string(i)), 0);
+  }
+
+  for (int i = 0; i < kClientNum; ++i) {
+    auto item = PopRequest();
+    ASSERT_NE(item, nullptr);
+    // Echo the request.
+    EXPECT_EQ(item->socket->Send(std::string(
+                  static_cast<char*>(item->data->buff), item->data->data_len)),
+              0);
+  }
+  for (int i = 0; i < kClientNum; ++i) {
+    EXPECT_EQ(Recv(clients[i].get()), "request_" + std::to_string(i));
+  }
+  EXPECT_EQ(acceptor_.GetConnectionNum(), kClientNum);
+
+  // The connections closed by the clients are released.
+  clients.clear();
+  for (int i = 0; i < 50 && acceptor_.GetConnectionNum() > 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  EXPECT_EQ(acceptor_.GetConnectionNum(), 0);
+}
+
+TEST_F(AcceptorTest, PauseAcceptingWithoutFds) {
+  struct rlimit old_limit;
+  ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &old_limit), 0);
+
+  // Leave fds for one client and its connection, and for the client
+  // waiting to be accepted.
+  int next_fd = dup(0);
+  ASSERT_GE(next_fd, 0);
+  close(next_fd);
+  struct rlimit limit = old_limit;
+  limit.rlim_cur = next_fd + 3;
+  ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limit), 0);
+
+  auto client_1 = Connect();
+  EXPECT_EQ(client_1->Send("request_1"), 0);
+  auto item = PopRequest();
+  ASSERT_NE(item, nullptr);
+  item.reset();
+
+  auto client_2 = Connect();
+  EXPECT_EQ(client_2->Send("request_2"), 0);
+  EXPECT_EQ(input_queue_.Pop(500), nullptr);
+  EXPECT_EQ(acceptor_.GetConnectionNum(), 1);
+
+  // Closing the first connection releases an fd for the second one.
+  client_1.reset();
+  item = PopRequest();
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(std::string(static_cast<char*>(item->data->buff),
+                        item->data->data_len),
+            "request_2");
+  EXPECT_EQ(setrlimit(RLIMIT_NOFILE, &old_limit), 0);
+}
+
+}  // namespace
+}  // namespace resdb
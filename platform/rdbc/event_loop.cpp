@@ -0,0 +1,326 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "platform/rdbc/event_loop.h"
+
+#include <glog/logging.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+
+namespace resdb {
+
+namespace {
+
+constexpr size_t kMaxFrameBytes = 1 << 30;
+// A client not reading its responses is disconnected once this many bytes
+// are pending.
+constexpr size_t kMaxPendingBytes = 64 << 20;
+constexpr int kMaxEvents = 256;
+
+}  // namespace
+
+Connection::Connection(int fd, int epoll_fd,
+                       std::shared_ptr<RecvBufferPool> pool)
+    : fd_(fd), epoll_fd_(epoll_fd), pool_(std::move(pool)) {}
+
+Connection::~Connection() { Close(); }
+
+bool Connection::OnReadable(const CallBack& call_back) {
+  while (true) {
+    char* buf = nullptr;
+    size_t need_size = 0;
+    if (read_state_ == ReadState::kSize) {
+      buf = reinterpret_cast<char*>(&frame_size_) + read_size_;
+      need_size = sizeof(frame_size_) - read_size_;
+    } else {
+      buf = frame_.get() + read_size_;
+      need_size = frame_size_ - read_size_;
+    }
+    ssize_t ret = recv(fd_, buf, need_size, 0);
+    if (ret == 0) {
+      return false;
+    }
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    read_size_ += ret;
+
+    if (read_state_ == ReadState::kSize) {
+      if (read_size_ < sizeof(frame_size_)) {
+        continue;
+      }
+      read_size_ = 0;
+      if (frame_size_ == 0) {
+        continue;
+      }
+      if (frame_size_ > kMaxFrameBytes) {
+        LOG(ERROR) << "read data size:" << frame_size_ << " close socket";
+        return false;
+      }
+      size_t capacity = 0;
+      frame_ = pool_->Get(frame_size_, &capacity);
+      read_state_ = ReadState::kData;
+      continue;
+    }
+
+    if (read_size_ < frame_size_) {
+      continue;
+    }
+    std::unique_ptr<DataInfo> frame = std::make_unique<DataInfo>();
+    frame->buff = frame_.get();
+    frame->data_len = frame_size_;
+    frame->holder = std::move(frame_);
+    read_state_ = ReadState::kSize;
+    read_size_ = 0;
+    frame_size_ = 0;
+    call_back(std::make_unique<ConnectionSocket>(shared_from_this()),
+              std::move(frame));
+  }
+}
+
+bool Connection::OnWritable() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (closed_ || !Flush()) {
+    return false;
+  }
+  if (pending_.empty()) {
+    WatchWritable(false);
+  }
+  return true;
+}
+
+int Connection::Send(const std::string& data) {
+  size_t data_size = data.size();
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (closed_) {
+    return -1;
+  }
+  if (pending_bytes_ + data_size > kMaxPendingBytes) {
+    LOG(ERROR) << "client does not read, pending bytes:" << pending_bytes_
+               << " close socket";
+    shutdown(fd_, SHUT_RDWR);
+    return -1;
+  }
+
+  // Write directly if nothing is pending.
+  size_t written = 0;
+  if (pending_.empty()) {
+    struct iovec iov[2];
+    iov[0].iov_base = &data_size;
+    iov[0].iov_len = sizeof(data_size);
+    iov[1].iov_base = const_cast<char*>(data.data());
+    iov[1].iov_len = data_size;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    ssize_t ret = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        LOG(ERROR) << "send data error: " << strerror(errno);
+        return -1;
+      }
+      ret = 0;
+    }
+    written = ret;
+    if (written == sizeof(data_size) + data_size) {
+      return 0;
+    }
+  }
+
+  std::string frame;
+  frame.reserve(sizeof(data_size) + data_size);
+  frame.append(reinterpret_cast<const char*>(&data_size), sizeof(data_size));
+  frame.append(data);
+  pending_bytes_ += frame.size() - written;
+  if (pending_.empty()) {
+    pending_offset_ = written;
+  }
+  pending_.push_back(std::move(frame));
+  WatchWritable(true);
+  return 0;
+}
+
+// Write the pending responses until the socket is full.
+bool Connection::Flush() {
+  while (!pending_.empty()) {
+    const std::string& frame = pending_.front();
+    ssize_t ret = send(fd_, frame.data() + pending_offset_,
+                       frame.size() - pending_offset_, MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    pending_offset_ += ret;
+    pending_bytes_ -= ret;
+    if (pending_offset_ == frame.size()) {
+      pending_.pop_front();
+      pending_offset_ = 0;
+    }
+  }
+  return true;
+}
+
+void Connection::WatchWritable(bool watch) {
+  if (watch_writable_ == watch) {
+    return;
+  }
+  struct epoll_event event;
+  event.events = EPOLLIN | (watch ? EPOLLOUT : 0);
+  event.data.ptr = this;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd_, &event) != 0) {
+    LOG(ERROR) << "watch socket fail:" << strerror(errno);
+    return;
+  }
+  watch_writable_ = watch;
+}
+
+void Connection::Shutdown() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (!closed_) {
+    shutdown(fd_, SHUT_RDWR);
+  }
+}
+
+void Connection::Close() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd_, nullptr);
+  close(fd_);
+  pending_.clear();
+  pending_bytes_ = 0;
+}
+
+ConnectionSocket::ConnectionSocket(std::shared_ptr<Connection> connection)
+    : connection_(std::move(connection)) {}
+
+void ConnectionSocket::Close() { connection_->Shutdown(); }
+
+int ConnectionSocket::Send(const std::string& data) {
+  return connection_->Send(data);
+}
+
+EventLoop::EventLoop(std::shared_ptr<RecvBufferPool> pool,
+                     Connection::CallBack call_back)
+    : pool_(std::move(pool)), call_back_(call_back) {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  assert(epoll_fd_ >= 0 && wake_fd_ >= 0);
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+  thread_ = std::thread(&EventLoop::Run, this);
+}
+
+EventLoop::~EventLoop() {
+  Stop();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    for (auto& it : connections_) {
+      it.second->Close();
+    }
+    connections_.clear();
+  }
+  close(wake_fd_);
+  close(epoll_fd_);
+}
+
+int EventLoop::AddConnection(int fd) {
+  auto connection = std::make_shared<Connection>(fd, epoll_fd_, pool_);
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    connections_[connection.get()] = connection;
+  }
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = connection.get();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+    LOG(ERROR) << "add socket fail:" << strerror(errno);
+    CloseConnection(connection.get());
+    return -1;
+  }
+  return 0;
+}
+
+size_t EventLoop::GetConnectionNum() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return connections_.size();
+}
+
+void EventLoop::Stop() {
+  stop_ = true;
+  uint64_t value = 1;
+  if (write(wake_fd_, &value, sizeof(value)) != sizeof(value)) {
+    LOG(ERROR) << "wake up event loop fail:" << strerror(errno);
+  }
+}
+
+void EventLoop::Run() {
+  struct epoll_event events[kMaxEvents];
+  while (!stop_) {
+    int num = epoll_wait(epoll_fd_, events, kMaxEvents, 1000);
+    for (int i = 0; i < num; ++i) {
+      Connection* connection = static_cast<Connection*>(events[i].data.ptr);
+      if (connection == nullptr) {
+        uint64_t value = 0;
+        if (read(wake_fd_, &value, sizeof(value)) < 0) {
+          LOG(ERROR) << "read wake up fd fail:" << strerror(errno);
+        }
+        continue;
+      }
+      bool ok = true;
+      if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        ok = connection->OnReadable(call_back_);
+      }
+      if (ok && (events[i].events & EPOLLOUT)) {
+        ok = connection->OnWritable();
+      }
+      if (!ok) {
+        CloseConnection(connection);
+      }
+    }
+  }
+}
+
+// The connection is released once the sockets handed on with its frames
+// are gone as well.
+void EventLoop::CloseConnection(Connection* connection) {
+  connection->Close();
+  std::lock_guard<std::mutex> lk(mutex_);
+  connections_.erase(connection);
+}
+
+}  // namespace resdb
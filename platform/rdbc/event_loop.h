@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "platform/common/data_comm/data_comm.h"
+#include "platform/common/data_comm/recv_buffer_pool.h"
+#include "platform/common/network/socket.h"
+
+namespace resdb {
+
+// Connection is a non-blocking client connection served by an EventLoop.
+// The frames use the framing of TcpSocket, the size of the data followed
+// by the data. They are read by a small state machine, the size first and
+// then the data into a pooled buffer. The responses are written without
+// blocking; the part the socket does not take is kept and written when the
+// socket becomes writable again.
+class Connection : public std::enable_shared_from_this<Connection> {
+ public:
+  typedef std::function<void(std::unique_ptr<Socket>,
+                             std::unique_ptr<DataInfo>)>
+      CallBack;
+
+  Connection(int fd, int epoll_fd, std::shared_ptr<RecvBufferPool> pool);
+  ~Connection();
+
+  // Read the available data and pass each complete frame to call_back with
+  // a socket sending the responses on this connection. Returns false if
+  // the connection is closed by the client or broken.
+  bool OnReadable(const CallBack& call_back);
+  // Write the pending responses. Returns false if the connection is broken.
+  bool OnWritable();
+
+  // Send a framed response. Returns -1 if the connection is closed.
+  int Send(const std::string& data);
+  // Stop the connection, the event loop then releases it.
+  void Shutdown();
+  void Close();
+
+ private:
+  bool Flush();
+  void WatchWritable(bool watch);
+
+ private:
+  int fd_;
+  int epoll_fd_;
+  std::shared_ptr<RecvBufferPool> pool_;
+
+  enum class ReadState { kSize, kData };
+  ReadState read_state_ = ReadState::kSize;
+  size_t frame_size_ = 0;
+  size_t read_size_ = 0;
+  std::shared_ptr<char> frame_;
+
+  std::mutex mutex_;
+  // The framed responses not written yet.
+  std::deque<std::string> pending_;
+  size_t pending_offset_ = 0;
+  size_t pending_bytes_ = 0;
+  bool watch_writable_ = false;
+  bool closed_ = false;
+};
+
+// ConnectionSocket is the Socket handed on with the frames received from a
+// Connection. Send queues the response on the connection and returns
+// without waiting for the client.
+class ConnectionSocket : public Socket {
+ public:
+  ConnectionSocket(std::shared_ptr<Connection> connection);
+
+  int Connect(const std::string& ip, int port) override { return -1; }
+  int Listen(const std::string& ip, int port) override { return -1; }
+  void ReInit() override {}
+  void Close() override;
+  std::unique_ptr<Socket> Accept() override { return nullptr; }
+  int Send(const std::string& data) override;
+  int Recv(void** buf, size_t* len) override { return -1; }
+  int GetBindingPort() override { return 0; }
+
+ private:
+  std::shared_ptr<Connection> connection_;
+};
+
+// EventLoop serves the connections added to it from one thread with epoll.
+class EventLoop {
+ public:
+  EventLoop(std::shared_ptr<RecvBufferPool> pool,
+            Connection::CallBack call_back);
+  ~EventLoop();
+
+  // Serve the connected non-blocking socket fd, the loop owns it.
+  int AddConnection(int fd);
+  size_t GetConnectionNum();
+  void Stop();
+
+ private:
+  void Run();
+  void CloseConnection(Connection* connection);
+
+ private:
+  std::shared_ptr<RecvBufferPool> pool_;
+  Connection::CallBack call_back_;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::atomic<bool> stop_ = false;
+  std::mutex mutex_;
+  std::map<Connection*, std::shared_ptr<Connection>> connections_;
+  std::thread thread_;
+};
+
+}  // namespace resdb
@@ -39,6 +39,12 @@ std::map<MetricName, std::pair<TableName, std::string>> metric_names = {
     {CLIENT_REQ, {CLIENT, "client_req"}},
     {SOCKET_RECV, {IO_THREAD, "socket_recv"}},
     {BROAD_CAST, {IO_THREAD, "broad_cast"}},
+    {CONTROL_QUEUE_DEPTH, {IO_THREAD, "control_queue_depth"}},
+    {BULK_QUEUE_DEPTH, {IO_THREAD, "bulk_queue_depth"}},
+    {COMPRESS_RAW_BYTES, {IO_THREAD, "compress_raw_bytes"}},
+    {COMPRESS_BYTES, {IO_THREAD, "compress_bytes"}},
+    {COMPRESS_CPU_US, {IO_THREAD, "compress_cpu_us"}},
+    {DECOMPRESS_CPU_US, {IO_THREAD, "decompress_cpu_us"}},
     {PROPOSE, {CONSENSUS, "propose"}},
     {PREPARE, {CONSENSUS, "prepare"}},
     {COMMIT, {CONSENSUS, "commit"}},
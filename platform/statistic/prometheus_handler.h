@@ -48,6 +48,12 @@ enum MetricName {
   COMMIT,
   EXECUTE,
   NUM_EXECUTE_TX,
+  CONTROL_QUEUE_DEPTH,
+  BULK_QUEUE_DEPTH,
+  COMPRESS_RAW_BYTES,
+  COMPRESS_BYTES,
+  COMPRESS_CPU_US,
+  DECOMPRESS_CPU_US,
 };
 
 class PrometheusHandler {
@@ -54,6 +54,12 @@ Stats::Stats(int sleep_time) {
   run_req_num_ = 0;
   run_req_run_time_ = 0;
   seq_gap_ = 0;
+  control_queue_depth_ = 0;
+  bulk_queue_depth_ = 0;
+  compress_raw_bytes_ = 0;
+  compress_bytes_ = 0;
+  compress_cpu_us_ = 0;
+  decompress_cpu_us_ = 0;
   total_request_ = 0;
   total_geo_request_ = 0;
   geo_request_ = 0;
@@ -375,6 +381,9 @@ void Stats::MonitorGlobal() {
   uint64_t send_broad_cast_msg_per_rep = 0;
   uint64_t server_call = 0, server_process = 0;
   uint64_t seq_gap = 0;
+  uint64_t control_queue_depth = 0, bulk_queue_depth = 0;
+  uint64_t compress_raw_bytes = 0, compress_bytes = 0, compress_cpu_us = 0,
+           decompress_cpu_us = 0;
   uint64_t total_request = 0, total_geo_request = 0, geo_request = 0;
 
   // ====== for client proxy ======
@@ -393,6 +402,8 @@ void Stats::MonitorGlobal() {
   uint64_t last_server_call = 0, last_server_process = 0;
   uint64_t last_total_request = 0, last_total_geo_request = 0,
            last_geo_request = 0;
+  uint64_t last_compress_raw_bytes = 0, last_compress_bytes = 0,
+           last_compress_cpu_us = 0, last_decompress_cpu_us = 0;
   uint64_t time = 0;
 
   while (!stop_) {
@@ -414,6 +425,12 @@ void Stats::MonitorGlobal() {
     server_call = server_call_;
     server_process = server_process_;
     seq_gap = seq_gap_;
+    control_queue_depth = control_queue_depth_;
+    bulk_queue_depth = bulk_queue_depth_;
+    compress_raw_bytes = compress_raw_bytes_;
+    compress_bytes = compress_bytes_;
+    compress_cpu_us = compress_cpu_us_;
+    decompress_cpu_us = decompress_cpu_us_;
     total_request = total_request_;
     total_geo_request = total_geo_request_;
     geo_request = geo_request_;
@@ -465,6 +482,18 @@ void Stats::MonitorGlobal() {
                << " total geo request per:"
                << (total_geo_request - last_total_geo_request) / 5
                << " geo request:" << (geo_request - last_geo_request)
+               << " control queue:" << control_queue_depth
+               << " bulk queue:" << bulk_queue_depth
+               << " compress ratio:"
+               << (compress_bytes > last_compress_bytes
+                       ? static_cast<double>(compress_raw_bytes -
+                                             last_compress_raw_bytes) /
+                             (compress_bytes - last_compress_bytes)
+                       : 0)
+               << " compress cpu(ms):"
+               << (compress_cpu_us - last_compress_cpu_us) / 1000
+               << " decompress cpu(ms):"
+               << (decompress_cpu_us - last_decompress_cpu_us) / 1000
                << " "
                   "seq fail:"
                << seq_fail - last_seq_fail << " time:" << time
@@ -500,6 +529,10 @@ void Stats::MonitorGlobal() {
     last_total_request = total_request;
     last_total_geo_request = total_geo_request;
     last_geo_request = geo_request;
+    last_compress_raw_bytes = compress_raw_bytes;
+    last_compress_bytes = compress_bytes;
+    last_compress_cpu_us = compress_cpu_us;
+    last_decompress_cpu_us = decompress_cpu_us;
   }
 }
 
@@ -593,6 +626,34 @@ void Stats::ServerProcess() {
 
 void Stats::SeqGap(uint64_t seq_gap) { seq_gap_ = seq_gap; }
 
+void Stats::SetSendQueueDepth(uint64_t control_depth, uint64_t bulk_depth) {
+  if (prometheus_) {
+    prometheus_->Set(CONTROL_QUEUE_DEPTH, control_depth);
+    prometheus_->Set(BULK_QUEUE_DEPTH, bulk_depth);
+  }
+  control_queue_depth_ = control_depth;
+  bulk_queue_depth_ = bulk_depth;
+}
+
+void Stats::Compress(uint64_t raw_bytes, uint64_t compressed_bytes,
+                     uint64_t cpu_us) {
+  if (prometheus_) {
+    prometheus_->Inc(COMPRESS_RAW_BYTES, raw_bytes);
+    prometheus_->Inc(COMPRESS_BYTES, compressed_bytes);
+    prometheus_->Inc(COMPRESS_CPU_US, cpu_us);
+  }
+  compress_raw_bytes_ += raw_bytes;
+  compress_bytes_ += compressed_bytes;
+  compress_cpu_us_ += cpu_us;
+}
+
+void Stats::Decompress(uint64_t cpu_us) {
+  if (prometheus_) {
+    prometheus_->Inc(DECOMPRESS_CPU_US, cpu_us);
+  }
+  decompress_cpu_us_ += cpu_us;
+}
+
 void Stats::AddLatency(uint64_t run_time) {
   run_req_num_++;
   run_req_run_time_ += run_time;
@@ -117,6 +117,12 @@ class Stats {
   void IncGeoRequest();
 
   void SeqGap(uint64_t seq_gap);
+  // Messages waiting in the control and the bulk send lanes.
+  void SetSendQueueDepth(uint64_t control_depth, uint64_t bulk_depth);
+  // Frames compressed for the replica links and the thread CPU time spent.
+  void Compress(uint64_t raw_bytes, uint64_t compressed_bytes,
+                uint64_t cpu_us);
+  void Decompress(uint64_t cpu_us);
   // Network in->worker
   void ServerCall();
   void ServerProcess();
@@ -148,6 +154,9 @@ class Stats {
   std::atomic<uint64_t> run_req_num_;
   std::atomic<uint64_t> run_req_run_time_;
   std::atomic<uint64_t> seq_gap_;
+  std::atomic<uint64_t> control_queue_depth_, bulk_queue_depth_;
+  std::atomic<uint64_t> compress_raw_bytes_, compress_bytes_,
+      compress_cpu_us_, decompress_cpu_us_;
   std::atomic<uint64_t> total_request_, total_geo_request_, geo_request_;
   int monitor_sleep_time_ = 5;  // default 5s.
 
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Trains the compression dictionary of the replica links from the
+// transactions committed in [min_seq, max_seq] and saves it to the
+// compression_dictionary_path of the replicas.
+
+#include <glog/logging.h>
+
+#include <fstream>
+
+#include "interface/common/resdb_txn_accessor.h"
+#include "platform/config/resdb_config_utils.h"
+#include "platform/networkstrate/frame_codec.h"
+
+using resdb::GenerateReplicaInfo;
+using resdb::ReplicaInfo;
+using resdb::ResDBConfig;
+using resdb::ResDBTxnAccessor;
+
+int main(int argc, char** argv) {
+  if (argc < 7) {
+    printf(
+        "<config path> <private key path> <cert_file> <min_seq> <max_seq> "
+        "<dictionary path> [max size(32768)]\n");
+    return 0;
+  }
+  std::string config_file = argv[1];
+  std::string private_key_file = argv[2];
+  std::string cert_file = argv[3];
+  uint64_t min_seq = atoi(argv[4]);
+  uint64_t max_seq = atoi(argv[5]);
+  std::string dictionary_file = argv[6];
+  size_t max_size = argc > 7 ? atoi(argv[7]) : 32 << 10;
+
+  ReplicaInfo self_info = GenerateReplicaInfo(0, "127.0.0.1", 88888);
+
+  std::unique_ptr<ResDBConfig> config =
+      GenerateResDBConfig(config_file, private_key_file, cert_file, self_info);
+
+  ResDBTxnAccessor client(*config);
+  auto resp = client.GetTxn(min_seq, max_seq);
+  if (!resp.ok()) {
+    LOG(ERROR) << "get txn fail";
+    exit(1);
+  }
+  std::vector<std::string> samples;
+  for (auto& txn : *resp) {
+    samples.push_back(std::move(txn.second));
+  }
+
+  std::string dictionary = resdb::TrainDictionary(samples, max_size);
+  std::ofstream file(dictionary_file, std::ios::binary);
+  file << dictionary;
+  if (!file.good()) {
+    LOG(ERROR) << "write dictionary fail:" << dictionary_file;
+    exit(1);
+  }
+  printf("save dictionary of %zu bytes from %zu txns to %s\n",
+         dictionary.size(), samples.size(), dictionary_file.c_str());
+}
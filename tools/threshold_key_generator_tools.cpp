@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "common/crypto/threshold_signature.h"
+
+using namespace resdb;
+
+void WriteKey(const google::protobuf::Message& key,
+              const std::string& file_name) {
+  std::string str;
+  assert(key.SerializeToString(&str));
+
+  printf("save key to path %s\n", file_name.c_str());
+  int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    printf("open file fail %s\n", strerror(errno));
+  }
+  assert(fd >= 0);
+  write(fd, str.c_str(), str.size());
+  close(fd);
+}
+
+// Generate the threshold key shares of all the replicas, node<id>.threshold.key
+// to be placed under threshold_key_path of each replica, and the public key
+// threshold.key.pub used by other regions to verify the certificates.
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf(
+        "<path> <replica num> [threshold(default 2f+1)] [modulus bits(default "
+        "%u)]\n",
+        ThresholdSignature::kDefaultModulusBits);
+    exit(0);
+  }
+  std::string path = argv[1];
+  uint32_t replica_num = atoi(argv[2]);
+  uint32_t threshold = 2 * ((replica_num - 1) / 3) + 1;
+  uint32_t modulus_bits = ThresholdSignature::kDefaultModulusBits;
+  if (argc > 3) {
+    threshold = atoi(argv[3]);
+  }
+  if (argc > 4) {
+    modulus_bits = atoi(argv[4]);
+  }
+
+  auto keys_or =
+      ThresholdSignature::GenerateKeys(replica_num, threshold, modulus_bits);
+  if (!keys_or.ok()) {
+    printf("generate keys fail: %s\n", keys_or.status().ToString().c_str());
+    exit(1);
+  }
+  for (const ThresholdKeyShare& key : *keys_or) {
+    WriteKey(key, path + "/node" + std::to_string(key.node_id()) +
+                      ".threshold.key");
+  }
+  WriteKey((*keys_or)[0].public_key(), path + "/threshold.key.pub");
+}